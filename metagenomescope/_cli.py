@@ -21,28 +21,70 @@
 # https://github.com/biocore/qurro/blob/master/qurro/scripts/_plot.py.
 
 import click
-from .config import MAXN_DEFAULT, MAXE_DEFAULT
+from .config import (
+    MAXN_DEFAULT,
+    MAXE_DEFAULT,
+    VALIDATION_LEVELS,
+    VALIDATION_DEFAULT,
+    INFO_TOP_COMPONENTS_DEFAULT,
+    LAYOUT_WORKERS_DEFAULT,
+    DECOMPOSITION_WORKERS_DEFAULT,
+    TABLE_FORMATS,
+    RENDER_FORMATS,
+    RENDER_COMPONENTS_DEFAULT,
+)
+from . import arg_utils
 from .main import make_viz
+from .graph_info import GraphInfo
+from .assembly_graph_parser import SUPPORTED_FILETYPE_TO_PARSER
 from ._param_descriptions import (
     INPUT,
+    INPUT_FORMAT,
     OUTPUT_DIR,
+    ASSUME_ORIENTED,
     MAXN,
     MAXE,
+    OUT_OF_CORE,
+    VALIDATION,
+    TOP_COMPONENTS,
+    TIME_BUDGET,
+    LAYOUT_WORKERS,
+    DECOMPOSITION_WORKERS,
+    DECOMPOSITION_TIME_LIMIT,
+    DECOMPOSITION_MAX_CALLS,
+    MAX_PATTERN_DEPTH,
+    LAYOUT_TIMINGS,
+    CLIP_TIPS,
+    MIN_COVERAGE,
+    TRANSITIVE_REDUCTION,
+    MBF,
+    UP,
+    EXPORT_TABLES,
+    SAVE_DATABASE,
+    RENDER_IMAGES,
+    RENDER_COMPONENTS,
+    MAKE_TILES,
+    ANNOTATIONS,
 )
 
-
 # Make mgsc -h show the help text
-@click.command(context_settings={"help_option_names": ["-h", "--help"]})
-@click.option("-i", "--input-file", required=True, help=INPUT)
-@click.option("-o", "--output-dir", required=True, help=OUTPUT_DIR)
-# @click.option(
-#    "-ao",
-#    "--assume-oriented",
-#    required=False,
-#    default=False,
-#    help=ASSUME_ORIENTED,
-# )
-@click.option(
+CONTEXT_SETTINGS = {"help_option_names": ["-h", "--help"]}
+
+# Options shared between multiple commands
+input_file_option = click.option(
+    "-i", "--input-file", required=True, help=INPUT
+)
+input_format_option = click.option(
+    "-if",
+    "--input-format",
+    required=False,
+    default=None,
+    type=click.Choice(
+        list(SUPPORTED_FILETYPE_TO_PARSER.keys()), case_sensitive=False
+    ),
+    help=INPUT_FORMAT,
+)
+max_node_count_option = click.option(
     "-maxn",
     "--max-node-count",
     required=False,
@@ -50,7 +92,7 @@ from ._param_descriptions import (
     help=MAXN,
     show_default=True,
 )
-@click.option(
+max_edge_count_option = click.option(
     "-maxe",
     "--max-edge-count",
     required=False,
@@ -58,12 +100,205 @@ from ._param_descriptions import (
     help=MAXE,
     show_default=True,
 )
-# @click.option(
-#    "-mbf", "--metacarvel-bubble-file", required=False, default=None, help=MBF
-# )
-# @click.option(
-#    "-up", "--user-pattern-file", required=False, default=None, help=UP
-# )
+assume_oriented_option = click.option(
+    "-ao",
+    "--assume-oriented",
+    is_flag=True,
+    required=False,
+    default=False,
+    help=ASSUME_ORIENTED,
+)
+validation_option = click.option(
+    "-vl",
+    "--validation",
+    required=False,
+    default=VALIDATION_DEFAULT,
+    type=click.Choice(VALIDATION_LEVELS),
+    help=VALIDATION,
+    show_default=True,
+)
+
+
+class DefaultCommandGroup(click.Group):
+    """A click Group that runs a default command if no command is given.
+
+    MetagenomeScope used to only have a single command, so "mgsc -i graph.gfa
+    -o viz" has to keep working even though there are now other commands
+    (e.g. "mgsc info"). If the first argument isn't the name of a command,
+    we just stick the name of the default command in front of the
+    arguments. (This means that "mgsc -h" shows the help for the default
+    command.)
+    """
+
+    default_command = "viz"
+
+    def parse_args(self, ctx, args):
+        if len(args) == 0 or args[0] not in self.commands:
+            args = [self.default_command] + list(args)
+        return super().parse_args(ctx, args)
+
+
+def is_default(ctx, param_name):
+    """Returns True if a parameter wasn't explicitly given by the user."""
+    return (
+        ctx.get_parameter_source(param_name)
+        == click.core.ParameterSource.DEFAULT
+    )
+
+
+@click.group(cls=DefaultCommandGroup, context_settings=CONTEXT_SETTINGS)
+def run_script():
+    pass
+
+
+@run_script.command("viz", context_settings=CONTEXT_SETTINGS)
+@input_file_option
+@input_format_option
+@click.option("-o", "--output-dir", required=True, help=OUTPUT_DIR)
+@assume_oriented_option
+@max_node_count_option
+@max_edge_count_option
+@validation_option
+@click.option(
+    "-ooc",
+    "--out-of-core",
+    is_flag=True,
+    required=False,
+    default=False,
+    help=OUT_OF_CORE,
+)
+@click.option(
+    "-tb",
+    "--time-budget",
+    required=False,
+    default=None,
+    type=float,
+    help=TIME_BUDGET,
+)
+@click.option(
+    "-lw",
+    "--layout-workers",
+    required=False,
+    default=LAYOUT_WORKERS_DEFAULT,
+    help=LAYOUT_WORKERS,
+    show_default=True,
+)
+@click.option(
+    "-lt",
+    "--layout-timings",
+    required=False,
+    default=None,
+    help=LAYOUT_TIMINGS,
+)
+@click.option(
+    "-ct",
+    "--clip-tips",
+    required=False,
+    default=None,
+    type=int,
+    help=CLIP_TIPS,
+)
+@click.option(
+    "-mc",
+    "--min-coverage",
+    required=False,
+    default=None,
+    type=float,
+    help=MIN_COVERAGE,
+)
+@click.option(
+    "-tr",
+    "--transitive-reduction",
+    is_flag=True,
+    required=False,
+    default=False,
+    help=TRANSITIVE_REDUCTION,
+)
+@click.option(
+    "-dw",
+    "--decomposition-workers",
+    required=False,
+    default=DECOMPOSITION_WORKERS_DEFAULT,
+    help=DECOMPOSITION_WORKERS,
+    show_default=True,
+)
+@click.option(
+    "-dtl",
+    "--decomposition-time-limit",
+    required=False,
+    default=None,
+    type=float,
+    help=DECOMPOSITION_TIME_LIMIT,
+)
+@click.option(
+    "-dmc",
+    "--decomposition-max-calls",
+    required=False,
+    default=None,
+    type=int,
+    help=DECOMPOSITION_MAX_CALLS,
+)
+@click.option(
+    "-mpd",
+    "--max-pattern-depth",
+    required=False,
+    default=None,
+    type=int,
+    help=MAX_PATTERN_DEPTH,
+)
+@click.option(
+    "-mbf", "--metacarvel-bubble-file", required=False, default=None, help=MBF
+)
+@click.option(
+    "-up", "--user-pattern-file", required=False, default=None, help=UP
+)
+@click.option(
+    "-et",
+    "--export-tables",
+    required=False,
+    default=None,
+    type=click.Choice(TABLE_FORMATS),
+    help=EXPORT_TABLES,
+)
+@click.option(
+    "-db",
+    "--save-database",
+    is_flag=True,
+    required=False,
+    default=False,
+    help=SAVE_DATABASE,
+)
+@click.option(
+    "-ri",
+    "--render-images",
+    required=False,
+    multiple=True,
+    type=click.Choice(RENDER_FORMATS),
+    help=RENDER_IMAGES,
+)
+@click.option(
+    "-rc",
+    "--render-components",
+    required=False,
+    default=RENDER_COMPONENTS_DEFAULT,
+    help=RENDER_COMPONENTS,
+    show_default=True,
+)
+@click.option(
+    "-mt",
+    "--make-tiles",
+    is_flag=True,
+    required=False,
+    default=False,
+    help=MAKE_TILES,
+)
+@click.option(
+    "-a",
+    "--annotations",
+    required=False,
+    multiple=True,
+    help=ANNOTATIONS,
+)
 # @click.option(
 #    "-spqr",
 #    "--compute-spqr-data",
@@ -112,14 +347,33 @@ from ._param_descriptions import (
 #    default=False,
 #    help=NPDF,
 # )
-def run_script(
+def viz(
     input_file: str,
+    input_format: str,
     output_dir: str,
-    # assume_oriented: bool,
+    assume_oriented: bool,
     max_node_count: int,
     max_edge_count: int,
-    # metacarvel_bubble_file: str,
-    # user_pattern_file: str,
+    validation: str,
+    out_of_core: bool,
+    time_budget: float,
+    layout_workers: int,
+    layout_timings: str,
+    clip_tips: int,
+    min_coverage: float,
+    transitive_reduction: bool,
+    decomposition_workers: int,
+    decomposition_time_limit: float,
+    decomposition_max_calls: int,
+    max_pattern_depth: int,
+    metacarvel_bubble_file: str,
+    user_pattern_file: str,
+    export_tables: str,
+    save_database: bool,
+    render_images: tuple,
+    render_components: int,
+    make_tiles: bool,
+    annotations: tuple,
     # compute_spqr_data: bool,
     # save_structural_patterns: bool,
     # preserve_gv: bool,
@@ -141,15 +395,49 @@ def run_script(
 
     ...which will generate an output directory named "viz". (You'll need to
     replace "graph.gfa" with whatever the path to your assembly graph is.)
+
+    You can also pipe a graph in through stdin, e.g.
+
+        zcat graph.gfa.gz | mgsc -i - -if gfa -o viz
+
+    To quickly summarize a graph (e.g. to figure out what -maxn / -maxe
+    should be) without visualizing it, see "mgsc info -h".
     """
+    # If --time-budget is given, we'll pick -maxn / -maxe automatically --
+    # unless the user explicitly gave them.
+    ctx = click.get_current_context()
+    if time_budget is not None:
+        if is_default(ctx, "max_node_count"):
+            max_node_count = None
+        if is_default(ctx, "max_edge_count"):
+            max_edge_count = None
     make_viz(
         input_file,
         output_dir,
-        # assume_oriented,
         max_node_count,
         max_edge_count,
-        # metacarvel_bubble_file,
-        # user_pattern_file,
+        out_of_core,
+        input_format,
+        validation,
+        time_budget,
+        layout_workers,
+        layout_timings,
+        assume_oriented,
+        clip_tips,
+        min_coverage,
+        transitive_reduction,
+        decomposition_workers,
+        decomposition_time_limit,
+        decomposition_max_calls,
+        max_pattern_depth,
+        metacarvel_bubble_file,
+        user_pattern_file,
+        export_tables,
+        save_database,
+        render_images,
+        render_components,
+        make_tiles,
+        annotations,
         # compute_spqr_data,
         # save_structural_patterns,
         # preserve_gv,
@@ -159,5 +447,59 @@ def run_script(
     )
 
 
+@run_script.command("info", context_settings=CONTEXT_SETTINGS)
+@input_file_option
+@input_format_option
+@assume_oriented_option
+@max_node_count_option
+@max_edge_count_option
+@validation_option
+@click.option(
+    "-tc",
+    "--top-components",
+    required=False,
+    default=INFO_TOP_COMPONENTS_DEFAULT,
+    help=TOP_COMPONENTS,
+    show_default=True,
+)
+def info(
+    input_file: str,
+    input_format: str,
+    assume_oriented: bool,
+    max_node_count: int,
+    max_edge_count: int,
+    validation: str,
+    top_components: int,
+) -> None:
+    """Quickly summarizes an assembly graph, without visualizing it.
+
+    This reports the numbers of nodes, edges, and connected components in
+    the graph; the distribution of component sizes; the total sequence length
+    and N50; and a list of the largest components, along with a (rough)
+    estimate of how much of the total layout time each one will take up.
+    It also says which components would be skipped with the given -maxn /
+    -maxe values.
+
+    This doesn't do any pattern detection or layout, so it should be a lot
+    faster than actually visualizing the graph:
+
+        mgsc info -i graph.gfa
+    """
+    arg_utils.validate_max_counts(max_node_count, max_edge_count)
+    graph_info = GraphInfo(
+        input_file,
+        input_format=input_format,
+        validation=validation,
+        assume_oriented=assume_oriented,
+    )
+    click.echo(
+        graph_info.to_str(
+            max_node_count=max_node_count,
+            max_edge_count=max_edge_count,
+            num_top_components=top_components,
+        )
+    )
+
+
 if __name__ == "__main__":
     run_script()
@@ -19,7 +19,15 @@
 
 INPUT = (
     "Assembly graph file to be visualized. GFA, FASTG, LastGraph (Velvet), "
-    "and GML (MetaCarvel) file formats are accepted."
+    "and GML (MetaCarvel) file formats are accepted. Use - to read the graph "
+    "from stdin (this requires --input-format)."
+)
+
+INPUT_FORMAT = (
+    "Filetype of the input assembly graph. If this isn't given, we'll guess "
+    "the filetype from the input filename's extension. This must be given if "
+    "the input is stdin, or a pipe whose name doesn't end with one of these "
+    "extensions."
 )
 
 OUTPUT_DIR = (
@@ -30,11 +38,12 @@ OUTPUT_DIR = (
 )
 
 ASSUME_ORIENTED = (
-    "Assume that the nodes in a graph are already oriented, and doesn't "
-    "create duplicates. This will only work with graphs where, for every "
-    "node, its reverse complement node is not present in the same connected "
-    "component; if this is the case for any node, then an error will be "
-    "raised. THIS OPTION ISN'T FINISHED YET!"
+    "Assume that the input graph is already oriented, and don't create a "
+    "reverse-complement copy of each node and edge. This roughly halves the "
+    "time and memory needed for GFA and LastGraph files (GML and FASTG files "
+    "aren't affected). Each node's orientation is taken from the edges it's "
+    "in: e.g. a GFA link from A+ to B- means that B is reverse-complemented. "
+    "If a node is used in both orientations, an error will be raised."
 )
 
 MAXN = (
@@ -45,7 +54,9 @@ MAXN = (
     "of the less messy regions of graphs with a few 'hairball' components. "
     "(Note that certain patterns might result in nodes being duplicated in "
     "the display so that they can be present in multiple patterns; these "
-    '"duplicate" nodes will not count against this number.)'
+    '"duplicate" nodes will not count against this number.) If this isn\'t '
+    "given and --time-budget is, this is set automatically based on the "
+    "predicted layout time of a component this large."
 )
 
 MAXE = (
@@ -54,26 +65,171 @@ MAXE = (
     "analogously to --max-node-count."
 )
 
-# TODO: actually change way this works so that -ubl always true
+TIME_BUDGET = (
+    "Try to finish within this many seconds. We predict how long each "
+    "connected component will take to lay out, and (if laying out "
+    "everything would take too long) do a faster but lower-quality layout "
+    "of the most expensive components, or skip them entirely. These "
+    "predictions are rough, so this is a target rather than a guarantee; "
+    "using --layout-timings will make the predictions better over time."
+)
+
+LAYOUT_WORKERS = (
+    "Number of processes to use for laying out connected components in "
+    "parallel. Components are laid out in descending order of predicted "
+    "layout time, so that large components don't hold things up at the end."
+)
+
+DECOMPOSITION_WORKERS = (
+    "Number of processes to use for checking nodes for structural patterns "
+    "in parallel. This only helps for graphs with lots of nodes; the "
+    "patterns identified are the same regardless of how many processes are "
+    "used."
+)
+
+DECOMPOSITION_TIME_LIMIT = (
+    "Maximum number of seconds to spend looking for structural patterns in "
+    "each connected component. If we run out of time for a component, we'll "
+    "keep the patterns we've found so far and leave the rest of the "
+    "component uncollapsed."
+)
+
+DECOMPOSITION_MAX_CALLS = (
+    "Maximum number of times to check a node for structural patterns in "
+    "each connected component. Like --decomposition-time-limit, but "
+    "deterministic."
+)
+
+MAX_PATTERN_DEPTH = (
+    "Maximum number of levels that structural patterns can be nested (1 "
+    "means that patterns can't contain other patterns). Deeply nested "
+    "patterns take longer to lay out."
+)
+
+LAYOUT_TIMINGS = (
+    "JSON file in which to record how long each component took to lay out. "
+    "If this file already exists, the timings in it are used to calibrate "
+    "our predictions of how long layout will take (used by --time-budget "
+    "and --layout-workers); new timings are then added to it. This file is "
+    "specific to the machine you're running MetagenomeScope on."
+)
+
+CLIP_TIPS = (
+    'Before doing anything else, remove "tips" (dead-end nodes attached '
+    "to just one other node) with length at most this many bp. These are "
+    "usually caused by sequencing errors. We won't remove a tip if that "
+    "would leave its neighbor as a new dead end. Removed nodes are listed in "
+    "the visualization's graph information."
+)
+
+MIN_COVERAGE = (
+    'Before doing anything else, remove nodes with coverage ("depth" in '
+    'LastGraph files, "cov" in FASTG files) less than this value. Nodes '
+    "without coverage information are kept. Removed nodes are listed in the "
+    "visualization's graph information."
+)
+
+TRANSITIVE_REDUCTION = (
+    "Before doing anything else, remove edges A -> C when the edges A -> B "
+    "and B -> C are also present. (To keep this fast, we only look at "
+    'these "triangles", and skip nodes with very many outgoing edges.) '
+    "Removed edges are listed in the visualization's graph information."
+)
+
+TOP_COMPONENTS = (
+    "Number of the largest connected components to list individually in the "
+    "summary."
+)
+
+VALIDATION = (
+    'How thoroughly to check that the input graph is valid. "strict" does '
+    'every check we have. "fast" still does the structural checks (e.g. for '
+    "duplicate node IDs or edges referring to unseen nodes), but skips "
+    "attribute scans and cross-checks between different parts of the file "
+    "(e.g. checking that all nodes have a given attribute up front, or that "
+    'node sequences match the lengths given for them). "none" skips '
+    "validation entirely: only use this if you trust that the input graph is "
+    "well-formed, since otherwise MetagenomeScope may fail in confusing ways "
+    "(or silently produce a weird visualization)."
+)
+
+OUT_OF_CORE = (
+    "Store the graph on disk while processing it, rather than loading the "
+    "entire graph into memory. Connected components are then read back in "
+    "and laid out a few at a time. This is slower than the default mode, but "
+    "lets you visualize graphs that are too large to fit in memory. (Only "
+    "LastGraph and GFA files are parsed directly to disk; other filetypes are "
+    "still parsed in memory first.) Temporary files are stored in the "
+    "directory specified by the TMPDIR environment variable, if set."
+)
+
 MBF = (
     "File describing pre-identified bubbles in the graph, in the format "
     "of MetaCarvel's bubbles.txt output: each line of the file is formatted "
     "as (source label)(tab)(sink label)(tab)(all node labels in the bubble, "
     "including source and sink labels, all separated by tabs). Please see the "
     "MetaCarvel documentation at https://github.com/marbl/MetaCarvel for "
-    "more details on MetaCarvel. This option can only be used if the input "
-    "graph is a MetaCarvel GML file; otherwise, this will raise an error."
+    "more details on MetaCarvel. Bubbles are collapsed before we look for "
+    "other structural patterns in the graph."
 )
 
 UP = (
     "File describing any pre-identified structural patterns in the graph: "
     "each line of the file should be formatted as "
     "(pattern type)(tab)(all node IDs in the pattern, all separated by tabs). "
-    "If (pattern type) is 'Bubble' or 'Frayed Rope', then the pattern will be "
-    "represented in the visualization as a Bubble or Frayed Rope, "
-    "respectively; otherwise, the pattern will be represented as a generic "
+    "If (pattern type) is 'Bubble', 'Chain', 'Cyclic Chain', or 'Frayed "
+    "Rope', then the pattern will be represented in the visualization as "
+    "that type of pattern; otherwise, the pattern will be represented as a "
+    "generic "
     "'misc. user-specified pattern,' and colored accordingly in the "
-    "visualization."
+    "visualization. Patterns can contain other patterns, as long as they "
+    "contain all of their nodes."
+)
+
+EXPORT_TABLES = (
+    "Also write out the laid-out nodes, edges, and patterns as tables in "
+    'this format (Parquet or Arrow IPC), in a "tables" folder in the output '
+    "directory. Each row includes the number of the component it's in. "
+    "Requires pyarrow."
+)
+
+SAVE_DATABASE = (
+    "Also save the laid-out nodes, edges, patterns, and components to an "
+    "indexed SQLite database (graph.db) in the output directory. This "
+    "makes it easy to look up e.g. where a certain node is, or what's in a "
+    "certain component, without loading the whole visualization."
+)
+
+RENDER_IMAGES = (
+    "Also draw the largest components as static images in this format, in an "
+    '"images" folder in the output directory. This works without a browser, '
+    "so it's useful for making thumbnails of lots of graphs. Can be given "
+    "twice (-ri svg -ri png) to draw both SVG and PNG images. PNG images "
+    "require cairosvg. Uses --layout-workers processes."
+)
+
+RENDER_COMPONENTS = (
+    "Number of components to draw if --render-images is given. Components "
+    "are drawn in order of size, starting with the largest one."
+)
+
+MAKE_TILES = (
+    "Also draw each big component as a pyramid of small image tiles, in a "
+    '"tiles" folder in the output directory. When viewing one of these '
+    "components, the visualization shows these tiles (and a minimap) right "
+    "away, and only draws the actual nodes and edges once you zoom in. "
+    "Uses --layout-workers processes."
+)
+
+ANNOTATIONS = (
+    "Tab-separated file of node annotations (e.g. bins, taxonomy, or "
+    "coverage in each sample) to color nodes by in the visualization. The "
+    "file should have a header row; the first column should contain node "
+    "names, and each other column is an annotation. Columns where every "
+    "value is a number are treated as numeric, and other columns are "
+    "treated as categories. Rows for names that aren't in the graph are "
+    "ignored. Can be given multiple times, as long as column names aren't "
+    "repeated."
 )
 
 SPQR = (
@@ -0,0 +1,382 @@
+# Copyright (C) 2016-- Marcus Fedarko, Jay Ghurye, Todd Treangen, Mihai Pop
+# Authored by Marcus Fedarko
+#
+# This file is part of MetagenomeScope.
+#
+# MetagenomeScope is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# MetagenomeScope is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with MetagenomeScope.  If not, see <http://www.gnu.org/licenses/>.
+####
+# Joining user-provided node annotations (-a) onto the graph.
+#
+# Annotation files are tab-separated tables with a header row. The first
+# column of each file contains node names; every other column is an
+# annotation (e.g. the bin or taxonomy of each contig, or its coverage in
+# each of a bunch of samples). These tables can have millions of rows, so we
+# stream through them one row at a time and look up each row's node name in
+# a hash index of the graph's node names (a "hashed join") -- so we only ever
+# hold onto rows that actually match a node in the graph.
+#
+# Every annotated node name gets a "slot," and each column is stored as an
+# array with one value per slot. Columns start out numeric: we parse their
+# values straight into an array of doubles (with NaN for missing values).
+# The first time a column has a value that isn't a number, it becomes a
+# "categorical" column instead, whose values are dictionary-encoded (the
+# array holds indices into a dictionary of the column's distinct values,
+# with -1 for missing values). If this happens after we've already stored
+# some numbers in the column, we've lost the original text of these numbers
+# -- so we read the file a second time, just for the columns this happened
+# to. (Usually this isn't needed, since e.g. a column of bins will have a
+# non-numeric value in the first row.)
+#
+# Like the extra attributes in attr_tables.py, the joined annotations are
+# saved as one columnar "side table" per component, as
+# ANNOTATIONS_DIR_NAME/N.js in the output directory:
+#
+# {
+#     "node_ids": [node ID, ...],
+#     "cols": {column name: [value for each node ID], ...},
+# }
+#
+# Only nodes with at least one annotation are included, and columns without
+# any values in a component are left out of its table. Values in categorical
+# columns are indices into that column's "values" list (stored once, in the
+# main graph data; see write_annotation_tables()), so that every component
+# agrees on what each category is; values in numeric columns are rounded to
+# config.ANNOTATION_SIG_DIGITS significant digits, which keeps per-sample
+# coverage columns from taking up much space.
+
+import os
+import csv
+import json
+from array import array
+from . import config
+
+CATEGORICAL = "categorical"
+NUMERIC = "numeric"
+
+
+def get_name_index(graph_data):
+    """Returns a dict mapping node names to the nodes with these names.
+
+    Each node is represented as a 2-tuple of (0-indexed component index,
+    node ID). A name can map to multiple nodes (if a node was duplicated
+    during pattern decomposition). Nodes in skipped components aren't
+    included, since the viewer can't draw them anyway.
+    """
+    name_pos = graph_data["node_attrs"]["name"]
+    name2nodes = {}
+    for cmp_idx, comp in enumerate(graph_data["components"]):
+        if comp["skipped"]:
+            continue
+        for node_id, data in comp["nodes"].items():
+            name2nodes.setdefault(data[name_pos], []).append(
+                (cmp_idx, node_id)
+            )
+    return name2nodes
+
+
+def round_value(value):
+    """Rounds a number to config.ANNOTATION_SIG_DIGITS significant digits.
+
+    Whole numbers are returned as ints, so that they don't get written out
+    with a trailing ".0".
+    """
+    value = float("{:.{}g}".format(value, config.ANNOTATION_SIG_DIGITS))
+    if value.is_integer():
+        return int(value)
+    return value
+
+
+def parse_number(text):
+    """Returns text as a float, or None if it isn't a (finite) number."""
+    try:
+        value = float(text)
+    except ValueError:
+        return None
+    if value != value or value in (float("inf"), float("-inf")):
+        return None
+    return value
+
+
+def new_column(name):
+    """Returns a new (numeric, empty) column.
+
+    Columns are dicts with the keys "name", "type", "data" (an array with
+    one value per slot), "has_values" (whether or not we've stored any
+    values in the column yet), and "codes" (for categorical columns, a dict
+    mapping each distinct value to its dictionary index; None for numeric
+    columns).
+    """
+    return {
+        "name": name,
+        "type": NUMERIC,
+        "data": array("d"),
+        "has_values": False,
+        "codes": None,
+    }
+
+
+def make_categorical(col):
+    """Turns a column into an empty categorical column."""
+    col["type"] = CATEGORICAL
+    col["data"] = array("l")
+    col["has_values"] = False
+    col["codes"] = {}
+
+
+def set_value(col, slot, text):
+    """Stores a (non-missing) value in a column.
+
+    Returns False if text isn't a number but col is a numeric column that
+    already has numbers in it (in which case nothing is stored, and the
+    caller is responsible for reading this column again); returns True
+    otherwise.
+    """
+    if col["type"] == NUMERIC:
+        value = parse_number(text)
+        if value is None:
+            if col["has_values"]:
+                return False
+            make_categorical(col)
+    if col["type"] == NUMERIC:
+        missing = float("nan")
+    else:
+        codes = col["codes"]
+        if text not in codes:
+            codes[text] = len(codes)
+        value = codes[text]
+        missing = -1
+    data = col["data"]
+    if len(data) <= slot:
+        data.extend(array(data.typecode, [missing]) * (slot + 1 - len(data)))
+    data[slot] = value
+    col["has_values"] = True
+    return True
+
+
+def get_value(col, slot):
+    """Returns the value of a column to write out for a slot.
+
+    This is None if the value is missing; a rounded number (see
+    round_value()) for numeric columns; and a dictionary index for
+    categorical columns.
+    """
+    data = col["data"]
+    if slot >= len(data):
+        return None
+    value = data[slot]
+    if col["type"] == NUMERIC:
+        if value != value:
+            return None
+        return round_value(value)
+    if value < 0:
+        return None
+    return value
+
+
+def finish_column(col):
+    """Returns info about a column for the viewer, once we've read it in.
+
+    Columns without any values are categorical (with no categories).
+    """
+    if col["type"] == NUMERIC and col["has_values"]:
+        numbers = [v for v in col["data"] if v == v]
+        # (Rounding doesn't change the order of numbers, so we can round
+        # these after finding them)
+        return {
+            "name": col["name"],
+            "type": NUMERIC,
+            "min": round_value(min(numbers)),
+            "max": round_value(max(numbers)),
+        }
+    if col["type"] == NUMERIC:
+        make_categorical(col)
+    # dicts preserve insertion order, so this lists each column's values in
+    # the order of their dictionary indices
+    return {
+        "name": col["name"],
+        "type": CATEGORICAL,
+        "values": list(col["codes"]),
+    }
+
+
+def read_header(filepath):
+    """Returns the header row of an annotation file.
+
+    Raises a ValueError if the file is empty.
+    """
+    with open(filepath, "r", newline="") as f:
+        try:
+            return next(csv.reader(f, delimiter="\t"))
+        except StopIteration:
+            raise ValueError("Annotation file {} is empty.".format(filepath))
+
+
+def read_rows(filepath, num_fields):
+    """Yields the fields of every non-empty row after an annotation file's
+    header.
+
+    Raises a ValueError if a row doesn't have num_fields fields.
+    """
+    with open(filepath, "r", newline="") as f:
+        reader = csv.reader(f, delimiter="\t")
+        next(reader, None)
+        for line_num, fields in enumerate(reader, 2):
+            if len(fields) == 0:
+                continue
+            if len(fields) != num_fields:
+                raise ValueError(
+                    "Line {} of annotation file {} has {} field(s), but the "
+                    "header has {}.".format(
+                        line_num, filepath, len(fields), num_fields
+                    )
+                )
+            yield fields
+
+
+def read_annotation_file(filepath, name2nodes, name2slot, seen_cols):
+    """Streams through an annotation file, joining its rows to nodes.
+
+    name2slot maps the names of nodes we've seen annotations for to their
+    slots; we add this file's matched names to it. seen_cols should be a
+    list of the column names seen so far (across all files); we add this
+    file's columns to the end of it.
+
+    Returns a 3-tuple of (a list of this file's columns -- see new_column()
+    -- the number of rows in the file, the number of rows that matched
+    nodes).
+
+    Raises a ValueError if the file is empty, if one of its column names is
+    already used (in this file or in a previous file), or if a row doesn't
+    have the same number of fields as the header.
+    """
+    header = read_header(filepath)
+    col_names = header[1:]
+    if len(col_names) == 0:
+        raise ValueError(
+            "Annotation file {} doesn't have any annotation "
+            "columns.".format(filepath)
+        )
+    for col_name in col_names:
+        if col_name in seen_cols:
+            raise ValueError(
+                "Annotation column {} is given more than once.".format(
+                    col_name
+                )
+            )
+        seen_cols.append(col_name)
+
+    cols = [new_column(name) for name in col_names]
+    # Indices of columns that we need to read again, as categorical columns
+    reread = []
+    num_rows = 0
+    num_matched = 0
+    for fields in read_rows(filepath, len(header)):
+        num_rows += 1
+        if fields[0] not in name2nodes:
+            continue
+        num_matched += 1
+        slot = name2slot.setdefault(fields[0], len(name2slot))
+        for c, text in enumerate(fields[1:]):
+            text = text.strip()
+            if text in config.ANNOTATION_MISSING_VALUES or c in reread:
+                continue
+            # If a node is annotated more than once, later values win
+            if not set_value(cols[c], slot, text):
+                reread.append(c)
+
+    if len(reread) > 0:
+        for c in reread:
+            make_categorical(cols[c])
+        for fields in read_rows(filepath, len(header)):
+            slot = name2slot.get(fields[0])
+            if slot is None:
+                continue
+            for c in reread:
+                text = fields[c + 1].strip()
+                if text not in config.ANNOTATION_MISSING_VALUES:
+                    set_value(cols[c], slot, text)
+
+    return cols, num_rows, num_matched
+
+
+def write_annotation_tables(graph_data, annotation_files, output_dir):
+    """Joins annotation files to a graph and writes out side tables.
+
+    graph_data should be the output of AssemblyGraph.to_dict(), and
+    annotation_files should be a list of paths to annotation files. One side
+    table (see above) is written for every component that has at least one
+    annotated node.
+
+    Returns a 2-tuple of (info about the annotations, for the viewer; a list
+    of (number of rows, number of rows that matched nodes) for each file).
+    The info dict has the keys:
+
+    "dir": the directory containing the side tables, relative to the output
+        directory
+    "columns": a list with one dict per annotation column, in the order
+        they were given. Each of these has the keys "name" and "type"
+        (either "categorical" or "numeric"). Categorical columns also have a
+        "values" key (the distinct values in this column; side tables store
+        indices into this list), and numeric columns have "min" and "max"
+        keys.
+    "components": a list of the (0-indexed) indices of the components that
+        have side tables
+    """
+    name2nodes = get_name_index(graph_data)
+    name2slot = {}
+    col_names = []
+    cols = []
+    file_stats = []
+    for filepath in annotation_files:
+        file_cols, num_rows, num_matched = read_annotation_file(
+            filepath, name2nodes, name2slot, col_names
+        )
+        cols.extend(file_cols)
+        file_stats.append((num_rows, num_matched))
+
+    columns = [finish_column(col) for col in cols]
+
+    # Group the annotated nodes by component, remembering their slots
+    cmp2nodes = {}
+    for name, slot in name2slot.items():
+        for cmp_idx, node_id in name2nodes[name]:
+            cmp2nodes.setdefault(cmp_idx, []).append((node_id, slot))
+
+    annotations_dir = os.path.join(output_dir, config.ANNOTATIONS_DIR_NAME)
+    if len(cmp2nodes) > 0:
+        os.makedirs(annotations_dir, exist_ok=True)
+    for cmp_idx, nodes in cmp2nodes.items():
+        table_cols = {}
+        for col in cols:
+            values = [get_value(col, slot) for node_id, slot in nodes]
+            if all(v is None for v in values):
+                continue
+            table_cols[col["name"]] = values
+        table = {
+            "node_ids": [node_id for node_id, slot in nodes],
+            "cols": table_cols,
+        }
+        with open(
+            os.path.join(annotations_dir, "{}.js".format(cmp_idx + 1)), "w"
+        ) as f:
+            f.write("define(")
+            json.dump(table, f)
+            f.write(");\n")
+
+    info = {
+        "dir": config.ANNOTATIONS_DIR_NAME,
+        "columns": columns,
+        "components": sorted(cmp2nodes),
+    }
+    return info, file_stats
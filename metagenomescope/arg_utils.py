@@ -1,4 +1,5 @@
 import os
+from . import config
 
 
 def create_output_dir(output_dir):
@@ -43,3 +44,50 @@ def validate_max_counts(max_node_ct, max_edge_ct):
         raise ValueError("Maximum node count must be at least 1")
     if edgebad:
         raise ValueError("Maximum edge count must be at least 1")
+
+
+def validate_time_budget(time_budget):
+    if time_budget <= 0:
+        raise ValueError("Time budget must be positive")
+
+
+def validate_layout_workers(layout_workers):
+    if layout_workers < 1:
+        raise ValueError("Number of layout workers must be at least 1")
+
+
+def validate_decomposition_workers(decomposition_workers):
+    if decomposition_workers < 1:
+        raise ValueError("Number of decomposition workers must be at least 1")
+
+
+def validate_decomposition_limits(time_limit, max_calls, max_depth):
+    if time_limit is not None and time_limit <= 0:
+        raise ValueError("Decomposition time limit must be positive")
+    if max_calls is not None and max_calls < 1:
+        raise ValueError("Maximum decomposition calls must be at least 1")
+    if max_depth is not None and max_depth < 1:
+        raise ValueError("Maximum pattern depth must be at least 1")
+
+
+def get_max_counts(max_node_ct, max_edge_ct, time_budget, cost_model):
+    """Fills in -maxn / -maxe, if they weren't given (i.e. they're None).
+
+    If a time budget was given, then we use the layout cost model to pick
+    these: any component with more than this many nodes (or edges) is
+    predicted to take longer than the whole budget to lay out, even if we
+    degrade its layout, so there's no point trying. (Components smaller
+    than this might still get skipped, once we know more about them -- see
+    AssemblyGraph.apply_time_budget().) Otherwise, we just use the defaults.
+    """
+    auto_ct = None
+    if time_budget is not None:
+        auto_ct = cost_model.get_max_component_size(time_budget)
+        if auto_ct is not None:
+            # -maxn and -maxe have to be at least 1
+            auto_ct = max(auto_ct, 1)
+    if max_node_ct is None:
+        max_node_ct = config.MAXN_DEFAULT if auto_ct is None else auto_ct
+    if max_edge_ct is None:
+        max_edge_ct = config.MAXE_DEFAULT if auto_ct is None else auto_ct
+    return max_node_ct, max_edge_ct
@@ -37,12 +37,97 @@
 #  that maps to your new function.
 #
 #  3. Add tests for your parser in metagenomescope/tests/assembly_graph_parser/
+#
+# GRAPH "TARGETS"
+#
+# Each parse_() function also accepts an optional "digraph" argument. If this
+# is given, the parser will add nodes and edges to that object (using its
+# add_node() and add_edge() methods) instead of creating a new nx.DiGraph. This
+# is used in out-of-core mode, where we pass in a
+# disk_graph.DiskBackedGraph so that we never have to hold the entire graph in
+# memory. (The GML and FASTG parsers rely on other libraries that produce
+# a nx.DiGraph, so for those filetypes we just copy that DiGraph into the
+# target; only the LastGraph and GFA parsers avoid building the entire graph
+# in memory.)
+#
+# READING FROM STDIN / PIPES
+#
+# If the input filename is "-", we'll read the graph from stdin. Since we
+# can't sniff the filetype of stdin from its name, the filetype has to be
+# given explicitly in this case (see sniff_filetype()). All of the parsers
+# read through their input exactly once, without seeking, so named pipes and
+# things like /dev/fd/63 (from bash's process substitution) also work -- for
+# these, you'll also need to specify the filetype if the name doesn't end with
+# a supported extension.
+#
+# VALIDATION LEVELS
+#
+# Each parse_() function also accepts a "validation" argument, which should be
+# one of config.VALIDATION_LEVELS. This controls how paranoid we are about the
+# input graph: see the comments above these in config.py for details.
+#
+# ASSUMING THAT THE GRAPH IS ORIENTED
+#
+# By default, the GFA and LastGraph parsers add a reverse-complement "twin"
+# (named using input_node_utils.negate_node_id()) for every node and edge in
+# the file. Some graphs (e.g. scaffold graphs, or some long-read assembly
+# graphs) are already oriented, though, and for these the twins just double
+# the size of everything downstream. So these parsers also accept an
+# "assume_oriented" argument: if this is True, we only create one node per
+# sequence (named as in the file), and figure out its orientation from the
+# edges it's in. See orient_edge() for details. (The GML and FASTG parsers
+# ignore this argument, since MetaCarvel GML files are already oriented and
+# FASTG files declare both strands of each sequence explicitly.)
+#
+# KEEPING TRACK OF ATTRIBUTES
+#
+# When we create the graph ourselves, it's an AttrTrackingDiGraph: this just
+# remembers the names (and value types) of the attributes passed to
+# add_node() / add_edge(). AssemblyGraph uses this to figure out the "extra"
+# attributes in the graph (and check for reserved attributes) without going
+# back through every node and edge. DiskBackedGraph keeps track of the same
+# information in its columns.
 
+import os
+import sys
+import contextlib
 import networkx as nx
 import gfapy
 import pyfastg
+from . import config
 from .input_node_utils import gc_content, negate_node_id
 
+STDIN_FILENAME = "-"
+
+
+def is_stdin(filename):
+    """Returns True if filename refers to stdin, False otherwise."""
+    return filename == STDIN_FILENAME
+
+
+def get_basename(filename):
+    """Returns a name to use for the input file in MetagenomeScope's output.
+
+    This is just the basename of the file, unless we're reading from stdin.
+    """
+    if is_stdin(filename):
+        return "stdin"
+    return os.path.basename(filename)
+
+
+@contextlib.contextmanager
+def open_input(filename, binary=False):
+    """Opens an input file for reading, treating "-" as stdin.
+
+    We don't close stdin when we're done with it (if we did, then later
+    attempts to read from stdin would fail in confusing ways).
+    """
+    if is_stdin(filename):
+        yield sys.stdin.buffer if binary else sys.stdin
+    else:
+        with open(filename, "rb" if binary else "r") as f:
+            yield f
+
 
 def is_not_pos_int(number_string):
     """Returns False if a str represents a positive integer; True otherwise.
@@ -80,6 +165,11 @@ def is_not_pos_int(number_string):
 def validate_lastgraph_file(graph_file):
     """Attempts to verify that this LastGraph file seems "valid."
 
+    This just runs through all of validate_lastgraph_lines() without doing
+    anything with the lines. (parse_lastgraph() uses
+    validate_lastgraph_lines() directly, so that we can validate and parse the
+    file in a single pass -- see that function's docs for details.)
+
     Parameters
     ----------
     graph_file: io.TextIOBase
@@ -127,6 +217,36 @@ def validate_lastgraph_file(graph_file):
         Line C. [seq 2]
         Line D. [seq 3]
     """
+    for line in validate_lastgraph_lines(graph_file):
+        pass
+
+
+def validate_lastgraph_lines(graph_file, strict=True):
+    """Yields each line of a LastGraph file, after validating it.
+
+    If strict is False, we skip the checks that cross-check one part of the
+    file against another: the node count in the header, and the lengths of
+    node sequences (against $COV_SHORT1, and against each other). We still do
+    all of the structural checks (e.g. that NODE/ARC declarations have enough
+    fields, that node blocks aren't interrupted, and that there aren't any
+    duplicate node IDs / edges or arcs referring to unseen nodes), since
+    these are cheap and since a graph that fails them would break things
+    later on. This is what parse_lastgraph() uses for config.VALIDATION_FAST.
+
+    The checks done here are described in validate_lastgraph_file()'s
+    docstring. Each line is checked before it's yielded, so code consuming
+    these lines can assume that each line it sees is ok (at least as far as
+    the lines before it are concerned). Checks that can only be done after
+    seeing the entire file (e.g. that the number of nodes matches the header)
+    are done after the last line is yielded -- so if you're building up a
+    graph from these lines, you should just throw it away if this raises an
+    error.
+
+    This lets us validate and parse a LastGraph file in a single pass through
+    it, which is nice both for speed and because it means we can parse
+    LastGraph files from stdin / pipes (which we can't seek back to the start
+    of).
+    """
     header_num_nodes = 0
     num_nodes = 0
     in_node_block = False
@@ -134,10 +254,12 @@ def validate_lastgraph_file(graph_file):
     curr_node_fwdseq = None
     curr_node_length = 0
     line_num = 1
-    seen_nodes = []
-    seen_edges = []
+    # These were lists in the past, which made validation quadratic-time in
+    # the number of nodes/edges.
+    seen_nodes = set()
+    seen_edges = set()
     for line in graph_file:
-        if line_num == 1:
+        if line_num == 1 and strict:
             header_num_nodes_str = line.split()[0]
             if is_not_pos_int(header_num_nodes_str):
                 raise ValueError(
@@ -196,10 +318,10 @@ def validate_lastgraph_file(graph_file):
                     "a positive integer.".format(line_num)
                 )
             for node_id in split_line[1:3]:
-                # For reference, split_line[1:3] just gives you all the stuff
-                # in the range [1, 3) (i.e. the second and third elements of
-                # split_line, referring to the source and target node of this
-                # edge)
+                # For reference, split_line[1:3] just gives you all the
+                # stuff in the range [1, 3) (i.e. the second and third
+                # elements of split_line, referring to the source and
+                # target node of this edge)
                 if node_id not in seen_nodes:
                     raise ValueError(
                         "Line {}: Unseen node {} referred to in an "
@@ -210,26 +332,28 @@ def validate_lastgraph_file(graph_file):
                 negate_node_id(split_line[2]),
                 negate_node_id(split_line[1]),
             )
-            # If rev_ids is in seen_edges, then so is fwd_ids. No need to check
-            # both here.
+            # If rev_ids is in seen_edges, then so is fwd_ids. No need to
+            # check both here.
             if fwd_ids in seen_edges:
                 raise ValueError(
-                    "Line {}: Edge from {} to {} somehow declared multiple "
-                    "times.".format(line_num, split_line[1], split_line[2])
+                    "Line {}: Edge from {} to {} somehow declared "
+                    "multiple times.".format(
+                        line_num, split_line[1], split_line[2]
+                    )
                 )
-            seen_edges.append(fwd_ids)
-            seen_edges.append(rev_ids)
+            seen_edges.add(fwd_ids)
+            seen_edges.add(rev_ids)
         elif in_node_block:
             if curr_node_fwdseq is None:
                 curr_node_fwdseq = line.strip()
-                if curr_node_length != len(curr_node_fwdseq):
+                if strict and curr_node_length != len(curr_node_fwdseq):
                     raise ValueError(
                         "Line {}: Node sequence length doesn't match "
                         "$COV_SHORT1.".format(line_num)
                     )
             else:
                 # The current line is the reverse sequence of this node.
-                if len(curr_node_fwdseq) != len(line.strip()):
+                if strict and len(curr_node_fwdseq) != len(line.strip()):
                     raise ValueError(
                         "Line {}: Node sequences have unequal "
                         "lengths.".format(line_num)
@@ -237,21 +361,22 @@ def validate_lastgraph_file(graph_file):
                 # If we've made it here, we've seen all there is to see
                 # about the current node block. We can say that this node
                 # is tentatively valid (and we can add it to seen_nodes).
-                seen_nodes.append(curr_node_id)
-                seen_nodes.append(negate_node_id(curr_node_id))
+                seen_nodes.add(curr_node_id)
+                seen_nodes.add(negate_node_id(curr_node_id))
 
                 # Reset various flag variables
                 in_node_block = False
                 curr_node_id = None
                 curr_node_length = 0
                 curr_node_fwdseq = None
+        yield line
         line_num += 1
     # If we finished reading the file while we were *still* in a node
     # block, then that means that the file ended before a given node's
     # declaration did. That's a problem!
     if in_node_block:
         raise ValueError("Node block ended too early at end-of-file.")
-    if len(seen_nodes) != (header_num_nodes * 2):
+    if strict and len(seen_nodes) != (header_num_nodes * 2):
         # seen_nodes should always be divisible by 2 (since every time we
         # record a node we add it and its complement), so dividing
         # len(seen_nodes) by 2 is ok
@@ -263,13 +388,17 @@ def validate_lastgraph_file(graph_file):
         )
 
 
-def validate_nx_digraph(g, required_node_fields, required_edge_fields):
+def validate_nx_digraph_structure(g):
     # Verify that the graph is directed and doesn't have duplicate edges
     if not g.is_directed():
         raise ValueError("The input graph should be directed.")
     if g.is_multigraph():
         raise ValueError("Multigraphs are unsupported in MetagenomeScope.")
 
+
+def validate_nx_digraph(g, required_node_fields, required_edge_fields):
+    validate_nx_digraph_structure(g)
+
     # Verify that all nodes have the properties we expect nodes to have
     num_nodes = len(g.nodes)
     for required_field in required_node_fields:
@@ -293,9 +422,89 @@ def validate_nx_digraph(g, required_node_fields, required_edge_fields):
             )
 
 
-def parse_metacarvel_gml(filename):
+def record_attr_types(attr_types, attrs):
+    """Updates attr_types (attribute name -> set of value types) with attrs.
+
+    None values don't count towards an attribute's types, but they still
+    mean that the attribute is present.
+    """
+    for name, value in attrs.items():
+        if name not in attr_types:
+            attr_types[name] = set()
+        if value is not None:
+            attr_types[name].add(type(value))
+
+
+class AttrTrackingDiGraph(nx.DiGraph):
+    """A nx.DiGraph that remembers the attributes of its nodes and edges.
+
+    node_attr_types and edge_attr_types map each attribute name passed to
+    add_node() / add_edge() to the set of types of its (non-None) values.
+
+    Only add_node() and add_edge() are tracked -- that's all the parsers
+    use, but NetworkX's other ways of adding stuff (add_nodes_from(),
+    relabelling, ...) aren't. So this info is only good right after parsing.
+    """
+
+    def __init__(self, incoming_graph_data=None, **attr):
+        self.node_attr_types = {}
+        self.edge_attr_types = {}
+        super().__init__(incoming_graph_data, **attr)
+
+    def add_node(self, node_for_adding, **attr):
+        record_attr_types(self.node_attr_types, attr)
+        super().add_node(node_for_adding, **attr)
+
+    def add_edge(self, u_of_edge, v_of_edge, **attr):
+        record_attr_types(self.edge_attr_types, attr)
+        super().add_edge(u_of_edge, v_of_edge, **attr)
+
+
+def get_attr_types(digraph):
+    """Returns the node and edge attributes in a parsed graph.
+
+    The output is a 2-tuple of dicts (for nodes and edges), each mapping
+    attribute names to sets of value types (see record_attr_types()). For
+    an AttrTrackingDiGraph we already know this; for any other nx.DiGraph,
+    we have to go through every node and edge.
+    """
+    if isinstance(digraph, AttrTrackingDiGraph):
+        return digraph.node_attr_types, digraph.edge_attr_types
+    node_attr_types = {}
+    edge_attr_types = {}
+    for _, data in digraph.nodes(data=True):
+        record_attr_types(node_attr_types, data)
+    for _, _, data in digraph.edges(data=True):
+        record_attr_types(edge_attr_types, data)
+    return node_attr_types, edge_attr_types
+
+
+def _copy_into(g, digraph):
+    """Copies the nodes and edges of a nx.DiGraph into a graph "target."
+
+    If digraph is None, we copy g into a new AttrTrackingDiGraph (so that we
+    know what attributes it has). Returns digraph.
+    """
+    if digraph is None:
+        digraph = AttrTrackingDiGraph()
+    for n in g.nodes:
+        digraph.add_node(n, **g.nodes[n])
+    for e in g.edges:
+        digraph.add_edge(e[0], e[1], **g.edges[e])
+    return digraph
+
+
+def parse_metacarvel_gml(
+    filename,
+    digraph=None,
+    validation=config.VALIDATION_DEFAULT,
+    assume_oriented=False,
+):
     """Returns a nx.DiGraph representation of a GML (MetaCarvel output) file.
 
+    (assume_oriented is ignored, since MetaCarvel graphs are already
+    oriented.)
+
     Unlike, say, LastGraph, the GML file spec isn't inherently tied to
     MetaCarvel (it's used by lots of different programs). However, we make the
     simplifying assumption that -- if you're trying to load in a GML file
@@ -307,47 +516,67 @@ def parse_metacarvel_gml(filename):
     effort in this function is just spent validating that the nx.DiGraph
     produced follows the format we expect (i.e. has all the metadata we
     anticipate MetaCarvel output graphs having).
+
+    With config.VALIDATION_FAST, we skip the up-front scans (one per
+    attribute) checking that every node/edge has all of the attributes we
+    expect -- but we still check that the graph is directed (and not a
+    multigraph), and still check each node's and edge's attributes as we go
+    through them, so a missing attribute will still be caught there. With
+    config.VALIDATION_NONE, we don't check anything.
     """
-    g = nx.gml.read_gml(filename)
+    with open_input(filename, binary=True) as graph_file:
+        g = nx.gml.read_gml(graph_file)
 
-    validate_nx_digraph(
-        g,
-        ("orientation", "length"),
-        ("orientation", "mean", "stdev", "bsize"),
-    )
+    strict = validation == config.VALIDATION_STRICT
+    if strict:
+        validate_nx_digraph(
+            g,
+            ("orientation", "length"),
+            ("orientation", "mean", "stdev", "bsize"),
+        )
+    elif validation == config.VALIDATION_FAST:
+        validate_nx_digraph_structure(g)
 
     # Verify that node attributes are good. Also, change orientations from FOW
     # and REV to + and -, to standardize this across filetypes, and convert
     # lengths from strings to integers.
     for n in g.nodes:
-        orientation = g.nodes[n]["orientation"]
-        if type(orientation) != str or orientation not in ("FOW", "REV"):
+        orientation = g.nodes[n].get("orientation")
+        if validation != config.VALIDATION_NONE and (
+            type(orientation) != str or orientation not in ("FOW", "REV")
+        ):
             raise ValueError(
                 'Node {} has unsupported orientation "{}". Should be either '
                 '"FOW" or "REV".'.format(n, orientation)
             )
-        if is_not_pos_int(g.nodes[n]["length"]):
+        if validation != config.VALIDATION_NONE and is_not_pos_int(
+            g.nodes[n].get("length")
+        ):
             raise ValueError(
                 'Node {} has non-positive-integer length "{}".'.format(
-                    n, g.nodes[n]["length"]
+                    n, g.nodes[n].get("length")
                 )
             )
         g.nodes[n]["orientation"] = "+" if orientation == "FOW" else "-"
         g.nodes[n]["length"] = int(g.nodes[n]["length"])
 
-    # Verify that edge attributes are good
+    if validation == config.VALIDATION_NONE:
+        return _copy_into(g, digraph)
+
+    # Verify that edge attributes are good. (We use .get() here, since with
+    # config.VALIDATION_FAST we haven't checked that these are all present.)
     for e in g.edges:
-        if g.edges[e]["orientation"] not in ("EE", "EB", "BE", "BB"):
+        if g.edges[e].get("orientation") not in ("EE", "EB", "BE", "BB"):
             raise ValueError(
                 'Edge {} has unsupported orientation "{}". Should be one of '
                 '"EE", "EB", "BE", or "BB".'.format(
-                    e, g.edges[e]["orientation"]
+                    e, g.edges[e].get("orientation")
                 )
             )
-        if is_not_pos_int(g.edges[e]["bsize"]):
+        if is_not_pos_int(g.edges[e].get("bsize")):
             raise ValueError(
                 'Edge {} has non-positive-integer bsize "{}".'.format(
-                    e, g.edges[e]["bsize"]
+                    e, g.edges[e].get("bsize")
                 )
             )
         # NOTE: Yeah, this technically allows for NaN/Infinity values to pass
@@ -362,90 +591,305 @@ def parse_metacarvel_gml(filename):
         # "infinity" stdev just explode everything
         for field in ("mean", "stdev"):
             try:
-                float(g.edges[e][field])
+                float(g.edges[e].get(field))
             except Exception:
                 # Rationale for using except Exception is analogous to what's
                 # discussed in this comment thread:
                 # https://github.com/biocore/LabControl/pull/585#discussion_r323413268
                 raise ValueError(
                     'Edge {} has non-numeric {} "{}".'.format(
-                        e, field, g.edges[e][field]
+                        e, field, g.edges[e].get(field)
                     )
                 )
 
-    return g  # , ("orientation",), ("bsize", "orientation", "mean", "stdev")
+    # , ("orientation",), ("bsize", "orientation", "mean", "stdev")
+    return _copy_into(g, digraph)
+
+
+def orient_edge(
+    src, src_orient, tgt, tgt_orient, node2orientation, check=True
+):
+    """Figures out what to do with an edge when assuming the graph's oriented.
+
+    src_orient and tgt_orient should each be "+" or "-", describing which
+    strand of src and tgt this edge is incident on. Since we only have one
+    node for each sequence in this case, we use these to decide what each
+    node's orientation is:
+
+    - If both are "-", then this is just the reverse complement of an edge
+      from tgt+ to src+, so we flip it around.
+    - Otherwise, the src node gets orientation src_orient, and the tgt node
+      gets orientation tgt_orient.
+
+    node2orientation should be a dict mapping node names to orientations
+    seen so far: we'll update it with the orientations of src and tgt. If
+    check is True and one of these nodes was previously seen with the
+    opposite orientation, then the graph isn't consistently oriented (the
+    same sequence is used in both directions), so we raise a ValueError.
+
+    Returns a 2-tuple of (src, tgt) for the edge to add to the graph.
+    """
+    if src_orient == "-" and tgt_orient == "-":
+        src, tgt = tgt, src
+        src_orient = tgt_orient = "+"
+    for node, orientation in ((src, src_orient), (tgt, tgt_orient)):
+        prev_orientation = node2orientation.setdefault(node, orientation)
+        if check and prev_orientation != orientation:
+            raise ValueError(
+                "Node {} is used in both orientations, so the graph doesn't "
+                "seem to be oriented. Try again without "
+                "--assume-oriented.".format(node)
+            )
+    return src, tgt
+
+
+def add_gfa_segment(digraph, node, check_nodes, orientation=None):
+    """Adds a GFA segment (a gfapy line object) to a graph as node(s).
+
+    If orientation is None, we add both a positive and a negative node for
+    this segment; otherwise, we just add a single node with this orientation
+    (see the comments at the top of this file about assuming that the graph
+    is oriented).
+    """
+    if check_nodes and node.length is None:
+        raise ValueError(
+            "Found a node without a specified length: {}".format(node.name)
+        )
+    if check_nodes and node.name[0] == "-":
+        raise ValueError(
+            "Node IDs in the input assembly graph cannot "
+            'start with the "-" character.'
+        )
+    sequence_gc = None
+    if not gfapy.is_placeholder(node.sequence):
+        sequence_gc = gc_content(node.sequence)[0]
+    if orientation is not None:
+        digraph.add_node(
+            node.name,
+            length=node.length,
+            gc_content=sequence_gc,
+            orientation=orientation,
+        )
+        return
+    # Add both a positive and negative node.
+    digraph.add_node(
+        node.name,
+        length=node.length,
+        gc_content=sequence_gc,
+        orientation="+",
+    )
+    digraph.add_node(
+        negate_node_id(node.name),
+        length=node.length,
+        gc_content=sequence_gc,
+        orientation="-",
+    )
+
+
+def add_gfa_edge(digraph, edge):
+    """Adds a GFA edge (a gfapy line object) and its complement to a graph."""
+    # Set edge_tuple to the edge's explicitly specified orientation
+    # This code is a bit verbose, but that was the easiest way to write it
+    # I could think of
+    if edge.from_orient == "-":
+        src_id = negate_node_id(edge.from_name)
+    else:
+        src_id = edge.from_name
+    if edge.to_orient == "-":
+        tgt_id = negate_node_id(edge.to_name)
+    else:
+        tgt_id = edge.to_name
+    edge_tuple = (src_id, tgt_id)
+    digraph.add_edge(*edge_tuple)
+
+    # Now, try to add the complement of the edge (done manually, since
+    # .complement() isn't available for GFA2 edges as of writing)
+    complement_tuple = (negate_node_id(tgt_id), negate_node_id(src_id))
+
+    # Don't add an edge twice if its complement is itself (as in the
+    # loop.gfa test case)
+    if complement_tuple != edge_tuple:
+        digraph.add_edge(*complement_tuple)
+
+
+def stream_gfa(filename, digraph, validation, assume_oriented):
+    """Adds the segments and edges in a GFA file to a graph "target."
+
+    This is what parse_gfa() uses when it's given a graph target (e.g. a
+    DiskBackedGraph in out-of-core mode). Unlike gfapy.Gfa.from_file(), this
+    never holds more than one line of the file in memory: we parse each
+    line on its own using gfapy.Line, add it to the target, and then forget
+    about it.
+
+    The catch is that gfapy can't do any checks that involve multiple lines
+    (since it never sees the whole graph). With config.VALIDATION_STRICT, we
+    do the one such check that matters to us ourselves: that every segment
+    referred to by an edge is declared somewhere in the file. This means
+    remembering the names of every segment, but the target already has to
+    do that anyway.
+    """
+    vlevel = 1 if validation == config.VALIDATION_STRICT else 0
+    check_nodes = validation != config.VALIDATION_NONE
+    strict = validation == config.VALIDATION_STRICT
+    declared = set()
+    referenced = set()
+    # gfapy can usually guess the version from a line by itself, but the
+    # header (if present) tells us for sure
+    version = None
+    node2orientation = {}
+    with open_input(filename) as graph_file:
+        for line in graph_file:
+            line = line.rstrip("\r\n")
+            if len(line) == 0 or line[0] not in "HSLCE":
+                continue
+            gline = gfapy.Line(line, vlevel=vlevel, version=version)
+            if gline.record_type == "H":
+                vn = gline.get("VN")
+                if vn is not None:
+                    version = "gfa2" if str(vn).startswith("2") else "gfa1"
+            elif gline.record_type == "S":
+                if strict:
+                    declared.add(gline.name)
+                orientation = None
+                if assume_oriented:
+                    orientation = node2orientation.get(gline.name, "+")
+                add_gfa_segment(digraph, gline, check_nodes, orientation)
+            else:
+                if strict:
+                    referenced.add(gline.from_name)
+                    referenced.add(gline.to_name)
+                if assume_oriented:
+                    digraph.add_edge(
+                        *orient_edge(
+                            gline.from_name,
+                            gline.from_orient,
+                            gline.to_name,
+                            gline.to_orient,
+                            node2orientation,
+                            check_nodes,
+                        )
+                    )
+                else:
+                    add_gfa_edge(digraph, gline)
+    if strict:
+        undeclared = referenced - declared
+        if len(undeclared) > 0:
+            raise ValueError(
+                "Edge(s) refer to segment {}, which isn't declared in the "
+                "file.".format(min(undeclared))
+            )
+    if assume_oriented:
+        # A segment declared before any of its edges got added with a "+"
+        # orientation, since we didn't know any better at the time. Fix that
+        # now. (Updating a node's attributes like this is fine for all of the
+        # targets we use.)
+        for name, orientation in node2orientation.items():
+            if orientation == "-":
+                digraph.add_node(name, orientation="-")
+    return digraph
 
 
-def parse_gfa(filename):
+def parse_gfa(
+    filename,
+    digraph=None,
+    validation=config.VALIDATION_DEFAULT,
+    assume_oriented=False,
+):
     """Returns a nx.DiGraph representation of a GFA1 or GFA2 file.
 
     NOTE that, at present, we only visualize nodes and edges in the GFA graph.
     A TODO is displaying all or most of the relevant information in these
     graphs, like GfaViz does: see
     https://github.com/marbl/MetagenomeScope/issues/147 for discussion of this.
+
+    With config.VALIDATION_FAST or config.VALIDATION_NONE, we turn off
+    gfapy's validation (vlevel=0). We still check that each node has a
+    length and a valid name with config.VALIDATION_FAST, since that's cheap
+    to do while we're adding nodes to the graph.
+
+    If assume_oriented is True, then we won't add reverse-complement nodes or
+    edges (see the comments at the top of this file).
+
+    If digraph is given, then we read through the file line by line instead
+    of loading all of it into a gfapy.Gfa object first: see stream_gfa().
     """
-    digraph = nx.DiGraph()
-    gfa_graph = gfapy.Gfa.from_file(filename)
+    if digraph is not None:
+        return stream_gfa(filename, digraph, validation, assume_oriented)
+    digraph = AttrTrackingDiGraph()
+    vlevel = 1 if validation == config.VALIDATION_STRICT else 0
+    if is_stdin(filename):
+        # Add lines one at a time as we read them, rather than building up a
+        # list of every line in the file first. This is basically what
+        # Gfa.from_file() does.
+        gfa_graph = gfapy.Gfa(vlevel=vlevel)
+        with open_input(filename) as graph_file:
+            for line in graph_file:
+                gfa_graph.add_line(line.rstrip("\r\n"))
+        # Until gfapy figures out the GFA version (e.g. from an H line's VN
+        # tag), it holds lines back in a queue instead of adding them. So if
+        # the file doesn't have a header, we need to flush this queue
+        # ourselves (from_file() does this at the end, too).
+        gfa_graph.process_line_queue()
+        if vlevel > 0:
+            gfa_graph.validate()
+    else:
+        # Gfa.from_file() reads through the file once, so this is fine for
+        # named pipes
+        gfa_graph = gfapy.Gfa.from_file(filename, vlevel=vlevel)
+
+    check_nodes = validation != config.VALIDATION_NONE
+
+    if assume_oriented:
+        # We need to know each node's orientation before we add it, so go
+        # through the edges first
+        node2orientation = {}
+        edge_tuples = [
+            orient_edge(
+                edge.from_name,
+                edge.from_orient,
+                edge.to_name,
+                edge.to_orient,
+                node2orientation,
+                check_nodes,
+            )
+            for edge in gfa_graph.edges
+        ]
 
     # Add nodes ("segments") to the DiGraph
     for node in gfa_graph.segments:
-        if node.length is None:
-            raise ValueError(
-                "Found a node without a specified length: "
-                "{}".format(node.name)
-            )
-        if node.name[0] == "-":
-            raise ValueError(
-                "Node IDs in the input assembly graph cannot "
-                'start with the "-" character.'
-            )
-        sequence_gc = None
-        if not gfapy.is_placeholder(node.sequence):
-            sequence_gc = gc_content(node.sequence)[0]
-        # Add both a positive and negative node.
-        digraph.add_node(
-            node.name,
-            length=node.length,
-            gc_content=sequence_gc,
-            orientation="+",
-        )
-        digraph.add_node(
-            negate_node_id(node.name),
-            length=node.length,
-            gc_content=sequence_gc,
-            orientation="-",
-        )
+        orientation = None
+        if assume_oriented:
+            orientation = node2orientation.get(node.name, "+")
+        add_gfa_segment(digraph, node, check_nodes, orientation)
+
+    if assume_oriented:
+        for edge_tuple in edge_tuples:
+            digraph.add_edge(*edge_tuple)
+        return digraph
 
     # Now, add edges to the DiGraph
     for edge in gfa_graph.edges:
-        # Set edge_tuple to the edge's explicitly specified orientation
-        # This code is a bit verbose, but that was the easiest way to write it
-        # I could think of
-        if edge.from_orient == "-":
-            src_id = negate_node_id(edge.from_name)
-        else:
-            src_id = edge.from_name
-        if edge.to_orient == "-":
-            tgt_id = negate_node_id(edge.to_name)
-        else:
-            tgt_id = edge.to_name
-        edge_tuple = (src_id, tgt_id)
-        digraph.add_edge(*edge_tuple)
-
-        # Now, try to add the complement of the edge (done manually, since
-        # .complement() isn't available for GFA2 edges as of writing)
-        complement_tuple = (negate_node_id(tgt_id), negate_node_id(src_id))
-
-        # Don't add an edge twice if its complement is itself (as in the
-        # loop.gfa test case)
-        if complement_tuple != edge_tuple:
-            digraph.add_edge(*complement_tuple)
+        add_gfa_edge(digraph, edge)
     return digraph
 
 
-def parse_fastg(filename):
+def parse_fastg(
+    filename,
+    digraph=None,
+    validation=config.VALIDATION_DEFAULT,
+    assume_oriented=False,
+):
+    # (assume_oriented is ignored: FASTG files already declare both strands
+    # of each sequence as separate nodes.)
+    # pyfastg only accepts filenames, but it just reads through the file once
+    # -- so we can give it /dev/stdin if we're reading from stdin.
+    if is_stdin(filename):
+        filename = "/dev/stdin"
     g = pyfastg.parse_fastg(filename)
-    validate_nx_digraph(g, ("length", "cov", "gc"), ())
+    if validation == config.VALIDATION_STRICT:
+        validate_nx_digraph(g, ("length", "cov", "gc"), ())
+    elif validation == config.VALIDATION_FAST:
+        validate_nx_digraph_structure(g)
     # Add an "orientation" attribute for every node.
     # pyfastg guarantees that every node should have a +/- suffix assigned to
     # its name, so this should be safe.
@@ -462,10 +906,38 @@ def parse_fastg(filename):
                     "orientation?"
                 ).format(n)
             )
-    return g
+    return _copy_into(g, digraph)
+
+
+def add_oriented_lastgraph_arc(
+    digraph, line_contents, node2orientation, check
+):
+    """Adds an ARC from a LastGraph file when assuming the graph's oriented.
+
+    line_contents should be the split ARC line. In LastGraph files, a
+    negative node ID in an ARC line refers to the reverse complement of that
+    node; we use orient_edge() to figure out what edge to add, and then
+    update the orientations of the nodes involved if needed.
+    """
+    ends = []
+    for node_id in line_contents[1:3]:
+        if node_id[0] == "-":
+            ends.extend((node_id[1:], "-"))
+        else:
+            ends.extend((node_id, "+"))
+    src, tgt = orient_edge(*ends, node2orientation, check)
+    digraph.add_edge(src, tgt, multiplicity=int(line_contents[3]))
+    for node in (src, tgt):
+        if node2orientation[node] == "-":
+            digraph.add_node(node, orientation="-")
 
 
-def parse_lastgraph(filename):
+def parse_lastgraph(
+    filename,
+    digraph=None,
+    validation=config.VALIDATION_DEFAULT,
+    assume_oriented=False,
+):
     """Returns a nx.DiGraph representation of a LastGraph (Velvet) file.
 
     As far as I'm aware, there isn't a standard LastGraph parser available
@@ -477,6 +949,18 @@ def parse_lastgraph(filename):
     Fun fact: this parser was the first part of MetagenomeScope I ever
     wrote! (I've updated the code since to be a bit less sloppy.)
 
+    With config.VALIDATION_FAST, we only do the validation checks that don't
+    require remembering anything about previous lines (see
+    validate_lastgraph_lines()). With config.VALIDATION_NONE, we don't
+    validate the file at all -- so if it's malformed, this might fail in
+    weird ways (or produce a weird graph).
+
+    If assume_oriented is True, then we won't add reverse-complement nodes or
+    edges (see the comments at the top of this file). Since NODE declarations
+    come before ARC declarations in LastGraph files, we add each node with
+    a "+" orientation and then update this if an ARC uses the node's "-"
+    strand.
+
     References
     ----------
     https://www.ebi.ac.uk/~zerbino/velvet/Manual.pdf
@@ -488,16 +972,15 @@ def parse_lastgraph(filename):
         as $O_COV_SHORT_1 / $COV_SHORT_1) was primarily based on chucking
         LastGraph files into Bandage and seeing how it handled them.
     """
-    with open(filename, "r") as graph_file:
-        validate_lastgraph_file(graph_file)
-        # If validate_lastgraph_file() succeeded, we shouldn't have any
-        # problems parsing this assembly graph.
-
-        # Now, go back to the start of the file so we can actually *parse* it
-        # this time, instead of just checking it for correctness.
-        # CODELINK: https://stackoverflow.com/a/2106825/10730311
-        graph_file.seek(0)
-        digraph = nx.DiGraph()
+    with open_input(filename) as graph_file:
+        # We used to run validate_lastgraph_file() on the whole file, then
+        # seek back to the start of the file and parse it. Now we validate
+        # each line right before parsing it, so we only need one pass through
+        # the file (and can thus read from stdin / pipes). If the file is
+        # invalid, validate_lastgraph_lines() will raise an error at some
+        # point and we'll never return the partially-built digraph.
+        if digraph is None:
+            digraph = AttrTrackingDiGraph()
         parsing_node = False
         parsed_fwdseq = False
         curr_node_attrs = {
@@ -507,7 +990,14 @@ def parse_lastgraph(filename):
             "fwdseq": None,
             "revseq": None,
         }
-        for line in graph_file:
+        node2orientation = {}
+        if validation == config.VALIDATION_NONE:
+            lines = graph_file
+        else:
+            lines = validate_lastgraph_lines(
+                graph_file, strict=(validation == config.VALIDATION_STRICT)
+            )
+        for line in lines:
             if line.startswith("NODE"):
                 parsing_node = True
                 line_contents = line.split()
@@ -522,6 +1012,14 @@ def parse_lastgraph(filename):
                 )
             elif line.startswith("ARC"):
                 line_contents = line.split()
+                if assume_oriented:
+                    add_oriented_lastgraph_arc(
+                        digraph,
+                        line_contents,
+                        node2orientation,
+                        validation != config.VALIDATION_NONE,
+                    )
+                    continue
                 id1, id2 = line_contents[1], line_contents[2]
                 nid1 = negate_node_id(line_contents[1])
                 nid2 = negate_node_id(line_contents[2])
@@ -550,13 +1048,16 @@ def parse_lastgraph(filename):
                 else:
                     curr_node_attrs["revseq"] = line.strip()
                     # Now we can add a node for the "negative" node.
-                    digraph.add_node(
-                        negate_node_id(curr_node_attrs["id"]),
-                        length=curr_node_attrs["length"],
-                        depth=curr_node_attrs["depth"],
-                        gc_content=gc_content(curr_node_attrs["revseq"])[0],
-                        orientation="-",
-                    )
+                    # (... Unless we're assuming the graph's oriented.)
+                    if not assume_oriented:
+                        rev_gc = gc_content(curr_node_attrs["revseq"])[0]
+                        digraph.add_node(
+                            negate_node_id(curr_node_attrs["id"]),
+                            length=curr_node_attrs["length"],
+                            depth=curr_node_attrs["depth"],
+                            gc_content=rev_gc,
+                            orientation="-",
+                        )
                     # At this point, we're done with parsing this node.
                     # Clear our temporary variables for later use if
                     # parsing other nodes.
@@ -579,18 +1080,46 @@ SUPPORTED_FILETYPE_TO_PARSER = {
     "fastg": parse_fastg,
 }
 
+# Filetypes for which each sequence in the input file is represented by two
+# nodes in the parsed graph (one for the sequence and one for its reverse
+# complement). Useful if you want to count each sequence only once: in these
+# graphs, the "+" oriented node is the one that was actually declared in the
+# file.
+FILETYPES_WITH_RC_NODES = ("lastgraph", "gfa", "fastg")
 
-def sniff_filetype(filename):
+
+def sniff_filetype(filename, input_format=None):
     """Attempts to determine the filetype of the file specified by a filename.
 
-    Currently, this just returns the extension of the filename (after
+    If input_format is not None, we'll just use that as the filetype (after
+    checking that it's supported, and converting it to lowercase). This is
+    required if we're reading from stdin, since there's no extension to look
+    at.
+
+    Otherwise, this just returns the extension of the filename (after
     converting the filename to lowercase). If the extension isn't one of
     "lastgraph", "gfa", "fastg", or "gml", this throws a
     NotImplementedError.
 
     It might be worth extending this in the future to try sniffing via a
     more sophisticated method, but this seems fine for the time being.
+    (Sniffing the contents of the file would mean reading from it twice,
+    which we can't do with stdin or pipes -- so the extension it is.)
     """
+    if input_format is not None:
+        if input_format.lower() in SUPPORTED_FILETYPE_TO_PARSER:
+            return input_format.lower()
+        raise NotImplementedError(
+            "The input format ({}) isn't one of the following supported "
+            "filetypes: {}.".format(
+                input_format, tuple(SUPPORTED_FILETYPE_TO_PARSER.keys())
+            )
+        )
+    if is_stdin(filename):
+        raise ValueError(
+            "When reading an assembly graph from stdin, you need to specify "
+            "its filetype using --input-format."
+        )
     lowercase_fn = filename.lower()
     for suffix in SUPPORTED_FILETYPE_TO_PARSER:
         if lowercase_fn.endswith(suffix):
@@ -598,12 +1127,45 @@ def sniff_filetype(filename):
     raise NotImplementedError(
         "The input filename ({}) doesn't end with one of the following "
         "supported filetypes: {}. Please provide an assembly graph that "
-        "follows one of these filetypes and is named accordingly.".format(
+        "follows one of these filetypes and is named accordingly, or "
+        "specify its filetype using --input-format.".format(
             filename, tuple(SUPPORTED_FILETYPE_TO_PARSER.keys())
         )
     )
 
 
-def parse(filename):
-    filetype = sniff_filetype(filename)
-    return SUPPORTED_FILETYPE_TO_PARSER[filetype](filename)
+def check_validation_level(validation):
+    if validation not in config.VALIDATION_LEVELS:
+        raise ValueError(
+            "Unrecognized validation level {}. Should be one of {}.".format(
+                validation, config.VALIDATION_LEVELS
+            )
+        )
+
+
+def parse(
+    filename,
+    digraph=None,
+    input_format=None,
+    validation=config.VALIDATION_DEFAULT,
+    assume_oriented=False,
+):
+    check_validation_level(validation)
+    filetype = sniff_filetype(filename, input_format)
+    return SUPPORTED_FILETYPE_TO_PARSER[filetype](
+        filename,
+        digraph=digraph,
+        validation=validation,
+        assume_oriented=assume_oriented,
+    )
+
+
+def has_rc_nodes(filetype, assume_oriented=False):
+    """Returns True if each sequence is represented by two nodes.
+
+    See FILETYPES_WITH_RC_NODES. If assume_oriented is True, then only FASTG
+    files will have two nodes per sequence.
+    """
+    if assume_oriented:
+        return filetype == "fastg"
+    return filetype in FILETYPES_WITH_RC_NODES
@@ -0,0 +1,146 @@
+# Copyright (C) 2016-- Marcus Fedarko, Jay Ghurye, Todd Treangen, Mihai Pop
+# Authored by Marcus Fedarko
+#
+# This file is part of MetagenomeScope.
+#
+# MetagenomeScope is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# MetagenomeScope is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with MetagenomeScope.  If not, see <http://www.gnu.org/licenses/>.
+####
+# Splitting "extra" node / edge attributes out of the viewer's graph data.
+#
+# AssemblyGraph.to_dict() puts every attribute of every element (including
+# extra attributes from the input file, like GC content, depth,
+# multiplicity, ...) into that element's data list. The viewer only needs
+# the extra attributes once something is selected, so (rather than making
+# every visualization load all of these up front) we move them into one
+# small "side table" per component, saved as
+# ATTR_TABLES_DIR_NAME/N.js in the output directory. The viewer loads a
+# component's side table the first time it needs it.
+#
+# Side tables are columnar: each one looks like
+#
+# {
+#     "node_ids": [node ID, ...],
+#     "node_cols": {extra node attr: [value for each node ID], ...},
+#     "edge_ids": [[source ID, target ID], ...],
+#     "edge_cols": {extra edge attr: [value for each edge], ...},
+# }
+#
+# Like data.js, these are saved as RequireJS modules so that they can be
+# loaded from file:// URLs.
+
+import os
+import json
+from . import config
+
+
+def get_core_attrs(attrs, extra_attrs):
+    """Returns info about the non-extra attributes of a kind of element.
+
+    attrs should map field names to positions in a data list (e.g.
+    graph_data["node_attrs"]); extra_attrs should be a collection of the
+    extra field names.
+
+    Returns a 2-tuple of (new attrs dict, the old positions of each field in
+    the new data lists). Fields keep their relative order.
+    """
+    extra_attrs = set(extra_attrs)
+    keep = sorted(i for f, i in attrs.items() if f not in extra_attrs)
+    old2new = {old: new for new, old in enumerate(keep)}
+    new_attrs = {f: old2new[i] for f, i in attrs.items() if i in old2new}
+    return new_attrs, keep
+
+
+def get_component_attr_table(comp, na, ea, extra_node_attrs, extra_edge_attrs):
+    """Returns the side table (see above) for a single component."""
+    node_ids = list(comp["nodes"].keys())
+    edge_ids = []
+    edge_data = []
+    for src, tgts in comp["edges"].items():
+        for tgt, data in tgts.items():
+            edge_ids.append([src, tgt])
+            edge_data.append(data)
+    return {
+        "node_ids": node_ids,
+        "node_cols": {
+            a: [comp["nodes"][n][na[a]] for n in node_ids]
+            for a in extra_node_attrs
+        },
+        "edge_ids": edge_ids,
+        "edge_cols": {
+            a: [d[ea[a]] for d in edge_data] for a in extra_edge_attrs
+        },
+    }
+
+
+def strip_component(comp, node_keep, edge_keep):
+    """Returns a copy of a component dict without extra attributes.
+
+    Only the nodes / edges are copied; everything else (patterns, zoom
+    levels, ...) is shared with the original component.
+    """
+    stripped = dict(comp)
+    stripped["nodes"] = {
+        n: [data[i] for i in node_keep] for n, data in comp["nodes"].items()
+    }
+    stripped["edges"] = {
+        src: {tgt: [data[i] for i in edge_keep] for tgt, data in tgts.items()}
+        for src, tgts in comp["edges"].items()
+    }
+    return stripped
+
+
+def write_attr_tables(graph_data, output_dir):
+    """Writes out side tables of extra attributes for every component.
+
+    graph_data should be the output of AssemblyGraph.to_dict(). This doesn't
+    modify graph_data (since other exports need the extra attributes too);
+    instead, it returns a version of graph_data without the extra
+    attributes, for the viewer. The returned dict has an "attr_tables_dir"
+    key, giving the directory (relative to the output directory) that
+    contains the side tables.
+
+    If there aren't any extra attributes, no side tables are written.
+    """
+    extra_node_attrs = graph_data["extra_node_attrs"]
+    extra_edge_attrs = graph_data["extra_edge_attrs"]
+    na = graph_data["node_attrs"]
+    ea = graph_data["edge_attrs"]
+    core_na, node_keep = get_core_attrs(na, extra_node_attrs)
+    core_ea, edge_keep = get_core_attrs(ea, extra_edge_attrs)
+
+    viewer_data = dict(graph_data)
+    viewer_data["node_attrs"] = core_na
+    viewer_data["edge_attrs"] = core_ea
+    viewer_data["attr_tables_dir"] = config.ATTR_TABLES_DIR_NAME
+
+    if len(extra_node_attrs) == 0 and len(extra_edge_attrs) == 0:
+        return viewer_data
+
+    tables_dir = os.path.join(output_dir, config.ATTR_TABLES_DIR_NAME)
+    os.makedirs(tables_dir, exist_ok=True)
+    components = []
+    for cc_num, comp in enumerate(graph_data["components"], 1):
+        if comp["skipped"]:
+            components.append(comp)
+            continue
+        table = get_component_attr_table(
+            comp, na, ea, extra_node_attrs, extra_edge_attrs
+        )
+        with open(os.path.join(tables_dir, "{}.js".format(cc_num)), "w") as f:
+            f.write("define(")
+            json.dump(table, f)
+            f.write(");\n")
+        components.append(strip_component(comp, node_keep, edge_keep))
+    viewer_data["components"] = components
+    return viewer_data
@@ -0,0 +1,201 @@
+# Copyright (C) 2016-- Marcus Fedarko, Jay Ghurye, Todd Treangen, Mihai Pop
+# Authored by Marcus Fedarko
+#
+# This file is part of MetagenomeScope.
+#
+# MetagenomeScope is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# MetagenomeScope is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with MetagenomeScope.  If not, see <http://www.gnu.org/licenses/>.
+####
+# Multilevel coarsening of huge components, for "semantic zoom" in the viewer.
+#
+# Even after collapsing patterns, the top level of a tangled metagenome
+# component can have tens of thousands of nodes -- which is a lot for the
+# browser to draw at once, and not much use to look at when zoomed out
+# anyway. So, for big components, we build a hierarchy of "zoom levels":
+# each level groups together the super-nodes of the level below it (level 0
+# groups together the component's top-level nodes and collapsed patterns),
+# until we get down to a small number of super-nodes. The viewer draws a
+# coarse level when you're zoomed out, and switches to finer levels (and
+# eventually the actual graph) as you zoom in.
+#
+# Grouping is done using heavy-edge matching (as in multilevel graph
+# partitioners like METIS): each node is paired up with the unpaired neighbor
+# it shares the heaviest edge with, so densely connected nodes end up in the
+# same super-node. Each level thus has about half as many super-nodes as the
+# level below it.
+#
+# We've already laid out the full component by the time we do this, so
+# "laying out" each level is cheap: each super-node is just drawn as the
+# bounding box of everything in it.
+
+
+from . import config
+
+
+def coarsen_once(node_weights, edges):
+    """Groups nodes in a graph together using heavy-edge matching.
+
+    node_weights should be a list of the "weight" of each node (the number of
+    actual nodes it represents); nodes are identified by their index in this
+    list. edges should be a dict mapping (i, j) tuples of node indices, with
+    i < j, to the weight of the edge between i and j. (Edge direction doesn't
+    matter here.)
+
+    We visit nodes from lowest to highest degree (since low-degree nodes have
+    the fewest options, it's best to match them first), and pair each
+    unmatched node with the unmatched neighbor it has the heaviest edge to.
+    Ties are broken by picking the lightest neighbor, so super-nodes stay
+    roughly balanced in size.
+
+    Matching alone doesn't shrink "star"-shaped graphs much (only one leaf
+    can be matched with the center), so afterwards any node that couldn't be
+    matched with anything gets absorbed into the group of its heaviest
+    neighbor. (All of an unmatched node's neighbors must have already been
+    matched -- otherwise it would've been matched with one of them -- so we
+    never absorb one unmatched node into another.)
+
+    Returns (groups, new node weights, new edges): groups is a list where
+    groups[k] is a list of the node indices in super-node k, and the other
+    two are in the same format as the inputs (for the coarsened graph).
+    """
+    n = len(node_weights)
+    adj = [{} for i in range(n)]
+    for (i, j), w in edges.items():
+        adj[i][j] = w
+        adj[j][i] = w
+
+    group = [None] * n
+    groups = []
+    unmatched = []
+    for u in sorted(range(n), key=lambda i: (len(adj[i]), i)):
+        if group[u] is not None:
+            continue
+        best = None
+        best_key = None
+        for v, w in adj[u].items():
+            if group[v] is None and v != u:
+                key = (w, -node_weights[v], -v)
+                if best is None or key > best_key:
+                    best = v
+                    best_key = key
+        group[u] = len(groups)
+        if best is None:
+            groups.append([u])
+            if len(adj[u]) > 0:
+                unmatched.append(u)
+        else:
+            group[best] = group[u]
+            groups.append([u, best])
+
+    for u in unmatched:
+        best = max(adj[u], key=lambda v: (adj[u][v], -v))
+        g = group[best]
+        groups[g].append(u)
+        groups[group[u]] = None
+        group[u] = g
+
+    # Renumber the groups, now that some are gone
+    old2new = {}
+    final_groups = []
+    for g, members in enumerate(groups):
+        if members is not None:
+            old2new[g] = len(final_groups)
+            final_groups.append(sorted(members))
+
+    new_weights = [
+        sum(node_weights[u] for u in members) for members in final_groups
+    ]
+    new_edges = {}
+    for (i, j), w in edges.items():
+        gi = old2new[group[i]]
+        gj = old2new[group[j]]
+        if gi != gj:
+            key = (min(gi, gj), max(gi, gj))
+            new_edges[key] = new_edges.get(key, 0) + w
+    return final_groups, new_weights, new_edges
+
+
+def merge_boxes(boxes):
+    """Returns the bounding box of a list of [xmin, ymin, xmax, ymax] boxes."""
+    return [
+        min(b[0] for b in boxes),
+        min(b[1] for b in boxes),
+        max(b[2] for b in boxes),
+        max(b[3] for b in boxes),
+    ]
+
+
+def build_zoom_levels(node_ids, node_weights, edges, boxes):
+    """Builds a hierarchy of coarsened versions of a component.
+
+    node_ids is a list of the IDs of the top-level nodes (and collapsed
+    patterns) in the component; node_weights, edges, and boxes are
+    parallel to this list (see coarsen_once() for the format of the first
+    two; boxes[i] is the [xmin, ymin, xmax, ymax] bounding box of node i).
+
+    Returns a list of levels, from finest to coarsest. Each level is a dict
+    with the following keys:
+
+    "children": a list where the k-th entry lists the members of super-node
+                k. For the first level these are entries in node_ids; for
+                later levels, these are indices of super-nodes in the
+                previous level.
+    "sizes": the total number of top-level nodes / patterns' nodes in each
+             super-node (i.e. its weight).
+    "bbs": the bounding box of each super-node.
+    "edges": a list of [i, j, weight] lists, one per pair of super-nodes
+             connected by at least one edge.
+
+    We stop once a level has at most config.ZOOM_LEVEL_TARGET_SIZE
+    super-nodes, once we have config.ZOOM_LEVEL_MAX_LEVELS levels, or once
+    coarsening stops making much of a difference (i.e. a level has more
+    than config.ZOOM_LEVEL_MIN_SHRINK times as many super-nodes as the
+    previous level).
+    """
+    levels = []
+    prev_ids = list(node_ids)
+    weights = list(node_weights)
+    curr_edges = dict(edges)
+    curr_boxes = list(boxes)
+    while (
+        len(weights) > config.ZOOM_LEVEL_TARGET_SIZE
+        and len(levels) < config.ZOOM_LEVEL_MAX_LEVELS
+    ):
+        groups, new_weights, new_edges = coarsen_once(weights, curr_edges)
+        if len(groups) >= len(weights):
+            break
+        new_boxes = [
+            merge_boxes([curr_boxes[u] for u in members]) for members in groups
+        ]
+        levels.append(
+            {
+                "children": [
+                    [prev_ids[u] for u in members] for members in groups
+                ],
+                "sizes": new_weights,
+                "bbs": new_boxes,
+                "edges": [
+                    [i, j, w] for (i, j), w in sorted(new_edges.items())
+                ],
+            }
+        )
+        shrunk_enough = len(groups) <= config.ZOOM_LEVEL_MIN_SHRINK * len(
+            weights
+        )
+        prev_ids = list(range(len(groups)))
+        weights = new_weights
+        curr_edges = new_edges
+        curr_boxes = new_boxes
+        if not shrunk_enough:
+            break
+    return levels
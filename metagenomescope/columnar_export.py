@@ -0,0 +1,336 @@
+# Copyright (C) 2016-- Marcus Fedarko, Jay Ghurye, Todd Treangen, Mihai Pop
+# Authored by Marcus Fedarko
+#
+# This file is part of MetagenomeScope.
+#
+# MetagenomeScope is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# MetagenomeScope is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with MetagenomeScope.  If not, see <http://www.gnu.org/licenses/>.
+####
+# Exporting the laid-out graph as columnar tables (-et), for analyses that
+# don't need the interactive visualization -- e.g. looking at where certain
+# contigs ended up, or at pattern membership, across lots of samples.
+#
+# We write three tables (nodes, edges, and patterns) as either Parquet or
+# Arrow IPC files. These are built from the output of to_dict() (so this
+# works the same way for AssemblyGraph and PagedAssemblyGraph), one
+# component at a time: rows are buffered until there are at least
+# config.TABLE_BATCH_ROWS of them, and then written out as a record batch.
+# A TableExporter can be passed to to_dict() (as its on_component callback)
+# so that each component's rows are written out as soon as to_dict() makes
+# that component -- the column types of extra attributes come from the
+# parsers (see the "extra_node_attr_types" field of to_dict()'s output), so
+# we don't need to look at any components before we start writing.
+#
+# Low-cardinality string columns (orientations, pattern types, and any extra
+# string attributes) are dictionary-encoded. Arrow IPC files only allow one
+# dictionary per column, so we keep a single dictionary per column and just
+# add to it as we see new values (these additions are written as dictionary
+# "deltas"). Node names are basically unique, so we don't dictionary-encode
+# those -- growing a dictionary that big for every batch would take forever,
+# and wouldn't save any space.
+#
+# pyarrow is an optional dependency, so we only import it if -et is given.
+
+import os
+from . import config
+from .export_utils import get_extra_attr_types
+
+
+def import_pyarrow():
+    """Imports pyarrow, raising a ValueError if it isn't installed.
+
+    Returns a 3-tuple of the (pyarrow, pyarrow.ipc, pyarrow.parquet) modules.
+    """
+    try:
+        import pyarrow
+        import pyarrow.ipc
+        import pyarrow.parquet
+    except ImportError:
+        raise ValueError(
+            "Exporting tables (--export-tables) requires pyarrow, which "
+            "doesn't seem to be installed. You can install it using "
+            '"pip install pyarrow".'
+        )
+    return pyarrow, pyarrow.ipc, pyarrow.parquet
+
+
+# Marker used in place of a pyarrow type, for dictionary-encoded string
+# columns
+DICT_STRING = "dict_string"
+
+
+class TableWriter(object):
+    """Writes rows to a Parquet / Arrow IPC file, in batches."""
+
+    def __init__(self, filepath, table_format, columns):
+        """Opens the output file.
+
+        columns should be a list of (column name, pyarrow type) 2-tuples.
+        The type can also be DICT_STRING, for dictionary-encoded strings.
+        """
+        self.pa, ipc, pq = import_pyarrow()
+        pa = self.pa
+        self.names = [c[0] for c in columns]
+        self.types = {}
+        # Maps dictionary-encoded column names to a 2-tuple of (dict mapping
+        # values to indices, list of values)
+        self.dicts = {}
+        fields = []
+        for name, col_type in columns:
+            if col_type == DICT_STRING:
+                col_type = pa.dictionary(pa.int32(), pa.string())
+                self.dicts[name] = ({}, [])
+            self.types[name] = col_type
+            fields.append(pa.field(name, col_type))
+        self.schema = pa.schema(fields)
+
+        if table_format == config.TABLE_FORMAT_PARQUET:
+            self.writer = pq.ParquetWriter(filepath, self.schema)
+        elif table_format == config.TABLE_FORMAT_ARROW:
+            self.writer = ipc.new_file(
+                filepath,
+                self.schema,
+                options=ipc.IpcWriteOptions(emit_dictionary_deltas=True),
+            )
+        else:
+            raise ValueError(
+                "Unrecognized table format: {}".format(table_format)
+            )
+        self.buffer = {name: [] for name in self.names}
+        self.num_buffered = 0
+
+    def add_row(self, values):
+        """Adds a row (a list of values, in the same order as the columns)."""
+        for name, val in zip(self.names, values):
+            self.buffer[name].append(val)
+        self.num_buffered += 1
+
+    def encode(self, name, values):
+        """Dictionary-encodes a list of values, using this column's dict."""
+        val2index, dict_values = self.dicts[name]
+        indices = []
+        for v in values:
+            if v is None:
+                indices.append(None)
+                continue
+            v = str(v)
+            if v not in val2index:
+                val2index[v] = len(dict_values)
+                dict_values.append(v)
+            indices.append(val2index[v])
+        return self.pa.DictionaryArray.from_arrays(
+            self.pa.array(indices, type=self.pa.int32()),
+            self.pa.array(dict_values, type=self.pa.string()),
+        )
+
+    def flush(self, min_rows=1):
+        """Writes out buffered rows, if there are at least min_rows of them."""
+        if self.num_buffered < min_rows or self.num_buffered == 0:
+            return
+        arrays = []
+        for name in self.names:
+            if name in self.dicts:
+                arrays.append(self.encode(name, self.buffer[name]))
+            else:
+                arrays.append(
+                    self.pa.array(self.buffer[name], type=self.types[name])
+                )
+        self.writer.write_batch(
+            self.pa.record_batch(arrays, schema=self.schema)
+        )
+        self.buffer = {name: [] for name in self.names}
+        self.num_buffered = 0
+
+    def close(self):
+        self.flush()
+        self.writer.close()
+
+
+PATT_FIELDS = (
+    "pattern_id",
+    "pattern_type",
+    "parent_id",
+    "left",
+    "bottom",
+    "right",
+    "top",
+    "width",
+    "height",
+)
+
+
+class TableExporter(object):
+    """Writes out node, edge, and pattern tables one component at a time.
+
+    The tables are written to the config.TABLES_DIR_NAME subdirectory of
+    output_dir (which should already exist). table_format should be one of
+    config.TABLE_FORMATS. Call add_component() for every component, in
+    order, and then close().
+    """
+
+    def __init__(self, output_dir, table_format):
+        self.pa = import_pyarrow()[0]
+        if table_format not in config.TABLE_FORMATS:
+            raise ValueError(
+                "Unrecognized table format: {}".format(table_format)
+            )
+        self.tables_dir = os.path.join(output_dir, config.TABLES_DIR_NAME)
+        self.table_format = table_format
+        # We don't know what columns to use until we've seen the top-level
+        # fields of to_dict()'s output, so the writers are created in the
+        # first add_component() call
+        self.writers = None
+
+    def start(self, graph_data):
+        pa = self.pa
+        na = graph_data["node_attrs"]
+        ea = graph_data["edge_attrs"]
+        self.extra_node_attrs = graph_data["extra_node_attrs"]
+        self.extra_edge_attrs = graph_data["extra_edge_attrs"]
+        extra_node_types = get_extra_attr_types(graph_data, "node")
+        extra_edge_types = get_extra_attr_types(graph_data, "edge")
+
+        # Extra attributes that aren't all bools / ints / numbers are stored
+        # as dictionary-encoded strings
+        type2col = {
+            bool: pa.bool_(),
+            int: pa.int64(),
+            float: pa.float64(),
+            str: DICT_STRING,
+        }
+        node_cols = [
+            ("component", pa.int32()),
+            ("node_id", pa.int64()),
+            ("name", pa.string()),
+            ("length", pa.int64()),
+            ("x", pa.float64()),
+            ("y", pa.float64()),
+            ("width", pa.float64()),
+            ("height", pa.float64()),
+            ("orientation", DICT_STRING),
+            ("parent_id", pa.int64()),
+            ("is_dup", pa.bool_()),
+        ] + [(a, type2col[extra_node_types[a]]) for a in self.extra_node_attrs]
+        edge_cols = [
+            ("component", pa.int32()),
+            ("src_id", pa.int64()),
+            ("tgt_id", pa.int64()),
+            ("parent_id", pa.int64()),
+            ("is_dup", pa.bool_()),
+            ("is_outlier", pa.int8()),
+            ("relative_weight", pa.float64()),
+            ("ctrl_pt_coords", pa.list_(pa.float64())),
+        ] + [(a, type2col[extra_edge_types[a]]) for a in self.extra_edge_attrs]
+        patt_cols = [
+            ("component", pa.int32()),
+            ("pattern_id", pa.int64()),
+            ("pattern_type", DICT_STRING),
+            ("parent_id", pa.int64()),
+            ("left", pa.float64()),
+            ("bottom", pa.float64()),
+            ("right", pa.float64()),
+            ("top", pa.float64()),
+            ("width", pa.float64()),
+            ("height", pa.float64()),
+        ]
+        # Positions of the fields we want in each data list
+        self.node_pos = [
+            na[f]
+            for f in (
+                "name",
+                "length",
+                "x",
+                "y",
+                "width",
+                "height",
+                "orientation",
+                "parent_id",
+            )
+        ]
+        self.node_dup_pos = na["is_dup"]
+        self.node_extra_pos = [na[a] for a in self.extra_node_attrs]
+        self.edge_pos = [ea["parent_id"]]
+        self.edge_dup_pos = ea["is_dup"]
+        self.edge_rest_pos = [
+            ea[f] for f in ("is_outlier", "relative_weight", "ctrl_pt_coords")
+        ]
+        self.edge_extra_pos = [ea[a] for a in self.extra_edge_attrs]
+        self.patt_pos = [graph_data["patt_attrs"][f] for f in PATT_FIELDS]
+
+        os.makedirs(self.tables_dir, exist_ok=True)
+        self.writers = []
+        for table_name, cols in (
+            ("nodes", node_cols),
+            ("edges", edge_cols),
+            ("patterns", patt_cols),
+        ):
+            filepath = os.path.join(
+                self.tables_dir, "{}.{}".format(table_name, self.table_format)
+            )
+            self.writers.append(TableWriter(filepath, self.table_format, cols))
+
+    def add_component(self, graph_data, cc_num, comp):
+        """Writes out the rows for a component.
+
+        This has the same signature as the on_component callback of
+        to_dict(), so it can be passed straight to that.
+        """
+        if self.writers is None:
+            self.start(graph_data)
+        if comp["skipped"]:
+            return
+        node_writer, edge_writer, patt_writer = self.writers
+        for node_id, data in comp["nodes"].items():
+            node_writer.add_row(
+                [cc_num, int(node_id)]
+                + [data[i] for i in self.node_pos]
+                + [bool(data[self.node_dup_pos])]
+                + [data[i] for i in self.node_extra_pos]
+            )
+        for src_id, tgts in comp["edges"].items():
+            for tgt_id, data in tgts.items():
+                edge_writer.add_row(
+                    [cc_num, int(src_id), int(tgt_id)]
+                    + [data[i] for i in self.edge_pos]
+                    + [bool(data[self.edge_dup_pos])]
+                    + [data[i] for i in self.edge_rest_pos]
+                    + [data[i] for i in self.edge_extra_pos]
+                )
+        for data in comp["patts"]:
+            patt_writer.add_row([cc_num] + [data[i] for i in self.patt_pos])
+        for w in self.writers:
+            w.flush(min_rows=config.TABLE_BATCH_ROWS)
+
+    def close(self):
+        if self.writers is not None:
+            for w in self.writers:
+                w.close()
+
+
+def write_tables(graph_data, output_dir, table_format):
+    """Writes out node, edge, and pattern tables for a graph.
+
+    graph_data should be the output of AssemblyGraph.to_dict() (or
+    PagedAssemblyGraph.to_dict()); see TableExporter for the other
+    parameters. (make_viz() uses a TableExporter directly, so that it
+    can write things out while to_dict() is still going.)
+
+    Every row includes the (1-indexed) number of the component it's in,
+    matching the component numbers shown in the visualization.
+    """
+    exporter = TableExporter(output_dir, table_format)
+    try:
+        for cc_num, comp in enumerate(graph_data["components"], 1):
+            exporter.add_component(graph_data, cc_num, comp)
+    finally:
+        exporter.close()
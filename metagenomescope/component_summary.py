@@ -0,0 +1,133 @@
+# Copyright (C) 2016-- Marcus Fedarko, Jay Ghurye, Todd Treangen, Mihai Pop
+# Authored by Marcus Fedarko
+#
+# This file is part of MetagenomeScope.
+#
+# MetagenomeScope is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# MetagenomeScope is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with MetagenomeScope.  If not, see <http://www.gnu.org/licenses/>.
+####
+# Per-component summary statistics, for the viewer's component browser.
+#
+# The viewer uses these to show a sortable / filterable list of all of the
+# components in the graph, so that users can jump straight to interesting
+# components instead of stepping through them one size rank at a time. The
+# table is columnar (one list per statistic, with one entry per component,
+# in size rank order) to keep it small.
+
+from . import config
+from .input_node_utils import n50
+
+# Layout statuses
+STATUS_FULL = "full"
+STATUS_DEGRADED = "degraded"
+STATUS_SKIPPED = "skipped"
+
+SUMMARY_COLUMNS = (
+    "nodes",
+    "edges",
+    "patterns",
+    "length",
+    "n50",
+    "gc",
+    "depth",
+    "status",
+)
+
+
+def get_attr_name(extra_attrs, candidates):
+    """Returns the first of candidates that's in extra_attrs, or None."""
+    for attr in candidates:
+        if attr in extra_attrs:
+            return attr
+    return None
+
+
+def weighted_mean(vals_and_weights):
+    """Returns the weighted mean of some (value, weight) pairs.
+
+    Pairs where the value is None or negative (some formats use -1 for
+    "unknown") are ignored; if the weights of the remaining pairs sum to 0,
+    they're weighted equally. Returns None if there aren't any valid pairs.
+    """
+    pairs = [(v, w) for v, w in vals_and_weights if v is not None and v >= 0]
+    if len(pairs) == 0:
+        return None
+    total_weight = sum(w for v, w in pairs)
+    if total_weight == 0:
+        return sum(v for v, w in pairs) / len(pairs)
+    return sum(v * w for v, w in pairs) / total_weight
+
+
+def get_component_summary(graph_data):
+    """Computes summary statistics for every component in a graph.
+
+    graph_data should be the output of AssemblyGraph.to_dict() (before
+    extra attributes are moved into side tables, since we need the GC
+    content / depth of every node).
+
+    Returns a dict mapping each of SUMMARY_COLUMNS to a list with one value
+    per component. Duplicate nodes / edges (made when splitting up adjacent
+    patterns) aren't counted. Mean GC content and depth are weighted by node
+    length, and are None if the input graph doesn't have these attributes.
+    We don't keep the nodes / edges of components that weren't laid out
+    around, so for these we just use the node count, edge count, and total
+    length that to_dict() saved in their placeholders; everything else
+    (besides their status) is None.
+    """
+    na = graph_data["node_attrs"]
+    ea = graph_data["edge_attrs"]
+    gc_attr = get_attr_name(
+        graph_data["extra_node_attrs"], config.SUMMARY_GC_ATTRS
+    )
+    depth_attr = get_attr_name(
+        graph_data["extra_node_attrs"], config.SUMMARY_DEPTH_ATTRS
+    )
+    summary = {col: [] for col in SUMMARY_COLUMNS}
+    for comp in graph_data["components"]:
+        if comp["skipped"]:
+            for col in SUMMARY_COLUMNS:
+                summary[col].append(None)
+            summary["nodes"][-1] = comp["num_nodes"]
+            summary["edges"][-1] = comp["num_edges"]
+            summary["length"][-1] = comp["length"]
+            summary["status"][-1] = STATUS_SKIPPED
+            continue
+
+        nodes = [d for d in comp["nodes"].values() if not d[na["is_dup"]]]
+        num_edges = sum(
+            1
+            for tgts in comp["edges"].values()
+            for d in tgts.values()
+            if not d[ea["is_dup"]]
+        )
+        lengths = [
+            d[na["length"]] for d in nodes if d[na["length"]] is not None
+        ]
+        summary["nodes"].append(len(nodes))
+        summary["edges"].append(num_edges)
+        summary["patterns"].append(len(comp["patts"]))
+        summary["length"].append(sum(lengths) if len(lengths) > 0 else None)
+        summary["n50"].append(n50(lengths) if len(lengths) > 0 else None)
+        for col, attr in (("gc", gc_attr), ("depth", depth_attr)):
+            if attr is None:
+                summary[col].append(None)
+            else:
+                summary[col].append(
+                    weighted_mean(
+                        (d[na[attr]], d[na["length"]] or 0) for d in nodes
+                    )
+                )
+        summary["status"].append(
+            STATUS_DEGRADED if comp["degraded"] else STATUS_FULL
+        )
+    return summary
@@ -189,6 +189,196 @@ PATTERN2COLOR = {
 MAXN_DEFAULT = 7999
 MAXE_DEFAULT = 7999
 
+# Default number of components to list in the output of "mgsc info".
+INFO_TOP_COMPONENTS_DEFAULT = 10
+
+# Exponent used in layout_utils.estimate_layout_cost() (used by "mgsc info"
+# to estimate how expensive each component will be to lay out) and in the
+# layout cost model.
+LAYOUT_COST_EXPONENT = 1.5
+
+# Layout cost model (see layout_cost.py) used for --time-budget. Predicted
+# time, in seconds, to lay out a component is
+#
+#   c0 + c1 * (|V| + |E|) ^ LAYOUT_COST_EXPONENT + c2 * (# patterns)
+#      + c3 * (max pattern nesting depth)
+#
+# ... where these are the coefficients used until we have enough recorded
+# timings (see --layout-timings) to fit our own. These are ballpark numbers
+# from laying out a few graphs on my laptop, so your mileage may vary.
+LAYOUT_COST_DEFAULT_COEFFS = (0.005, 2e-5, 0.01, 0.01)
+# We need at least this many recorded timings before we'll try to fit the
+# coefficients above from them.
+LAYOUT_COST_MIN_OBSERVATIONS = 10
+# Max number of timings we keep around in a --layout-timings file. Older
+# timings are thrown out first.
+LAYOUT_COST_MAX_OBSERVATIONS = 2000
+# Initial guess for how long a "degraded" layout (see DEGRADED_GRAPH_STYLE)
+# takes, relative to a normal layout. Refined using recorded timings.
+DEGRADED_LAYOUT_COST_FACTOR = 0.3
+# Extra graph attributes passed to dot when doing a "degraded" layout of a
+# component under --time-budget. These limit the number of iterations used
+# in network simplex (nslimit, nslimit1), crossing minimization (mclimit),
+# and the search for negative-cut-value edges (searchsize). The layouts are
+# uglier but still (mostly) readable.
+DEGRADED_GRAPH_STYLE = (
+    "nslimit=1;\n\tnslimit1=1;\n\tmclimit=0.1;\n\tsearchsize=5"
+)
+# Fraction of the --time-budget we hold back for stuff that happens after
+# layout (rotating the graph, writing out the JSON, copying files, ...).
+TIME_BUDGET_RESERVE_FRACTION = 0.05
+# Default number of worker processes used for layout (-lw).
+LAYOUT_WORKERS_DEFAULT = 1
+
+# Default number of worker processes used to run pattern validators in
+# parallel during hierarchical decomposition (-dw); see
+# graph_objects/parallel_validation.py. We only bother starting up processes
+# for a validator's pass through the graph if there are at least
+# PARALLEL_VALIDATION_MIN_CANDIDATES nodes to check.
+DECOMPOSITION_WORKERS_DEFAULT = 1
+PARALLEL_VALIDATION_MIN_CANDIDATES = 1000
+
+# When nodes / edges are removed from a graph that's already been decomposed
+# (see AssemblyGraph.remove_nodes_and_edges()), we only look for new patterns
+# starting from top-level nodes within this many edges (ignoring direction)
+# of the stuff that changed.
+INCREMENTAL_DECOMPOSITION_RADIUS = 3
+
+# Graph simplification settings (see simplification.py). COVERAGE_ATTRS are
+# the node attributes we'll look for, in order, when filtering nodes by
+# --min-coverage ("depth" is from LastGraph files, "cov" is from FASTG files).
+# TRANSITIVE_REDUCTION_MAX_DEGREE is the max out-degree of a node whose
+# outgoing edges we'll try to remove during --transitive-reduction; this keeps
+# that pass linear-time on graphs with a few hugely-connected nodes.
+COVERAGE_ATTRS = ("depth", "cov")
+TRANSITIVE_REDUCTION_MAX_DEGREE = 20
+
+# "Zoom level" settings (see coarsening.py). We only build zoom levels for
+# components with at least ZOOM_LEVELS_MIN_COMPONENT_SIZE top-level nodes /
+# collapsed patterns -- smaller components are cheap enough to just draw.
+# Coarsening stops once a level has at most ZOOM_LEVEL_TARGET_SIZE
+# super-nodes, once there are ZOOM_LEVEL_MAX_LEVELS levels, or once a level
+# keeps more than ZOOM_LEVEL_MIN_SHRINK of the previous level's super-nodes.
+ZOOM_LEVELS_MIN_COMPONENT_SIZE = 2000
+ZOOM_LEVEL_TARGET_SIZE = 100
+ZOOM_LEVEL_MAX_LEVELS = 12
+ZOOM_LEVEL_MIN_SHRINK = 0.9
+
+# Columnar table export (-et) settings (see columnar_export.py). Tables are
+# written to the TABLES_DIR_NAME subdirectory of the output directory, with
+# one file per table (nodes, edges, patterns).
+TABLE_FORMAT_PARQUET = "parquet"
+TABLE_FORMAT_ARROW = "arrow"
+TABLE_FORMATS = (TABLE_FORMAT_PARQUET, TABLE_FORMAT_ARROW)
+TABLES_DIR_NAME = "tables"
+# Minimum number of rows we buffer before writing out a record batch. (We
+# only write batches in between components, so batches can be bigger.)
+TABLE_BATCH_ROWS = 65536
+
+# SQLite database (-db) settings (see graph_db.py). The database is written
+# to DB_FILE_NAME in the output directory. DB_BATCH_ROWS is the number of
+# rows we insert per transaction.
+DB_FILE_NAME = "graph.db"
+DB_BATCH_ROWS = 100000
+
+# Static image rendering (-ri) settings (see render.py). Images are written
+# to the IMAGES_DIR_NAME subdirectory of the output directory, one per
+# component per format. By default we only render the largest
+# RENDER_COMPONENTS_DEFAULT components.
+RENDER_FORMAT_SVG = "svg"
+RENDER_FORMAT_PNG = "png"
+RENDER_FORMATS = (RENDER_FORMAT_SVG, RENDER_FORMAT_PNG)
+IMAGES_DIR_NAME = "images"
+RENDER_COMPONENTS_DEFAULT = 10
+# Empty space (in points) around the edges of each image
+RENDER_MARGIN = 10
+# PNGs are scaled down so that neither dimension exceeds this many pixels.
+# (Big components can be tens of thousands of points wide, and a PNG that
+# large is pretty useless as a thumbnail.)
+RENDER_PNG_MAX_DIM = 2000
+
+# Tile pyramid (-mt) settings (see tiles.py). Tiles for component N are
+# written to TILES_DIR_NAME/N/ in the output directory. Only components with
+# at least TILES_MIN_COMPONENT_SIZE nodes + edges get tiles; smaller ones are
+# fast enough to just draw.
+TILES_DIR_NAME = "tiles"
+TILES_MIN_COMPONENT_SIZE = 3000
+# Width / height of each tile, in pixels
+TILE_SIZE = 256
+# Max number of levels in a pyramid. Level 0 fits the whole component into
+# one tile, and each level after that doubles the scale (so level z has up
+# to 4^z tiles).
+TILE_MAX_LEVELS = 6
+# Elements smaller than this many pixels at a level are drawn as a dot
+# instead, with at most one dot per pixel
+TILE_MIN_ELEMENT_PX = 1
+
+# Extra node / edge attributes (GC content, depth, ...) aren't included in
+# the viewer's main graph data; instead, they're written to one "side table"
+# per component in ATTR_TABLES_DIR_NAME/N.js (see attr_tables.py), which the
+# viewer only loads when it needs them.
+ATTR_TABLES_DIR_NAME = "attrs"
+
+# Instancing settings (see instancing.py). Components with at most
+# INSTANCE_MAX_COMPONENT_SIZE nodes + edges that share their layout with at
+# least INSTANCE_MIN_COUNT - 1 other components are stored in the viewer's
+# data as instances of a shared template. Coordinates are compared (and
+# stored in templates) rounded to INSTANCE_COORD_DECIMALS decimal places.
+INSTANCE_MAX_COMPONENT_SIZE = 50
+INSTANCE_MIN_COUNT = 2
+INSTANCE_COORD_DECIMALS = 2
+
+# Names of node attributes (in order of preference) used for the GC content
+# and depth columns of the viewer's component summary table (see
+# component_summary.py). Different input formats call these different things.
+SUMMARY_GC_ATTRS = ("gc_content", "gc")
+SUMMARY_DEPTH_ATTRS = ("depth", "cov", "coverage", "dp")
+
+# Layout progress reporting settings (see progress.py). When stdout is a
+# terminal, the progress bar (PROGRESS_BAR_WIDTH characters wide) is redrawn
+# at most every PROGRESS_BAR_INTERVAL seconds. Otherwise, we print a log line
+# at most every PROGRESS_LOG_INTERVAL seconds (if something has finished since
+# the last line), and at least every PROGRESS_LOG_HEARTBEAT seconds.
+PROGRESS_BAR_INTERVAL = 0.5
+PROGRESS_BAR_WIDTH = 20
+PROGRESS_LOG_INTERVAL = 30
+PROGRESS_LOG_HEARTBEAT = 300
+
+# Node annotation (-a) settings (see annotations.py). Joined annotations are
+# written to one side table per component in ANNOTATIONS_DIR_NAME/N.js.
+# Numeric values are rounded to ANNOTATION_SIG_DIGITS significant digits, and
+# fields that are any of ANNOTATION_MISSING_VALUES are treated as missing.
+ANNOTATIONS_DIR_NAME = "annotations"
+ANNOTATION_SIG_DIGITS = 4
+ANNOTATION_MISSING_VALUES = ("", "NA", "N/A", "NaN", "nan")
+
+# Out-of-core (-ooc) mode settings. DISK_CHUNK_SIZE is the number of nodes /
+# edges we buffer in memory before writing them to disk (and the number of
+# nodes / edges we read back in at once when finishing up the on-disk graph).
+# DISK_MAX_EDGE_BUCKETS is the max number of files we'll split the edge list
+# into when looking for duplicate edges (we use roughly one bucket per
+# DISK_CHUNK_SIZE edges, but don't want to have too many files open at once).
+# PAGE_NODE_COUNT is (roughly) the max number of nodes we'll page into memory
+# at once when processing components: we group small components together into
+# "pages" so that we don't have to run through the whole AssemblyGraph
+# pipeline separately for each of, like, a million 1-node components. (A
+# single component with more nodes than this will be put in its own page.)
+DISK_CHUNK_SIZE = 100000
+DISK_MAX_EDGE_BUCKETS = 256
+PAGE_NODE_COUNT = 50000
+
+# Validation levels for input graphs (-vl). "strict" does every check we have;
+# "fast" still does the structural checks (e.g. that a LastGraph NODE
+# declaration has enough fields, or that there aren't duplicate node IDs), but
+# skips attribute scans and cross-checks between different parts of the file
+# (e.g. the node count in a LastGraph header); and "none" skips all of these
+# checks, trusting that the input is well-formed.
+VALIDATION_STRICT = "strict"
+VALIDATION_FAST = "fast"
+VALIDATION_NONE = "none"
+VALIDATION_LEVELS = (VALIDATION_STRICT, VALIDATION_FAST, VALIDATION_NONE)
+VALIDATION_DEFAULT = VALIDATION_STRICT
+
 # Various status messages/message prefixes that are displayed to the user.
 USERBUBBLES_SEARCH_MSG = "Identifying user-specified bubbles in the graph..."
 USERPATTERNS_SEARCH_MSG = (
@@ -0,0 +1,797 @@
+# Copyright (C) 2016-- Marcus Fedarko, Jay Ghurye, Todd Treangen, Mihai Pop
+# Authored by Marcus Fedarko
+#
+# This file is part of MetagenomeScope.
+#
+# MetagenomeScope is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# MetagenomeScope is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with MetagenomeScope.  If not, see <http://www.gnu.org/licenses/>.
+####
+# This module contains a disk-backed graph store, used when MetagenomeScope is
+# run in "out-of-core" mode (-ooc). The idea is that, for graphs with tens or
+# hundreds of millions of nodes/edges, building a single NetworkX DiGraph of
+# the entire graph can take more memory than the machine actually has (NetworkX
+# stores a few dicts per node and edge, which adds up fast). However, we lay out
+# graphs one connected component at a time anyway -- so we don't actually need
+# the entire graph in memory at once, as long as we can figure out what the
+# components are without loading the entire graph.
+#
+# So: DiskBackedGraph mimics the bits of the nx.DiGraph API that our parsers
+# use (add_node() and add_edge()), but writes node/edge attributes and the edge
+# list to flat binary files in a temporary directory. Once parsing is done,
+# finalize() removes duplicate edges, labels connected components, and sorts
+# nodes/edges by component -- all of which is done a chunk at a time, using
+# memory-mapped arrays for anything with one entry per node / edge / component
+# -- and then component_digraph() can "page in" a small nx.DiGraph containing
+# just the nodes and edges of some components.
+
+import os
+import math
+import shutil
+import tempfile
+import numpy
+from . import config
+from .assembly_graph_parser import AttrTrackingDiGraph
+
+
+def _chunks(length, chunk_size):
+    """Yields (start, end) ranges covering [0, length), chunk_size at a time."""
+    for start in range(0, length, chunk_size):
+        yield start, min(start + chunk_size, length)
+
+
+def _new_array(path, length, dtype=numpy.int64):
+    """Creates a memory-mapped .npy file of the given length, filled with 0s.
+
+    (numpy.memmap doesn't allow creating zero-length files, so in that case
+    we just return an empty in-memory array.)
+    """
+    if length == 0:
+        return numpy.zeros(0, dtype=dtype)
+    return numpy.lib.format.open_memmap(
+        path, mode="w+", dtype=dtype, shape=(length,)
+    )
+
+
+def label_components(
+    src, tgt, edge_rows, num_nodes, path, chunk_size=config.DISK_CHUNK_SIZE
+):
+    """Labels the weakly connected components of a graph stored on disk.
+
+    The edges of the graph are (src[r], tgt[r]) for each r in edge_rows; all
+    of these can be memory-mapped arrays. Returns a memory-mapped array
+    (stored at path) where the i-th entry is the smallest node index in node
+    i's component.
+
+    A union-find that calls find() for one edge at a time is way too slow in
+    Python for huge graphs, so we do this in a vectorized way instead
+    ("hooking and shortcutting," like in the Shiloach-Vishkin algorithm).
+    Every node starts out labelled with itself. Then we repeat two steps
+    until nothing changes: (1) go through the edges a chunk at a time, and for
+    each edge whose endpoints have different labels, point the larger label
+    at the smaller one; (2) replace every node's label with its label's label
+    ("pointer jumping"), a chunk at a time, until every label points to
+    itself. Labels only ever decrease, and a node's label is always in the
+    same component as the node, so this converges to each component's
+    smallest node index. In practice this only takes a few passes through the
+    edges.
+    """
+    labels = _new_array(path, num_nodes)
+    for start, end in _chunks(num_nodes, chunk_size):
+        labels[start:end] = numpy.arange(start, end)
+    while True:
+        hooked = False
+        for start, end in _chunks(len(edge_rows), chunk_size):
+            rows = edge_rows[start:end]
+            src_labels = labels[src[rows]]
+            tgt_labels = labels[tgt[rows]]
+            diff = src_labels != tgt_labels
+            if diff.any():
+                hooked = True
+                src_labels = src_labels[diff]
+                tgt_labels = tgt_labels[diff]
+                numpy.minimum.at(
+                    labels,
+                    numpy.maximum(src_labels, tgt_labels),
+                    numpy.minimum(src_labels, tgt_labels),
+                )
+        if not hooked:
+            return labels
+        jumped = True
+        while jumped:
+            jumped = False
+            for start, end in _chunks(num_nodes, chunk_size):
+                curr = labels[start:end]
+                nxt = labels[curr]
+                if not numpy.array_equal(curr, nxt):
+                    labels[start:end] = nxt
+                    jumped = True
+
+
+class _Column(object):
+    """A single node or edge attribute, stored on disk as a flat array.
+
+    We support three "kinds" of values: numbers (stored as float64s, with NaN
+    for missing values -- if every value we saw was an int, we'll convert them
+    back to ints when paging things back in), booleans (stored as int8s, with
+    -1 for missing values), and strings (dictionary-encoded as int32 codes,
+    with -1 for missing values). Since these all have fixed widths, we can
+    find the value for the i-th node/edge without any sort of index.
+    """
+
+    def __init__(self, name, path, num_missing):
+        self.name = name
+        self.path = path
+        self.kind = None
+        self.all_int = True
+        # Whether or not we've seen a non-None value yet
+        self.has_values = False
+        self.code2str = []
+        self.str2code = {}
+        self.buffer = []
+        self.data = None
+        self.fh = open(path, "wb")
+        # If this attribute first shows up partway through the file, then the
+        # elements we've already written out are missing this attribute.
+        self.num_missing_prefix = num_missing
+
+    def _set_kind(self, value):
+        if type(value) is bool:
+            kind = "bool"
+        elif type(value) is int or type(value) is float:
+            kind = "num"
+        elif type(value) is str:
+            kind = "str"
+        else:
+            raise ValueError(
+                'Out-of-core mode can\'t store attribute "{}" with value {} '
+                "(of type {}).".format(self.name, value, type(value))
+            )
+        self.has_values = True
+        if self.kind is None:
+            self.kind = kind
+            if self.num_missing_prefix > 0:
+                self.buffer.extend([None] * self.num_missing_prefix)
+                self.num_missing_prefix = 0
+        elif self.kind != kind:
+            raise ValueError(
+                'Attribute "{}" has values of multiple types.'.format(
+                    self.name
+                )
+            )
+
+    def append(self, value):
+        if value is not None:
+            self._set_kind(value)
+        elif self.kind is None:
+            # We don't know what type this column is yet, so we can't write
+            # out a missing value. Just remember that we need to.
+            self.num_missing_prefix += 1
+            return
+        self.buffer.append(value)
+
+    def _encode(self, values):
+        if self.kind == "num":
+            out = numpy.empty(len(values), dtype=numpy.float64)
+            for i, v in enumerate(values):
+                if v is None:
+                    out[i] = numpy.nan
+                else:
+                    if type(v) is not int:
+                        self.all_int = False
+                    out[i] = v
+        elif self.kind == "bool":
+            out = numpy.array(
+                [-1 if v is None else int(v) for v in values], dtype=numpy.int8
+            )
+        else:
+            out = numpy.empty(len(values), dtype=numpy.int32)
+            for i, v in enumerate(values):
+                if v is None:
+                    out[i] = -1
+                else:
+                    if v not in self.str2code:
+                        self.str2code[v] = len(self.code2str)
+                        self.code2str.append(v)
+                    out[i] = self.str2code[v]
+        return out
+
+    def flush(self):
+        if self.kind is not None and len(self.buffer) > 0:
+            self._encode(self.buffer).tofile(self.fh)
+            self.buffer = []
+
+    def finalize(self, total):
+        """Pads this column to total elements, then memory-maps it."""
+        if self.kind is None:
+            # This attribute was only ever None. Store it as a numeric column
+            # of NaNs, which'll just be skipped when paging things in.
+            self.kind = "num"
+            self.num_missing_prefix = 0
+        self.flush()
+        written = self.fh.tell() // self.itemsize()
+        if written < total:
+            self.buffer = [None] * (total - written)
+            self.flush()
+        self.fh.close()
+        if total > 0:
+            self.data = numpy.memmap(
+                self.path, dtype=self.dtype(), mode="r+", shape=(total,)
+            )
+        else:
+            self.data = numpy.zeros(0, dtype=self.dtype())
+
+    def dtype(self):
+        return {"num": numpy.float64, "bool": numpy.int8, "str": numpy.int32}[
+            self.kind
+        ]
+
+    def itemsize(self):
+        return numpy.dtype(self.dtype()).itemsize
+
+    def set_many(self, indices, values):
+        """Updates the values of elements after finalize() was called.
+
+        indices should be a numpy array, and values a list of the same
+        length. If an element shows up more than once, its last value wins.
+        """
+        for v in values:
+            if v is not None:
+                self._set_kind(v)
+        # numpy doesn't promise which value a repeated index gets in a fancy
+        # assignment, so only keep the last occurrence of each index
+        uniq, first = numpy.unique(indices[::-1], return_index=True)
+        last = len(indices) - 1 - first
+        self.data[uniq] = self._encode([values[i] for i in last.tolist()])
+
+    def value_types(self):
+        """Returns the set of types of this column's (non-None) values.
+
+        This matches what assembly_graph_parser.record_attr_types() would
+        come up with for the same values. Only accurate after finalize().
+        """
+        if not self.has_values:
+            return set()
+        if self.kind == "num":
+            return {int} if self.all_int else {float}
+        return {bool} if self.kind == "bool" else {str}
+
+    def present(self):
+        """Returns a boolean array indicating which elements have a value."""
+        if self.kind == "num":
+            return ~numpy.isnan(self.data)
+        return self.data >= 0
+
+    def decode(self, indices):
+        """Returns a list of Python values for the given element indices.
+
+        Missing values are returned as None.
+        """
+        raw = self.data[indices]
+        if self.kind == "num":
+            out = []
+            for v in raw.tolist():
+                if math.isnan(v):
+                    out.append(None)
+                elif self.all_int:
+                    out.append(int(v))
+                else:
+                    out.append(v)
+            return out
+        elif self.kind == "bool":
+            return [None if v < 0 else bool(v) for v in raw.tolist()]
+        else:
+            return [None if c < 0 else self.code2str[c] for c in raw.tolist()]
+
+
+class _UpdateLog(object):
+    """add_node() updates to a single attribute of already-added nodes.
+
+    Parsers can declare edges before the nodes they connect (e.g. GFA files
+    with L lines before S lines), in which case basically every node's
+    attributes arrive as an update -- so we can't just keep these in memory.
+    Instead, we append the index of each updated node to one flat file and
+    the new value to a _Column, then apply everything in finalize().
+    """
+
+    def __init__(self, name, path):
+        self.name = name
+        self.length = 0
+        self.idx_buffer = []
+        self.idx_fh = open(path + ".idx", "wb")
+        self.values = _Column(name, path + ".values", 0)
+
+    def append(self, idx, value):
+        self.idx_buffer.append(idx)
+        self.values.append(value)
+        self.length += 1
+
+    def flush(self):
+        if len(self.idx_buffer) > 0:
+            numpy.array(self.idx_buffer, dtype=numpy.int64).tofile(self.idx_fh)
+            self.idx_buffer = []
+        self.values.flush()
+
+    def apply(self, col, chunk_size):
+        """Applies these updates, in order, to a finalized _Column."""
+        self.flush()
+        self.idx_fh.close()
+        self.values.finalize(self.length)
+        if self.length == 0:
+            return
+        idx = numpy.memmap(
+            self.idx_fh.name, dtype=numpy.int64, mode="r", shape=(self.length,)
+        )
+        for start, end in _chunks(self.length, chunk_size):
+            col.set_many(
+                numpy.asarray(idx[start:end]),
+                self.values.decode(numpy.arange(start, end)),
+            )
+        del idx
+        self.values.data = None
+
+
+class DiskBackedGraph(object):
+    """A directed graph whose attributes and adjacency live on disk.
+
+    This is NOT a general-purpose graph class: it supports adding nodes and
+    edges (mimicking nx.DiGraph.add_node() and nx.DiGraph.add_edge(), so that
+    it can be passed to the parse_*() functions in assembly_graph_parser), and
+    then -- once finalize() has been called -- figuring out the connected
+    components of the graph and creating NetworkX DiGraphs of selected
+    components.
+
+    The only per-node thing we keep in memory is a hash index mapping node
+    names to integer indices (we need this in order to resolve the names
+    used in edge declarations). Attributes of nodes/edges and the edge list
+    itself are written out to flat binary files, in chunks, in a temporary
+    directory; this directory is deleted when close() is called.
+    """
+
+    def __init__(self, directory=None, chunk_size=config.DISK_CHUNK_SIZE):
+        self.dir = tempfile.mkdtemp(prefix="mgsc-ooc-", dir=directory)
+        self.chunk_size = chunk_size
+
+        # Node name -> integer index, and the reverse.
+        self.name2idx = {}
+        self.names = []
+
+        self.node_cols = {}
+        self.edge_cols = {}
+
+        self.num_edge_rows = 0
+        self.src_buffer = []
+        self.tgt_buffer = []
+        self.src_fh = open(os.path.join(self.dir, "edges.src"), "wb")
+        self.tgt_fh = open(os.path.join(self.dir, "edges.tgt"), "wb")
+
+        # add_node() calls for nodes that already exist update their
+        # attributes, like in NetworkX. Since we can't easily modify data
+        # that's already been written to disk, we log these updates (on disk,
+        # one _UpdateLog per attribute) and apply them in finalize().
+        self.node_updates = {}
+
+        self.finalized = False
+
+    def __len__(self):
+        return len(self.names)
+
+    def number_of_nodes(self):
+        return len(self.names)
+
+    def number_of_edges(self):
+        """Number of (distinct) edges. Only accurate after finalize()."""
+        return len(self.edge_rows)
+
+    def _get_column(self, cols, attr, num_existing):
+        if attr not in cols:
+            cols[attr] = _Column(
+                attr,
+                os.path.join(
+                    self.dir,
+                    "{}.{}".format(
+                        "nodes" if cols is self.node_cols else "edges",
+                        len(cols),
+                    ),
+                ),
+                num_existing,
+            )
+        return cols[attr]
+
+    def _append_row(self, cols, num_existing, attrs):
+        for attr in attrs:
+            self._get_column(cols, attr, num_existing)
+        for attr, col in cols.items():
+            col.append(attrs.get(attr, None))
+
+    def _check_not_finalized(self):
+        if self.finalized:
+            raise ValueError("Can't modify a finalized DiskBackedGraph.")
+
+    def _add_node_if_new(self, name):
+        """Adds a node with no attributes if it doesn't already exist.
+
+        Returns the node's integer index.
+        """
+        if name not in self.name2idx:
+            self.name2idx[name] = len(self.names)
+            self._append_row(self.node_cols, len(self.names), {})
+            self.names.append(name)
+            self._maybe_flush()
+        return self.name2idx[name]
+
+    def add_node(self, name, **attrs):
+        self._check_not_finalized()
+        if name in self.name2idx:
+            idx = self.name2idx[name]
+            for attr, value in attrs.items():
+                if attr not in self.node_updates:
+                    self.node_updates[attr] = _UpdateLog(
+                        attr,
+                        os.path.join(
+                            self.dir,
+                            "updates.{}".format(len(self.node_updates)),
+                        ),
+                    )
+                self.node_updates[attr].append(idx, value)
+            self._maybe_flush()
+        else:
+            self.name2idx[name] = len(self.names)
+            self._append_row(self.node_cols, len(self.names), attrs)
+            self.names.append(name)
+            self._maybe_flush()
+
+    def add_edge(self, src, tgt, **attrs):
+        """Adds an edge, and its source/target nodes if needed.
+
+        If this edge was already added, then (like NetworkX) we won't create
+        a duplicate edge. Unlike NetworkX, we don't merge the attributes of the
+        two declarations: the last declaration of an edge wins. We resolve
+        this when finalize() is called.
+        """
+        self._check_not_finalized()
+        src_idx = self._add_node_if_new(src)
+        tgt_idx = self._add_node_if_new(tgt)
+        self.src_buffer.append(src_idx)
+        self.tgt_buffer.append(tgt_idx)
+        self._append_row(self.edge_cols, self.num_edge_rows, attrs)
+        self.num_edge_rows += 1
+        self._maybe_flush()
+
+    def _maybe_flush(self, force=False):
+        if (
+            force
+            or len(self.src_buffer) >= self.chunk_size
+            or any(len(c.buffer) >= self.chunk_size for c in self._all_cols())
+            or any(
+                len(u.idx_buffer) >= self.chunk_size
+                for u in self.node_updates.values()
+            )
+        ):
+            numpy.array(self.src_buffer, dtype=numpy.int64).tofile(self.src_fh)
+            numpy.array(self.tgt_buffer, dtype=numpy.int64).tofile(self.tgt_fh)
+            self.src_buffer = []
+            self.tgt_buffer = []
+            for col in self._all_cols():
+                col.flush()
+            for log in self.node_updates.values():
+                log.flush()
+
+    def _all_cols(self):
+        return list(self.node_cols.values()) + list(self.edge_cols.values())
+
+    def _open_array(self, fh, length):
+        fh.close()
+        if length == 0:
+            return numpy.zeros(0, dtype=numpy.int64)
+        return numpy.memmap(
+            fh.name, dtype=numpy.int64, mode="r", shape=(length,)
+        )
+
+    def finalize(self):
+        """Finishes writing everything to disk, and labels components.
+
+        After this is called, no more nodes/edges can be added.
+        """
+        self._check_not_finalized()
+        self._maybe_flush(force=True)
+        num_nodes = len(self.names)
+        for col in self.node_cols.values():
+            col.finalize(num_nodes)
+        for col in self.edge_cols.values():
+            col.finalize(self.num_edge_rows)
+        for attr, log in self.node_updates.items():
+            if attr not in self.node_cols:
+                # This attribute was only given in updates, so we need to
+                # create an (all-missing) column for it first
+                col = self._get_column(self.node_cols, attr, 0)
+                col.kind = log.values.kind
+                col.finalize(num_nodes)
+            log.apply(self.node_cols[attr], self.chunk_size)
+        self.node_updates = {}
+
+        self.src = self._open_array(self.src_fh, self.num_edge_rows)
+        self.tgt = self._open_array(self.tgt_fh, self.num_edge_rows)
+        self.edge_rows = self._find_distinct_edges()
+
+        labels = label_components(
+            self.src,
+            self.tgt,
+            self.edge_rows,
+            num_nodes,
+            self._path("labels"),
+            self.chunk_size,
+        )
+        self.node_cc = self._number_components(labels)
+        del labels
+        os.remove(self._path("labels"))
+
+        # Sort nodes and edges by component, so that the nodes (and edges) in
+        # a given component are contiguous. Within a component, things stay
+        # in the order they were declared in.
+        def node_chunk(start, end):
+            return self.node_cc[start:end], numpy.arange(start, end)
+
+        def edge_chunk(start, end):
+            rows = self.edge_rows[start:end]
+            return self.node_cc[self.src[rows]], rows
+
+        self.cc_node_counts, self.cc_node_starts = self._count_by_component(
+            "cc_node", num_nodes, node_chunk
+        )
+        self.node_order = self._sort_by_component(
+            "node_order", num_nodes, node_chunk, self.cc_node_starts
+        )
+        self.cc_edge_counts, self.cc_edge_starts = self._count_by_component(
+            "cc_edge", len(self.edge_rows), edge_chunk
+        )
+        self.edge_order = self._sort_by_component(
+            "edge_order", len(self.edge_rows), edge_chunk, self.cc_edge_starts
+        )
+        self.finalized = True
+
+    def _path(self, name):
+        return os.path.join(self.dir, name + ".npy")
+
+    def _find_distinct_edges(self):
+        """Returns the (sorted) rows of the edge list that are distinct edges.
+
+        If an edge was declared multiple times, we keep its last declaration.
+        We encode each edge as a single int64 (src * num_nodes + tgt), and
+        then -- so that we never have to hold all of these in memory at once
+        -- split the edges into buckets by the remainder of this key modulo
+        the number of buckets. All declarations of the same edge end up in the
+        same bucket, so we can deduplicate each bucket on its own.
+        """
+        num_nodes = len(self.names)
+        num_rows = self.num_edge_rows
+        num_buckets = min(
+            max(int(math.ceil(num_rows / self.chunk_size)), 1),
+            config.DISK_MAX_EDGE_BUCKETS,
+        )
+        bucket_paths = [
+            os.path.join(self.dir, "bucket.{}".format(b))
+            for b in range(num_buckets)
+        ]
+        bucket_fhs = [open(bp, "wb") for bp in bucket_paths]
+        for start, end in _chunks(num_rows, self.chunk_size):
+            keys = self.src[start:end] * num_nodes + self.tgt[start:end]
+            buckets = keys % num_buckets
+            order = numpy.argsort(buckets, kind="stable")
+            bounds = numpy.searchsorted(
+                buckets[order], numpy.arange(num_buckets + 1)
+            )
+            pairs = numpy.stack(
+                (keys[order], numpy.arange(start, end)[order]), axis=1
+            )
+            for b in range(num_buckets):
+                if bounds[b] < bounds[b + 1]:
+                    pairs[bounds[b] : bounds[b + 1]].tofile(bucket_fhs[b])
+        for fh in bucket_fhs:
+            fh.close()
+
+        keep = _new_array(self._path("keep"), num_rows, numpy.int8)
+        for bp in bucket_paths:
+            pairs = numpy.fromfile(bp, dtype=numpy.int64).reshape(-1, 2)
+            os.remove(bp)
+            if len(pairs) == 0:
+                continue
+            # Sort by key, then by row; the last row for each key wins
+            order = numpy.lexsort((pairs[:, 1], pairs[:, 0]))
+            keys = pairs[order, 0]
+            is_last = numpy.append(keys[1:] != keys[:-1], True)
+            keep[pairs[order[is_last], 1]] = 1
+            del pairs, order, keys, is_last
+
+        num_distinct = 0
+        for start, end in _chunks(num_rows, self.chunk_size):
+            num_distinct += int(numpy.count_nonzero(keep[start:end]))
+        edge_rows = _new_array(self._path("edge_rows"), num_distinct)
+        pos = 0
+        for start, end in _chunks(num_rows, self.chunk_size):
+            rows = numpy.flatnonzero(keep[start:end]) + start
+            edge_rows[pos : pos + len(rows)] = rows
+            pos += len(rows)
+        del keep
+        if num_rows > 0:
+            os.remove(self._path("keep"))
+        return edge_rows
+
+    def _number_components(self, labels):
+        """Turns component labels into component numbers 0, 1, 2, ...
+
+        Components are numbered in order of their smallest node index (i.e.
+        the first component is the one containing the first node declared).
+        Each label is a node index labelled with itself, so the number of a
+        component is the number of these "roots" before its label.
+        """
+        num_nodes = len(labels)
+        node_cc = _new_array(self._path("node_cc"), num_nodes)
+        num_roots = 0
+        for start, end in _chunks(num_nodes, self.chunk_size):
+            is_root = labels[start:end] == numpy.arange(start, end)
+            node_cc[start:end] = numpy.cumsum(is_root) - 1 + num_roots
+            num_roots += int(numpy.count_nonzero(is_root))
+        self.num_components = num_roots
+        # Right now node_cc only has the right value for roots (and every
+        # label is a root), so we can just replace each entry with the entry
+        # of its label. Labels are <= node indices, so by the time we look up
+        # an entry here, it's either already been replaced (with the same
+        # value, since roots are labelled with themselves) or is a root.
+        for start, end in _chunks(num_nodes, self.chunk_size):
+            node_cc[start:end] = node_cc[labels[start:end]]
+        return node_cc
+
+    def _count_by_component(self, name, length, get_chunk):
+        """Counts the nodes (or edges) in each component.
+
+        get_chunk(start, end) should return a 2-tuple whose first element is
+        the component numbers of the items in [start, end).
+
+        Returns a 2-tuple of (counts, starts), where starts[c] is the sum of
+        counts[:c] (so starts has one more entry than counts).
+        """
+        counts = _new_array(self._path(name + "_counts"), self.num_components)
+        for start, end in _chunks(length, self.chunk_size):
+            ccs, _ = get_chunk(start, end)
+            uniq, cts = numpy.unique(ccs, return_counts=True)
+            counts[uniq] += cts
+        starts = _new_array(
+            self._path(name + "_starts"), self.num_components + 1
+        )
+        total = 0
+        for start, end in _chunks(self.num_components, self.chunk_size):
+            cumsum = numpy.cumsum(counts[start:end])
+            starts[start + 1 : end + 1] = cumsum + total
+            total += int(cumsum[-1])
+        return counts, starts
+
+    def _sort_by_component(self, name, length, get_chunk, starts):
+        """Stably sorts items by component, using a counting sort.
+
+        get_chunk(start, end) should return a 2-tuple of (the component
+        numbers of the items in [start, end), the values to output for these
+        items); starts should be as returned by _count_by_component(). We go
+        through the items a chunk at a time, keeping track of the next free
+        position in the output for each component.
+        """
+        out = _new_array(self._path(name), length)
+        cursor_path = self._path(name + "_cursor")
+        cursor = _new_array(cursor_path, self.num_components)
+        for start, end in _chunks(self.num_components, self.chunk_size):
+            cursor[start:end] = starts[start:end]
+        for start, end in _chunks(length, self.chunk_size):
+            ccs, values = get_chunk(start, end)
+            order = numpy.argsort(ccs, kind="stable")
+            sorted_ccs = ccs[order]
+            uniq, first, cts = numpy.unique(
+                sorted_ccs, return_index=True, return_counts=True
+            )
+            # Position of each item among the items in its component in this
+            # chunk
+            rank = numpy.arange(len(order)) - numpy.repeat(first, cts)
+            out[cursor[sorted_ccs] + rank] = values[order]
+            cursor[uniq] += cts
+        del cursor
+        if self.num_components > 0:
+            os.remove(cursor_path)
+        return out
+
+    def node_attrs(self):
+        """Returns a list of the names of all node attributes we've seen."""
+        return list(self.node_cols.keys())
+
+    def edge_attrs(self):
+        """Returns a list of the names of all edge attributes we've seen."""
+        return list(self.edge_cols.keys())
+
+    def node_attr_types(self):
+        """Maps each node attribute to the types of its values.
+
+        See _Column.value_types(); only accurate after finalize().
+        """
+        return {a: c.value_types() for a, c in self.node_cols.items()}
+
+    def edge_attr_types(self):
+        """Analogue of node_attr_types() for edges."""
+        return {a: c.value_types() for a, c in self.edge_cols.items()}
+
+    def node_values(self, attr, node_indices):
+        """Returns a list of attr's values for the given nodes.
+
+        Missing values are None.
+        """
+        return self.node_cols[attr].decode(node_indices)
+
+    def edge_values(self, attr, edge_rows):
+        """Returns a list of attr's values for the given edge rows.
+
+        Missing values are None.
+        """
+        return self.edge_cols[attr].decode(edge_rows)
+
+    def component_node_indices(self, cc_nums):
+        """Returns a numpy array of the node indices in these components."""
+        return _concat_ranges(self.node_order, self.cc_node_starts, cc_nums)
+
+    def component_edge_rows(self, cc_nums):
+        """Returns a numpy array of the edge rows in these components."""
+        return _concat_ranges(self.edge_order, self.cc_edge_starts, cc_nums)
+
+    def component_digraph(self, cc_nums):
+        """Returns an AttrTrackingDiGraph containing these components.
+
+        Nodes in the DiGraph are keyed by name, just like the graphs
+        returned by the parsers in assembly_graph_parser -- so this DiGraph
+        can be passed to AssemblyGraph as if we had just parsed it.
+        """
+        g = AttrTrackingDiGraph()
+        node_indices = self.component_node_indices(cc_nums)
+        node_names = [self.names[i] for i in node_indices.tolist()]
+        col_values = [
+            (attr, col.decode(node_indices))
+            for attr, col in self.node_cols.items()
+        ]
+        for i, name in enumerate(node_names):
+            attrs = {}
+            for attr, values in col_values:
+                if values[i] is not None:
+                    attrs[attr] = values[i]
+            g.add_node(name, **attrs)
+
+        edge_rows = self.component_edge_rows(cc_nums)
+        srcs = self.src[edge_rows].tolist()
+        tgts = self.tgt[edge_rows].tolist()
+        col_values = [
+            (attr, col.decode(edge_rows))
+            for attr, col in self.edge_cols.items()
+        ]
+        for i in range(len(srcs)):
+            attrs = {}
+            for attr, values in col_values:
+                if values[i] is not None:
+                    attrs[attr] = values[i]
+            g.add_edge(self.names[srcs[i]], self.names[tgts[i]], **attrs)
+        return g
+
+    def close(self):
+        """Deletes the temporary directory containing our on-disk data."""
+        for col in self._all_cols():
+            col.data = None
+        shutil.rmtree(self.dir, ignore_errors=True)
+
+
+def _concat_ranges(order, starts, cc_nums):
+    pieces = [order[starts[c] : starts[c + 1]] for c in cc_nums]
+    if len(pieces) == 0:
+        return numpy.zeros(0, dtype=numpy.int64)
+    return numpy.concatenate(pieces)
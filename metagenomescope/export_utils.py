@@ -0,0 +1,59 @@
+# Copyright (C) 2016-- Marcus Fedarko, Jay Ghurye, Todd Treangen, Mihai Pop
+# Authored by Marcus Fedarko
+#
+# This file is part of MetagenomeScope.
+#
+# MetagenomeScope is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# MetagenomeScope is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with MetagenomeScope.  If not, see <http://www.gnu.org/licenses/>.
+####
+# Utilities shared by the non-JSON outputs (columnar tables, SQLite) that
+# are built from the output of AssemblyGraph.to_dict().
+
+
+# The names we use for the types of extra attributes, in the
+# "extra_node_attr_types" / "extra_edge_attr_types" fields of to_dict()'s
+# output (these have to be JSON-friendly, so we can't use the types
+# themselves).
+NAME2TYPE = {"bool": bool, "int": int, "float": float, "str": str}
+
+
+def get_attr_type_name(val_types):
+    """Figures out what type an extra attribute has.
+
+    Extra attributes (e.g. coverage, GC content) come straight from the input
+    graph, so we don't know their types in advance -- but the parsers keep
+    track of the types of each attribute's values as they go (see
+    assembly_graph_parser.record_attr_types()). Given this set of types,
+    this returns "bool", "int", or "float" (if all of the values are bools /
+    ints / numbers), or "str" otherwise. (An attribute that's always None is
+    treated as a str.)
+    """
+    if val_types == {bool}:
+        return "bool"
+    elif val_types == {int}:
+        return "int"
+    elif len(val_types) > 0 and val_types <= {int, float}:
+        return "float"
+    return "str"
+
+
+def get_extra_attr_types(graph_data, kind):
+    """Returns a dict mapping extra node/edge attributes to Python types.
+
+    kind should be "node" or "edge". graph_data should be the output of
+    to_dict() (we just need its top-level fields, not the components).
+    """
+    return {
+        a: NAME2TYPE[t]
+        for a, t in graph_data["extra_{}_attr_types".format(kind)].items()
+    }
@@ -0,0 +1,370 @@
+# Copyright (C) 2016-- Marcus Fedarko, Jay Ghurye, Todd Treangen, Mihai Pop
+# Authored by Marcus Fedarko
+#
+# This file is part of MetagenomeScope.
+#
+# MetagenomeScope is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# MetagenomeScope is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with MetagenomeScope.  If not, see <http://www.gnu.org/licenses/>.
+####
+# Saving the laid-out graph to an indexed SQLite database (-db), and looking
+# things up in it.
+#
+# The visualization itself just loads one big JSON blob, which is fine for
+# the browser but annoying if you just want to know e.g. where a certain
+# contig ended up, or what's in component 57. (The old version of
+# MetagenomeScope stored everything in a SQLite database; this is sort of a
+# return to that, although the schema is based on what to_dict() outputs.)
+#
+# The database has four tables: components, nodes, edges, and patterns.
+# Nodes, edges, and patterns are indexed by component and by parent pattern,
+# and nodes are also indexed by name.
+#
+# We write the database from the output of to_dict() (so this works for both
+# AssemblyGraph and PagedAssemblyGraph), inserting rows in batches of
+# config.DB_BATCH_ROWS, with one transaction per batch. Indexes are created
+# after all of the rows have been inserted, since that's much faster than
+# updating them on every insert.
+
+import json
+import sqlite3
+from . import config
+from .export_utils import get_extra_attr_types
+
+# Maps Python types (as output by get_extra_attr_types()) to SQLite types
+TYPE2SQL = {bool: "INTEGER", int: "INTEGER", float: "REAL", str: "TEXT"}
+
+COMPONENT_COLS = [
+    ("component", "INTEGER PRIMARY KEY"),
+    ("skipped", "INTEGER"),
+    ("degraded", "INTEGER"),
+    ("num_nodes", "INTEGER"),
+    ("num_edges", "INTEGER"),
+    ("num_patterns", "INTEGER"),
+    ("width", "REAL"),
+    ("height", "REAL"),
+    # JSON list of the reasons we stopped decomposing this component early
+    ("decomposition_truncated", "TEXT"),
+]
+NODE_COLS = [
+    ("node_id", "INTEGER PRIMARY KEY"),
+    ("component", "INTEGER"),
+    ("name", "TEXT"),
+    ("length", "INTEGER"),
+    ("x", "REAL"),
+    ("y", "REAL"),
+    ("width", "REAL"),
+    ("height", "REAL"),
+    ("orientation", "TEXT"),
+    ("parent_id", "INTEGER"),
+    ("is_dup", "INTEGER"),
+]
+EDGE_COLS = [
+    ("src_id", "INTEGER"),
+    ("tgt_id", "INTEGER"),
+    ("component", "INTEGER"),
+    ("parent_id", "INTEGER"),
+    ("is_dup", "INTEGER"),
+    ("is_outlier", "INTEGER"),
+    ("relative_weight", "REAL"),
+    # JSON list of control point coordinates
+    ("ctrl_pt_coords", "TEXT"),
+]
+PATT_COLS = [
+    ("pattern_id", "INTEGER PRIMARY KEY"),
+    ("component", "INTEGER"),
+    ("pattern_type", "TEXT"),
+    ("parent_id", "INTEGER"),
+    ("left", "REAL"),
+    ("bottom", "REAL"),
+    ("right", "REAL"),
+    ("top", "REAL"),
+    ("width", "REAL"),
+    ("height", "REAL"),
+]
+
+# (table, column) pairs to index. (Components don't need any extra indexes;
+# their primary key is the component number.)
+INDEXES = [
+    ("nodes", "name"),
+    ("nodes", "component"),
+    ("nodes", "parent_id"),
+    ("edges", "component"),
+    ("edges", "parent_id"),
+    ("patterns", "component"),
+    ("patterns", "parent_id"),
+]
+
+
+def quote(identifier):
+    """Quotes a table / column name for use in a SQL statement.
+
+    We need this because some column names are SQL keywords (e.g. "left"),
+    and extra attribute names come from the input graph so could be anything.
+    """
+    return '"' + identifier.replace('"', '""') + '"'
+
+
+def to_sql_val(val, py_type):
+    """Converts an extra attribute value to something we can store."""
+    if val is None or py_type is not str:
+        return val
+    return str(val)
+
+
+class BatchInserter(object):
+    """Inserts rows into a few tables, committing once per batch."""
+
+    def __init__(self, conn, batch_size):
+        self.conn = conn
+        self.batch_size = batch_size
+        # Maps table name to (INSERT statement, list of buffered rows)
+        self.tables = {}
+        self.num_buffered = 0
+
+    def add_table(self, table_name, cols):
+        """Creates a table. cols should be a list of (name, type) tuples."""
+        self.conn.execute(
+            "CREATE TABLE {} ({})".format(
+                quote(table_name),
+                ", ".join("{} {}".format(quote(c), t) for c, t in cols),
+            )
+        )
+        stmt = "INSERT INTO {} VALUES ({})".format(
+            quote(table_name), ", ".join("?" * len(cols))
+        )
+        self.tables[table_name] = (stmt, [])
+
+    def add_row(self, table_name, row):
+        self.tables[table_name][1].append(row)
+        self.num_buffered += 1
+        if self.num_buffered >= self.batch_size:
+            self.flush()
+
+    def flush(self):
+        if self.num_buffered == 0:
+            return
+        self.conn.execute("BEGIN")
+        for stmt, rows in self.tables.values():
+            self.conn.executemany(stmt, rows)
+            del rows[:]
+        self.conn.execute("COMMIT")
+        self.num_buffered = 0
+
+
+def write_database(graph_data, db_path):
+    """Saves a graph to a new SQLite database.
+
+    graph_data should be the output of AssemblyGraph.to_dict() (or
+    PagedAssemblyGraph.to_dict()). Raises a FileExistsError if something
+    already exists at db_path -- we don't want to add tables to an
+    unrelated database.
+
+    Component numbers are 1-indexed, matching the component numbers shown in
+    the visualization. Components that were too large to lay out are
+    included in the components table (with skipped = 1), but all we know
+    about them is their node and edge counts.
+    """
+    # Opening in "x" mode fails if the file already exists
+    try:
+        open(db_path, "x").close()
+    except FileExistsError:
+        raise FileExistsError("Database {} already exists.".format(db_path))
+
+    na = graph_data["node_attrs"]
+    ea = graph_data["edge_attrs"]
+    pta = graph_data["patt_attrs"]
+    components = graph_data["components"]
+    extra_node_attrs = graph_data["extra_node_attrs"]
+    extra_edge_attrs = graph_data["extra_edge_attrs"]
+    extra_node_types = get_extra_attr_types(graph_data, "node")
+    extra_edge_types = get_extra_attr_types(graph_data, "edge")
+    patt_fields = [c[0] for c in PATT_COLS if c[0] != "component"]
+
+    # We manage transactions ourselves (isolation_level=None turns off the
+    # sqlite3 module's automatic BEGINs). This is a brand-new file, so if
+    # something goes wrong partway through it's garbage anyway -- so we can
+    # turn off the journal and syncing, which speeds up inserts a lot.
+    conn = sqlite3.connect(db_path, isolation_level=None)
+    try:
+        conn.execute("PRAGMA journal_mode = OFF")
+        conn.execute("PRAGMA synchronous = OFF")
+
+        inserter = BatchInserter(conn, config.DB_BATCH_ROWS)
+        inserter.add_table("components", COMPONENT_COLS)
+        inserter.add_table(
+            "nodes",
+            NODE_COLS
+            + [(a, TYPE2SQL[extra_node_types[a]]) for a in extra_node_attrs],
+        )
+        inserter.add_table(
+            "edges",
+            EDGE_COLS
+            + [(a, TYPE2SQL[extra_edge_types[a]]) for a in extra_edge_attrs],
+        )
+        inserter.add_table("patterns", PATT_COLS)
+        inserter.add_table("graph_info", [("key", "TEXT"), ("value", "TEXT")])
+        for key in (
+            "input_file_basename",
+            "input_file_type",
+            "total_num_nodes",
+            "total_num_edges",
+        ):
+            inserter.add_row("graph_info", (key, str(graph_data[key])))
+
+        for cc_num, comp in enumerate(components, 1):
+            if comp["skipped"]:
+                inserter.add_row(
+                    "components",
+                    (
+                        cc_num,
+                        True,
+                        None,
+                        comp["num_nodes"],
+                        comp["num_edges"],
+                        None,
+                        None,
+                        None,
+                        None,
+                    ),
+                )
+                continue
+            num_edges = 0
+            for src_id, tgts in comp["edges"].items():
+                for tgt_id, data in tgts.items():
+                    num_edges += 1
+                    inserter.add_row(
+                        "edges",
+                        [
+                            int(src_id),
+                            int(tgt_id),
+                            cc_num,
+                            data[ea["parent_id"]],
+                            data[ea["is_dup"]],
+                            data[ea["is_outlier"]],
+                            data[ea["relative_weight"]],
+                            json.dumps(data[ea["ctrl_pt_coords"]]),
+                        ]
+                        + [
+                            to_sql_val(data[ea[a]], extra_edge_types[a])
+                            for a in extra_edge_attrs
+                        ],
+                    )
+            for node_id, data in comp["nodes"].items():
+                inserter.add_row(
+                    "nodes",
+                    [
+                        int(node_id),
+                        cc_num,
+                        data[na["name"]],
+                        data[na["length"]],
+                        data[na["x"]],
+                        data[na["y"]],
+                        data[na["width"]],
+                        data[na["height"]],
+                        data[na["orientation"]],
+                        data[na["parent_id"]],
+                        data[na["is_dup"]],
+                    ]
+                    + [
+                        to_sql_val(data[na[a]], extra_node_types[a])
+                        for a in extra_node_attrs
+                    ],
+                )
+            for data in comp["patts"]:
+                inserter.add_row(
+                    "patterns",
+                    [data[pta["pattern_id"]], cc_num]
+                    + [data[pta[f]] for f in patt_fields[1:]],
+                )
+            inserter.add_row(
+                "components",
+                (
+                    cc_num,
+                    False,
+                    comp["degraded"],
+                    len(comp["nodes"]),
+                    num_edges,
+                    len(comp["patts"]),
+                    comp["bb"][0],
+                    comp["bb"][1],
+                    json.dumps(comp["decomposition_truncated"]),
+                ),
+            )
+        inserter.flush()
+
+        conn.execute("BEGIN")
+        for table_name, col in INDEXES:
+            conn.execute(
+                "CREATE INDEX {} ON {} ({})".format(
+                    quote("{}_{}".format(table_name, col)),
+                    quote(table_name),
+                    quote(col),
+                )
+            )
+        conn.execute("COMMIT")
+    finally:
+        conn.close()
+
+
+def _query(db_path, stmt, params):
+    """Runs a query, returning a list of dicts (one per row)."""
+    conn = sqlite3.connect(db_path)
+    try:
+        conn.row_factory = sqlite3.Row
+        return [dict(row) for row in conn.execute(stmt, params)]
+    finally:
+        conn.close()
+
+
+def find_nodes(db_path, name):
+    """Returns a list of the nodes with a given name.
+
+    Each node is represented as a dict mapping column names to values. There
+    can be more than one node with the same name, since we sometimes
+    duplicate nodes (e.g. when they're at the boundary of two patterns); the
+    original node will be listed first. If there aren't any nodes with this
+    name, this returns an empty list.
+    """
+    return _query(
+        db_path,
+        "SELECT * FROM nodes WHERE name = ? ORDER BY node_id",
+        (name,),
+    )
+
+
+def get_component(db_path, cc_num):
+    """Returns everything in a component.
+
+    The output is a dict with keys "component" (the row from the components
+    table, as a dict), "nodes", "edges", and "patterns" (lists of rows, as
+    dicts). Raises a ValueError if this component doesn't exist.
+    """
+    comp = _query(
+        db_path, "SELECT * FROM components WHERE component = ?", (cc_num,)
+    )
+    if len(comp) == 0:
+        raise ValueError("Component {} doesn't exist.".format(cc_num))
+    out = {"component": comp[0]}
+    for table_name, order in (
+        ("nodes", "node_id"),
+        ("edges", "src_id, tgt_id"),
+        ("patterns", "pattern_id"),
+    ):
+        out[table_name] = _query(
+            db_path,
+            "SELECT * FROM {} WHERE component = ? ORDER BY {}".format(
+                table_name, order
+            ),
+            (cc_num,),
+        )
+    return out
@@ -0,0 +1,308 @@
+# Copyright (C) 2016-- Marcus Fedarko, Jay Ghurye, Todd Treangen, Mihai Pop
+# Authored by Marcus Fedarko
+#
+# This file is part of MetagenomeScope.
+#
+# MetagenomeScope is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# MetagenomeScope is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with MetagenomeScope.  If not, see <http://www.gnu.org/licenses/>.
+####
+# Quick "triage" of an assembly graph: node/edge counts, component sizes,
+# etc. This is what "mgsc info" uses.
+#
+# The idea is that this should be fast enough to run on any graph before
+# actually visualizing it, so that you can figure out reasonable values for
+# -maxn / -maxe without having to wait for the entire pipeline to run. So we
+# don't build any NetworkX objects here: we just pass a GraphInfo object to
+# the parser (as a graph "target" -- see assembly_graph_parser's docs), which
+# only remembers node lengths and the edge list, and then compute connected
+# components using a union-find.
+
+from array import array
+import numpy
+
+from . import assembly_graph_parser, config
+from .input_node_utils import n50
+from .layout_utils import estimate_layout_cost
+from .msg_utils import operation_msg, conclude_msg
+from .union_find import UnionFind
+
+
+class GraphInfo(object):
+    """Summarizes an assembly graph without building the whole thing."""
+
+    def __init__(
+        self,
+        filename,
+        input_format=None,
+        validation=config.VALIDATION_DEFAULT,
+        assume_oriented=False,
+    ):
+        self.filename = filename
+        self.assume_oriented = assume_oriented
+        self.basename = assembly_graph_parser.get_basename(filename)
+        self.filetype = assembly_graph_parser.sniff_filetype(
+            filename, input_format
+        )
+
+        # Node name -> integer index
+        self.name2idx = {}
+        # These are indexed by node index. Lengths are None if not given.
+        self.lengths = []
+        self.orientations = []
+        # Edge list, as node indices. (We use arrays, rather than lists, to
+        # save on memory.)
+        self.srcs = array("q")
+        self.tgts = array("q")
+
+        operation_msg(
+            "Reading and parsing input file {}...".format(self.basename)
+        )
+        assembly_graph_parser.parse(
+            filename,
+            digraph=self,
+            input_format=self.filetype,
+            validation=validation,
+            assume_oriented=assume_oriented,
+        )
+        conclude_msg()
+
+        operation_msg("Identifying connected components...")
+        self.compute_components()
+        conclude_msg()
+
+    def _get_idx(self, name):
+        if name not in self.name2idx:
+            self.name2idx[name] = len(self.lengths)
+            self.lengths.append(None)
+            self.orientations.append(None)
+        return self.name2idx[name]
+
+    def add_node(self, name, **attrs):
+        """Mimics nx.DiGraph.add_node(). Only length/orientation are kept."""
+        idx = self._get_idx(name)
+        if "length" in attrs:
+            self.lengths[idx] = attrs["length"]
+        if "orientation" in attrs:
+            self.orientations[idx] = attrs["orientation"]
+
+    def add_edge(self, src, tgt, **attrs):
+        """Mimics nx.DiGraph.add_edge(). Edge attributes are ignored."""
+        self.srcs.append(self._get_idx(src))
+        self.tgts.append(self._get_idx(tgt))
+
+    def compute_components(self):
+        """Counts distinct edges and labels connected components.
+
+        After this is done, the components are numbered in the same order
+        that AssemblyGraph would sort them in (in descending order by node
+        count, then edge count).
+        """
+        self.num_nodes = len(self.lengths)
+        srcs = numpy.array(self.srcs, dtype=numpy.int64)
+        tgts = numpy.array(self.tgts, dtype=numpy.int64)
+        # Like NetworkX, we ignore repeated declarations of the same edge
+        if len(srcs) > 0:
+            _, first_pos = numpy.unique(
+                srcs * self.num_nodes + tgts, return_index=True
+            )
+            srcs = srcs[first_pos]
+            tgts = tgts[first_pos]
+        self.num_edges = len(srcs)
+
+        uf = UnionFind()
+        for a, b in zip(srcs.tolist(), tgts.tolist()):
+            uf.union(a, b)
+        _, node_cc = numpy.unique(
+            [uf.find(i) for i in range(self.num_nodes)], return_inverse=True
+        )
+        num_ccs = int(node_cc.max()) + 1 if self.num_nodes > 0 else 0
+
+        node_cts = numpy.bincount(node_cc, minlength=num_ccs)
+        edge_cts = numpy.bincount(node_cc[srcs], minlength=num_ccs)
+        lengths = numpy.array(
+            [0 if x is None else x for x in self.lengths], dtype=numpy.float64
+        )
+        length_sums = numpy.bincount(
+            node_cc, weights=lengths, minlength=num_ccs
+        )
+        # Sort components by node count, then edge count (both descending)
+        order = numpy.lexsort((-edge_cts, -node_cts))
+        self.component_node_counts = node_cts[order].tolist()
+        self.component_edge_counts = edge_cts[order].tolist()
+        self.component_lengths = length_sums[order].tolist()
+        self.component_costs = [
+            estimate_layout_cost(n, e)
+            for n, e in zip(
+                self.component_node_counts, self.component_edge_counts
+            )
+        ]
+
+    @property
+    def num_components(self):
+        return len(self.component_node_counts)
+
+    def get_sequence_lengths(self):
+        """Returns a list of the lengths of the sequences in the graph.
+
+        For filetypes where each sequence is represented by two nodes (see
+        assembly_graph_parser.has_rc_nodes()), we only count the "+" node for
+        each sequence. Nodes without a length are ignored.
+        """
+        only_pos = assembly_graph_parser.has_rc_nodes(
+            self.filetype, self.assume_oriented
+        )
+        return [
+            length
+            for length, orientation in zip(self.lengths, self.orientations)
+            if length is not None and (not only_pos or orientation == "+")
+        ]
+
+    def get_size_distribution(self):
+        """Bins components by their node counts.
+
+        Bins are powers of 2: [1, 1], [2, 3], [4, 7], [8, 15], etc. Returns a
+        list of (low, high, # components, # nodes, # edges) tuples, one for
+        each nonempty bin, in ascending order.
+        """
+        bins = {}
+        for n, e in zip(
+            self.component_node_counts, self.component_edge_counts
+        ):
+            low = 1 << (n.bit_length() - 1)
+            if low not in bins:
+                bins[low] = [0, 0, 0]
+            bins[low][0] += 1
+            bins[low][1] += n
+            bins[low][2] += e
+        return [
+            (low, 2 * low - 1, bins[low][0], bins[low][1], bins[low][2])
+            for low in sorted(bins)
+        ]
+
+    def get_too_large_components(self, max_node_count, max_edge_count):
+        """Returns indices of components that exceed -maxn or -maxe."""
+        return [
+            i
+            for i in range(self.num_components)
+            if self.component_node_counts[i] > max_node_count
+            or self.component_edge_counts[i] > max_edge_count
+        ]
+
+    def to_str(
+        self,
+        max_node_count=config.MAXN_DEFAULT,
+        max_edge_count=config.MAXE_DEFAULT,
+        num_top_components=config.INFO_TOP_COMPONENTS_DEFAULT,
+    ):
+        """Returns a human-readable summary of the graph."""
+        lines = [
+            "Summary of {} ({}):".format(self.basename, self.filetype),
+            "  Nodes: {:,}".format(self.num_nodes),
+            "  Edges: {:,}".format(self.num_edges),
+            "  Connected components: {:,}".format(self.num_components),
+        ]
+        seq_lengths = self.get_sequence_lengths()
+        if len(seq_lengths) > 0:
+            if assembly_graph_parser.has_rc_nodes(
+                self.filetype, self.assume_oriented
+            ):
+                note = " (each sequence counted once)"
+            else:
+                note = ""
+            lines.append(
+                "  Total sequence length{}: {:,}".format(
+                    note, int(sum(seq_lengths))
+                )
+            )
+            lines.append("  N50: {:,}".format(int(n50(seq_lengths))))
+
+        lines.append("")
+        lines.append("Component size distribution (by node count):")
+        lines.append(
+            "  {:>15}  {:>12}  {:>12}  {:>12}".format(
+                "# nodes", "# components", "total nodes", "total edges"
+            )
+        )
+        for low, high, cc_ct, node_ct, edge_ct in self.get_size_distribution():
+            if low == high:
+                size_range = "{:,}".format(low)
+            else:
+                size_range = "{:,}-{:,}".format(low, high)
+            lines.append(
+                "  {:>15}  {:>12,}  {:>12,}  {:>12,}".format(
+                    size_range, cc_ct, node_ct, edge_ct
+                )
+            )
+
+        too_large = set(
+            self.get_too_large_components(max_node_count, max_edge_count)
+        )
+        total_cost = sum(
+            c for i, c in enumerate(self.component_costs) if i not in too_large
+        )
+        num_shown = min(num_top_components, self.num_components)
+        if num_shown > 0:
+            lines.append("")
+            lines.append(
+                "Largest {:,} component(s), with estimated share of total "
+                "layout time:".format(num_shown)
+            )
+            lines.append(
+                "  {:>6}  {:>10}  {:>10}  {:>14}  {:>11}".format(
+                    "#", "nodes", "edges", "total length", "layout time"
+                )
+            )
+            for i in range(num_shown):
+                if i in too_large:
+                    share = "skipped"
+                else:
+                    share = "{:.1f}%".format(
+                        100 * self.component_costs[i] / total_cost
+                    )
+                lines.append(
+                    "  {:>6,}  {:>10,}  {:>10,}  {:>14,}  {:>11}".format(
+                        i + 1,
+                        self.component_node_counts[i],
+                        self.component_edge_counts[i],
+                        int(self.component_lengths[i]),
+                        share,
+                    )
+                )
+
+        lines.append("")
+        if len(too_large) > 0:
+            lines.append(
+                "With -maxn {:,} and -maxe {:,}, {:,} component(s) ({:,} "
+                "nodes, {:,} edges) would be skipped.".format(
+                    max_node_count,
+                    max_edge_count,
+                    len(too_large),
+                    sum(self.component_node_counts[i] for i in too_large),
+                    sum(self.component_edge_counts[i] for i in too_large),
+                )
+            )
+        else:
+            lines.append(
+                "With -maxn {:,} and -maxe {:,}, all components would be "
+                "laid out.".format(max_node_count, max_edge_count)
+            )
+        if self.num_components > 0:
+            lines.append(
+                "To lay out every component, use -maxn {:,} -maxe {:,} (or "
+                "higher).".format(
+                    max(self.component_node_counts),
+                    # -maxe has to be at least 1
+                    max(max(self.component_edge_counts), 1),
+                )
+            )
+        return "\n".join(lines)
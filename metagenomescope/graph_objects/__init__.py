@@ -1,4 +1,5 @@
 from .assembly_graph import AssemblyGraph
+from .paged_assembly_graph import PagedAssemblyGraph
 from .pattern import Pattern, StartEndPattern
 
-__all__ = ["AssemblyGraph", "Pattern", "StartEndPattern"]
+__all__ = ["AssemblyGraph", "PagedAssemblyGraph", "Pattern", "StartEndPattern"]
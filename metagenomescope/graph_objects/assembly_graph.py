@@ -1,17 +1,31 @@
 import math
 import json
-import os
+import time
+import multiprocessing
 from copy import deepcopy
 from operator import itemgetter
-from collections import deque
+from collections import deque, defaultdict
+from itertools import chain
 import numpy
 import networkx as nx
-import pygraphviz
 
 
-from .. import assembly_graph_parser, config, layout_utils
+from .. import (
+    assembly_graph_parser,
+    coarsening,
+    config,
+    export_utils,
+    layout_utils,
+    layout_cost,
+    progress,
+    simplification,
+    union_find,
+    user_patterns,
+)
 from ..msg_utils import operation_msg, conclude_msg
 from .pattern import StartEndPattern, Pattern
+from . import parallel_validation
+from .decomposition_budget import DecompositionBudget
 
 
 class AssemblyGraph(object):
@@ -29,16 +43,134 @@ class AssemblyGraph(object):
     https://www.thedigitalcatonline.com/blog/2014/08/20/python-3-oop-part-3-delegation-composition-and-inheritance/
     """
 
+    # Reserved attributes we use for nodes/edges -- see self.check_attrs().
+    INTERNAL_NODE_ATTRS = frozenset(
+        [
+            "relative_length",
+            "longside_proportion",
+            "width",
+            "height",
+            "x",
+            "y",
+            "relative_x",
+            "relative_y",
+            "parent_id",
+            "name",
+            "is_dup",
+            "cc_num",
+        ]
+    )
+
+    INTERNAL_EDGE_ATTRS = frozenset(
+        [
+            "ctrl_pt_coords",
+            "relative_ctrl_pt_coords",
+            "parent_id",
+            "is_outlier",
+            "relative_weight",
+            "orig_src",
+            "orig_tgt",
+            "is_dup",
+            "cc_num",
+            # these are used in the JS, so we exclude them here out of an
+            # abundance of caution
+            "source",
+            "target",
+        ]
+    )
+
     def __init__(
         self,
         filename,
         max_node_count=config.MAXN_DEFAULT,
         max_edge_count=config.MAXE_DEFAULT,
+        digraph=None,
+        first_node_id=0,
+        input_format=None,
+        validation=config.VALIDATION_DEFAULT,
+        time_budget=None,
+        layout_workers=config.LAYOUT_WORKERS_DEFAULT,
+        decomposition_workers=config.DECOMPOSITION_WORKERS_DEFAULT,
+        decomposition_time_limit=None,
+        decomposition_max_calls=None,
+        max_pattern_depth=None,
+        cost_model=None,
+        assume_oriented=False,
+        clip_tips_length=None,
+        min_coverage=None,
+        transitive_reduction=False,
+        bubble_file=None,
+        user_pattern_file=None,
     ):
-        """Parses the input graph file and initializes the AssemblyGraph."""
+        """Parses the input graph file and initializes the AssemblyGraph.
+
+        filename can be "-", in which case we'll read the graph from stdin;
+        input_format (one of the keys of
+        assembly_graph_parser.SUPPORTED_FILETYPE_TO_PARSER) must be given in
+        this case. If input_format is None, we'll try to figure out the
+        filetype from filename.
+
+        validation should be one of config.VALIDATION_LEVELS; this controls
+        how much effort we put into checking that the input graph is valid,
+        both in the parser and in check_attrs().
+
+        If assume_oriented is True, we'll assume that the input graph is
+        already oriented, and won't create reverse-complement nodes/edges
+        for GFA or LastGraph files (see the comments at the top of
+        assembly_graph_parser.py).
+
+        If digraph is not None, then we'll skip parsing the input file and
+        just use digraph (which should look like the output of one of the
+        parsers in assembly_graph_parser, i.e. a nx.DiGraph keyed by node
+        name) as the graph. This is used in out-of-core mode, where we
+        create an AssemblyGraph for each "page" of components at a time. In
+        this case, first_node_id should be set so that the integer node IDs
+        assigned to this graph don't collide with the node IDs of previously
+        processed pages.
+
+        If time_budget is not None, it should be the number of seconds we
+        have to get through everything (starting from when this constructor
+        is called); see apply_time_budget(). layout_workers is the number of
+        processes used to run dot on components in parallel, and
+        decomposition_workers is the number of processes used to check nodes
+        for patterns in parallel (see parallel_validation.py). cost_model
+        should be a layout_cost.LayoutCostModel -- if it's None, we'll make
+        a new one with the default coefficients. (We pass this in, rather
+        than always making a new one, so that recorded timings can be shared
+        across "pages" and saved for future runs.)
+
+        decomposition_time_limit, decomposition_max_calls, and
+        max_pattern_depth limit how much effort we put into decomposing each
+        component (see decomposition_budget.py). Components where we hit
+        one of these limits are recorded in self.truncated_components.
+
+        clip_tips_length, min_coverage, and transitive_reduction control the
+        (optional) simplification of the graph we do before anything else;
+        see simplification.simplify(). Everything removed is stored in
+        self.removed_nodes and self.removed_edges.
+
+        bubble_file and user_pattern_file are (optional) paths to files of
+        user-specified bubbles / patterns (see user_patterns.py). These are
+        read in here, so that we can complain about any problems with them
+        early on, and collapsed before automatic pattern detection (see
+        add_user_patterns()).
+        """
+        self.start_time = time.time()
         self.filename = filename
         self.max_node_count = max_node_count
         self.max_edge_count = max_edge_count
+        assembly_graph_parser.check_validation_level(validation)
+        self.validation = validation
+        self.assume_oriented = assume_oriented
+        self.time_budget = time_budget
+        self.layout_workers = layout_workers
+        self.decomposition_workers = decomposition_workers
+        self.decomposition_time_limit = decomposition_time_limit
+        self.decomposition_max_calls = decomposition_max_calls
+        self.max_pattern_depth = max_pattern_depth
+        if cost_model is None:
+            cost_model = layout_cost.LayoutCostModel()
+        self.cost_model = cost_model
 
         # Each entry in these structures will be a Pattern (or subclass).
         # NOTE that these patterns will only be "represented" in
@@ -49,68 +181,89 @@ class AssemblyGraph(object):
         self.cyclic_chains = []
         self.bubbles = []
         self.frayed_ropes = []
+        # User-specified patterns that aren't any of the above types
+        self.misc_patterns = []
 
         self.id2pattern = {}
 
-        # Reserved attributes we use for nodes/edges -- see self.check_attrs().
-        self.internal_node_attrs = set(
-            [
-                "relative_length",
-                "longside_proportion",
-                "width",
-                "height",
-                "x",
-                "y",
-                "relative_x",
-                "relative_y",
-                "parent_id",
-                "name",
-                "is_dup",
-                "cc_num",
-            ]
-        )
-
-        self.internal_edge_attrs = set(
-            [
-                "ctrl_pt_coords",
-                "relative_ctrl_pt_coords",
-                "parent_id",
-                "is_outlier",
-                "relative_weight",
-                "orig_src",
-                "orig_tgt",
-                "is_dup",
-                "cc_num",
-                # these are used in the JS, so we exclude them here out of an
-                # abundance of caution
-                "source",
-                "target",
-            ]
-        )
+        self.internal_node_attrs = set(AssemblyGraph.INTERNAL_NODE_ATTRS)
+        self.internal_edge_attrs = set(AssemblyGraph.INTERNAL_EDGE_ATTRS)
 
         # "Extra" data for nodes/edges -- e.g. GC content, coverage,
         # multiplicity, ...
         self.extra_node_attrs = set()
         self.extra_edge_attrs = set()
 
-        self.basename = os.path.basename(self.filename)
-        operation_msg(
-            "Reading and parsing input file {}...".format(self.basename)
-        )
+        self.basename = assembly_graph_parser.get_basename(self.filename)
         # NOTE: Ideally we'd just return this along with the digraph from
         # assembly_graph_parser.parse(), but uhhhh that will make me refactor
         # like 20 tests and I don't want to do that ._.
-        self.filetype = assembly_graph_parser.sniff_filetype(self.filename)
+        self.filetype = assembly_graph_parser.sniff_filetype(
+            self.filename, input_format
+        )
 
-        self.digraph = assembly_graph_parser.parse(self.filename)
-        self.check_attrs()
-        conclude_msg()
+        if digraph is None:
+            operation_msg(
+                "Reading and parsing input file {}...".format(self.basename)
+            )
+            self.digraph = assembly_graph_parser.parse(
+                self.filename,
+                input_format=self.filetype,
+                validation=self.validation,
+                assume_oriented=self.assume_oriented,
+            )
+            self.check_attrs()
+            conclude_msg()
+        else:
+            self.digraph = digraph
+            self.check_attrs()
+
+        # Read user-specified patterns. We check that the node names in
+        # these files are valid now, while self.digraph is still keyed by
+        # name (and before simplification, etc. remove anything).
+        self.user_patterns = []
+        if bubble_file is not None:
+            self.user_patterns.extend(
+                user_patterns.parse_bubble_file(bubble_file)
+            )
+        if user_pattern_file is not None:
+            self.user_patterns.extend(
+                user_patterns.parse_pattern_file(user_pattern_file)
+            )
+        user_patterns.check_node_names(self.user_patterns, self.digraph)
+        for up in self.user_patterns:
+            if up.pattern_type == "bubble" and up.source is None:
+                user_patterns.find_source_and_sink(up, self.digraph)
+
+        # Simplify the graph, if requested. We do this before removing
+        # too-large components, since simplification can shrink components.
+        self.removed_nodes = []
+        self.removed_edges = []
+        if (
+            clip_tips_length is not None
+            or min_coverage is not None
+            or transitive_reduction
+        ):
+            operation_msg("Simplifying the graph...")
+            self.removed_nodes, self.removed_edges = simplification.simplify(
+                self.digraph,
+                clip_tips_length=clip_tips_length,
+                min_coverage=min_coverage,
+                transitive_reduction=transitive_reduction,
+                get_rc_node_name=simplification.get_rc_node_name_func(
+                    self.filetype, self.assume_oriented
+                ),
+            )
+            conclude_msg()
 
         # Remove nodes/edges in components that are too large to lay out.
         self.num_too_large_components = 0
+        # (num nodes, num edges, total length) for each of these components,
+        # so that the viewer can at least say how big they were
+        self.skipped_components = []
         self.remove_too_large_components()
 
-        self.reindex_digraph()
+        self.reindex_digraph(first_node_id)
 
         # Initialize all edges with is_dup by default, so that in the future we
         # can distinguish easily between duplicate and non-duplicate edges
@@ -119,7 +272,15 @@ class AssemblyGraph(object):
 
         # Number of nodes in the graph, including patterns and duplicate nodes.
         # Used for assigning new unique node IDs.
-        self.num_nodes = len(self.digraph)
+        self.num_nodes = first_node_id + len(self.digraph)
+
+        # If these are set before calling self.process(), they'll be used
+        # instead of computing node/edge scaling parameters from just the
+        # nodes/edges in this graph. (This lets us scale things consistently
+        # across "pages" in out-of-core mode.) See get_node_scaling_params()
+        # and get_edge_scaling_params().
+        self.node_scaling_params = None
+        self.edge_scaling_params = None
 
         # Holds the top-level decomposed digraph. All of the original nodes /
         # edges in the graph are accounted for within this graph in some way --
@@ -136,6 +297,22 @@ class AssemblyGraph(object):
         # memory, I think.)
         self.cc_num_to_bb = {}
 
+        # Components we'll do a "degraded" (faster, but uglier) layout of in
+        # order to meet the time budget. Each component is identified by the
+        # smallest top-level node ID within it in self.decomposed_digraph.
+        # (Set in apply_time_budget().)
+        self.degraded_components = set()
+
+        # Zoom levels for huge components (see compute_zoom_levels()), keyed
+        # the same way as self.degraded_components.
+        self.cc_zoom_levels = {}
+
+        # Components where we stopped decomposition early, due to hitting
+        # one of the decomposition limits. Keyed the same way as
+        # self.degraded_components; values are lists of reasons (see
+        # decomposition_budget.py). (Set in hierarchically_identify_patterns().)
+        self.truncated_components = {}
+
     def check_attrs(self):
         """Verifies that nodes and edges in self.digraph don't have attributes
         that would conflict with built-in attributes we store here.
@@ -145,7 +322,36 @@ class AssemblyGraph(object):
         job for future Marcus, I guess. But honestly I doubt a lot of people
         are going to be coming at us with graphs that have
         "longside_proportion" in their node attributes so I thiiiink we're ok.
+
+        This also figures out the "extra" node/edge attributes in the graph,
+        and saves the types of every attribute's values in
+        self.node_attr_types and self.edge_attr_types (see
+        assembly_graph_parser.get_attr_types()).
+
+        The parsers give us an AttrTrackingDiGraph, which already knows the
+        names of all of the attributes in the graph. If self.validation is
+        config.VALIDATION_STRICT, we still check each node and edge one at a
+        time. Otherwise, we just check these names, and -- for
+        config.VALIDATION_FAST -- only fall back to the slow check if
+        there's a conflict somewhere (so that we can say which node/edge has
+        the reserved attribute). With config.VALIDATION_NONE, we don't
+        check for conflicts at all.
         """
+        (
+            self.node_attr_types,
+            self.edge_attr_types,
+        ) = assembly_graph_parser.get_attr_types(self.digraph)
+        if self.validation != config.VALIDATION_STRICT:
+            node_attrs = set(self.node_attr_types)
+            edge_attrs = set(self.edge_attr_types)
+            if self.validation == config.VALIDATION_NONE or (
+                len(node_attrs & self.internal_node_attrs) == 0
+                and len(edge_attrs & self.internal_edge_attrs) == 0
+            ):
+                self.extra_node_attrs |= node_attrs - self.internal_node_attrs
+                self.extra_edge_attrs |= edge_attrs - self.internal_edge_attrs
+                return
+
         for node in self.digraph.nodes:
             data = self.digraph.nodes[node]
             fieldset = set(data.keys())
@@ -183,6 +389,13 @@ class AssemblyGraph(object):
                 num_nodes > self.max_node_count
                 or num_edges > self.max_edge_count
             ):
+                self.skipped_components.append(
+                    (
+                        num_nodes,
+                        num_edges,
+                        self.get_total_length(cc_node_ids),
+                    )
+                )
                 self.digraph.remove_nodes_from(cc_node_ids)
                 self.num_too_large_components += 1
                 operation_msg(
@@ -199,17 +412,32 @@ class AssemblyGraph(object):
                 "-maxn/-maxe parameters, or reducing the size of the graph."
             )
 
-    def reindex_digraph(self):
+    def get_total_length(self, node_ids):
+        """Returns the total length of some nodes in self.digraph.
+
+        Nodes without a length are ignored; if none of the nodes have a length,
+        returns None (same as what get_component_summary() does).
+        """
+        lengths = [
+            self.digraph.nodes[n]["length"]
+            for n in node_ids
+            if self.digraph.nodes[n].get("length") is not None
+        ]
+        return sum(lengths) if len(lengths) > 0 else None
+
+    def reindex_digraph(self, first_node_id=0):
         """Assigns every node in the graph a unique integer ID, and adds a
         "name" attribute containing the original ID. This unique integer ID
         should never be shown to the user, but will be used for things like
         layout and internal storage of nodes. This way, we can have multiple
         nodes with the same name without causing a problem.
 
+        IDs are assigned starting at first_node_id.
+
         Also calls self.save_orig_src_and_tgt() on every edge in the digraph.
         """
         self.digraph = nx.convert_node_labels_to_integers(
-            self.digraph, label_attribute="name"
+            self.digraph, first_label=first_node_id, label_attribute="name"
         )
         for edge in self.digraph.edges:
             self.save_orig_src_and_tgt(edge)
@@ -302,6 +530,7 @@ class AssemblyGraph(object):
 
         # Now, get all "starting" nodes (the incoming nodes on the middle node)
         starting_node_ids = list(g.pred[middle_node_id].keys())
+        starting_node_id_set = set(starting_node_ids)
 
         # A frayed rope must have multiple paths from which to converge to
         # the "middle node" section
@@ -332,7 +561,7 @@ class AssemblyGraph(object):
                 # We know now that all of the ending nodes only have one
                 # incoming node, but we don't know that about the starting
                 # nodes. Make sure that this frayed rope isn't cyclical.
-                if o in starting_node_ids:
+                if o in starting_node_id_set:
                     return False, None
 
         # Check the entire frayed rope's structure
@@ -345,6 +574,103 @@ class AssemblyGraph(object):
         # If we've made it here, this frayed rope is valid!
         return True, composite
 
+    @staticmethod
+    def find_frayed_ropes(g, node_ids, budget=None):
+        r"""Finds frayed ropes in a graph, using a single scan.
+
+        This is a generalization of is_valid_frayed_rope(): the middle of a
+        frayed rope can be a path of nodes, rather than just one node --
+
+        s1 -\               /-> e1
+             m1 -> ... -> mk
+        s2 -/               \-> e2
+
+        (In the hierarchical decomposition, this path will usually have
+        already been collapsed into a chain, in which case the middle is a
+        single chain node. But this works either way.)
+
+        Rather than trying each node as the start of a frayed rope, we go
+        through node_ids and only look at "convergence" nodes (with >= 2
+        incoming edges); from each of these, we walk along the middle path
+        until we reach the "divergence" node (with >= 2 outgoing edges).
+        Since each node is only walked through from the single convergence
+        node before it, this takes time linear in the size of the graph.
+
+        Returns a list of frayed ropes, each of which is a list of the node
+        IDs in the rope (start nodes, then middle nodes in order, then end
+        nodes). These frayed ropes don't overlap. (Two frayed ropes found by
+        this might share nodes -- e.g. if the end node of one is a start node
+        of another -- in which case we only return the first one, and the
+        other one can be found later on with the first one collapsed.)
+
+        If budget (a DecompositionBudget) is given, then looking at each node
+        in node_ids counts as one check of that node: we skip nodes whose
+        components are out of time / calls, and charge the rest.
+        """
+        ropes = []
+        used = set()
+        for conv_node_id in node_ids:
+            if budget is None:
+                rope = AssemblyGraph.find_frayed_rope_at(g, conv_node_id, used)
+            else:
+                if not budget.can_check(conv_node_id):
+                    continue
+                check_start = budget.start_check()
+                rope = AssemblyGraph.find_frayed_rope_at(g, conv_node_id, used)
+                budget.finish_check(conv_node_id, check_start)
+            if rope is not None:
+                used.update(rope)
+                ropes.append(rope)
+        return ropes
+
+    @staticmethod
+    def find_frayed_rope_at(g, conv_node_id, used):
+        """Looks for a frayed rope that converges at a node.
+
+        Returns the rope's node IDs (see find_frayed_ropes()), or None if
+        there isn't a frayed rope here that avoids the nodes in used.
+        """
+        starting_node_ids = g.pred[conv_node_id]
+        if len(starting_node_ids) < 2 or conv_node_id in used:
+            return None
+        # None of the start nodes can have extraneous outgoing nodes
+        if any(len(g.adj[n]) != 1 for n in starting_node_ids):
+            return None
+
+        # Walk along the middle of the rope, until it diverges
+        middle_node_ids = [conv_node_id]
+        curr_node_id = conv_node_id
+        while len(g.adj[curr_node_id]) == 1:
+            curr_node_id = next(iter(g.adj[curr_node_id]))
+            if len(g.pred[curr_node_id]) != 1:
+                # The middle converges again (or loops back around to the
+                # convergence node), so this isn't a frayed rope. (We'll try
+                # again from curr_node_id, if it's in node_ids.)
+                break
+            middle_node_ids.append(curr_node_id)
+        ending_node_ids = g.adj[curr_node_id]
+        if curr_node_id != middle_node_ids[-1] or len(ending_node_ids) < 2:
+            return None
+
+        # Ending nodes can't have extraneous incoming nodes, and they can't
+        # lead back to the start of the rope
+        if any(
+            len(g.pred[n]) != 1
+            or any(o in starting_node_ids for o in g.adj[n])
+            for n in ending_node_ids
+        ):
+            return None
+
+        composite = (
+            list(starting_node_ids) + middle_node_ids + list(ending_node_ids)
+        )
+        composite_set = set(composite)
+        if len(composite_set) != len(composite):
+            return None
+        if not used.isdisjoint(composite_set):
+            return None
+        return composite
+
     @staticmethod
     def is_valid_cyclic_chain(g, starting_node_id):
         """Identifies the cyclic chain that "starts at" a given starting
@@ -1102,13 +1428,230 @@ class AssemblyGraph(object):
         )
         return p
 
+    def add_user_patterns(self):
+        """Collapses the user-specified patterns in the decomposed digraph.
+
+        This should be called before automatic pattern detection, since
+        we'll only collapse nodes that are still in the top level of the
+        graph. The automatic pattern detection will then treat these
+        patterns like any other collapsed pattern (so they can be nested
+        within other patterns, but nothing inside them will be changed).
+
+        User-specified patterns can contain earlier user-specified patterns
+        (as long as they contain all of the nodes in these patterns), and
+        bubbles can share their start / end nodes with the end / start
+        nodes of earlier bubbles -- this is really common in MetaCarvel's
+        output. (We handle this by duplicating the shared node, as in
+        add_bubble().) Any other sort of overlap between patterns is an
+        error. Patterns containing nodes that were removed from the graph
+        (due to simplification, or being in a too-large component) are
+        skipped.
+
+        Returns the number of patterns skipped.
+        """
+        if len(self.user_patterns) == 0:
+            return 0
+        name2id = {}
+        for node_id, name in self.digraph.nodes(data="name"):
+            name2id[name] = node_id
+
+        # Lets us find the top-level user-specified pattern containing a
+        # node (or itself, if it isn't in a pattern yet)
+        top = union_find.UnionFind()
+        # Maps each user-specified pattern to the number of (non-duplicate)
+        # nodes within it, including within its descendant patterns
+        num_nodes = {}
+        type2collection = {
+            "bubble": self.bubbles,
+            "chain": self.chains,
+            "cyclicchain": self.cyclic_chains,
+            "frayedrope": self.frayed_ropes,
+        }
+        num_skipped = 0
+        for up in self.user_patterns:
+            if any(name not in name2id for name in up.member_names):
+                num_skipped += 1
+                continue
+            is_bubble = up.pattern_type == "bubble"
+            start_id = end_id = None
+            if is_bubble:
+                start_id = name2id[up.source]
+                end_id = name2id[up.sink]
+            member_ids = []
+            # Maps earlier patterns overlapping this one to the number of
+            # their nodes that are in this one
+            overlapping = defaultdict(int)
+            for name in up.member_names:
+                node_id = name2id[name]
+                t = top.find(node_id)
+                if t == node_id:
+                    member_ids.append(node_id)
+                    continue
+                tp = self.id2pattern[t]
+                if is_bubble and tp.pattern_type == "bubble":
+                    if node_id == start_id and tp.get_end_node() == node_id:
+                        start_id = t
+                        member_ids.append(t)
+                        continue
+                    if node_id == end_id and tp.get_start_node() == node_id:
+                        end_id = t
+                        member_ids.append(t)
+                        continue
+                overlapping[t] += 1
+            for t, ct in overlapping.items():
+                if ct != num_nodes[t] or t in (start_id, end_id):
+                    raise ValueError(
+                        up.get_err_prefix()
+                        + '" overlaps with another user-specified pattern'
+                    )
+                member_ids.append(t)
+            if is_bubble:
+                # (The start / end node must be top-level, or be shared with
+                # another bubble)
+                if top.find(start_id) != start_id or (
+                    top.find(end_id) != end_id
+                ):
+                    raise ValueError(
+                        up.get_err_prefix()
+                        + '" overlaps with another user-specified pattern'
+                    )
+                if start_id == end_id:
+                    raise ValueError(
+                        up.get_err_prefix()
+                        + '" has the same start and end node'
+                    )
+            if not user_patterns.is_contiguous(
+                member_ids, self.decomposed_digraph
+            ):
+                raise ValueError(up.get_err_prefix() + config.CONTIGUOUS_ERR)
+
+            if is_bubble:
+                p = self.add_bubble(member_ids, start_id, end_id)
+            else:
+                p = self.add_pattern(member_ids, up.pattern_type)
+            type2collection.get(up.pattern_type, self.misc_patterns).append(p)
+            self.id2pattern[p.pattern_id] = p
+
+            ct = 0
+            for c in p.node_ids:
+                top.union(p.pattern_id, c)
+                if c in num_nodes:
+                    ct += num_nodes[c]
+                elif not self.is_pattern(c):
+                    if not self.digraph.nodes[c].get("is_dup", False):
+                        ct += 1
+            num_nodes[p.pattern_id] = ct
+        return num_skipped
+
+    def make_decomposition_budget(self, digraph):
+        """Returns a DecompositionBudget for the components in digraph.
+
+        digraph should be the decomposed digraph, or a subgraph of it
+        containing entire components. The budget uses the decomposition
+        limits we were given; if we weren't given any, this returns None.
+        """
+        if (
+            self.decomposition_time_limit is None
+            and self.decomposition_max_calls is None
+            and self.max_pattern_depth is None
+        ):
+            return None
+        budget = DecompositionBudget(
+            digraph,
+            self.decomposition_time_limit,
+            self.decomposition_max_calls,
+            self.max_pattern_depth,
+        )
+        # (New patterns' depths are based on the depths of the top-level
+        # patterns they contain)
+        for n in digraph.nodes:
+            if self.is_pattern(n):
+                budget.pattern_depth[n] = self.id2pattern[n].get_depth(self)
+        return budget
+
     def hierarchically_identify_patterns(self):
         """Run all of the pattern detection algorithms above on the graph
         repeatedly until the graph has been "fully" squished into patterns.
         """
         # We'll modify this as we go through this method
         self.decomposed_digraph = deepcopy(self.digraph)
+        parallel = self.decomposition_workers > 1
+        if parallel:
+            # Keep track of which nodes we modify, so that we know which
+            # precomputed validator outputs are still correct
+            self.decomposed_digraph = (
+                parallel_validation.ChangeTrackingDiGraph(
+                    self.decomposed_digraph
+                )
+            )
+
+        num_skipped = self.add_user_patterns()
+        if len(self.user_patterns) > 0:
+            operation_msg(
+                (
+                    "Collapsed {:,} user-specified pattern(s); skipped {:,} "
+                    "containing nodes that were removed from the graph."
+                ).format(len(self.id2pattern), num_skipped),
+                True,
+            )
+
+        budget = self.make_decomposition_budget(self.decomposed_digraph)
+        self.collapse_patterns(budget)
+        if budget is not None:
+            self.truncated_components = budget.get_truncated_components(
+                self.decomposed_digraph
+            )
+            if len(self.truncated_components) > 0:
+                operation_msg(
+                    (
+                        "Stopped pattern decomposition early in {:,} "
+                        "component(s), due to the decomposition limits."
+                    ).format(len(self.truncated_components)),
+                    True,
+                )
+        # Now that we're done here, go through all the nodes and edges in the
+        # top level of the graph and record that they don't have a parent
+        # pattern
+        for node_id in self.decomposed_digraph.nodes:
+            if not self.is_pattern(node_id):
+                self.digraph.nodes[node_id]["parent_id"] = None
+        for edge in self.decomposed_digraph.edges:
+            self.decomposed_digraph.edges[edge]["parent_id"] = None
+
+    def collapse_patterns(self, budget=None, region=None):
+        """Repeatedly runs the pattern validators on the decomposed digraph,
+        collapsing whatever they find, until nothing more can be collapsed.
+
+        budget is an optional DecompositionBudget. region is an optional set
+        of top-level node IDs: if it's given, we only check these nodes (and
+        the patterns we create from them) for patterns. This is used by
+        remove_nodes_and_edges() to only redo decomposition near the stuff
+        that changed. (Validators can still look at anything in the graph;
+        region just limits which nodes we start them from. We add the IDs of
+        new patterns, and their neighbors, to region as we go -- so that
+        the new patterns can be collapsed into bigger patterns.)
+
+        If self.decomposition_workers > 1, we use the same
+        parallel_validation.ValidatorPool for every pass through the graph
+        in this call, and shut it down when we're done.
+        """
+        pool = None
+        if self.decomposition_workers > 1:
+            pool = parallel_validation.ValidatorPool(
+                self.decomposed_digraph, self.decomposition_workers, region
+            )
+        try:
+            self.run_collapse_passes(budget, region, pool)
+        finally:
+            if pool is not None:
+                pool.close()
 
+    def run_collapse_passes(self, budget, region, pool):
+        """Does the actual work of collapse_patterns().
+
+        pool is a parallel_validation.ValidatorPool, or None if we aren't
+        running validators in parallel.
+        """
         while True:
             # Run through all of the pattern detection methods on all of the
             # top-level nodes (or node groups) in the decomposed DiGraph.
@@ -1133,11 +1676,55 @@ class AssemblyGraph(object):
             ):
                 # We sort the nodes in order to make this deterministic
                 # (I doubt the extra time cost from sorting will be a big deal)
-                candidate_nodes = sorted(list(self.decomposed_digraph.nodes))
+                if region is None:
+                    candidate_nodes = sorted(
+                        list(self.decomposed_digraph.nodes)
+                    )
+                else:
+                    candidate_nodes = sorted(
+                        n for n in region if n in self.decomposed_digraph
+                    )
+                precomputed = {}
+                if pool is not None:
+                    to_precompute = candidate_nodes
+                    if budget is not None:
+                        to_precompute = [
+                            c for c in candidate_nodes if budget.can_check(c)
+                        ]
+                    precomputed = pool.precompute(validator, to_precompute)
+                    self.decomposed_digraph.touched = set()
                 while len(candidate_nodes) > 0:
                     n = candidate_nodes[0]
-                    validator_outputs = validator(self.decomposed_digraph, n)
+                    if budget is not None:
+                        if not budget.can_check(n):
+                            # We've run out of time / calls for this node's
+                            # component, so leave it as is
+                            candidate_nodes.remove(n)
+                            continue
+                        check_start = budget.start_check()
+                    validator_outputs = None
+                    if n in precomputed:
+                        outputs, reads = precomputed.pop(n)
+                        # If nothing the validator looked at has changed
+                        # since we ran it, then running it again would just
+                        # give us the same thing
+                        if self.decomposed_digraph.touched.isdisjoint(reads):
+                            validator_outputs = outputs
+                    if validator_outputs is None:
+                        validator_outputs = validator(
+                            self.decomposed_digraph, n
+                        )
                     pattern_valid = validator_outputs[0]
+                    if pattern_valid and budget is not None:
+                        # (The start / end of a bubble get duplicated rather
+                        # than nested, if they're patterns.)
+                        not_nested = ()
+                        if ptype == "bubble":
+                            not_nested = validator_outputs[2:4]
+                        depth = budget.get_depth(
+                            validator_outputs[1], not_nested
+                        )
+                        pattern_valid = budget.depth_ok(n, depth)
                     if pattern_valid:
                         pattern_node_ids = validator_outputs[1]
 
@@ -1154,6 +1741,10 @@ class AssemblyGraph(object):
                         collection.append(p)
                         candidate_nodes.append(p.pattern_id)
                         self.id2pattern[p.pattern_id] = p
+                        if region is not None:
+                            self.add_to_region(region, p.pattern_id)
+                        if budget is not None:
+                            budget.add_pattern(n, p.pattern_id, depth)
                         for pn in p.node_ids:
                             # Remove nodes if they're in candidate nodes. There
                             # may be nodes in this pattern not in candidate
@@ -1170,18 +1761,86 @@ class AssemblyGraph(object):
                         # If the pattern was invalid, we still need to
                         # remove n
                         candidate_nodes.remove(n)
+                    if budget is not None:
+                        budget.finish_check(n, check_start)
+            # Frayed ropes are found all at once, rather than by calling a
+            # validator on each node (see find_frayed_ropes())
+            if self.collapse_frayed_ropes(budget, region) > 0:
+                something_collapsed = True
+
             if not something_collapsed:
                 # We didn't collapse anything... so we're done here! We can't
                 # do any more.
                 break
-        # Now that we're done here, go through all the nodes and edges in the
-        # top level of the graph and record that they don't have a parent
-        # pattern
-        for node_id in self.decomposed_digraph.nodes:
-            if not self.is_pattern(node_id):
-                self.digraph.nodes[node_id]["parent_id"] = None
-        for edge in self.decomposed_digraph.edges:
-            self.decomposed_digraph.edges[edge]["parent_id"] = None
+
+    def add_to_region(self, region, pattern_id):
+        """Adds a new pattern, and its neighbors, to a region.
+
+        See collapse_patterns().
+        """
+        region.add(pattern_id)
+        region.update(self.decomposed_digraph.succ[pattern_id])
+        region.update(self.decomposed_digraph.pred[pattern_id])
+
+    def collapse_frayed_ropes(self, budget=None, region=None):
+        """Finds and collapses frayed ropes in the decomposed digraph.
+
+        budget and region are the same as in collapse_patterns(). Returns the
+        number of frayed ropes collapsed.
+
+        Scanning each candidate node counts as a check against the budget
+        (see find_frayed_ropes()), and the time spent collapsing each rope
+        counts towards its component's time budget.
+        """
+        if region is None:
+            candidate_nodes = sorted(self.decomposed_digraph.nodes)
+        else:
+            candidate_nodes = sorted(
+                n for n in region if n in self.decomposed_digraph
+            )
+        num_collapsed = 0
+        for rope in AssemblyGraph.find_frayed_ropes(
+            self.decomposed_digraph, candidate_nodes, budget
+        ):
+            if budget is not None:
+                collapse_start = budget.start_check()
+                depth = budget.get_depth(rope)
+                if not budget.depth_ok(rope[0], depth):
+                    continue
+            p = self.add_pattern(rope, "frayedrope")
+            self.frayed_ropes.append(p)
+            self.id2pattern[p.pattern_id] = p
+            if region is not None:
+                self.add_to_region(region, p.pattern_id)
+            if budget is not None:
+                budget.add_pattern(rope[0], p.pattern_id, depth)
+                budget.add_time(rope[0], collapse_start)
+            num_collapsed += 1
+        return num_collapsed
+
+    @staticmethod
+    def get_node_scaling_params(lengths):
+        """Computes the parameters used to scale nodes based on their lengths.
+
+        Returns a 4-tuple of (min log length, max log length, 25th percentile
+        of log lengths, 75th percentile of log lengths). If the min and max
+        log lengths are equal, the two percentiles will be None (we won't
+        need them).
+
+        This is separate from scale_nodes() so that, in out-of-core mode, we
+        can compute these parameters using all of the nodes in the graph and
+        then apply them to one "page" of the graph at a time.
+        """
+        log_lengths = [
+            math.log(length, config.NODE_SCALING_LOG_BASE)
+            for length in lengths
+        ]
+        min_log_len = min(log_lengths)
+        max_log_len = max(log_lengths)
+        if min_log_len == max_log_len:
+            return min_log_len, max_log_len, None, None
+        q25, q75 = numpy.percentile(log_lengths, [25, 75])
+        return min_log_len, max_log_len, q25, q75
 
     def scale_nodes(self):
         """Scales nodes in the graph based on their lengths.
@@ -1201,7 +1860,9 @@ class AssemblyGraph(object):
         Previously, this scaled nodes in separate components differently.
         However, MetagenomeScope will (soon) be able to show multiple
         components at once, so we scale nodes based on the min/max lengths
-        throughout the entire graph.
+        throughout the entire graph. (If self.node_scaling_params has been
+        set, we'll use that instead of computing things from this graph's
+        nodes.)
         """
         node_lengths = nx.get_node_attributes(self.digraph, "length")
         node_log_lengths = {}
@@ -1209,8 +1870,13 @@ class AssemblyGraph(object):
             node_log_lengths[node] = math.log(
                 length, config.NODE_SCALING_LOG_BASE
             )
-        min_log_len = min(node_log_lengths.values())
-        max_log_len = max(node_log_lengths.values())
+        if self.node_scaling_params is None:
+            params = AssemblyGraph.get_node_scaling_params(
+                node_lengths.values()
+            )
+        else:
+            params = self.node_scaling_params
+        min_log_len, max_log_len, q25, q75 = params
         if min_log_len == max_log_len:
             for node in self.digraph.nodes:
                 self.digraph.nodes[node]["relative_length"] = 0.5
@@ -1219,9 +1885,6 @@ class AssemblyGraph(object):
                 ] = config.MID_LONGSIDE_PROPORTION
         else:
             log_len_range = max_log_len - min_log_len
-            q25, q75 = numpy.percentile(
-                list(node_log_lengths.values()), [25, 75]
-            )
             for node in self.digraph.nodes:
                 node_log_len = node_log_lengths[node]
                 self.digraph.nodes[node]["relative_length"] = (
@@ -1284,6 +1947,46 @@ class AssemblyGraph(object):
             data["height"] = area ** data["longside_proportion"]
             data["width"] = area / data["height"]
 
+    @staticmethod
+    def get_edge_scaling_params(weights):
+        """Computes the parameters used to scale edges based on their weights.
+
+        Returns a 4-tuple of (lower Tukey fence, upper Tukey fence, min
+        non-outlier weight, max non-outlier weight).
+
+        If there are less than 4 weights, the fences will be None (with such a
+        small number of data points the notion of "outliers" kinda breaks
+        apart). If there are less than 2 non-outlier weights, the min/max
+        weights will be None.
+
+        Outlier detection is done using "inner" Tukey fences, as described in
+        Exploratory Data Analysis (1977).
+        """
+        lf = None
+        uf = None
+        if len(weights) >= 4:
+            # Calculate lower and upper Tukey fences. First, compute the
+            # upper and lower quartiles (aka the 25th and 75th percentiles)
+            lq, uq = numpy.percentile(weights, [25, 75])
+            # Determine 1.5 * the interquartile range.
+            # (If desired, we could use other values besides 1.5 -- this
+            # isn't set in stone.)
+            d = 1.5 * (uq - lq)
+            # Now we can calculate the actual Tukey fences:
+            lf = lq - d
+            uf = uq + d
+            non_outlier_weights = [w for w in weights if lf <= w <= uf]
+        else:
+            # There are < 4 edges, so consider all edges as "non-outliers."
+            non_outlier_weights = list(weights)
+
+        min_ew = None
+        max_ew = None
+        if len(non_outlier_weights) >= 2:
+            min_ew = min(non_outlier_weights)
+            max_ew = max(non_outlier_weights)
+        return lf, uf, min_ew, max_ew
+
     def scale_edges(self):
         """Scales edges in the graph based on their weights, if present.
 
@@ -1314,8 +2017,9 @@ class AssemblyGraph(object):
         Relative scaling will only be done for non-outlier edges. This helps
         make things look more consistent.
 
-        Outlier detection is done using "inner" Tukey fences, as described in
-        Exploratory Data Analysis (1977).
+        The fences / min / max weights used here are computed by
+        get_edge_scaling_params(), unless self.edge_scaling_params has been
+        set (in which case we'll use that).
         """
 
         def _assign_default_weight_attrs(edges):
@@ -1339,56 +2043,30 @@ class AssemblyGraph(object):
                         "Duplicate edges shouldn't exist in the graph yet."
                     )
 
-            non_outlier_edges = []
-            non_outlier_edge_weights = []
-            # Only try to flag outlier edges if the graph contains at least 4
-            # edges. With < 4 data points, computing quartiles becomes a bit
-            # silly.
-            if len(weights) >= 4:
-                # Calculate lower and upper Tukey fences. First, compute the
-                # upper and lower quartiles (aka the 25th and 75th percentiles)
-                lq, uq = numpy.percentile(weights, [25, 75])
-                # Determine 1.5 * the interquartile range.
-                # (If desired, we could use other values besides 1.5 -- this
-                # isn't set in stone.)
-                d = 1.5 * (uq - lq)
-                # Now we can calculate the actual Tukey fences:
-                lf = lq - d
-                uf = uq + d
-                # Now, iterate through every edge and flag outliers.
-                # Non-outlier edges will be added to a list of edges that we'll
-                # scale relatively.
-                for edge in real_edges:
-                    data = self.digraph.edges[edge]
-                    ew = data[ew_field]
-                    if ew > uf:
-                        data["is_outlier"] = 1
-                        data["relative_weight"] = 1
-                    elif ew < lf:
-                        data["is_outlier"] = -1
-                        data["relative_weight"] = 0
-                    else:
-                        data["is_outlier"] = 0
-                        non_outlier_edges.append(edge)
-                        non_outlier_edge_weights.append(ew)
+            if self.edge_scaling_params is None:
+                params = AssemblyGraph.get_edge_scaling_params(weights)
             else:
-                # There are < 4 edges, so consider all edges as "non-outliers."
-                for edge in real_edges:
-                    data = self.digraph.edges[edge]
-                    if "is_dup" not in data or not data["is_dup"]:
-                        data["is_outlier"] = 0
-                        non_outlier_edges.append(edge)
-                        ew = data[ew_field]
-                        non_outlier_edge_weights.append(ew)
-                    else:
-                        raise ValueError(
-                            "Duplicate edges shouldn't exist in the graph yet."
-                        )
+                params = self.edge_scaling_params
+            lf, uf, min_ew, max_ew = params
+
+            # Now, iterate through every edge and flag outliers. Non-outlier
+            # edges will be scaled relatively, if possible.
+            non_outlier_edges = []
+            for edge in real_edges:
+                data = self.digraph.edges[edge]
+                ew = data[ew_field]
+                if lf is not None and ew > uf:
+                    data["is_outlier"] = 1
+                    data["relative_weight"] = 1
+                elif lf is not None and ew < lf:
+                    data["is_outlier"] = -1
+                    data["relative_weight"] = 0
+                else:
+                    data["is_outlier"] = 0
+                    non_outlier_edges.append(edge)
 
             # Perform relative scaling for non-outlier edges, if possible.
-            if len(non_outlier_edges) >= 2:
-                min_ew = min(non_outlier_edge_weights)
-                max_ew = max(non_outlier_edge_weights)
+            if min_ew is not None:
                 if min_ew != max_ew:
                     ew_range = max_ew - min_ew
                     for edge in non_outlier_edges:
@@ -1479,192 +2157,930 @@ class AssemblyGraph(object):
         # this function prettier, us 2020 denizens would welcome that.
         return [(ccs[t[0]], t[1], t[2]) for t in sorted_indices_and_cts]
 
-    def layout(self):
-        """Lays out the graph's components, handling patterns specially."""
-        # Do layout one component at a time.
-        # (We don't bother checking for skipped components, since we should
-        # have already called self.remove_too_large_components().)
-        first_small_component = False
-        for cc_i, cc_tuple in enumerate(
-            self.get_connected_components(), self.num_too_large_components + 1
+    def get_component_cost_features(self, cc_tuple):
+        """Returns the features used by the layout cost model for a component.
+
+        cc_tuple should be one of the tuples returned by
+        get_connected_components(). Returns a 4-tuple of (# nodes, # edges,
+        # patterns, max pattern nesting depth), which can be passed directly
+        to layout_cost.LayoutCostModel.predict() / record().
+        """
+        num_patterns = 0
+        depth = 0
+        for node_id in cc_tuple[0]:
+            if self.is_pattern(node_id):
+                patt = self.id2pattern[node_id]
+                num_patterns += patt.get_counts(self)[2] + 1
+                depth = max(depth, patt.get_depth(self))
+        return (cc_tuple[1], cc_tuple[2], num_patterns, depth)
+
+    def can_fake_layout(self, cc_tuple):
+        """Returns True if a component is just a single node (no edges).
+
+        We can "fake" the layout of these components without calling dot --
+        see layout().
+        """
+        return (
+            cc_tuple[1] == 1
+            and cc_tuple[2] == 0
+            and not self.is_pattern(next(iter(cc_tuple[0])))
+        )
+
+    def predict_layout_cost(self, cc_tuple, degraded=False):
+        """Predicts how many seconds it'll take to lay out a component."""
+        if self.can_fake_layout(cc_tuple):
+            return 0
+        return self.cost_model.predict(
+            *self.get_component_cost_features(cc_tuple), degraded=degraded
+        )
+
+    def remove_component(self, cc_node_ids):
+        """Removes a component (after pattern decomposition) from the graph.
+
+        cc_node_ids should be the set of top-level node IDs in the component,
+        as returned by get_connected_components(). We remove these nodes from
+        self.decomposed_digraph, and all of the patterns within this
+        component (and all of the nodes within these patterns) from
+        self.id2pattern and self.digraph.
+        """
+        removed_patt_ids = set()
+        for node_id in cc_node_ids:
+            if self.is_pattern(node_id):
+                patt_queue = deque([self.id2pattern[node_id]])
+                while len(patt_queue) > 0:
+                    curr_patt = patt_queue.popleft()
+                    removed_patt_ids.add(curr_patt.pattern_id)
+                    for child_node_id in curr_patt.node_ids:
+                        if self.is_pattern(child_node_id):
+                            patt_queue.append(self.id2pattern[child_node_id])
+                        else:
+                            self.digraph.remove_node(child_node_id)
+            else:
+                self.digraph.remove_node(node_id)
+        self.decomposed_digraph.remove_nodes_from(cc_node_ids)
+        for patt_id in removed_patt_ids:
+            del self.id2pattern[patt_id]
+        for patt_list in (
+            self.chains,
+            self.cyclic_chains,
+            self.bubbles,
+            self.frayed_ropes,
+            self.misc_patterns,
         ):
-            cc_node_ids = cc_tuple[0]
-            cc_full_node_ct = cc_tuple[1]
-            cc_full_edge_ct = cc_tuple[2]
+            patt_list[:] = [
+                p for p in patt_list if p.pattern_id not in removed_patt_ids
+            ]
 
-            if cc_full_node_ct >= 5:
-                operation_msg(
-                    "Laying out component {:,} ({:,} nodes, {:,} edges)...".format(
-                        cc_i, cc_full_node_ct, cc_full_edge_ct
-                    )
+    def get_parent_id(self, node_id):
+        """Returns the ID of the pattern containing a node or pattern.
+
+        Returns None if this node / pattern is in the top level of the graph.
+        """
+        if self.is_pattern(node_id):
+            return self.id2pattern[node_id].parent_id
+        return self.digraph.nodes[node_id].get("parent_id")
+
+    def get_top_level_id(self, node_id):
+        """Returns the ID of the top-level node / pattern containing a node.
+
+        (If this node is already in the top level, this just returns node_id.)
+        """
+        parent_id = self.get_parent_id(node_id)
+        while parent_id is not None:
+            node_id = parent_id
+            parent_id = self.get_parent_id(node_id)
+        return node_id
+
+    def get_dup_group(self, node_id):
+        """Returns a set of a node and all of its duplicates.
+
+        (Duplicates are linked to their original node by is_dup edges; see
+        add_bubble(). Duplicates can themselves be duplicated, so we follow
+        these edges as far as they go.)
+        """
+        group = set()
+        stack = [node_id]
+        while len(stack) > 0:
+            n = stack.pop()
+            if n in group:
+                continue
+            group.add(n)
+            for e in chain(
+                self.digraph.in_edges(n), self.digraph.out_edges(n)
+            ):
+                if self.digraph.edges[e].get("is_dup", False):
+                    stack.extend(e)
+        return group
+
+    def add_top_level_edge(self, src_id, tgt_id, edge_data):
+        """Adds an edge to the decomposed digraph, based on an edge's data in
+        self.digraph.
+        """
+        data = dict(edge_data)
+        data["parent_id"] = None
+        self.decomposed_digraph.add_edge(src_id, tgt_id, **data)
+
+    def dissolve_pattern(self, patt):
+        """Un-collapses a top-level pattern in the decomposed digraph.
+
+        This undoes add_pattern() / add_bubble(): the pattern's child nodes
+        and patterns are moved back to the top level, and edges incident on
+        them are rerouted accordingly. We figure out these edges from
+        self.digraph, rather than from the edges currently incident on the
+        pattern in the decomposed digraph -- this way, we don't have to
+        worry about multiple edges having been merged into one edge to or
+        from the pattern.
+
+        The pattern is removed from self.id2pattern, but not from the lists
+        of each type of pattern (self.chains, etc.); the caller should
+        handle that.
+        """
+        self.decomposed_digraph.remove_nodes_from([patt.pattern_id])
+        del self.id2pattern[patt.pattern_id]
+        for child_id in patt.node_ids:
+            if self.is_pattern(child_id):
+                child = self.id2pattern[child_id]
+                child.parent_id = None
+                self.decomposed_digraph.add_node(
+                    child_id, pattern_type=child.pattern_type
                 )
             else:
-                if not first_small_component:
-                    operation_msg(
-                        "Laying out small (each containing < 5 nodes) "
-                        "remaining component(s)..."
-                    )
-                    first_small_component = True
+                data = self.digraph.nodes[child_id]
+                data["parent_id"] = None
+                self.decomposed_digraph.add_node(child_id, **data)
+
+        # Now that all of the children are in the top level, add edges.
+        for child_id in patt.node_ids:
+            child_is_patt = self.is_pattern(child_id)
+            if child_is_patt:
+                member_ids = self.get_component_contents([child_id])[0]
+            else:
+                member_ids = [child_id]
+            for m in member_ids:
+                for e in self.digraph.out_edges(m):
+                    tgt = self.get_top_level_id(e[1])
+                    # Skip edges within this child pattern, since they're
+                    # already accounted for in its subgraph
+                    if not (child_is_patt and tgt == child_id):
+                        self.add_top_level_edge(
+                            child_id, tgt, self.digraph.edges[e]
+                        )
+                for e in self.digraph.in_edges(m):
+                    src = self.get_top_level_id(e[0])
+                    if not (child_is_patt and src == child_id):
+                        self.add_top_level_edge(
+                            src, child_id, self.digraph.edges[e]
+                        )
+
+    def undup_node(self, dup_id):
+        """Merges a top-level duplicate node back into its original node.
+
+        This undoes the duplication done in add_bubble(), once the bubble
+        that the duplicate was created for has been dissolved. Edges
+        incident on the duplicate are moved to the original node, and the
+        duplicate is removed from the graph.
 
-            # If this component contains just one basic node, and no edges or
-            # patterns, then we can "fake" its layout. This lets us avoid
-            # calling PyGraphviz a gazillion times, and speeds things up (esp
-            # for large graphs with gazillions of 1-node components).
-            # As a TODO, we can probs generalize this to other types of simple
-            # components -- e.g. components with just one loop edge (since we
-            # don't even use the control points from loop edges right now), etc
-            if cc_full_node_ct == 1 and cc_full_edge_ct == 0:
-                # Get the single value from the set without actually popping
-                # it, because knowing my luck I feel like that would cause
-                # problems.
-                # https://stackoverflow.com/questions/59825#comment67384382_60233
-                lone_node_id = next(iter(cc_node_ids))
-                if not self.is_pattern(lone_node_id):
-                    # Alright, we can fake this! Nice.
-                    data = self.digraph.nodes[lone_node_id]
-                    data["cc_num"] = cc_i
-                    data["x"] = data["width"] / 2
-                    data["y"] = data["height"] / 2
-                    self.cc_num_to_bb[cc_i] = (
-                        data["width"] + 0.1,
-                        data["height"] + 0.1,
+        Returns the ID of the original node.
+        """
+        # The original node is the node linked to this one by an is_dup edge
+        # that was created before this one (duplicates of this node, if any,
+        # will have been created later, so they'll have higher IDs)
+        linked = []
+        for e in chain(
+            self.digraph.in_edges(dup_id), self.digraph.out_edges(dup_id)
+        ):
+            if self.digraph.edges[e].get("is_dup", False):
+                linked.extend(n for n in e if n < dup_id)
+        orig_id = min(linked)
+
+        new_edges = []
+        for e in list(self.digraph.out_edges(dup_id)):
+            if e[1] == orig_id:
+                continue
+            tgt = orig_id if e[1] == dup_id else e[1]
+            data = dict(self.digraph.edges[e])
+            data["orig_src"] = orig_id
+            data["orig_tgt"] = tgt
+            new_edges.append((orig_id, tgt, data))
+        for e in list(self.digraph.in_edges(dup_id)):
+            # (Self-loops were already handled above)
+            if e[0] == orig_id or e[0] == dup_id:
+                continue
+            data = dict(self.digraph.edges[e])
+            data["orig_tgt"] = orig_id
+            new_edges.append((e[0], orig_id, data))
+
+        self.digraph.remove_node(dup_id)
+        self.decomposed_digraph.remove_nodes_from([dup_id])
+        for src, tgt, data in new_edges:
+            self.digraph.add_edge(src, tgt, **data)
+            self.add_top_level_edge(
+                self.get_top_level_id(src), self.get_top_level_id(tgt), data
+            )
+        return orig_id
+
+    def remove_nodes_and_edges(self, node_ids=(), edges=(), reason=None):
+        """Removes nodes and edges from the graph, updating the decomposition
+        and layout to match.
+
+        This is meant for interactive filtering (e.g. removing tips or
+        low-coverage nodes from an already-processed graph), where running
+        hierarchically_identify_patterns() and layout() again from scratch
+        would be really slow. Instead, we just:
+
+        1. Dissolve every pattern containing a removed node or an endpoint of
+           a removed edge (and all of these patterns' ancestors).
+        2. Remove the nodes (and their duplicates) and edges.
+        3. Merge duplicate nodes created for the dissolved patterns back into
+           their original nodes.
+        4. Run the validators again, but only starting from the top-level
+           nodes within config.INCREMENTAL_DECOMPOSITION_RADIUS edges of the
+           stuff that changed (see collapse_patterns()). The decomposition
+           limits we were given apply to the components containing these
+           nodes, just like in hierarchically_identify_patterns().
+        5. If the graph has already been laid out, lay out these components
+           again. Patterns that weren't dissolved keep their layouts, so
+           only the new patterns (and the top level of each component) have
+           to go through dot.
+
+        Patterns that weren't affected by the removal are left alone -- so
+        the resulting decomposition is valid, but it isn't necessarily
+        identical to what we'd get by decomposing the graph from scratch
+        (which might e.g. have grouped things differently in the first
+        place). Dissolved user-specified patterns aren't recreated.
+
+        node_ids should contain node IDs in self.digraph, and edges should
+        contain (source ID, target ID) tuples of edges in self.digraph. If
+        reason is given, the removed nodes / edges will be added to
+        self.removed_nodes / self.removed_edges with this reason (this should
+        be one of the reasons in simplification.py), so that they show up
+        in the visualization.
+
+        Notably, this doesn't redo the node / edge scaling. (This mirrors
+        how duplicate nodes don't influence scaling in process().)
+        """
+        for n in node_ids:
+            if n not in self.digraph.nodes:
+                raise ValueError("Node {} isn't in the graph.".format(n))
+        for e in edges:
+            if not self.digraph.has_edge(*e):
+                raise ValueError(
+                    "Edge {} -> {} isn't in the graph.".format(e[0], e[1])
+                )
+            if self.digraph.edges[e].get("is_dup", False):
+                raise ValueError(
+                    "Edge {} -> {} just links a duplicate node to its "
+                    "original node; it can't be removed by itself.".format(
+                        e[0], e[1]
                     )
-                    continue
+                )
 
-            # Lay out this component, using the node and edge data for
-            # top-level nodes and edges as well as the width/height computed
-            # for "pattern nodes" (in which other nodes, edges, and patterns
-            # can be contained).
-            gv_input = layout_utils.get_gv_header()
+        # Removing a node means removing all of its duplicates, too
+        to_remove = set()
+        for n in node_ids:
+            to_remove |= self.get_dup_group(n)
+        # (Edges incident on removed nodes will be removed anyway)
+        edges = [
+            e for e in edges if e[0] not in to_remove and e[1] not in to_remove
+        ]
 
-            # Populate GraphViz input with node information
-            # This mirrors what's done in Pattern.layout().
-            # Also, while we're at it, set component numbers to make traversal
-            # easier later on.
-            for node_id in cc_node_ids:
-                if self.is_pattern(node_id):
-                    self.id2pattern[node_id].set_cc_num(self, cc_i)
-                    # Lay out the pattern in isolation (could involve multiple
-                    # layers, since patterns can contain other patterns).
-                    self.id2pattern[node_id].layout(self)
-                    height = self.id2pattern[node_id].height
-                    width = self.id2pattern[node_id].width
-                    shape = self.id2pattern[node_id].shape
-                else:
-                    data = self.digraph.nodes[node_id]
-                    data["cc_num"] = cc_i
-                    height = data["height"]
-                    width = data["width"]
-                    shape = config.NODE_ORIENTATION_TO_SHAPE[
-                        data["orientation"]
+        if reason is not None:
+            for n in sorted(to_remove):
+                if not self.digraph.nodes[n].get("is_dup", False):
+                    self.removed_nodes.append(
+                        [self.digraph.nodes[n]["name"], reason]
+                    )
+            for src, tgt in edges:
+                self.removed_edges.append(
+                    [
+                        self.digraph.nodes[src]["name"],
+                        self.digraph.nodes[tgt]["name"],
+                        reason,
                     ]
-                gv_input += "\t{} [height={},width={},shape={}];\n".format(
-                    node_id, height, width, shape
                 )
 
-            # Add edge info.
-            top_level_edges = self.decomposed_digraph.subgraph(
-                cc_node_ids
-            ).edges
-            for edge in top_level_edges:
-                gv_input += "\t{} -> {};\n".format(edge[0], edge[1])
-                self.decomposed_digraph.edges[edge]["cc_num"] = cc_i
-
-            gv_input += "}"
-            top_level_cc_graph = pygraphviz.AGraph(gv_input)
-            # Actually perform layout for this component!
-            # If you're wondering why MetagenomeScope is taking so long to run
-            # on your graph and you traced your way back to this line of code,
-            # then boy do I have an NP-Hard problem for you .____________.
-            top_level_cc_graph.layout(prog="dot")
-
-            # Output the layout info for this component to an xdot file
-            # (TODO, reenable with the -px option; will be nice for debugging)
-            # top_level_cc_graph.draw("cc_{}.xdot".format(cc_i))
-
-            self.cc_num_to_bb[cc_i] = layout_utils.get_bb_x2_y2(
-                top_level_cc_graph.graph_attr["bb"]
+        if self.decomposed_digraph is None:
+            # We haven't done decomposition yet, so this is easy
+            self.digraph.remove_nodes_from(to_remove)
+            self.digraph.remove_edges_from(edges)
+            return
+
+        laid_out = len(self.cc_num_to_bb) > 0
+
+        # Nodes (or patterns) next to the stuff we're removing. We'll use
+        # these to figure out which components have changed.
+        touched_ids = set()
+        for n in to_remove:
+            touched_ids.update(self.digraph.pred[n])
+            touched_ids.update(self.digraph.succ[n])
+        for e in edges:
+            touched_ids.update(e)
+        touched_ids -= to_remove
+
+        # 1. Dissolve affected patterns, from the top down (so that we only
+        # ever dissolve top-level patterns)
+        # (Neighbors of removed nodes don't need their patterns to be
+        # dissolved -- just the removed nodes and the endpoints of removed
+        # edges.)
+        to_dissolve = set()
+        for n in to_remove.union(*edges):
+            parent_id = self.get_parent_id(n)
+            while parent_id is not None:
+                to_dissolve.add(parent_id)
+                parent_id = self.get_parent_id(parent_id)
+        patt_queue = deque(
+            p for p in to_dissolve if self.id2pattern[p].parent_id is None
+        )
+        dup_ids = []
+        while len(patt_queue) > 0:
+            patt = self.id2pattern[patt_queue.popleft()]
+            self.dissolve_pattern(patt)
+            for child_id in patt.node_ids:
+                touched_ids.add(child_id)
+                if child_id in to_dissolve:
+                    patt_queue.append(child_id)
+                elif not self.is_pattern(child_id) and self.digraph.nodes[
+                    child_id
+                ].get("is_dup", False):
+                    dup_ids.append(child_id)
+        for patt_list in (
+            self.chains,
+            self.cyclic_chains,
+            self.bubbles,
+            self.frayed_ropes,
+            self.misc_patterns,
+        ):
+            patt_list[:] = [
+                p for p in patt_list if p.pattern_id not in to_dissolve
+            ]
+
+        # 2. Remove stuff. Everything we're removing is now in the top level.
+        self.decomposed_digraph.remove_nodes_from(to_remove)
+        self.digraph.remove_nodes_from(to_remove)
+        for src, tgt in edges:
+            self.digraph.remove_edge(src, tgt)
+            if self.decomposed_digraph.has_edge(src, tgt):
+                self.decomposed_digraph.remove_edge(src, tgt)
+
+        # 3. Merge duplicates back in. We go through later duplicates first,
+        # since they might be duplicates of earlier duplicates.
+        for dup_id in sorted(dup_ids, reverse=True):
+            if dup_id not in to_remove:
+                touched_ids.add(self.undup_node(dup_id))
+
+        # Figure out the top-level nodes next to the stuff that changed, and
+        # the (top-level nodes in the) components containing them
+        seeds = set(
+            self.get_top_level_id(n) for n in touched_ids if n in self.digraph
+        )
+        seeds.update(n for n in touched_ids if n in self.decomposed_digraph)
+        changed = set()
+        stack = list(seeds)
+        while len(stack) > 0:
+            n = stack.pop()
+            if n in changed:
+                continue
+            changed.add(n)
+            stack.extend(self.decomposed_digraph.succ[n])
+            stack.extend(self.decomposed_digraph.pred[n])
+
+        if laid_out:
+            # Do this before decomposition, so that new duplicate nodes get
+            # un-rotated widths / heights
+            self.unrotate_dimensions(changed)
+
+        # 4. Decompose the stuff near the changes again
+        region = self.get_nearby_top_level_ids(
+            seeds, config.INCREMENTAL_DECOMPOSITION_RADIUS
+        )
+        budget = self.make_decomposition_budget(
+            self.decomposed_digraph.subgraph(changed)
+        )
+        self.collapse_patterns(budget, region)
+        # (New patterns are all in region)
+        changed = set(
+            n for n in changed | region if n in self.decomposed_digraph
+        )
+        for node_id in changed:
+            if not self.is_pattern(node_id):
+                self.digraph.nodes[node_id]["parent_id"] = None
+        for edge in self.decomposed_digraph.subgraph(changed).edges:
+            self.decomposed_digraph.edges[edge]["parent_id"] = None
+        # These are keyed by the smallest top-level node ID in each component,
+        # so forget about the components that changed
+        self.truncated_components = {
+            k: v
+            for k, v in self.truncated_components.items()
+            if k in self.decomposed_digraph and k not in changed
+        }
+        if budget is not None:
+            self.truncated_components.update(
+                budget.get_truncated_components(
+                    self.decomposed_digraph.subgraph(changed)
+                )
             )
+        self.degraded_components = set(
+            k
+            for k in self.degraded_components
+            if k in self.decomposed_digraph and k not in changed
+        )
 
-            # Go through _all_ nodes, edges, and patterns within this
-            # component and set final position information. Nodes and edges
-            # within patterns will need to be updated based on their parent
-            # pattern's position information.
-            for node_id in cc_node_ids:
-                gv_node = top_level_cc_graph.get_node(node_id)
-                # The (x, y) position for this node describes its center pos
-                x, y = layout_utils.getxy(gv_node.attr["pos"])
+        # 5. Lay out the changed components again
+        if laid_out:
+            self.relayout_components(changed)
+            self.compute_zoom_levels(changed)
 
-                if self.is_pattern(node_id):
-                    patt = self.id2pattern[node_id]
-                    patt.set_bb(x, y)
+    def get_nearby_top_level_ids(self, seeds, radius):
+        """Returns the top-level nodes within radius edges of some seeds.
 
-                    # "Reconcile" child nodes, edges, and patterns' relative
-                    # positions with the absolute position of this pattern in
-                    # the layout.
-                    # We go arbitrarily deep here, since patterns can contain
-                    # other patterns (which can contain other patterns, ...)
-                    #
-                    # We use a FIFO queue where each element is a 2-tuple of
-                    # (Pattern object, parent Pattern object). This storage
-                    # method lets us easily associate patterns with their
-                    # parent patterns, and traverse the patterns in such a way
-                    # that whenever we get to a given pattern we've already
-                    # determined coordinate info for its parent.
-                    #
-                    # (Of course, patterns at the top level don't have a
-                    # parent, hence the None in the second element of the tuple
-                    # below.)
-                    patt_queue = deque([patt])
-                    while len(patt_queue) > 0:
-                        # Get the first pattern added
-                        curr_patt = patt_queue.popleft()
-                        for child_node_id in curr_patt.node_ids:
-                            if self.is_pattern(child_node_id):
-                                new_patt = self.id2pattern[child_node_id]
-                                # Set pattern bounding box
-                                cx = curr_patt.left + new_patt.relative_x
-                                cy = curr_patt.bottom + new_patt.relative_y
-                                new_patt.set_bb(cx, cy)
-                                # Add patterns within this pattern to the end of
-                                # the queue
-                                patt_queue.append(new_patt)
-                            else:
-                                # Reconcile data for this normal node within a
-                                # pattern
-                                data = self.digraph.nodes[child_node_id]
-                                data["x"] = curr_patt.left + data["relative_x"]
-                                data["y"] = (
-                                    curr_patt.bottom + data["relative_y"]
-                                )
+        This ignores edge directions, and includes the seeds themselves.
+        """
+        nearby = set(seeds)
+        frontier = list(seeds)
+        for i in range(radius):
+            next_frontier = []
+            for n in frontier:
+                for m in chain(
+                    self.decomposed_digraph.succ[n],
+                    self.decomposed_digraph.pred[n],
+                ):
+                    if m not in nearby:
+                        nearby.add(m)
+                        next_frontier.append(m)
+            frontier = next_frontier
+        return nearby
+
+    def get_cc_num(self, node_id):
+        """Returns the component number of a top-level node or pattern."""
+        if self.is_pattern(node_id):
+            return self.id2pattern[node_id].cc_num
+        return self.digraph.nodes[node_id]["cc_num"]
+
+    def relayout_components(self, region):
+        """Lays out the components containing a set of top-level nodes again.
+
+        This is used by remove_nodes_and_edges(). The widths / heights of
+        everything in these components should have already been
+        un-rotated (see unrotate_dimensions()). Other components keep their
+        layouts, although since components are numbered in order of size
+        (see get_connected_components()) they might get renumbered.
+        """
+        old_cc_num_to_bb = self.cc_num_to_bb
+        self.cc_num_to_bb = {}
+        for cc_i, cc_tuple in enumerate(
+            self.get_connected_components(), self.num_too_large_components + 1
+        ):
+            cc_node_ids = cc_tuple[0]
+            some_node_id = next(iter(cc_node_ids))
+            if some_node_id not in region:
+                old_cc_i = self.get_cc_num(some_node_id)
+                self.cc_num_to_bb[cc_i] = old_cc_num_to_bb[old_cc_i]
+                if old_cc_i != cc_i:
+                    for node_id in cc_node_ids:
+                        if self.is_pattern(node_id):
+                            self.id2pattern[node_id].set_cc_num(self, cc_i)
+                        else:
+                            self.digraph.nodes[node_id]["cc_num"] = cc_i
+                    for edge in self.decomposed_digraph.subgraph(
+                        cc_node_ids
+                    ).edges:
+                        self.decomposed_digraph.edges[edge]["cc_num"] = cc_i
+                continue
+
+            if self.can_fake_layout(cc_tuple):
+                self.fake_component_layout(cc_i, cc_node_ids)
+            else:
+                prep_start_time = time.time()
+                gv_input, top_level_edges = self.get_component_gv_input(
+                    cc_i, cc_node_ids
+                )
+                prep_time = time.time() - prep_start_time
+                dot_output = layout_utils.run_dot(
+                    gv_input, cc_node_ids, top_level_edges
+                )
+                self.finish_component_layout(
+                    cc_i, cc_tuple, top_level_edges, prep_time, dot_output
+                )
+            self.rotate_component(cc_i, cc_node_ids)
+
+    def apply_time_budget(self):
+        """Decides how to lay out each component in order to meet the budget.
+
+        This uses self.cost_model to predict how long each component will
+        take to lay out (both normally and "degraded," i.e. with
+        config.DEGRADED_GRAPH_STYLE), and then uses
+        layout_cost.plan_layouts() to figure out which components to lay out
+        fully, which to degrade, and which to skip. The budget we use for
+        this is whatever's left of self.time_budget at this point, minus
+        config.TIME_BUDGET_RESERVE_FRACTION of the total budget (for the
+        stuff that happens after layout).
+
+        Skipped components are removed from the graph and counted in
+        self.num_too_large_components, so they'll show up in the
+        visualization the same way as components that exceeded -maxn / -maxe.
+        Degraded components are recorded in self.degraded_components.
+
+        Does nothing if self.time_budget is None. Should be called after
+        pattern decomposition (since the cost model takes patterns into
+        account) and before layout.
+        """
+        if self.time_budget is None:
+            return
+        budget = self.time_budget * (1 - config.TIME_BUDGET_RESERVE_FRACTION)
+        remaining = budget - (time.time() - self.start_time)
+        ccs = self.get_connected_components()
+        full_costs = [self.predict_layout_cost(t) for t in ccs]
+        degraded_costs = [
+            self.predict_layout_cost(t, degraded=True) for t in ccs
+        ]
+        modes = layout_cost.plan_layouts(
+            full_costs, degraded_costs, remaining, self.layout_workers
+        )
+        num_skipped = 0
+        for cc_tuple, mode in zip(ccs, modes):
+            if mode == layout_cost.SKIP:
+                self.skipped_components.append(
+                    self.get_skipped_component_info(cc_tuple[0])
+                )
+                self.remove_component(cc_tuple[0])
+                num_skipped += 1
+                operation_msg(
+                    (
+                        "Ignoring a component ({:,} nodes, {:,} edges): "
+                        "predicted layout time exceeds --time-budget."
+                    ).format(cc_tuple[1], cc_tuple[2]),
+                    True,
+                )
+            elif mode == layout_cost.DEGRADED:
+                self.degraded_components.add(min(cc_tuple[0]))
 
-                        for edge in curr_patt.subgraph.edges:
-                            data = curr_patt.subgraph.edges[edge]
-                            data[
-                                "ctrl_pt_coords"
-                            ] = layout_utils.shift_control_points(
-                                data["relative_ctrl_pt_coords"],
-                                curr_patt.left,
-                                curr_patt.bottom,
-                            )
+        if num_skipped == len(ccs):
+            raise ValueError(
+                "We don't have enough time to lay out any components within "
+                "the time budget. Try increasing --time-budget, or reducing "
+                "the size of the graph."
+            )
+        self.num_too_large_components += num_skipped
+        if len(self.degraded_components) > 0:
+            operation_msg(
+                (
+                    "Doing a faster, lower-quality layout of {:,} "
+                    "component(s) in order to meet --time-budget."
+                ).format(len(self.degraded_components)),
+                True,
+            )
 
+    def get_skipped_component_info(self, cc_node_ids):
+        """Returns (num nodes, num edges, total length) for a component.
+
+        cc_node_ids should be the set of top-level node IDs in a component,
+        as returned by get_connected_components(). Unlike the counts
+        get_connected_components() gives, we don't count duplicate nodes /
+        edges here -- this way these numbers match up with what
+        get_component_summary() would've said about this component if we had
+        laid it out.
+        """
+        node_ids = set()
+        patt_queue = deque()
+        for node_id in cc_node_ids:
+            if self.is_pattern(node_id):
+                patt_queue.append(self.id2pattern[node_id])
+            else:
+                node_ids.add(node_id)
+        while len(patt_queue) > 0:
+            curr_patt = patt_queue.popleft()
+            for child_node_id in curr_patt.node_ids:
+                if self.is_pattern(child_node_id):
+                    patt_queue.append(self.id2pattern[child_node_id])
                 else:
-                    # Save data for this normal node
-                    self.digraph.nodes[node_id]["x"] = x
-                    self.digraph.nodes[node_id]["y"] = y
+                    node_ids.add(child_node_id)
+        num_edges = sum(
+            1
+            for e in self.digraph.subgraph(node_ids).edges
+            if not self.digraph.edges[e].get("is_dup", False)
+        )
+        node_ids = [
+            n
+            for n in node_ids
+            if not self.digraph.nodes[n].get("is_dup", False)
+        ]
+        return (len(node_ids), num_edges, self.get_total_length(node_ids))
 
-            # Save ctrl pt data for top-level edges
-            for edge in top_level_edges:
-                data = self.decomposed_digraph.edges[edge]
-                gv_edge = top_level_cc_graph.get_edge(*edge)
-                coords = layout_utils.get_control_points(gv_edge.attr["pos"])
-                data["ctrl_pt_coords"] = coords
+    def is_degraded(self, cc_node_ids):
+        """Returns True if we're doing a degraded layout of a component."""
+        return min(cc_node_ids) in self.degraded_components
 
-            if not first_small_component:
-                conclude_msg()
+    def get_component_gv_input(self, cc_i, cc_node_ids):
+        """Prepares a component for layout, and returns its DOT input.
 
-        if first_small_component:
-            conclude_msg()
+        This lays out all of the patterns in this component (each in
+        isolation), sets the component number of everything in the
+        component, and then creates DOT input for the top level of the
+        component -- using the node and edge data for top-level nodes and
+        edges as well as the width/height computed for "pattern nodes" (in
+        which other nodes, edges, and patterns can be contained).
+
+        Returns a 2-tuple of (DOT input, list of top-level edges).
+        """
+        gv_input = layout_utils.get_gv_header(
+            degraded=self.is_degraded(cc_node_ids)
+        )
+
+        # Populate GraphViz input with node information
+        # This mirrors what's done in Pattern.layout().
+        # Also, while we're at it, set component numbers to make traversal
+        # easier later on.
+        for node_id in cc_node_ids:
+            if self.is_pattern(node_id):
+                self.id2pattern[node_id].set_cc_num(self, cc_i)
+                # Lay out the pattern in isolation (could involve multiple
+                # layers, since patterns can contain other patterns). See
+                # Pattern.layout() for why it might already be laid out.
+                if self.id2pattern[node_id].width is None:
+                    self.id2pattern[node_id].layout(self)
+                height = self.id2pattern[node_id].height
+                width = self.id2pattern[node_id].width
+                shape = self.id2pattern[node_id].shape
+            else:
+                data = self.digraph.nodes[node_id]
+                data["cc_num"] = cc_i
+                height = data["height"]
+                width = data["width"]
+                shape = config.NODE_ORIENTATION_TO_SHAPE[data["orientation"]]
+            gv_input += "\t{} [height={},width={},shape={}];\n".format(
+                node_id, height, width, shape
+            )
+
+        # Add edge info.
+        top_level_edges = list(
+            self.decomposed_digraph.subgraph(cc_node_ids).edges
+        )
+        for edge in top_level_edges:
+            gv_input += "\t{} -> {};\n".format(edge[0], edge[1])
+            self.decomposed_digraph.edges[edge]["cc_num"] = cc_i
+
+        gv_input += "}"
+        return gv_input, top_level_edges
+
+    def apply_component_layout(
+        self, cc_i, cc_node_ids, top_level_edges, dot_output
+    ):
+        """Saves the layout of a component's top level.
+
+        dot_output should be the output of layout_utils.run_dot() on the DOT
+        input returned by get_component_gv_input().
+        """
+        bb, node_pos, edge_pos, _ = dot_output
+        self.cc_num_to_bb[cc_i] = layout_utils.get_bb_x2_y2(bb)
+
+        # Go through _all_ nodes, edges, and patterns within this
+        # component and set final position information. Nodes and edges
+        # within patterns will need to be updated based on their parent
+        # pattern's position information.
+        for node_id in cc_node_ids:
+            # The (x, y) position for this node describes its center pos
+            x, y = layout_utils.getxy(node_pos[node_id])
+
+            if self.is_pattern(node_id):
+                patt = self.id2pattern[node_id]
+                patt.set_bb(x, y)
+
+                # "Reconcile" child nodes, edges, and patterns' relative
+                # positions with the absolute position of this pattern in
+                # the layout.
+                # We go arbitrarily deep here, since patterns can contain
+                # other patterns (which can contain other patterns, ...)
+                #
+                # We use a FIFO queue where each element is a 2-tuple of
+                # (Pattern object, parent Pattern object). This storage
+                # method lets us easily associate patterns with their
+                # parent patterns, and traverse the patterns in such a way
+                # that whenever we get to a given pattern we've already
+                # determined coordinate info for its parent.
+                #
+                # (Of course, patterns at the top level don't have a
+                # parent, hence the None in the second element of the tuple
+                # below.)
+                patt_queue = deque([patt])
+                while len(patt_queue) > 0:
+                    # Get the first pattern added
+                    curr_patt = patt_queue.popleft()
+                    for child_node_id in curr_patt.node_ids:
+                        if self.is_pattern(child_node_id):
+                            new_patt = self.id2pattern[child_node_id]
+                            # Set pattern bounding box
+                            cx = curr_patt.left + new_patt.relative_x
+                            cy = curr_patt.bottom + new_patt.relative_y
+                            new_patt.set_bb(cx, cy)
+                            # Add patterns within this pattern to the end of
+                            # the queue
+                            patt_queue.append(new_patt)
+                        else:
+                            # Reconcile data for this normal node within a
+                            # pattern
+                            data = self.digraph.nodes[child_node_id]
+                            data["x"] = curr_patt.left + data["relative_x"]
+                            data["y"] = curr_patt.bottom + data["relative_y"]
+
+                    for edge in curr_patt.subgraph.edges:
+                        data = curr_patt.subgraph.edges[edge]
+                        data[
+                            "ctrl_pt_coords"
+                        ] = layout_utils.shift_control_points(
+                            data["relative_ctrl_pt_coords"],
+                            curr_patt.left,
+                            curr_patt.bottom,
+                        )
+
+            else:
+                # Save data for this normal node
+                self.digraph.nodes[node_id]["x"] = x
+                self.digraph.nodes[node_id]["y"] = y
+
+        # Save ctrl pt data for top-level edges
+        for edge in top_level_edges:
+            data = self.decomposed_digraph.edges[edge]
+            coords = layout_utils.get_control_points(edge_pos[edge])
+            data["ctrl_pt_coords"] = coords
+
+    def layout(self, prog=None, first_progress_index=0):
+        """Lays out the graph's components, handling patterns specially.
+
+        Components are numbered in the order given by
+        get_connected_components(), but we lay them out longest-predicted-
+        first (according to self.cost_model). If self.layout_workers > 1,
+        then the top-level dot call for each component is sent off to a pool
+        of worker processes as soon as the component is prepared, so doing
+        the big components first means they won't be left running by
+        themselves at the end while every other worker sits idle. (Small
+        components -- with < 5 nodes -- are always done last, mostly so that
+        we can print a single message for all of them.)
+
+        After each component is laid out, we record how long it took in
+        self.cost_model. Progress (and an ETA) is reported as we go; see
+        progress.LayoutProgress. If prog is None, we make a new LayoutProgress
+        for just this graph. Otherwise, prog should be a LayoutProgress that
+        has already been started and then suspended (this is used in
+        out-of-core mode, so that we report progress over all pages at once):
+        this graph's components will be components first_progress_index,
+        first_progress_index + 1, ... in it, and we'll update its estimates
+        for them, resume it while we lay things out, and suspend it again when
+        we're done.
+        """
+        # (We don't bother checking for skipped components, since we should
+        # have already called self.remove_too_large_components().)
+        ccs = list(
+            enumerate(
+                self.get_connected_components(),
+                self.num_too_large_components + 1,
+            )
+        )
+        features = [self.get_component_cost_features(t) for _, t in ccs]
+        costs = [
+            0 if self.can_fake_layout(t) else self.cost_model.predict(*f)
+            for (_, t), f in zip(ccs, features)
+        ]
+        order = sorted(
+            range(len(ccs)),
+            key=lambda i: (ccs[i][1][1] >= 5, costs[i], -i),
+            reverse=True,
+        )
+        entries = [
+            (t[1], t[2], f[2], cost)
+            for (_, t), f, cost in zip(ccs, features, costs)
+        ]
+        own_prog = prog is None
+        if own_prog:
+            prog = progress.LayoutProgress(
+                entries, workers=self.layout_workers
+            )
+        else:
+            for i, entry in enumerate(entries):
+                prog.set_component(first_progress_index + i, entry)
+
+        pool = None
+        if self.layout_workers > 1:
+            pool = multiprocessing.Pool(self.layout_workers)
+        # For the pool: list of (cc_i, cc_tuple, top-level edges, seconds
+        # spent preparing the component, AsyncResult)
+        pending = []
+
+        first_small_component = False
+        if own_prog:
+            prog.start()
+        else:
+            prog.resume()
+        try:
+            for i in order:
+                cc_i, cc_tuple = ccs[i]
+                cc_node_ids = cc_tuple[0]
+                cc_full_node_ct = cc_tuple[1]
+                cc_full_edge_ct = cc_tuple[2]
+
+                if cc_full_node_ct >= 5:
+                    desc = "{} component {:,} ({:,} nodes, {:,} edges)".format(
+                        "Laying out" if pool is None else "Preparing",
+                        cc_i,
+                        cc_full_node_ct,
+                        cc_full_edge_ct,
+                    )
+                    prog.set_current(desc)
+                    # Without a progress bar, mention components that'll
+                    # take a while, so it's clear what we're waiting on
+                    if (
+                        pool is None
+                        and prog.mode == progress.LOG
+                        and costs[i] >= prog.interval
+                    ):
+                        prog.message(
+                            "{} (predicted to take {})...".format(
+                                desc, progress.format_duration(costs[i])
+                            )
+                        )
+                elif not first_small_component:
+                    prog.set_current(None)
+                    prog.message(
+                        "Laying out small (each containing < 5 nodes) "
+                        "remaining component(s)..."
+                    )
+                    first_small_component = True
+
+                # If this component contains just one basic node, and no
+                # edges or patterns, then we can "fake" its layout. This lets
+                # us avoid calling PyGraphviz a gazillion times, and speeds
+                # things up (esp for large graphs with gazillions of 1-node
+                # components).
+                # As a TODO, we can probs generalize this to other types of
+                # simple components -- e.g. components with just one loop
+                # edge (since we don't even use the control points from loop
+                # edges right now), etc
+                if self.can_fake_layout(cc_tuple):
+                    self.fake_component_layout(cc_i, cc_node_ids)
+                    prog.done(first_progress_index + i, 0)
+                    continue
+
+                prep_start_time = time.time()
+                gv_input, top_level_edges = self.get_component_gv_input(
+                    cc_i, cc_node_ids
+                )
+                prep_time = time.time() - prep_start_time
+
+                if pool is None:
+                    # Actually perform layout for this component!
+                    # If you're wondering why MetagenomeScope is taking so
+                    # long to run on your graph and you traced your way back
+                    # to this line of code, then boy do I have an NP-Hard
+                    # problem for you .____________.
+                    dot_output = layout_utils.run_dot(
+                        gv_input, cc_node_ids, top_level_edges
+                    )
+                    seconds = self.finish_component_layout(
+                        cc_i, cc_tuple, top_level_edges, prep_time, dot_output
+                    )
+                    prog.done(first_progress_index + i, seconds)
+                else:
+                    # Report progress as soon as a worker finishes this
+                    # component (the callback is run in this process), rather
+                    # than when we get around to applying its layout below
+                    def on_dot_done(
+                        dot_output,
+                        i=first_progress_index + i,
+                        prep_time=prep_time,
+                    ):
+                        prog.done(i, prep_time + dot_output[3])
+
+                    pending.append(
+                        (
+                            cc_i,
+                            cc_tuple,
+                            top_level_edges,
+                            prep_time,
+                            pool.apply_async(
+                                layout_utils.run_dot,
+                                (gv_input, cc_node_ids, top_level_edges),
+                                callback=on_dot_done,
+                            ),
+                        )
+                    )
+
+            if pool is not None:
+                prog.set_current(None)
+                prog.message(
+                    "Waiting for the layouts of {:,} component(s) to "
+                    "finish...".format(len(pending))
+                )
+                for cc_i, cc_tuple, edges, prep_time, result in pending:
+                    self.finish_component_layout(
+                        cc_i, cc_tuple, edges, prep_time, result.get()
+                    )
+        finally:
+            if own_prog:
+                prog.finish()
+            else:
+                prog.suspend()
+            if pool is not None:
+                pool.terminate()
+                pool.join()
 
         # At this point, we are now done with layout. Coordinate information
         # for nodes and edges is stored in self.digraph or in the
@@ -1673,6 +3089,43 @@ class AssemblyGraph(object):
         # be able to make a JSON representation of this graph and move on to
         # visualizing it in the browser!
 
+    def fake_component_layout(self, cc_i, cc_node_ids):
+        """Lays out a component containing just a single node, without dot.
+
+        See can_fake_layout().
+        """
+        # Get the single value from the set without actually popping it,
+        # because knowing my luck I feel like that would cause problems.
+        # https://stackoverflow.com/questions/59825#comment67384382_60233
+        lone_node_id = next(iter(cc_node_ids))
+        data = self.digraph.nodes[lone_node_id]
+        data["cc_num"] = cc_i
+        data["x"] = data["width"] / 2
+        data["y"] = data["height"] / 2
+        self.cc_num_to_bb[cc_i] = (
+            data["width"] + 0.1,
+            data["height"] + 0.1,
+        )
+
+    def finish_component_layout(
+        self, cc_i, cc_tuple, top_level_edges, prep_time, dot_output
+    ):
+        """Saves a component's layout, and records how long it took.
+
+        Returns the number of seconds spent on this component.
+        """
+        apply_start_time = time.time()
+        self.apply_component_layout(
+            cc_i, cc_tuple[0], top_level_edges, dot_output
+        )
+        seconds = prep_time + dot_output[3] + time.time() - apply_start_time
+        self.cost_model.record(
+            *self.get_component_cost_features(cc_tuple),
+            seconds,
+            self.is_degraded(cc_tuple[0])
+        )
+        return seconds
+
     def dot(self, output_filepath, component_number):
         """TODO. Visualizes a component of the laid out graph.
 
@@ -1687,7 +3140,22 @@ class AssemblyGraph(object):
     def to_cytoscape_compatible_format(self):
         """TODO."""
 
-    def to_dict(self):
+    @staticmethod
+    def get_skipped_placeholder(num_nodes, num_edges, length):
+        """Returns the to_dict() entry for a component we didn't lay out.
+
+        We don't keep these components' nodes and edges around, but we still
+        know how big they were before layout -- so we include that, for the
+        component summary and etc.
+        """
+        return {
+            "skipped": True,
+            "num_nodes": num_nodes,
+            "num_edges": num_edges,
+            "length": length,
+        }
+
+    def to_dict(self, on_component=None):
         """Returns a dict representation of the graph usable as JSON.
 
         (The dict will need to be pushed through json.dumps() first in order
@@ -1697,6 +3165,13 @@ class AssemblyGraph(object):
         This should be analogous to the SQLite3 database schema previously
         used for MgSc.
 
+        If on_component is given, we call on_component(out, cc_num, comp)
+        for each component as soon as we've made its dict representation
+        (comp), where out is the dict we're building up (all of its fields
+        besides "components" are already filled in) and cc_num is the
+        component's 1-indexed number. This lets exporters write stuff out
+        as we go.
+
         Should only be called after self.process() has already been called.
 
         Inspired by to_dict() in Empress.
@@ -1752,9 +3227,11 @@ class AssemblyGraph(object):
         # TODO: do this in a more clear way
         self.extra_node_attrs -= set(node_fields)
         self.extra_edge_attrs -= set(edge_fields)
+        # (We sort the extra attrs so that the order of fields is
+        # deterministic -- set iteration order isn't guaranteed to be.)
         for fields, attrs in (
-            (node_fields + list(self.extra_node_attrs), NODE_ATTRS),
-            (edge_fields + list(self.extra_edge_attrs), EDGE_ATTRS),
+            (node_fields + sorted(self.extra_node_attrs), NODE_ATTRS),
+            (edge_fields + sorted(self.extra_edge_attrs), EDGE_ATTRS),
             (patt_fields, PATT_ATTRS),
         ):
             for i, f in enumerate(fields):
@@ -1848,22 +3325,48 @@ class AssemblyGraph(object):
             "node_attrs": NODE_ATTRS,
             "edge_attrs": EDGE_ATTRS,
             "patt_attrs": PATT_ATTRS,
-            "extra_node_attrs": list(self.extra_node_attrs),
-            "extra_edge_attrs": list(self.extra_edge_attrs),
+            "extra_node_attrs": sorted(self.extra_node_attrs),
+            "extra_edge_attrs": sorted(self.extra_edge_attrs),
+            # The parsers already know the types of these attributes' values
+            # (see self.check_attrs()), so save them for the exporters
+            "extra_node_attr_types": {
+                a: export_utils.get_attr_type_name(
+                    self.node_attr_types.get(a, set())
+                )
+                for a in self.extra_node_attrs
+            },
+            "extra_edge_attr_types": {
+                a: export_utils.get_attr_type_name(
+                    self.edge_attr_types.get(a, set())
+                )
+                for a in self.extra_edge_attrs
+            },
             "components": [],
             "input_file_basename": self.basename,
             "input_file_type": self.filetype,
             "total_num_nodes": self.digraph.number_of_nodes(),
             "total_num_edges": self.digraph.number_of_edges(),
+            # Nodes/edges removed during simplification, so that the viewer
+            # can report them. These are identified by name, since they were
+            # removed before we assigned integer IDs.
+            "removed_elements": {
+                "nodes": self.removed_nodes,
+                "edges": self.removed_edges,
+            },
         }
 
         # Hack: indicate the number of skipped components in the exported data.
         # There are obviously much more efficient ways to do this (e.g. just
         # pass the number of skipped components as a global data property), but
         # this works with the JS I have set up right now and dude it's 5am give
-        # me a break
-        for n in range(self.num_too_large_components):
-            out["components"].append({"skipped": True})
+        # me a break. (We sort these the same way as the laid-out components,
+        # largest first.)
+        for n, info in enumerate(
+            sorted(self.skipped_components, key=itemgetter(0, 1), reverse=True)
+        ):
+            out["components"].append(self.get_skipped_placeholder(*info))
+            if on_component is not None:
+                on_component(out, n + 1, out["components"][-1])
 
         # For each component:
         # (This is the same general strategy for iterating through the graph as
@@ -1877,6 +3380,11 @@ class AssemblyGraph(object):
                 "patts": [],
                 "bb": self.cc_num_to_bb[cc_i],
                 "skipped": False,
+                "degraded": self.is_degraded(cc_tuple[0]),
+                "zoom_levels": self.cc_zoom_levels.get(min(cc_tuple[0]), []),
+                "decomposition_truncated": self.truncated_components.get(
+                    min(cc_tuple[0]), []
+                ),
             }
             # Go through top-level nodes and collapsed patterns
             for node_id in cc_tuple[0]:
@@ -1952,6 +3460,8 @@ class AssemblyGraph(object):
             # self.get_connected_components() we can just add component JSONs
             # to out["components"] as we go through things.
             out["components"].append(this_component)
+            if on_component is not None:
+                on_component(out, cc_i, this_component)
         return out
 
     def to_json(self):
@@ -1968,47 +3478,18 @@ class AssemblyGraph(object):
         """Rotates the graph so it flows from L -> R rather than T -> B."""
         # Rotate and scale bounding boxes
         for cc_num in self.cc_num_to_bb.keys():
-            bb = self.cc_num_to_bb[cc_num]
-            self.cc_num_to_bb[cc_num] = [
-                bb[1] * config.POINTS_PER_INCH,
-                bb[0] * config.POINTS_PER_INCH,
-            ]
+            self.rotate_bb(cc_num)
 
         # Rotate patterns
         for patt in self.id2pattern.values():
-            # Swap height and width
-            patt.width, patt.height = patt.height, patt.width
-            patt.width *= config.POINTS_PER_INCH
-            patt.height *= config.POINTS_PER_INCH
-            # Change bounding box of the pattern.
-            #
-            #    _T_                  ___R___
-            #   |   |       --->    T|       |B
-            #  L|   |R      --->     |_______|
-            #   |___|                    L
-            #     B
-            l, b, r, t = patt.left, patt.bottom, patt.right, patt.top
-            patt.left = -t
-            patt.right = -b
-            patt.top = -r
-            patt.bottom = -l
-
-            # Rotate edges within this pattern
-            for edge in patt.subgraph.edges:
-                data = patt.subgraph.edges[edge]
-                data["ctrl_pt_coords"] = layout_utils.rotate_ctrl_pt_coords(
-                    data["ctrl_pt_coords"]
-                )
+            self.rotate_pattern(patt)
 
         # Rotate normal nodes
         for node_id in self.digraph.nodes:
             data = self.digraph.nodes[node_id]
-            data["width"], data["height"] = data["height"], data["width"]
-            data["width"] *= config.POINTS_PER_INCH
-            data["height"] *= config.POINTS_PER_INCH
             if "x" not in data:
                 print(data, "tf lol")
-            data["x"], data["y"] = layout_utils.rotate(data["x"], data["y"])
+            self.rotate_node(data)
 
         # Rotate edges
         for edge in self.decomposed_digraph.edges:
@@ -2017,8 +3498,199 @@ class AssemblyGraph(object):
                 data["ctrl_pt_coords"]
             )
 
-    def process(self):
-        """Basic pipeline for preparing a graph for visualization."""
+    def rotate_bb(self, cc_num):
+        """Rotates and scales the bounding box of a component."""
+        bb = self.cc_num_to_bb[cc_num]
+        self.cc_num_to_bb[cc_num] = [
+            bb[1] * config.POINTS_PER_INCH,
+            bb[0] * config.POINTS_PER_INCH,
+        ]
+
+    def rotate_pattern(self, patt):
+        """Rotates a pattern, and the edges directly within it."""
+        # Swap height and width
+        patt.width, patt.height = patt.height, patt.width
+        patt.width *= config.POINTS_PER_INCH
+        patt.height *= config.POINTS_PER_INCH
+        # Change bounding box of the pattern.
+        #
+        #    _T_                  ___R___
+        #   |   |       --->    T|       |B
+        #  L|   |R      --->     |_______|
+        #   |___|                    L
+        #     B
+        l, b, r, t = patt.left, patt.bottom, patt.right, patt.top
+        patt.left = -t
+        patt.right = -b
+        patt.top = -r
+        patt.bottom = -l
+
+        # Rotate edges within this pattern
+        for edge in patt.subgraph.edges:
+            data = patt.subgraph.edges[edge]
+            data["ctrl_pt_coords"] = layout_utils.rotate_ctrl_pt_coords(
+                data["ctrl_pt_coords"]
+            )
+
+    def rotate_node(self, data):
+        """Rotates a normal node, given its data in self.digraph."""
+        data["width"], data["height"] = data["height"], data["width"]
+        data["width"] *= config.POINTS_PER_INCH
+        data["height"] *= config.POINTS_PER_INCH
+        data["x"], data["y"] = layout_utils.rotate(data["x"], data["y"])
+
+    def get_component_contents(self, cc_node_ids):
+        """Returns everything within a component.
+
+        cc_node_ids should be the set of top-level node IDs in a component.
+        Returns a 2-tuple of (list of all normal node IDs in the component,
+        including those within patterns; list of all Pattern objects in the
+        component).
+        """
+        node_ids = []
+        patts = []
+        for node_id in cc_node_ids:
+            if self.is_pattern(node_id):
+                patt_queue = deque([self.id2pattern[node_id]])
+                while len(patt_queue) > 0:
+                    curr_patt = patt_queue.popleft()
+                    patts.append(curr_patt)
+                    for child_node_id in curr_patt.node_ids:
+                        if self.is_pattern(child_node_id):
+                            patt_queue.append(self.id2pattern[child_node_id])
+                        else:
+                            node_ids.append(child_node_id)
+            else:
+                node_ids.append(node_id)
+        return node_ids, patts
+
+    def rotate_component(self, cc_num, cc_node_ids):
+        """Does what rotate_from_TB_to_LR() does, but for just one component.
+
+        Used when only some components have been laid out again (see
+        relayout_components()).
+        """
+        self.rotate_bb(cc_num)
+        node_ids, patts = self.get_component_contents(cc_node_ids)
+        for patt in patts:
+            self.rotate_pattern(patt)
+        for node_id in node_ids:
+            self.rotate_node(self.digraph.nodes[node_id])
+        for edge in self.decomposed_digraph.subgraph(cc_node_ids).edges:
+            data = self.decomposed_digraph.edges[edge]
+            data["ctrl_pt_coords"] = layout_utils.rotate_ctrl_pt_coords(
+                data["ctrl_pt_coords"]
+            )
+
+    def unrotate_dimensions(self, top_level_node_ids):
+        """Undoes the rotation of node and pattern widths / heights.
+
+        top_level_node_ids should be a collection of top-level node IDs.
+        Everything within these nodes / patterns that has already been
+        rotated (i.e. every normal node, and every pattern that has been laid
+        out) gets its width and height swapped back and converted back to
+        inches, so that we can lay it out again. (We don't bother undoing the
+        rotation of positions, since these get recomputed during layout.)
+        """
+        node_ids, patts = self.get_component_contents(top_level_node_ids)
+        for patt in patts:
+            if patt.width is not None:
+                patt.width, patt.height = (
+                    patt.height / config.POINTS_PER_INCH,
+                    patt.width / config.POINTS_PER_INCH,
+                )
+        for node_id in node_ids:
+            data = self.digraph.nodes[node_id]
+            data["width"], data["height"] = (
+                data["height"] / config.POINTS_PER_INCH,
+                data["width"] / config.POINTS_PER_INCH,
+            )
+
+    def get_top_level_box(self, node_id):
+        """Returns the [xmin, ymin, xmax, ymax] bounding box of a top-level
+        node or collapsed pattern.
+
+        Should only be called after rotate_from_TB_to_LR(). Coordinates are
+        in the same system as the exported node x / y coordinates.
+        """
+        if self.is_pattern(node_id):
+            p = self.id2pattern[node_id]
+            return [
+                min(p.left, p.right),
+                min(p.bottom, p.top),
+                max(p.left, p.right),
+                max(p.bottom, p.top),
+            ]
+        data = self.digraph.nodes[node_id]
+        half_w = data["width"] / 2
+        half_h = data["height"] / 2
+        return [
+            data["x"] - half_w,
+            data["y"] - half_h,
+            data["x"] + half_w,
+            data["y"] + half_h,
+        ]
+
+    def compute_zoom_levels(self, region=None):
+        """Builds zoom levels for components with lots of top-level nodes.
+
+        See coarsening.py for details. Zoom levels are stored in
+        self.cc_zoom_levels, keyed by the smallest top-level node ID in each
+        component (the same trick we use for self.degraded_components).
+        Components with fewer than config.ZOOM_LEVELS_MIN_COMPONENT_SIZE
+        top-level nodes / collapsed patterns don't get any zoom levels.
+
+        If region (a set of top-level node IDs) is given, we only redo the
+        zoom levels for components containing these nodes.
+
+        Should only be called after rotate_from_TB_to_LR().
+        """
+        if region is None:
+            self.cc_zoom_levels = {}
+        else:
+            self.cc_zoom_levels = {
+                k: v
+                for k, v in self.cc_zoom_levels.items()
+                if k in self.decomposed_digraph and k not in region
+            }
+        for cc_tuple in self.get_connected_components():
+            if region is not None and next(iter(cc_tuple[0])) not in region:
+                continue
+            cc_node_ids = sorted(cc_tuple[0])
+            if len(cc_node_ids) < config.ZOOM_LEVELS_MIN_COMPONENT_SIZE:
+                continue
+            operation_msg(
+                "Building zoom levels for a component with {} top-level "
+                "nodes...".format(len(cc_node_ids))
+            )
+            id2index = {n: i for i, n in enumerate(cc_node_ids)}
+            weights = []
+            boxes = []
+            for node_id in cc_node_ids:
+                if self.is_pattern(node_id):
+                    patt = self.id2pattern[node_id]
+                    weights.append(patt.get_counts(self)[0])
+                else:
+                    weights.append(1)
+                boxes.append(self.get_top_level_box(node_id))
+            edges = {}
+            for src, tgt in self.decomposed_digraph.subgraph(
+                cc_node_ids
+            ).edges:
+                if src == tgt:
+                    continue
+                i, j = sorted((id2index[src], id2index[tgt]))
+                edges[(i, j)] = edges.get((i, j), 0) + 1
+            self.cc_zoom_levels[cc_node_ids[0]] = coarsening.build_zoom_levels(
+                cc_node_ids, weights, edges, boxes
+            )
+            conclude_msg()
+
+    def process(self, layout_progress=None, first_progress_index=0):
+        """Basic pipeline for preparing a graph for visualization.
+
+        layout_progress and first_progress_index are passed to layout().
+        """
 
         # Node/edge scaling is done *before* pattern detection, so duplicate
         # nodes/edges created during pattern detection shouldn't influence
@@ -2037,10 +3709,14 @@ class AssemblyGraph(object):
         self.hierarchically_identify_patterns()
         conclude_msg()
 
+        self.apply_time_budget()
+
         operation_msg("Laying out the graph...", True)
-        self.layout()
+        self.layout(layout_progress, first_progress_index)
         operation_msg("...Finished laying out the graph.", True)
 
         operation_msg("Rotating and scaling things as needed...")
         self.rotate_from_TB_to_LR()
         conclude_msg()
+
+        self.compute_zoom_levels()
@@ -0,0 +1,174 @@
+# Copyright (C) 2016-- Marcus Fedarko, Jay Ghurye, Todd Treangen, Mihai Pop
+# Authored by Marcus Fedarko
+#
+# This file is part of MetagenomeScope.
+#
+# MetagenomeScope is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# MetagenomeScope is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with MetagenomeScope.  If not, see <http://www.gnu.org/licenses/>.
+####
+# Per-component limits on hierarchical pattern decomposition.
+#
+# On really tangled components, decomposition can take a very long time
+# (checking for superbubbles is particularly expensive), and can produce
+# patterns nested many levels deep -- which are slow to lay out, since each
+# level of nesting is laid out separately. So the user can limit how much
+# time / how many validator calls we spend on each component, and how deeply
+# patterns can be nested. When a component runs out of time or calls, we
+# just stop looking for patterns in it: whatever patterns we found are kept,
+# and everything else in the component is left uncollapsed.
+#
+# Components here are the weakly connected components of the graph before
+# decomposition. (Decomposition never merges or splits components, so these
+# correspond exactly to the components we lay out later.)
+
+import time
+from collections import defaultdict
+import networkx as nx
+
+# Reasons we'll record for truncating decomposition of a component.
+TIME = "time"
+CALLS = "validator_calls"
+DEPTH = "nesting_depth"
+
+
+class DecompositionBudget(object):
+    def __init__(self, digraph, max_time=None, max_calls=None, max_depth=None):
+        """Initializes budgets for each component in a digraph.
+
+        max_time is the number of seconds we can spend on decomposing each
+        component; max_calls is the number of times we can check a node in
+        each component for a pattern; and max_depth is the maximum number of
+        levels of patterns allowed (e.g. 1 means that patterns can't contain
+        other patterns). Any of these can be None, in which case there's no
+        limit.
+        """
+        self.max_time = max_time
+        self.max_calls = max_calls
+        self.max_depth = max_depth
+
+        # Maps node / pattern IDs to the index of their component
+        self.node2cc = {}
+        for cc_i, cc_node_ids in enumerate(
+            nx.weakly_connected_components(digraph)
+        ):
+            for n in cc_node_ids:
+                self.node2cc[n] = cc_i
+
+        self.cc_time = defaultdict(float)
+        self.cc_calls = defaultdict(int)
+
+        # Maps pattern IDs to their depth (a pattern containing only nodes
+        # has depth 1, a pattern containing that pattern has depth 2, ...)
+        self.pattern_depth = {}
+
+        # Maps component indices to a list of the reasons we stopped
+        # decomposing them early (TIME, CALLS, and/or DEPTH)
+        self.truncated = {}
+
+        # Components we've stopped checking for patterns entirely
+        self.exhausted = set()
+
+    def truncate(self, cc_i, reason):
+        reasons = self.truncated.setdefault(cc_i, [])
+        if reason not in reasons:
+            reasons.append(reason)
+
+    def can_check(self, node_id):
+        """Returns True if we can still check this node for patterns.
+
+        If this node's component has run out of time or calls, this records
+        that the component was truncated. (We only do this once we actually
+        want to check another node, so that components that happen to
+        finish right at the limit aren't counted as truncated.)
+        """
+        cc_i = self.node2cc[node_id]
+        if cc_i in self.exhausted:
+            return False
+        if (
+            self.max_calls is not None
+            and self.cc_calls[cc_i] >= self.max_calls
+        ):
+            self.truncate(cc_i, CALLS)
+            self.exhausted.add(cc_i)
+        if self.max_time is not None and self.cc_time[cc_i] >= self.max_time:
+            self.truncate(cc_i, TIME)
+            self.exhausted.add(cc_i)
+        return cc_i not in self.exhausted
+
+    def start_check(self):
+        """Returns a timestamp to pass to finish_check()."""
+        return time.time()
+
+    def finish_check(self, node_id, start_time):
+        """Records that we checked a node, for its component's budget.
+
+        This should be called after both calling the validator and (if the
+        validator found something) collapsing the pattern, so that the time
+        taken to collapse things counts towards the time budget as well.
+        """
+        self.cc_calls[self.node2cc[node_id]] += 1
+        self.add_time(node_id, start_time)
+
+    def add_time(self, node_id, start_time):
+        """Like finish_check(), but without counting this as a check.
+
+        This is for work that isn't tied to checking a single node -- e.g.
+        collapsing frayed ropes, which are all found in one scan before any
+        of them get collapsed.
+        """
+        self.cc_time[self.node2cc[node_id]] += time.time() - start_time
+
+    def get_depth(self, member_node_ids, excluded_ids=()):
+        """Returns the depth a pattern with these members would have.
+
+        excluded_ids should contain any members that won't actually be
+        nested inside this pattern -- e.g. the starting / ending patterns of
+        a bubble, which are duplicated rather than nested (see
+        AssemblyGraph.add_bubble()).
+        """
+        depth = 0
+        for m in member_node_ids:
+            if m in self.pattern_depth and m not in excluded_ids:
+                depth = max(depth, self.pattern_depth[m])
+        return depth + 1
+
+    def depth_ok(self, node_id, depth):
+        """Returns True if a pattern of this depth is allowed.
+
+        If not, this records that the node's component was truncated.
+        """
+        if self.max_depth is not None and depth > self.max_depth:
+            self.truncate(self.node2cc[node_id], DEPTH)
+            return False
+        return True
+
+    def add_pattern(self, node_id, pattern_id, depth):
+        """Records a new pattern, found by checking node_id."""
+        self.node2cc[pattern_id] = self.node2cc[node_id]
+        self.pattern_depth[pattern_id] = depth
+
+    def get_truncated_components(self, decomposed_digraph):
+        """Returns truncation info, keyed by the components' top-level nodes.
+
+        The output is a dict mapping the smallest top-level node ID in each
+        truncated component (in decomposed_digraph) to a list of the reasons
+        it was truncated. (This is the same way AssemblyGraph identifies
+        components in e.g. degraded_components.)
+        """
+        cc2min = {}
+        for n in decomposed_digraph.nodes:
+            cc_i = self.node2cc[n]
+            if cc_i in self.truncated:
+                if cc_i not in cc2min or n < cc2min[cc_i]:
+                    cc2min[cc_i] = n
+        return {m: self.truncated[cc_i] for cc_i, m in cc2min.items()}
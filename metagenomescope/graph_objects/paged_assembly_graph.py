@@ -0,0 +1,480 @@
+# Copyright (C) 2016-- Marcus Fedarko, Jay Ghurye, Todd Treangen, Mihai Pop
+# Authored by Marcus Fedarko
+#
+# This file is part of MetagenomeScope.
+#
+# MetagenomeScope is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# MetagenomeScope is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with MetagenomeScope.  If not, see <http://www.gnu.org/licenses/>.
+
+import json
+import pickle
+import tempfile
+from operator import itemgetter
+import numpy
+
+from .. import assembly_graph_parser, config, layout_cost, progress
+from ..disk_graph import DiskBackedGraph
+from ..msg_utils import operation_msg, conclude_msg
+from .assembly_graph import AssemblyGraph
+
+
+class PagedAssemblyGraph(object):
+    """Out-of-core version of AssemblyGraph.
+
+    Rather than parsing the entire input graph into a NetworkX DiGraph, this
+    parses the graph into a DiskBackedGraph (which stores node/edge data on
+    disk, and identifies connected components a chunk at a time).
+    process() then "pages in" a group of components at a time, runs the
+    normal AssemblyGraph pipeline (scaling, pattern detection, layout) on
+    just those components, and writes their exported data out to a temporary
+    file -- so at any given point in time we only have the NetworkX / Pattern
+    objects and output for one page of the graph in memory.
+
+    This exposes the same interface as AssemblyGraph that make_viz() uses
+    (process(), to_dict(), to_json(), basename), so it can be used as a
+    drop-in replacement there.
+
+    NOTE that the output of this should match the output of AssemblyGraph on
+    the same graph (the same patterns, node dimensions, etc.), with a few
+    exceptions: 1) the integer IDs assigned to nodes/patterns may differ
+    (they're still unique, though), 2) components with the exact same node,
+    edge, and pattern counts may be ordered differently, and 3) since the
+    node IDs differ, the order in which nodes are passed to dot can differ
+    -- and dot's layouts are sensitive to that order -- so coordinates may
+    not be identical.
+    """
+
+    def __init__(
+        self,
+        filename,
+        max_node_count=config.MAXN_DEFAULT,
+        max_edge_count=config.MAXE_DEFAULT,
+        page_node_count=config.PAGE_NODE_COUNT,
+        temp_dir=None,
+        input_format=None,
+        validation=config.VALIDATION_DEFAULT,
+        layout_workers=config.LAYOUT_WORKERS_DEFAULT,
+        decomposition_workers=config.DECOMPOSITION_WORKERS_DEFAULT,
+        decomposition_time_limit=None,
+        decomposition_max_calls=None,
+        max_pattern_depth=None,
+        cost_model=None,
+        assume_oriented=False,
+    ):
+        """Parses the input graph file into disk-backed storage.
+
+        filename, input_format, validation, layout_workers,
+        decomposition_workers, decomposition_time_limit,
+        decomposition_max_calls, max_pattern_depth, cost_model, and
+        assume_oriented work the same as in AssemblyGraph. (The same cost
+        model is shared by every page, so the timings from all pages get
+        recorded in it.) We don't support AssemblyGraph's time_budget yet,
+        since that'd require planning the budget across pages.
+
+        temp_dir is the directory in which we'll create a temporary directory
+        for our on-disk data. If this is None, we'll use Python's default
+        (which you can control using the TMPDIR environment variable).
+        """
+        self.filename = filename
+        self.max_node_count = max_node_count
+        self.max_edge_count = max_edge_count
+        self.page_node_count = page_node_count
+        assembly_graph_parser.check_validation_level(validation)
+        self.validation = validation
+        self.assume_oriented = assume_oriented
+        self.layout_workers = layout_workers
+        self.decomposition_workers = decomposition_workers
+        self.decomposition_time_limit = decomposition_time_limit
+        self.decomposition_max_calls = decomposition_max_calls
+        self.max_pattern_depth = max_pattern_depth
+        if cost_model is None:
+            cost_model = layout_cost.LayoutCostModel()
+        self.cost_model = cost_model
+
+        self.basename = assembly_graph_parser.get_basename(self.filename)
+        self.filetype = assembly_graph_parser.sniff_filetype(
+            self.filename, input_format
+        )
+
+        operation_msg(
+            "Reading and parsing input file {} into disk-backed "
+            "storage...".format(self.basename)
+        )
+        self.store = DiskBackedGraph(directory=temp_dir)
+        try:
+            assembly_graph_parser.parse(
+                self.filename,
+                digraph=self.store,
+                input_format=self.filetype,
+                validation=self.validation,
+                assume_oriented=self.assume_oriented,
+            )
+            conclude_msg()
+            operation_msg("Identifying connected components...")
+            self.store.finalize()
+            conclude_msg()
+            self.check_attrs()
+        except Exception:
+            self.store.close()
+            raise
+
+        # Figure out which components are too large to lay out. This mirrors
+        # AssemblyGraph.remove_too_large_components(), but we don't need to
+        # touch any of the actual nodes/edges to do this.
+        self.num_too_large_components = 0
+        self.skipped_components = []
+        self.cc_nums_to_process = []
+        for cc_num in range(self.store.num_components):
+            num_nodes = int(self.store.cc_node_counts[cc_num])
+            num_edges = int(self.store.cc_edge_counts[cc_num])
+            if (
+                num_nodes > self.max_node_count
+                or num_edges > self.max_edge_count
+            ):
+                self.num_too_large_components += 1
+                lengths = [
+                    v
+                    for v in self.store.node_values(
+                        "length", self.store.component_node_indices([cc_num])
+                    )
+                    if v is not None
+                ]
+                self.skipped_components.append(
+                    (
+                        num_nodes,
+                        num_edges,
+                        sum(lengths) if len(lengths) > 0 else None,
+                    )
+                )
+                operation_msg(
+                    (
+                        "Ignoring a component ({:,} nodes, {:,} "
+                        "edges): exceeds -maxn or -maxe."
+                    ).format(num_nodes, num_edges),
+                    True,
+                )
+            else:
+                self.cc_nums_to_process.append(cc_num)
+
+        if len(self.cc_nums_to_process) == 0:
+            self.store.close()
+            raise ValueError(
+                "All components were too large to lay out. Try increasing the "
+                "-maxn/-maxe parameters, or reducing the size of the graph."
+            )
+
+        # Filled in by process(). As each page finishes, we pickle the dict
+        # representations of its components (as produced by
+        # AssemblyGraph.to_dict()) to an anonymous temporary file, and just
+        # remember where each one starts and how big it is (for sorting).
+        # Each entry in component_info is a 4-tuple of (file offset, node
+        # count, edge count, pattern count).
+        self.component_file = tempfile.TemporaryFile(dir=temp_dir)
+        self.component_info = []
+        # The rest of the top-level stuff in AssemblyGraph.to_dict()'s output
+        # will be taken from the output of the last page.
+        self.page_data_fields = {}
+        self.total_num_nodes = 0
+        self.total_num_edges = 0
+
+    def check_attrs(self):
+        """Analogue of AssemblyGraph.check_attrs(), using the store's columns.
+
+        Since the store knows all of the attributes it's seen, we can just
+        check those names rather than going through every node and edge. If
+        any reserved attributes are present, we find the first node/edge that
+        has any of them so that the error message matches AssemblyGraph's.
+        """
+        node_cols = self.store.node_cols
+        edge_cols = self.store.edge_cols
+        checks = (
+            (node_cols, AssemblyGraph.INTERNAL_NODE_ATTRS, "node"),
+            (edge_cols, AssemblyGraph.INTERNAL_EDGE_ATTRS, "edge"),
+        )
+        if self.validation == config.VALIDATION_NONE:
+            checks = ()
+        for cols, internal, noun in checks:
+            reserved = [a for a in cols if a in internal]
+            if len(reserved) == 0:
+                continue
+            if noun == "node":
+                rows = numpy.arange(len(self.store))
+            else:
+                rows = numpy.asarray(self.store.edge_rows)
+            present = {a: cols[a].present()[rows] for a in reserved}
+            has_any = numpy.zeros(len(rows), dtype=bool)
+            for p in present.values():
+                has_any |= p
+            if not has_any.any():
+                # These attributes were only ever declared as None
+                continue
+            first = int(numpy.argmax(has_any))
+            row = int(rows[first])
+            if noun == "node":
+                elem = self.store.names[row]
+            else:
+                elem = (
+                    self.store.names[int(self.store.src[row])],
+                    self.store.names[int(self.store.tgt[row])],
+                )
+            shared_attrs = set(a for a in reserved if present[a][first])
+            raise ValueError(
+                "Sorry -- {} {} has reserved attribute(s) {}. Please rename "
+                "these.".format(noun, elem, shared_attrs)
+            )
+        self.node_attr_types = self.store.node_attr_types()
+        self.edge_attr_types = self.store.edge_attr_types()
+        self.extra_node_attrs = (
+            set(self.store.node_attrs()) - AssemblyGraph.INTERNAL_NODE_ATTRS
+        )
+        self.extra_edge_attrs = (
+            set(self.store.edge_attrs()) - AssemblyGraph.INTERNAL_EDGE_ATTRS
+        )
+
+    def get_pages(self):
+        """Groups the components we'll process into "pages."
+
+        Returns a list of lists of component numbers (as used in the store).
+        Each page contains at most self.page_node_count nodes, unless a
+        single component is larger than that (in which case that component
+        gets its own page).
+        """
+        pages = []
+        curr_page = []
+        curr_page_node_ct = 0
+        for cc_num in self.cc_nums_to_process:
+            cc_node_ct = int(self.store.cc_node_counts[cc_num])
+            if (
+                len(curr_page) > 0
+                and curr_page_node_ct + cc_node_ct > self.page_node_count
+            ):
+                pages.append(curr_page)
+                curr_page = []
+                curr_page_node_ct = 0
+            curr_page.append(cc_num)
+            curr_page_node_ct += cc_node_ct
+        if len(curr_page) > 0:
+            pages.append(curr_page)
+        return pages
+
+    def get_scaling_params(self):
+        """Computes node and edge scaling parameters for the entire graph.
+
+        (Well, for every component we're going to process -- components that
+        are too large to lay out are excluded, just like how
+        AssemblyGraph.remove_too_large_components() is called before
+        AssemblyGraph.scale_nodes().)
+
+        Returns a 2-tuple of (node scaling params, edge scaling params). The
+        latter will be None if the graph doesn't have edge weights.
+        """
+        node_indices = self.store.component_node_indices(
+            self.cc_nums_to_process
+        )
+        node_params = AssemblyGraph.get_node_scaling_params(
+            self.store.node_values("length", node_indices)
+        )
+
+        edge_rows = self.store.component_edge_rows(self.cc_nums_to_process)
+        # Mirrors AssemblyGraph.get_edge_weight_field()
+        ew_field = None
+        weights = None
+        for fn in ("bsize", "multiplicity"):
+            if fn in self.store.edge_attrs():
+                fn_weights = [
+                    w
+                    for w in self.store.edge_values(fn, edge_rows)
+                    if w is not None
+                ]
+                if len(fn_weights) > 0:
+                    if ew_field is None:
+                        ew_field = fn
+                        weights = fn_weights
+                    else:
+                        raise ValueError(
+                            (
+                                "Graph has multiple 'edge weight' fields, "
+                                "including {} and {}. It's ambiguous which we "
+                                "should use for scaling."
+                            ).format(ew_field, fn)
+                        )
+        edge_params = None
+        if ew_field is not None:
+            edge_params = AssemblyGraph.get_edge_scaling_params(weights)
+        return node_params, edge_params
+
+    def process(self):
+        """Runs the AssemblyGraph pipeline on one page of the graph at a time.
+
+        Layout progress is reported over all pages at once: see
+        get_layout_progress().
+
+        After this is done, the on-disk data is deleted.
+        """
+        prog = None
+        try:
+            operation_msg("Computing node and edge scaling parameters...")
+            node_params, edge_params = self.get_scaling_params()
+            conclude_msg()
+
+            pages = self.get_pages()
+            prog = self.get_layout_progress(pages)
+            prog.start()
+            prog.suspend()
+            next_node_id = 0
+            first_progress_index = 0
+            for page_num, page in enumerate(pages, 1):
+                page_node_ct = int(numpy.sum(self.store.cc_node_counts[page]))
+                operation_msg(
+                    "Processing page {:,} / {:,} ({:,} component(s), {:,} "
+                    "nodes)...".format(
+                        page_num, len(pages), len(page), page_node_ct
+                    ),
+                    True,
+                )
+                ag = AssemblyGraph(
+                    self.filename,
+                    max_node_count=self.max_node_count,
+                    max_edge_count=self.max_edge_count,
+                    digraph=self.store.component_digraph(page),
+                    first_node_id=next_node_id,
+                    input_format=self.filetype,
+                    # We've already checked the attributes of the entire
+                    # graph in self.check_attrs(), so don't bother doing that
+                    # again for each page
+                    validation=config.VALIDATION_NONE,
+                    layout_workers=self.layout_workers,
+                    decomposition_workers=self.decomposition_workers,
+                    decomposition_time_limit=self.decomposition_time_limit,
+                    decomposition_max_calls=self.decomposition_max_calls,
+                    max_pattern_depth=self.max_pattern_depth,
+                    cost_model=self.cost_model,
+                )
+                # Make sure every page exports the same set of extra attrs
+                # (and types), even if some of these attrs are only present
+                # in other pages
+                ag.extra_node_attrs = set(self.extra_node_attrs)
+                ag.extra_edge_attrs = set(self.extra_edge_attrs)
+                ag.node_attr_types = self.node_attr_types
+                ag.edge_attr_types = self.edge_attr_types
+                ag.node_scaling_params = node_params
+                ag.edge_scaling_params = edge_params
+                ag.process(prog, first_progress_index)
+                first_progress_index += len(page)
+                page_data = ag.to_dict()
+
+                for f in (
+                    "node_attrs",
+                    "edge_attrs",
+                    "patt_attrs",
+                    "extra_node_attrs",
+                    "extra_edge_attrs",
+                    "extra_node_attr_types",
+                    "extra_edge_attr_types",
+                ):
+                    self.page_data_fields[f] = page_data[f]
+                self.total_num_nodes += page_data["total_num_nodes"]
+                self.total_num_edges += page_data["total_num_edges"]
+                self.save_components(page_data["components"])
+                del page_data
+
+                # The next page's node IDs should start after all of the IDs
+                # (including pattern and duplicate node IDs) used in this page
+                next_node_id = ag.num_nodes
+        finally:
+            if prog is not None:
+                prog.finish()
+            self.store.close()
+
+    def save_components(self, components):
+        """Writes out the dict representations of some components."""
+        for cc in components:
+            edge_ct = sum(len(tgts) for tgts in cc["edges"].values())
+            self.component_info.append(
+                (
+                    self.component_file.tell(),
+                    len(cc["nodes"]),
+                    edge_ct,
+                    len(cc["patts"]),
+                )
+            )
+            pickle.dump(cc, self.component_file, pickle.HIGHEST_PROTOCOL)
+
+    def iter_components(self):
+        """Yields the dict representation of every component, in order.
+
+        The order (and the placeholders for skipped components) matches the
+        "components" list in AssemblyGraph.to_dict()'s output. Components are
+        read back in from disk one at a time.
+        """
+        for info in sorted(
+            self.skipped_components, key=itemgetter(0, 1), reverse=True
+        ):
+            yield AssemblyGraph.get_skipped_placeholder(*info)
+        # Sort components the same way AssemblyGraph.get_connected_components()
+        # does: by node count, then edge count, then pattern count.
+        for info in sorted(
+            self.component_info, key=itemgetter(1, 2, 3), reverse=True
+        ):
+            self.component_file.seek(info[0])
+            yield pickle.load(self.component_file)
+
+    def get_layout_progress(self, pages):
+        """Makes a LayoutProgress covering every component on every page.
+
+        Until a page is decomposed, we don't know how many patterns its
+        components contain, so at first we assume they have none (and guess
+        how long they'll take to lay out based on just their node and edge
+        counts). Each page's AssemblyGraph.layout() call replaces these
+        guesses with the real numbers for its components.
+        """
+        components = []
+        for page in pages:
+            for cc_num in page:
+                num_nodes = int(self.store.cc_node_counts[cc_num])
+                num_edges = int(self.store.cc_edge_counts[cc_num])
+                predicted = 0
+                if num_nodes > 1 or num_edges > 0:
+                    predicted = self.cost_model.predict(
+                        num_nodes, num_edges, 0, 0
+                    )
+                components.append((num_nodes, num_edges, 0, predicted))
+        return progress.LayoutProgress(components, workers=self.layout_workers)
+
+    def to_dict(self, on_component=None):
+        """Returns a dict representation of the graph usable as JSON.
+
+        This has the same format as AssemblyGraph.to_dict(), and on_component
+        works the same way as there. Should only be called after
+        self.process() has already been called.
+        """
+        out = dict(self.page_data_fields)
+        out.update(
+            {
+                "components": [],
+                "input_file_basename": self.basename,
+                "input_file_type": self.filetype,
+                "total_num_nodes": self.total_num_nodes,
+                "total_num_edges": self.total_num_edges,
+                # We don't support simplification in out-of-core mode (yet)
+                "removed_elements": {"nodes": [], "edges": []},
+            }
+        )
+        for cc_num, cc in enumerate(self.iter_components(), 1):
+            out["components"].append(cc)
+            if on_component is not None:
+                on_component(out, cc_num, cc)
+        return out
+
+    def to_json(self):
+        return json.dumps(self.to_dict())
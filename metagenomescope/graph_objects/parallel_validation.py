@@ -0,0 +1,373 @@
+# Copyright (C) 2016-- Marcus Fedarko, Jay Ghurye, Todd Treangen, Mihai Pop
+# Authored by Marcus Fedarko
+#
+# This file is part of MetagenomeScope.
+#
+# MetagenomeScope is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# MetagenomeScope is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with MetagenomeScope.  If not, see <http://www.gnu.org/licenses/>.
+####
+# Running pattern validators in parallel.
+#
+# Hierarchical decomposition (AssemblyGraph.hierarchically_identify_patterns())
+# is inherently sequential: whether or not a node starts a pattern depends on
+# which patterns have already been collapsed. And we really want the results
+# of decomposition to be the same regardless of how many processes we use.
+#
+# The trick is that the validators (is_valid_chain(), etc.) only look at the
+# graph through g.adj[x], g.pred[x], and g.nodes[x] -- and collapsing a
+# pattern only changes these for a handful of nodes (the pattern's nodes and
+# their neighbors). So at the start of each validator's pass through the
+# graph, we run the validator on every candidate node in parallel, and record
+# which nodes each call looked at (its "read set"). Then, during the normal
+# sequential pass, we can reuse a precomputed result as long as none of the
+# nodes in its read set have been modified since we started the pass;
+# otherwise, we just call the validator again. Either way, we get exactly the
+# same result we'd get by calling the validator right then, so the patterns
+# we find are identical to the sequential ones. (This includes the order of
+# the nodes in each pattern, which depends on the order in which validators
+# see each node's neighbors -- so workers store exact copies of each node's
+# neighbor dicts, rather than rebuilding their graphs edge by edge. See
+# RegionGraph.)
+#
+# The unit of work is a "region": we split the graph into one contiguous
+# region per worker process (see get_regions()), and each worker keeps its
+# own copy of its region for the entire AssemblyGraph.collapse_patterns()
+# call. After each pass we only send each worker the nodes in its region that
+# changed, rather than the whole graph. A worker only checks candidate nodes
+# in its region, and if a validator tries to look at a node outside of the
+# worker's region, the worker gives up on that call (and the sequential pass
+# will just call the validator itself). Regions are grown by breadth-first
+# search, so this only happens for calls starting near the edge of a region.
+#
+# (We looked into splitting components up at cut vertices or strongly
+# connected components instead, but patterns don't respect those boundaries:
+# chains pass right through cut vertices, and superbubbles span multiple
+# SCCs. Read sets are exact, and in practice they're small -- most calls
+# only look at a node and its immediate neighbors.)
+
+import multiprocessing
+from collections import deque
+from itertools import chain
+import networkx as nx
+
+from .. import config
+
+
+class NotInRegionError(Exception):
+    """Raised when a validator looks at a node outside a worker's region."""
+
+
+class ReadTrackingMap(object):
+    """Wraps a mapping, recording which keys are looked up in it.
+
+    If region is not None, looking up a key that isn't in region raises a
+    NotInRegionError.
+    """
+
+    def __init__(self, mapping, reads, region=None):
+        self.mapping = mapping
+        self.reads = reads
+        self.region = region
+
+    def __getitem__(self, key):
+        if self.region is not None and key not in self.region:
+            raise NotInRegionError(key)
+        self.reads.add(key)
+        return self.mapping[key]
+
+
+class ReadTrackingGraph(object):
+    """Read-only view of a DiGraph that records which nodes are looked at.
+
+    This only supports the parts of the graph API used by the validators in
+    AssemblyGraph (g.adj[x], g.pred[x], and g.nodes[x]). See ReadTrackingMap
+    for what region does.
+    """
+
+    def __init__(self, g, region=None):
+        self.reads = set()
+        self.adj = ReadTrackingMap(g.adj, self.reads, region)
+        self.pred = ReadTrackingMap(g.pred, self.reads, region)
+        self.nodes = ReadTrackingMap(g.nodes, self.reads, region)
+
+
+class ChangeTrackingDiGraph(nx.DiGraph):
+    """DiGraph that records which nodes have had their neighborhoods changed.
+
+    After each modification, self.touched contains every node whose
+    outgoing edges, incoming edges, or attributes might have changed. Only
+    the methods used in hierarchical decomposition are tracked (see
+    AssemblyGraph.add_pattern() and add_bubble()).
+    """
+
+    def __init__(self, incoming_graph_data=None, **attr):
+        self.touched = set()
+        super().__init__(incoming_graph_data, **attr)
+
+    def add_node(self, node_for_adding, **attr):
+        self.touched.add(node_for_adding)
+        super().add_node(node_for_adding, **attr)
+
+    def add_edge(self, u_of_edge, v_of_edge, **attr):
+        self.touched.add(u_of_edge)
+        self.touched.add(v_of_edge)
+        super().add_edge(u_of_edge, v_of_edge, **attr)
+
+    def remove_edge(self, u, v):
+        self.touched.add(u)
+        self.touched.add(v)
+        super().remove_edge(u, v)
+
+    def remove_nodes_from(self, nodes):
+        nodes = list(nodes)
+        for n in nodes:
+            if n in self._adj:
+                self.touched.add(n)
+                self.touched.update(self._succ[n])
+                self.touched.update(self._pred[n])
+        super().remove_nodes_from(nodes)
+
+
+def get_node_state(g, n):
+    """Returns everything a validator can see about a node in g.
+
+    This is a 3-tuple of (n's attributes, n's outgoing edges, n's incoming
+    edges); the latter two are dicts mapping neighbors to edge attributes.
+    """
+    return (
+        dict(g.nodes[n]),
+        {v: dict(data) for v, data in g.adj[n].items()},
+        {u: dict(data) for u, data in g.pred[n].items()},
+    )
+
+
+class RegionGraph(object):
+    """A worker's copy of the nodes in its region.
+
+    This supports the same parts of the graph API as ReadTrackingGraph. We
+    just store the dicts get_node_state() gives us for each node, as is. (If
+    we instead rebuilt each node in a DiGraph by removing and re-adding its
+    edges, the order of its neighbors' neighbors would change -- and that
+    changes the order of the nodes in the patterns we find.)
+    """
+
+    def __init__(self):
+        self.nodes = {}
+        self.adj = {}
+        self.pred = {}
+
+    def set_node_state(self, n, state):
+        """Makes n look like it does in the graph get_node_state() was
+        given.
+        """
+        self.nodes[n], self.adj[n], self.pred[n] = state
+
+    def remove_node(self, n):
+        self.nodes.pop(n, None)
+        self.adj.pop(n, None)
+        self.pred.pop(n, None)
+
+
+def get_regions(g, num_regions, nodes=None):
+    """Splits nodes into at most num_regions regions of about the same size.
+
+    If nodes is None, this splits up all of the nodes in g. We grow each
+    region using a breadth-first search (ignoring edge directions), starting
+    from the smallest node we haven't put in a region yet -- so most nodes'
+    neighbors are in the same region as them. Small components get packed
+    into the same region, and large components get split across regions.
+
+    Returns a list of lists of node IDs.
+    """
+    if nodes is None:
+        nodes = g.nodes
+    node_set = set(nodes)
+    region_size = max(1, -(-len(node_set) // num_regions))
+    regions = [[]]
+    seen = set()
+    for start in sorted(node_set):
+        if start in seen:
+            continue
+        seen.add(start)
+        queue = deque([start])
+        while len(queue) > 0:
+            n = queue.popleft()
+            if len(regions[-1]) >= region_size:
+                regions.append([])
+            regions[-1].append(n)
+            for m in chain(g.adj[n], g.pred[n]):
+                if m in node_set and m not in seen:
+                    seen.add(m)
+                    queue.append(m)
+    return [r for r in regions if len(r) > 0]
+
+
+def _run_worker(conn, g, region):
+    """Main loop of a worker process; see ValidatorPool.
+
+    g is a RegionGraph containing the nodes in this worker's region (and
+    their edges, which might go to nodes outside of the region). Each message we receive is
+    either None (meaning we should stop) or a 4-tuple of (nodes removed
+    from the region, (node, state) pairs for nodes in the region that were
+    added or changed, the validator to run, and the nodes to run it on). We
+    reply with a list of (node, validator outputs, read set) for every node
+    whose validator call stayed within the region.
+    """
+    while True:
+        msg = conn.recv()
+        if msg is None:
+            return
+        try:
+            removed, changed, validator, node_ids = msg
+            for n in removed:
+                region.discard(n)
+                g.remove_node(n)
+            for n, state in changed:
+                region.add(n)
+                g.set_node_state(n, state)
+            results = []
+            for n in node_ids:
+                tracked = ReadTrackingGraph(g, region)
+                try:
+                    outputs = validator(tracked, n)
+                except NotInRegionError:
+                    continue
+                results.append((n, outputs, tracked.reads))
+            conn.send(results)
+        except Exception as e:
+            conn.send(e)
+
+
+class ValidatorPool(object):
+    """Worker processes that run validators on their own region of a graph.
+
+    This is meant to last for an entire AssemblyGraph.collapse_patterns()
+    call. We don't start up any processes until the first time
+    precompute() has enough candidate nodes to bother with; at that point,
+    we split the graph into regions (one per worker, see get_regions()) and
+    give each worker a copy of its region. After that, each precompute()
+    call just sends each worker the nodes in its region that have changed
+    since the last call.
+
+    g should be a ChangeTrackingDiGraph. If nodes is not None, we'll only
+    split up these nodes (plus any new nodes that get added next to them)
+    into regions.
+    """
+
+    def __init__(self, g, num_workers, nodes=None):
+        self.g = g
+        self.num_workers = num_workers
+        self.nodes = None if nodes is None else set(nodes)
+        # List of (process, connection) pairs, one per worker
+        self.workers = None
+        # Maps each node in a region to the index of its worker
+        self.owner = {}
+        # Nodes that have changed since we last synced up the workers
+        self.pending = set()
+
+    def start(self):
+        self.workers = []
+        self.pending = set()
+        for i, region in enumerate(
+            get_regions(self.g, self.num_workers, self.nodes)
+        ):
+            sub = RegionGraph()
+            for n in region:
+                self.owner[n] = i
+                sub.set_node_state(n, get_node_state(self.g, n))
+            parent_conn, child_conn = multiprocessing.Pipe()
+            proc = multiprocessing.Process(
+                target=_run_worker,
+                args=(child_conn, sub, set(region)),
+                daemon=True,
+            )
+            proc.start()
+            child_conn.close()
+            self.workers.append((proc, parent_conn))
+
+    def get_new_owner(self, n):
+        """Picks a region for a node that was added to the graph.
+
+        New nodes (i.e. patterns) go in the same region as one of their
+        neighbors, if possible.
+        """
+        owners = [
+            self.owner[m]
+            for m in chain(self.g.adj[n], self.g.pred[n])
+            if m in self.owner
+        ]
+        return min(owners) if len(owners) > 0 else 0
+
+    def precompute(self, validator, node_ids):
+        """Runs a validator on many nodes in parallel.
+
+        Returns a dict mapping node IDs in node_ids to 2-tuples of (the
+        validator's output for this node, the set of nodes the validator
+        looked at). If there are fewer than
+        config.PARALLEL_VALIDATION_MIN_CANDIDATES nodes, this doesn't do
+        anything and just returns an empty dict; this dict will also be
+        missing nodes whose validator calls went outside of their region. The
+        caller should fall back to calling the validator itself for any node
+        not in the dict.
+
+        The caller should reset self.g.touched right after calling this,
+        since the results correspond to the graph as it is now. (We keep
+        track of the touched nodes ourselves, so that we know what to send to
+        the workers next time.)
+        """
+        self.pending |= self.g.touched
+        if (
+            self.num_workers <= 1
+            or len(node_ids) < config.PARALLEL_VALIDATION_MIN_CANDIDATES
+        ):
+            return {}
+        if self.workers is None:
+            self.start()
+        msgs = [([], [], validator, []) for _ in self.workers]
+        for n in self.pending:
+            if n in self.g:
+                if n not in self.owner:
+                    self.owner[n] = self.get_new_owner(n)
+                msgs[self.owner[n]][1].append((n, get_node_state(self.g, n)))
+            elif n in self.owner:
+                msgs[self.owner.pop(n)][0].append(n)
+        self.pending = set()
+        for n in node_ids:
+            if n in self.owner:
+                msgs[self.owner[n]][3].append(n)
+        for (proc, conn), msg in zip(self.workers, msgs):
+            conn.send(msg)
+        precomputed = {}
+        for proc, conn in self.workers:
+            results = conn.recv()
+            if isinstance(results, Exception):
+                raise results
+            for n, outputs, reads in results:
+                precomputed[n] = (outputs, reads)
+        return precomputed
+
+    def close(self):
+        """Stops the worker processes (if we started any)."""
+        if self.workers is None:
+            return
+        for proc, conn in self.workers:
+            try:
+                conn.send(None)
+            except (BrokenPipeError, OSError):
+                pass
+            conn.close()
+        for proc, conn in self.workers:
+            proc.join(timeout=5)
+            if proc.is_alive():
+                proc.terminate()
+        self.workers = None
@@ -93,6 +93,22 @@ class Pattern(object):
 
         return [node_ct, edge_ct, patt_ct]
 
+    def get_depth(self, asm_graph):
+        """Returns how deeply patterns are nested within this pattern.
+
+        A pattern that doesn't contain any other patterns has depth 1; a
+        pattern containing a pattern that doesn't contain any other patterns
+        has depth 2; etc.
+        """
+        child_depth = 0
+        for node_id in self.node_ids:
+            if asm_graph.is_pattern(node_id):
+                child_depth = max(
+                    child_depth,
+                    asm_graph.id2pattern[node_id].get_depth(asm_graph),
+                )
+        return child_depth + 1
+
     def set_cc_num(self, asm_graph, cc_num):
         """Updates the component number attribute of all Patterns, nodes, and
         edges in this Pattern.
@@ -112,11 +128,14 @@ class Pattern(object):
     def layout(self, asm_graph):
         # Recursively go through all of the nodes within this pattern. If any
         # of these isn't actually a node (and is actually a pattern), then lay
-        # out that pattern!
+        # out that pattern! (Unless it's already been laid out -- this can
+        # happen after AssemblyGraph.remove_nodes_and_edges(), where we keep
+        # the layouts of patterns that weren't affected by the removal.)
         id2pattern = {}
         for node_id in self.node_ids:
             if asm_graph.is_pattern(node_id):
-                asm_graph.id2pattern[node_id].layout(asm_graph)
+                if asm_graph.id2pattern[node_id].width is None:
+                    asm_graph.id2pattern[node_id].layout(asm_graph)
                 id2pattern[node_id] = asm_graph.id2pattern[node_id]
 
         # Now that all of the patterns (if present) within this pattern have
@@ -56,3 +56,29 @@ def negate_node_id(id_string):
         return id_string[1:]
     else:
         return "-" + id_string
+
+
+def n50(node_lengths):
+    """Determines the N50 statistic of a list of numbers.
+
+    This function assumes that the input list is not empty. (If it is, this
+    raises a ValueError.)
+
+    Roughly: the N50 is the largest length L such that at least half of the
+    total length is contained in sequences of length >= L. We compute this by
+    sorting lengths in descending order and adding them up until we reach half
+    of the total length.
+    """
+    if len(node_lengths) == 0:
+        raise ValueError(config.EMPTY_LIST_N50_ERR)
+    sorted_lengths = sorted(node_lengths, reverse=True)
+    i = 0
+    running_sum = 0
+    half_total_length = 0.5 * sum(sorted_lengths)
+    while running_sum < half_total_length:
+        if i >= len(sorted_lengths):
+            # This should never happen, but just in case
+            raise IndexError(config.N50_CALC_ERR)
+        running_sum += sorted_lengths[i]
+        i += 1
+    return sorted_lengths[i - 1]
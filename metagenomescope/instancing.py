@@ -0,0 +1,208 @@
+# Copyright (C) 2016-- Marcus Fedarko, Jay Ghurye, Todd Treangen, Mihai Pop
+# Authored by Marcus Fedarko
+#
+# This file is part of MetagenomeScope.
+#
+# MetagenomeScope is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# MetagenomeScope is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with MetagenomeScope.  If not, see <http://www.gnu.org/licenses/>.
+####
+# Sharing the layouts of structurally identical components in the viewer's
+# graph data.
+#
+# Metagenome assembly graphs usually have a long tail of tiny components
+# that all look the same: thousands of lone nodes, two-node pairs, simple
+# bubbles, etc. These have the same layouts, so (rather than storing every
+# node's position / size / ... in every component) we store each distinct
+# layout once, as a "template", and store each component that uses it as
+# an "instance" that only lists its own node IDs, node names, node lengths,
+# and pattern IDs. The viewer expands instances back into normal components
+# when it needs them (see DataHolder.getComponent() in the JS).
+#
+# Two components share a template if, after replacing their node / pattern
+# IDs with their positions in a canonical ordering (and ignoring node names
+# and lengths), their data is the same when coordinates are rounded to
+# config.INSTANCE_COORD_DECIMALS decimal places. The template stores these
+# rounded values.
+#
+# Templates look like
+#
+# {
+#     "nodes": [node data list, with name and length set to None, ...],
+#     "edges": [[source node index, target node index, edge data list], ...],
+#     "patts": [pattern data list, ...],
+#     "bb": [width, height],
+# }
+#
+# ... where all "parent_id" and "pattern_id" values are indices in "patts"
+# instead of actual pattern IDs. Instances look like
+#
+# {
+#     "instance_of": index of the template in graph_data["templates"],
+#     "node_ids": [node ID for each node in the template, ...],
+#     "names": [name of each node, ...],
+#     "lengths": [length of each node, ...],
+#     "patt_ids": [pattern ID for each pattern in the template, ...],
+#     "skipped": False,
+# }
+#
+# Extra attributes aren't handled here, since write_attr_tables() has
+# already moved them to side tables keyed by node ID.
+
+import json
+from . import config
+
+
+def round_coords(val):
+    """Rounds all of the floats in a (possibly nested) value."""
+    if isinstance(val, float):
+        return round(val, config.INSTANCE_COORD_DECIMALS)
+    if isinstance(val, (list, tuple)):
+        return [round_coords(v) for v in val]
+    return val
+
+
+def can_instance(comp):
+    """Returns True if a component is a candidate for instancing.
+
+    We only instance small, "normal" components: big components won't
+    have any twins, and components with zoom levels / tiles / etc. have
+    extra data that we'd rather not worry about.
+    """
+    if comp["skipped"] or comp["degraded"]:
+        return False
+    if (
+        len(comp["zoom_levels"]) > 0
+        or len(comp["decomposition_truncated"]) > 0
+    ):
+        return False
+    if "tiles" in comp:
+        return False
+    num_edges = sum(len(tgts) for tgts in comp["edges"].values())
+    return len(comp["nodes"]) + num_edges <= config.INSTANCE_MAX_COMPONENT_SIZE
+
+
+def get_template(comp, na, ea, pa):
+    """Converts a component into a template.
+
+    Returns a 3-tuple of (template, node IDs, pattern IDs), where the node
+    and pattern IDs are listed in the same order as in the template.
+    """
+    pid = pa["pattern_id"]
+    ppar = pa["parent_id"]
+
+    # Order patterns by depth (so parents still come before children),
+    # then by position / size / type
+    patt_depth = {}
+    for patt in comp["patts"]:
+        # comp["patts"] already lists parents before children
+        parent = patt[ppar]
+        patt_depth[patt[pid]] = 0 if parent is None else patt_depth[parent] + 1
+    patts = sorted(
+        comp["patts"],
+        key=lambda p: (
+            patt_depth[p[pid]],
+            round_coords([v for i, v in enumerate(p) if i not in (pid, ppar)]),
+        ),
+    )
+    patt_ids = [p[pid] for p in patts]
+    patt2idx = {p: i for i, p in enumerate(patt_ids)}
+
+    def local_parent(parent):
+        return None if parent is None else patt2idx[parent]
+
+    # Order nodes by everything but their name and length (which can vary
+    # between instances)
+    instance_fields = (na["name"], na["length"])
+    template_nodes = {}
+    for node_id, data in comp["nodes"].items():
+        tdata = round_coords(data)
+        for i in instance_fields:
+            tdata[i] = None
+        tdata[na["parent_id"]] = local_parent(data[na["parent_id"]])
+        template_nodes[node_id] = tdata
+    node_ids = sorted(
+        comp["nodes"], key=lambda n: json.dumps(template_nodes[n])
+    )
+    node2idx = {n: i for i, n in enumerate(node_ids)}
+
+    edges = []
+    for src, tgts in comp["edges"].items():
+        for tgt, data in tgts.items():
+            tdata = round_coords(data)
+            tdata[ea["parent_id"]] = local_parent(data[ea["parent_id"]])
+            edges.append([node2idx[src], node2idx[tgt], tdata])
+    edges.sort(key=lambda e: (e[0], e[1]))
+
+    template_patts = []
+    for patt in patts:
+        tdata = round_coords(patt)
+        tdata[pid] = patt2idx[patt[pid]]
+        tdata[ppar] = local_parent(patt[ppar])
+        template_patts.append(tdata)
+
+    template = {
+        "nodes": [template_nodes[n] for n in node_ids],
+        "edges": edges,
+        "patts": template_patts,
+        "bb": round_coords(comp["bb"]),
+    }
+    return template, node_ids, patt_ids
+
+
+def instance_components(graph_data):
+    """Replaces structurally identical components with instances.
+
+    graph_data should be the graph data for the viewer (i.e. the output of
+    attr_tables.write_attr_tables()). This doesn't modify graph_data;
+    instead, it returns a version of graph_data where components that share
+    a template with at least config.INSTANCE_MIN_COUNT - 1 other components
+    are replaced with instances. The templates are stored in the returned
+    dict's "templates" list.
+    """
+    na = graph_data["node_attrs"]
+    ea = graph_data["edge_attrs"]
+    pa = graph_data["patt_attrs"]
+
+    # Maps template signatures (JSON strings) to lists of (component index,
+    # template, node IDs, pattern IDs)
+    sig2comps = {}
+    for c, comp in enumerate(graph_data["components"]):
+        if can_instance(comp):
+            template, node_ids, patt_ids = get_template(comp, na, ea, pa)
+            sig = json.dumps(template)
+            sig2comps.setdefault(sig, []).append(
+                (c, template, node_ids, patt_ids)
+            )
+
+    components = list(graph_data["components"])
+    templates = []
+    for matches in sig2comps.values():
+        if len(matches) < config.INSTANCE_MIN_COUNT:
+            continue
+        t = len(templates)
+        templates.append(matches[0][1])
+        for c, template, node_ids, patt_ids in matches:
+            nodes = graph_data["components"][c]["nodes"]
+            components[c] = {
+                "instance_of": t,
+                "node_ids": node_ids,
+                "names": [nodes[n][na["name"]] for n in node_ids],
+                "lengths": [nodes[n][na["length"]] for n in node_ids],
+                "patt_ids": patt_ids,
+                "skipped": False,
+            }
+
+    out = dict(graph_data)
+    out["components"] = components
+    out["templates"] = templates
+    return out
@@ -0,0 +1,288 @@
+# Copyright (C) 2016-- Marcus Fedarko, Jay Ghurye, Todd Treangen, Mihai Pop
+# Authored by Marcus Fedarko
+#
+# This file is part of MetagenomeScope.
+#
+# MetagenomeScope is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# MetagenomeScope is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with MetagenomeScope.  If not, see <http://www.gnu.org/licenses/>.
+####
+# Predicting how long it'll take to lay out each component, and using these
+# predictions to decide (1) what order to lay components out in and (2) which
+# components to lay out fully / "degrade" / skip in order to finish within a
+# --time-budget.
+#
+# The model is a (non-negative) linear model over a few features of each
+# component -- see config.LAYOUT_COST_DEFAULT_COEFFS for the details. The
+# default coefficients are just ballpark numbers, since how long dot takes
+# depends a lot on the machine you're running it on. So we record how long
+# each component actually took to lay out; if you pass a --layout-timings
+# file, these timings are saved there (and loaded the next time you run
+# MetagenomeScope with the same file), and once we have enough timings we fit
+# the coefficients to them with least squares.
+
+import os
+import json
+import heapq
+import numpy
+
+from . import config
+
+# Layout "modes" for a component under a --time-budget.
+FULL = "full"
+DEGRADED = "degraded"
+SKIP = "skip"
+
+
+def get_features(num_nodes, num_edges, num_patterns, depth):
+    """Returns the feature vector used for a component in the cost model."""
+    return [
+        1,
+        (num_nodes + num_edges) ** config.LAYOUT_COST_EXPONENT,
+        num_patterns,
+        depth,
+    ]
+
+
+class LayoutCostModel(object):
+    """Predicts how many seconds it'll take to lay out a component."""
+
+    def __init__(self, timings_file=None):
+        """Initializes the model.
+
+        If timings_file is given and exists, we'll load previously recorded
+        timings from it (and fit the model's coefficients to them, if there
+        are enough timings). Either way, save() will write out all timings
+        (old and new) to this file.
+        """
+        self.timings_file = timings_file
+        self.coeffs = list(config.LAYOUT_COST_DEFAULT_COEFFS)
+        self.degraded_factor = config.DEGRADED_LAYOUT_COST_FACTOR
+        # Each observation is [# nodes, # edges, # patterns, depth, seconds,
+        # degraded?]. We store the raw counts (rather than the features) so
+        # that changing config.LAYOUT_COST_EXPONENT doesn't invalidate old
+        # timings files.
+        self.observations = []
+        if self.timings_file is not None and os.path.exists(self.timings_file):
+            with open(self.timings_file, "r") as tf:
+                try:
+                    self.observations = json.load(tf)["observations"]
+                except (ValueError, KeyError, TypeError):
+                    raise ValueError(
+                        "Layout timings file {} seems malformed.".format(
+                            self.timings_file
+                        )
+                    )
+            self.fit()
+
+    def predict(
+        self, num_nodes, num_edges, num_patterns, depth, degraded=False
+    ):
+        """Returns the predicted layout time for a component, in seconds."""
+        features = get_features(num_nodes, num_edges, num_patterns, depth)
+        seconds = sum(c * f for c, f in zip(self.coeffs, features))
+        if degraded:
+            seconds *= self.degraded_factor
+        return seconds
+
+    def record(
+        self, num_nodes, num_edges, num_patterns, depth, seconds, degraded
+    ):
+        """Records how long it actually took to lay out a component.
+
+        This doesn't update the model until fit() is called.
+        """
+        self.observations.append(
+            [num_nodes, num_edges, num_patterns, depth, seconds, degraded]
+        )
+
+    def fit(self):
+        """Fits the model's coefficients to the recorded timings.
+
+        Full layouts are used to fit the coefficients, using least squares
+        while constraining the coefficients to be non-negative (a negative
+        coefficient would mean that, e.g., adding more nodes to a component
+        makes it faster to lay out, which -- while it might happen to fit the
+        data -- would give nonsense predictions for components unlike the
+        ones we've seen). Degraded layouts are then used to fit
+        self.degraded_factor, the ratio of degraded to full layout time.
+
+        If there aren't at least config.LAYOUT_COST_MIN_OBSERVATIONS timings
+        of full layouts, we leave the coefficients alone.
+        """
+        full = [o for o in self.observations if not o[5]]
+        if len(full) >= config.LAYOUT_COST_MIN_OBSERVATIONS:
+            X = numpy.array([get_features(*o[:4]) for o in full], dtype=float)
+            y = numpy.array([o[4] for o in full], dtype=float)
+            self.coeffs = fit_nonnegative_least_squares(X, y).tolist()
+
+        degraded = [o for o in self.observations if o[5]]
+        if len(degraded) > 0:
+            ratios = []
+            for o in degraded:
+                full_pred = self.predict(*o[:4])
+                if full_pred > 0:
+                    ratios.append(o[4] / full_pred)
+            if len(ratios) > 0:
+                # Use the median to avoid getting thrown off by weird outliers
+                # (e.g. a component that happened to get laid out while the
+                # machine was swapping)
+                self.degraded_factor = min(float(numpy.median(ratios)), 1)
+
+    def save(self):
+        """Writes out all recorded timings to self.timings_file.
+
+        Only the most recent config.LAYOUT_COST_MAX_OBSERVATIONS timings
+        are kept. Does nothing if self.timings_file is None.
+        """
+        if self.timings_file is None:
+            return
+        obs = self.observations[-config.LAYOUT_COST_MAX_OBSERVATIONS :]
+        with open(self.timings_file, "w") as tf:
+            json.dump({"observations": obs}, tf)
+
+    def get_max_component_size(self, budget):
+        """Returns the largest (# nodes + # edges) we could lay out in time.
+
+        This is the size of the largest component (without any patterns)
+        that we predict we could lay out, degraded, in budget seconds. Since
+        the cost model is increasing in component size, any component larger
+        than this is a lost cause -- so we can use this to set -maxn / -maxe
+        automatically, and avoid wasting time on pattern decomposition for
+        these components.
+        """
+        c0, c1 = self.coeffs[0], self.coeffs[1]
+        if c1 <= 0:
+            # The model thinks size doesn't matter, so there's nothing to
+            # filter on. (This should only happen with weird timings.)
+            return None
+        available = budget / self.degraded_factor - c0
+        if available <= 0:
+            return 0
+        return int((available / c1) ** (1 / config.LAYOUT_COST_EXPONENT))
+
+
+def fit_nonnegative_least_squares(X, y):
+    """Solves min ||Xb - y|| subject to b >= 0.
+
+    This is a simple active-set approach: do ordinary least squares, drop
+    any features that got a negative coefficient (fixing their coefficients
+    to 0), and repeat. This isn't guaranteed to find the true optimum in
+    every case (Lawson-Hanson NNLS would), but we only have a handful of
+    features, and it's good enough for ballpark predictions without needing
+    to depend on scipy.
+    """
+    num_features = X.shape[1]
+    active = list(range(num_features))
+    b = numpy.zeros(num_features)
+    while len(active) > 0:
+        sol = numpy.linalg.lstsq(X[:, active], y, rcond=None)[0]
+        b = numpy.zeros(num_features)
+        b[active] = sol
+        negative = [f for f, c in zip(active, sol) if c < 0]
+        if len(negative) == 0:
+            break
+        active = [f for f in active if f not in negative]
+    return numpy.clip(b, 0, None)
+
+
+def get_schedule_order(costs):
+    """Returns indices of costs, sorted from most to least expensive.
+
+    Dispatching jobs longest-predicted-first (the "LPT" rule) is a simple
+    way to avoid the situation where a few huge components get started
+    last and leave all the other workers sitting idle. Ties are broken by
+    index, so this is deterministic.
+    """
+    return sorted(range(len(costs)), key=lambda i: (-costs[i], i))
+
+
+def estimate_makespan(costs, num_workers):
+    """Predicts total wall-clock time for running these jobs in parallel.
+
+    Simulates dispatching the jobs longest-first (see get_schedule_order())
+    to num_workers workers, where each job goes to whichever worker frees
+    up first.
+    """
+    if len(costs) == 0:
+        return 0
+    loads = [0] * max(num_workers, 1)
+    for i in get_schedule_order(costs):
+        heapq.heappush(loads, heapq.heappop(loads) + costs[i])
+    return max(loads)
+
+
+def plan_layouts(full_costs, degraded_costs, budget, num_workers=1):
+    """Decides how to lay out each component in order to meet a budget.
+
+    full_costs and degraded_costs should be lists of the predicted times for
+    a full and degraded layout of each component, respectively; budget is
+    the number of seconds we have available.
+
+    Returns a list of modes (FULL, DEGRADED, or SKIP), one per component.
+
+    We start by laying out everything fully. If that's predicted to go over
+    budget, we degrade the k most expensive components, using the smallest k
+    that gets us under budget; if everything's degraded and we're still over
+    budget, we skip the j most expensive components (again using the
+    smallest j that works). Going after the most expensive components first
+    means that we keep as many components as possible looking nice.
+
+    (We find k and j using binary search, rather than trying every value,
+    since graphs can have a whole lot of components. The predicted makespan
+    isn't strictly guaranteed to decrease as k and j increase -- the
+    longest-first schedule is a heuristic -- but it's close enough.)
+    """
+    num_ccs = len(full_costs)
+    by_full = get_schedule_order(full_costs)
+    by_degraded = get_schedule_order(degraded_costs)
+
+    def get_modes(num_degraded, num_skipped):
+        modes = [FULL] * num_ccs
+        for i in by_full[:num_degraded]:
+            modes[i] = DEGRADED
+        for i in by_degraded[:num_skipped]:
+            modes[i] = SKIP
+        return modes
+
+    def fits(modes):
+        costs = []
+        for i, m in enumerate(modes):
+            if m == FULL:
+                costs.append(full_costs[i])
+            elif m == DEGRADED:
+                costs.append(degraded_costs[i])
+        return estimate_makespan(costs, num_workers) <= budget
+
+    def smallest_that_fits(make_modes):
+        # Returns the smallest x in [0, num_ccs] such that make_modes(x)
+        # fits within the budget, or None if even x = num_ccs doesn't fit.
+        if not fits(make_modes(num_ccs)):
+            return None
+        lo, hi = 0, num_ccs
+        while lo < hi:
+            mid = (lo + hi) // 2
+            if fits(make_modes(mid)):
+                hi = mid
+            else:
+                lo = mid + 1
+        return lo
+
+    k = smallest_that_fits(lambda x: get_modes(x, 0))
+    if k is not None:
+        return get_modes(k, 0)
+    j = smallest_that_fits(lambda x: get_modes(num_ccs, x))
+    if j is None:
+        # This can only happen if the budget is negative, i.e. we've already
+        # run out of time before even starting layout. Skip everything.
+        j = num_ccs
+    return get_modes(num_ccs, j)
@@ -1,7 +1,9 @@
+import time
+import pygraphviz
 from . import config
 
 
-def get_gv_header(graphname="thing"):
+def get_gv_header(graphname="thing", degraded=False):
     """Returns the header of a DOT language file.
 
     This will look something like
@@ -13,10 +15,15 @@ def get_gv_header(graphname="thing"):
 
     ... It's expected that the caller will, you know, add some actual
     node/edge/subgraph data and close out the graph declaration with a }.
+
+    If degraded is True, this'll also include config.DEGRADED_GRAPH_STYLE,
+    which makes dot cut some corners in order to finish faster.
     """
     gv_input = "digraph " + graphname + "{\n"
     if config.GRAPH_STYLE != "":
         gv_input += "\t{};\n".format(config.GRAPH_STYLE)
+    if degraded:
+        gv_input += "\t{};\n".format(config.DEGRADED_GRAPH_STYLE)
     if config.GLOBALNODE_STYLE != "":
         gv_input += "\tnode [{}];\n".format(config.GLOBALNODE_STYLE)
     if config.GLOBALEDGE_STYLE != "":
@@ -24,6 +31,51 @@ def get_gv_header(graphname="thing"):
     return gv_input
 
 
+def estimate_layout_cost(num_nodes, num_edges):
+    """Returns a rough estimate of how long it'll take to lay out a component.
+
+    This is in arbitrary units -- it's only meaningful relative to the
+    costs of other components. dot's runtime is dominated by rank assignment
+    (network simplex) and crossing minimization, both of which grow
+    superlinearly with the size of the graph, so we use (|V| + |E|) raised to
+    config.LAYOUT_COST_EXPONENT.
+
+    This doesn't account for pattern decomposition (which collapses parts of
+    a component before it gets laid out, making the actual cost lower), so
+    it's more of an upper bound than anything.
+    """
+    return (num_nodes + num_edges) ** config.LAYOUT_COST_EXPONENT
+
+
+def run_dot(gv_input, node_ids, edges):
+    """Lays out a DOT graph, and returns just the position info we need.
+
+    Returns a 4-tuple of (bounding box string, dict mapping each node ID in
+    node_ids to its "pos" string, dict mapping each edge (a 2-tuple of node
+    IDs) in edges to its "pos" string, and the number of seconds it took to
+    do all this).
+
+    This is a top-level function (that takes in and returns only plain
+    Python objects) so that it can be run in a worker process -- pygraphviz
+    objects can't be pickled, so we can't just send the AGraph back.
+    """
+    start_time = time.time()
+    cg = pygraphviz.AGraph(gv_input)
+    cg.layout(prog="dot")
+    node_pos = {}
+    for node_id in node_ids:
+        node_pos[node_id] = cg.get_node(node_id).attr["pos"]
+    edge_pos = {}
+    for edge in edges:
+        edge_pos[edge] = cg.get_edge(*edge).attr["pos"]
+    return (
+        cg.graph_attr["bb"],
+        node_pos,
+        edge_pos,
+        time.time() - start_time,
+    )
+
+
 def get_control_points(pos):
     """Removes "startp" and "endp" data, if present, from a string definining
     the "pos" attribute (i.e. the spline control points) of an edge object
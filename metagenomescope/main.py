@@ -18,20 +18,54 @@
 # along with MetagenomeScope.  If not, see <http://www.gnu.org/licenses/>.
 
 import os
+import json
+import hashlib
 from distutils.dir_util import copy_tree
 import jinja2
-from . import graph_objects, arg_utils
+from . import (
+    graph_objects,
+    arg_utils,
+    config,
+    layout_cost,
+    columnar_export,
+    graph_db,
+    render,
+    tiles,
+    attr_tables,
+    instancing,
+    component_summary,
+    annotations,
+)
 from .msg_utils import operation_msg, conclude_msg
 
 
 def make_viz(
     input_file: str,
     output_dir: str,
-    # assume_oriented: bool,
     max_node_count: int,
     max_edge_count: int,
-    # metacarvel_bubble_file: str,
-    # user_pattern_file: str,
+    out_of_core: bool = False,
+    input_format: str = None,
+    validation: str = config.VALIDATION_DEFAULT,
+    time_budget: float = None,
+    layout_workers: int = config.LAYOUT_WORKERS_DEFAULT,
+    layout_timings: str = None,
+    assume_oriented: bool = False,
+    clip_tips_length: int = None,
+    min_coverage: float = None,
+    transitive_reduction: bool = False,
+    decomposition_workers: int = config.DECOMPOSITION_WORKERS_DEFAULT,
+    decomposition_time_limit: float = None,
+    decomposition_max_calls: int = None,
+    max_pattern_depth: int = None,
+    metacarvel_bubble_file: str = None,
+    user_pattern_file: str = None,
+    export_tables: str = None,
+    save_database: bool = False,
+    render_images: tuple = (),
+    render_components: int = config.RENDER_COMPONENTS_DEFAULT,
+    make_tiles: bool = False,
+    annotation_files: tuple = (),
     # spqr: bool,
     # sp: bool,
     # pg: bool,
@@ -39,21 +73,107 @@ def make_viz(
     # nbdf: bool,
     # npdf: bool,
 ):
-    """Creates a visualization."""
+    """Creates a visualization.
+
+    If max_node_count or max_edge_count is None, we'll pick a value for it:
+    if time_budget is given, this is the size of the largest component that
+    the layout cost model thinks we could lay out within the budget (see
+    layout_cost.LayoutCostModel.get_max_component_size()); otherwise, this
+    is just config.MAXN_DEFAULT / config.MAXE_DEFAULT.
+    """
     arg_utils.check_dir_existence(output_dir)
+    if export_tables is not None:
+        if export_tables not in config.TABLE_FORMATS:
+            raise ValueError(
+                "Unrecognized table format: {}".format(export_tables)
+            )
+        # Fail now, rather than after doing all of the layout
+        columnar_export.import_pyarrow()
+    for image_format in render_images:
+        if image_format not in config.RENDER_FORMATS:
+            raise ValueError(
+                "Unrecognized image format: {}".format(image_format)
+            )
+        if image_format == config.RENDER_FORMAT_PNG:
+            render.import_cairosvg()
+    if render_components is not None and render_components < 1:
+        raise ValueError("Number of components to render must be at least 1")
+    for annotation_file in annotation_files:
+        if not os.path.isfile(annotation_file):
+            raise ValueError(
+                "Annotation file {} doesn't exist.".format(annotation_file)
+            )
+    if time_budget is not None:
+        arg_utils.validate_time_budget(time_budget)
+        if out_of_core:
+            raise ValueError(
+                "--time-budget can't be used with --out-of-core yet."
+            )
+    arg_utils.validate_layout_workers(layout_workers)
+    arg_utils.validate_decomposition_workers(decomposition_workers)
+    arg_utils.validate_decomposition_limits(
+        decomposition_time_limit, decomposition_max_calls, max_pattern_depth
+    )
+    simplify = (
+        clip_tips_length is not None
+        or min_coverage is not None
+        or transitive_reduction
+    )
+    if simplify and out_of_core:
+        raise ValueError(
+            "Graph simplification (--clip-tips, --min-coverage, "
+            "--transitive-reduction) can't be used with --out-of-core yet."
+        )
+
+    if out_of_core and (
+        metacarvel_bubble_file is not None or user_pattern_file is not None
+    ):
+        raise ValueError(
+            "User-specified bubbles / patterns (--metacarvel-bubble-file, "
+            "--user-pattern-file) can't be used with --out-of-core yet."
+        )
+
+    cost_model = layout_cost.LayoutCostModel(layout_timings)
+    max_node_count, max_edge_count = arg_utils.get_max_counts(
+        max_node_count, max_edge_count, time_budget, cost_model
+    )
     arg_utils.validate_max_counts(max_node_count, max_edge_count)
 
-    asm_graph = graph_objects.AssemblyGraph(
+    if out_of_core:
+        graph_class = graph_objects.PagedAssemblyGraph
+        in_memory_kwargs = {}
+    else:
+        graph_class = graph_objects.AssemblyGraph
+        in_memory_kwargs = {
+            "time_budget": time_budget,
+            "clip_tips_length": clip_tips_length,
+            "min_coverage": min_coverage,
+            "transitive_reduction": transitive_reduction,
+            "bubble_file": metacarvel_bubble_file,
+            "user_pattern_file": user_pattern_file,
+        }
+    asm_graph = graph_class(
         input_file,
         max_node_count=max_node_count,
         max_edge_count=max_edge_count,
+        input_format=input_format,
+        validation=validation,
+        layout_workers=layout_workers,
+        decomposition_workers=decomposition_workers,
+        decomposition_time_limit=decomposition_time_limit,
+        decomposition_max_calls=decomposition_max_calls,
+        max_pattern_depth=max_pattern_depth,
+        cost_model=cost_model,
+        assume_oriented=assume_oriented,
+        **in_memory_kwargs
     )
 
     # Identify patterns, do layout, etc.
     asm_graph.process()
 
-    # Get JSON representation of the graph data.
-    graph_data = asm_graph.to_json()
+    # Save the layout timings we just recorded (if --layout-timings was given)
+    # so that future runs can use them to make better predictions.
+    cost_model.save()
 
     operation_msg(
         "Writing graph data to the output directory, {}...".format(output_dir)
@@ -71,14 +191,80 @@ def make_viz(
     curr_loc = os.path.dirname(os.path.realpath(__file__))
     support_files_loc = os.path.join(curr_loc, "support_files")
     copy_tree(support_files_loc, output_dir)
+    conclude_msg()
 
-    # Using Jinja2, populate the {{ dataJSON }} tag in the main.js file with
-    # the JSON representation of the graph data.
+    # Get a dict representation of the graph data. (We keep the dict around,
+    # in case we also need to write it out as a database / etc.) If we're
+    # exporting tables, we write out each component's rows as soon as
+    # to_dict() produces it.
+    if export_tables is not None:
+        operation_msg(
+            "Writing {} tables to {}...".format(
+                export_tables,
+                os.path.join(output_dir, config.TABLES_DIR_NAME),
+            )
+        )
+        exporter = columnar_export.TableExporter(output_dir, export_tables)
+        try:
+            graph_dict = asm_graph.to_dict(on_component=exporter.add_component)
+        finally:
+            exporter.close()
+        conclude_msg()
+    else:
+        graph_dict = asm_graph.to_dict()
+
+    # Tiles need to be made before we convert the graph data to JSON, since
+    # the viewer needs to know which components have tiles
+    if make_tiles:
+        operation_msg(
+            "Drawing tiles for big components to {}...".format(
+                os.path.join(output_dir, config.TILES_DIR_NAME)
+            )
+        )
+        tiles.make_tiles(graph_dict, output_dir, workers=layout_workers)
+        conclude_msg()
+
+    # Join node annotations (if any were given) and save them as side tables
+    annotation_info = None
+    if len(annotation_files) > 0:
+        operation_msg("Joining node annotations...")
+        annotation_info, file_stats = annotations.write_annotation_tables(
+            graph_dict, annotation_files, output_dir
+        )
+        conclude_msg()
+        for annotation_file, (num_rows, num_matched) in zip(
+            annotation_files, file_stats
+        ):
+            print(
+                "{}: {:,} / {:,} row(s) matched node names.".format(
+                    annotation_file, num_matched, num_rows
+                )
+            )
+
+    operation_msg("Writing out the visualization...")
+    # Move extra node / edge attributes out of the data the viewer loads up
+    # front. (graph_dict itself keeps them, for the exports below.)
+    viewer_dict = attr_tables.write_attr_tables(graph_dict, output_dir)
+    # Store the layouts of identical small components only once
+    viewer_dict = instancing.instance_components(viewer_dict)
+    # Summarize each component, for the viewer's component browser
+    viewer_dict["component_summary"] = component_summary.get_component_summary(
+        graph_dict
+    )
+    viewer_dict["annotations"] = annotation_info
+    graph_data = json.dumps(viewer_dict)
+
+    # Save the JSON representation of the graph data to data.js (as a
+    # RequireJS module, since browsers won't let us load plain JSON files
+    # from file:// URLs). Using Jinja2, populate the {{ dataHash }} tag in
+    # the main.js file with a hash of this data: the viewer caches the
+    # decoded data in the browser (see data-cache.js), so when the same
+    # visualization is opened again it can skip loading data.js.
     #
     # Also, populate the {{ graphFilename }} tag in the index.html file, so we
     # can show the filename in the application title (this way the title is
     # shown immediately, rather than flickering when the page is loaded).
-    # (... This is obviously much less important than the first thing, but it's
+    # (... This is obviously much less important than the data, but it's
     # a nice little detail that should help users if they have many MgSc tabs
     # open at once.)
     #
@@ -88,14 +274,40 @@ def make_viz(
     # https://github.com/biocore/empress/blob/master/tests/python/make-dev-page.py.
     env = jinja2.Environment(loader=jinja2.FileSystemLoader(output_dir))
 
+    with open(os.path.join(output_dir, "data.js"), "w") as datajs_file:
+        datajs_file.write("define(")
+        datajs_file.write(graph_data)
+        datajs_file.write(");\n")
+    data_hash = hashlib.sha256(graph_data.encode("utf-8")).hexdigest()
+
     mainjs_template = env.get_template("main.js")
     with open(os.path.join(output_dir, "main.js"), "w") as mainjs_file:
-        mainjs_file.write(mainjs_template.render({"dataJSON": graph_data}))
+        mainjs_file.write(mainjs_template.render({"dataHash": data_hash}))
 
     index_template = env.get_template("index.html")
     with open(os.path.join(output_dir, "index.html"), "w") as index_file:
         index_file.write(
             index_template.render({"graphFilename": asm_graph.basename})
         )
-
     conclude_msg()
+
+    if save_database:
+        db_path = os.path.join(output_dir, config.DB_FILE_NAME)
+        operation_msg(config.DB_SAVE_MSG + db_path + "...")
+        graph_db.write_database(graph_dict, db_path)
+        conclude_msg()
+
+    if len(render_images) > 0:
+        operation_msg(
+            "Rendering components to {}...".format(
+                os.path.join(output_dir, config.IMAGES_DIR_NAME)
+            )
+        )
+        render.render_components(
+            graph_dict,
+            output_dir,
+            render_images,
+            num_components=render_components,
+            workers=layout_workers,
+        )
+        conclude_msg()
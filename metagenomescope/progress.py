@@ -0,0 +1,406 @@
+# Copyright (C) 2016-- Marcus Fedarko, Jay Ghurye, Todd Treangen, Mihai Pop
+# Authored by Marcus Fedarko
+#
+# This file is part of MetagenomeScope.
+#
+# MetagenomeScope is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# MetagenomeScope is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with MetagenomeScope.  If not, see <http://www.gnu.org/licenses/>.
+####
+# Progress reporting while laying out the graph.
+#
+# Laying out a big graph can take hours, so LayoutProgress keeps track of how
+# many components / patterns / elements (nodes + edges) have been laid out so
+# far, and estimates how much longer the rest will take. It shows this in
+# one of two ways:
+#
+# - If stdout is a terminal, as a "live" progress bar that's redrawn in
+#   place (at most every config.PROGRESS_BAR_INTERVAL seconds).
+#
+# - Otherwise (e.g. when stdout is redirected to a log file by a batch job),
+#   as structured "key=value" log lines. These are printed at most every
+#   config.PROGRESS_LOG_INTERVAL seconds, and only if something has finished
+#   since the last line -- but we print a line at least every
+#   config.PROGRESS_LOG_HEARTBEAT seconds, so that it's clear we're still
+#   alive while a huge component is being laid out.
+#
+# Components can be finished from another thread (e.g. the result-handler
+# thread of a multiprocessing.Pool, via an apply_async() callback), so all of
+# the bookkeeping is done while holding a lock. A background thread redraws
+# the bar / prints log lines even when nothing is finishing.
+#
+# ETAs are based on observed throughput: we group components by size (the
+# base-2 log of their number of elements), and for each group track how many
+# seconds per element its finished components took. Remaining components are
+# assumed to take that long per element as well. For components in groups we
+# haven't seen yet, we fall back to the layout cost model's prediction for
+# this component (scaled by how far off the model's predictions have been
+# for the components we've finished so far).
+
+import sys
+import math
+import time
+import shutil
+import threading
+from . import config
+
+BAR = "bar"
+LOG = "log"
+
+
+def format_duration(seconds):
+    """Formats a number of seconds as H:MM:SS, or "?" if it's None."""
+    if seconds is None:
+        return "?"
+    seconds = int(round(seconds))
+    return "{}:{:02d}:{:02d}".format(
+        seconds // 3600, (seconds // 60) % 60, seconds % 60
+    )
+
+
+def get_size_group(num_elements):
+    """Returns the size group (for ETA purposes) of a component."""
+    return int(math.log2(max(num_elements, 1)))
+
+
+class LayoutProgress(object):
+    """Tracks and reports progress while laying out components."""
+
+    def __init__(
+        self,
+        components,
+        workers=1,
+        stream=None,
+        mode=None,
+        interval=None,
+        clock=time.monotonic,
+    ):
+        """Initializes the progress tracker.
+
+        components should be a list with one 4-tuple of (# nodes, # edges,
+        # patterns, predicted seconds to lay out) for each component that
+        we'll lay out; components are referred to by their index in this
+        list. workers is the number of components that can be laid out at
+        once.
+
+        stream defaults to sys.stdout. mode should be BAR or LOG; if it isn't
+        given, we use BAR if stream is a terminal and LOG otherwise. interval
+        is the number of seconds between redraws / log lines; it defaults to
+        config.PROGRESS_BAR_INTERVAL or config.PROGRESS_LOG_INTERVAL.
+        """
+        self.components = list(components)
+        self.workers = max(workers, 1)
+        self.stream = sys.stdout if stream is None else stream
+        if mode is None:
+            isatty = getattr(self.stream, "isatty", None)
+            mode = BAR if isatty is not None and isatty() else LOG
+        if mode not in (BAR, LOG):
+            raise ValueError("Unrecognized progress mode: {}".format(mode))
+        self.mode = mode
+        if interval is None:
+            if mode == BAR:
+                interval = config.PROGRESS_BAR_INTERVAL
+            else:
+                interval = config.PROGRESS_LOG_INTERVAL
+        self.interval = interval
+        self.clock = clock
+
+        self.total_patterns = 0
+        self.total_elements = 0
+        # Maps size groups to [# elements, predicted seconds, # components]
+        # of the components in this group that haven't been finished yet.
+        # (Keeping these sums around means that estimating the ETA doesn't
+        # involve looking at every component.)
+        self.group_left = {}
+        for component in self.components:
+            self.add_left(component, 1)
+        self.finished = set()
+        self.num_patterns_done = 0
+        self.num_elements_done = 0
+        # Maps size groups to [# elements, seconds] of finished components
+        self.group_stats = {}
+        # Total actual / predicted seconds of finished components
+        self.seconds_done = 0
+        self.predicted_done = 0
+        # Short description of what's going on right now, shown in the bar
+        self.current = None
+
+        self.lock = threading.RLock()
+        self.start_time = None
+        self.last_report_time = None
+        self.last_report_done = None
+        self.bar_drawn = False
+        self.suspended = False
+        self.stop_event = threading.Event()
+        self.thread = None
+
+    def add_left(self, component, sign):
+        """Adds (sign = 1) or removes (sign = -1) an unfinished component
+        from the totals.
+        """
+        num_nodes, num_edges, num_patterns, predicted = component
+        self.total_patterns += sign * num_patterns
+        self.total_elements += sign * (num_nodes + num_edges)
+        left = self.group_left.setdefault(
+            get_size_group(num_nodes + num_edges), [0, 0, 0]
+        )
+        left[0] += sign * (num_nodes + num_edges)
+        left[1] += sign * predicted
+        left[2] += sign
+
+    def set_component(self, index, component):
+        """Replaces the 4-tuple describing a component we haven't finished.
+
+        This is useful if we only have rough estimates for some components
+        at first: e.g. in out-of-core mode, we don't know how many patterns
+        a component has (or how long it'll take to lay out) until its page
+        has been decomposed.
+        """
+        with self.lock:
+            if index in self.finished:
+                return
+            self.add_left(self.components[index], -1)
+            self.components[index] = component
+            self.add_left(component, 1)
+
+    def suspend(self):
+        """Stops reporting progress until resume() is called.
+
+        This is for when other stuff is going to be printed for a while (and
+        we don't want the progress bar to get in the way).
+        """
+        with self.lock:
+            self.suspended = True
+            self.clear_bar()
+            self.stream.flush()
+
+    def resume(self):
+        """Starts reporting progress again, after suspend().
+
+        (In log mode, we don't print a line right away -- otherwise we'd
+        print a line every time we switch between pages in out-of-core mode.)
+        """
+        with self.lock:
+            self.suspended = False
+            if self.mode == BAR:
+                self.report()
+
+    def start(self):
+        """Starts the clock, and starts reporting progress."""
+        with self.lock:
+            self.start_time = self.clock()
+            self.report()
+        if self.interval > 0:
+            self.thread = threading.Thread(target=self.run, daemon=True)
+            self.thread.start()
+
+    def run(self):
+        """Reports progress periodically, until finish() is called."""
+        while not self.stop_event.wait(self.interval):
+            self.maybe_report(periodic=True)
+
+    def set_current(self, description):
+        """Sets the description of what we're working on right now."""
+        with self.lock:
+            self.current = description
+            self.maybe_report()
+
+    def message(self, text):
+        """Prints a line of text, without messing up the progress bar."""
+        with self.lock:
+            self.clear_bar()
+            self.stream.write(text + "\n")
+            if (
+                self.mode == BAR
+                and self.start_time is not None
+                and not self.suspended
+            ):
+                self.draw_bar()
+            self.stream.flush()
+
+    def done(self, index, seconds):
+        """Records that a component was laid out, taking some seconds.
+
+        (In parallel layout, seconds should be the amount of time spent on
+        this component, not the amount of time it took to come back from a
+        worker.) Finishing the same component twice doesn't do anything.
+        """
+        with self.lock:
+            if index in self.finished:
+                return
+            self.finished.add(index)
+            num_nodes, num_edges, num_patterns, predicted = self.components[
+                index
+            ]
+            num_elements = num_nodes + num_edges
+            group = get_size_group(num_elements)
+            self.num_patterns_done += num_patterns
+            self.num_elements_done += num_elements
+            stats = self.group_stats.setdefault(group, [0, 0])
+            stats[0] += num_elements
+            stats[1] += seconds
+            left = self.group_left[group]
+            left[0] -= num_elements
+            left[1] -= predicted
+            left[2] -= 1
+            self.seconds_done += seconds
+            self.predicted_done += predicted
+            self.maybe_report()
+
+    def finish(self):
+        """Stops reporting progress, after reporting it one last time."""
+        self.stop_event.set()
+        if self.thread is not None:
+            self.thread.join()
+        with self.lock:
+            self.current = None
+            self.report()
+            if self.mode == BAR:
+                self.stream.write("\n")
+                self.stream.flush()
+                self.bar_drawn = False
+
+    def get_eta(self):
+        """Returns the estimated number of seconds left, or None if we can't
+        make an estimate yet.
+        """
+        with self.lock:
+            if self.predicted_done > 0:
+                calibration = self.seconds_done / self.predicted_done
+            else:
+                calibration = None
+            work_left = 0
+            num_left = 0
+            for group, left in self.group_left.items():
+                if left[2] == 0:
+                    continue
+                num_left += left[2]
+                stats = self.group_stats.get(group)
+                if stats is not None:
+                    work_left += left[0] * (stats[1] / stats[0])
+                elif calibration is not None:
+                    work_left += left[1] * calibration
+                else:
+                    return None
+            return work_left / max(min(self.workers, num_left), 1)
+
+    def get_stats(self):
+        """Returns a dict describing the progress so far."""
+        with self.lock:
+            elapsed = self.clock() - self.start_time
+            return {
+                "components": len(self.finished),
+                "total_components": len(self.components),
+                "patterns": self.num_patterns_done,
+                "total_patterns": self.total_patterns,
+                "elements": self.num_elements_done,
+                "total_elements": self.total_elements,
+                "elapsed": elapsed,
+                "rate": (
+                    self.num_elements_done / elapsed if elapsed > 0 else None
+                ),
+                "eta": self.get_eta(),
+            }
+
+    def maybe_report(self, periodic=False):
+        """Reports progress, if it's been long enough since the last time.
+
+        In LOG mode, we only print a line if something has finished since
+        the last line (or if it's been config.PROGRESS_LOG_HEARTBEAT seconds
+        since the last line, and this is a periodic check).
+        """
+        with self.lock:
+            # (Don't report anything before start(), after finish(), or while
+            # we're suspended)
+            if (
+                self.start_time is None
+                or self.stop_event.is_set()
+                or self.suspended
+            ):
+                return
+            since_last = self.clock() - self.last_report_time
+            if since_last < self.interval:
+                return
+            if (
+                self.mode == LOG
+                and len(self.finished) == self.last_report_done
+                and not (
+                    periodic and since_last >= config.PROGRESS_LOG_HEARTBEAT
+                )
+            ):
+                return
+            self.report()
+
+    def report(self):
+        """Draws the progress bar / prints a log line right now."""
+        with self.lock:
+            if self.mode == BAR:
+                self.draw_bar()
+            else:
+                self.stream.write(self.get_log_line() + "\n")
+            self.stream.flush()
+            self.last_report_time = self.clock()
+            self.last_report_done = len(self.finished)
+
+    def get_log_line(self):
+        """Returns a structured log line describing the progress so far."""
+        s = self.get_stats()
+        return (
+            "Layout progress: components={}/{} patterns={}/{} "
+            "elements={}/{} rate={} elapsed={} eta={}".format(
+                s["components"],
+                s["total_components"],
+                s["patterns"],
+                s["total_patterns"],
+                s["elements"],
+                s["total_elements"],
+                "?" if s["rate"] is None else "{:.1f}/s".format(s["rate"]),
+                format_duration(s["elapsed"]),
+                format_duration(s["eta"]),
+            )
+        )
+
+    def get_bar_line(self, width):
+        """Returns a progress bar line that's at most width characters."""
+        s = self.get_stats()
+        frac = s["elements"] / max(s["total_elements"], 1)
+        bar_width = config.PROGRESS_BAR_WIDTH
+        filled = int(frac * bar_width)
+        line = (
+            "[{}{}] {:3.0f}% | {:,}/{:,} components | {:,}/{:,} elements "
+            "| {} elements/s | ETA {}".format(
+                "#" * filled,
+                "-" * (bar_width - filled),
+                frac * 100,
+                s["components"],
+                s["total_components"],
+                s["elements"],
+                s["total_elements"],
+                "?" if s["rate"] is None else "{:,.0f}".format(s["rate"]),
+                format_duration(s["eta"]),
+            )
+        )
+        if self.current is not None:
+            line += " | " + self.current
+        return line[:width]
+
+    def draw_bar(self):
+        """Redraws the progress bar in place."""
+        width = shutil.get_terminal_size().columns - 1
+        self.stream.write("\r" + self.get_bar_line(width) + "\x1b[K")
+        self.bar_drawn = True
+
+    def clear_bar(self):
+        """Erases the progress bar, if it's currently drawn."""
+        if self.bar_drawn:
+            self.stream.write("\r\x1b[K")
+            self.bar_drawn = False
@@ -0,0 +1,438 @@
+# Copyright (C) 2016-- Marcus Fedarko, Jay Ghurye, Todd Treangen, Mihai Pop
+# Authored by Marcus Fedarko
+#
+# This file is part of MetagenomeScope.
+#
+# MetagenomeScope is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# MetagenomeScope is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with MetagenomeScope.  If not, see <http://www.gnu.org/licenses/>.
+####
+# Rendering laid-out components as static SVG / PNG images (-ri), without
+# needing a browser.
+#
+# The viewer can export images (Drawer.exportImage()), but that requires
+# opening the visualization and drawing the whole component with
+# Cytoscape.js first -- which isn't great if you want thumbnails of the
+# biggest components for a few thousand samples. Here, we just write out the
+# layout data from to_dict() as SVG elements, using the same shapes and
+# default colors as the viewer: patterns are drawn as boxes, nodes as
+# polygons pointing in the direction of their orientation, and edges as
+# splines through their Graphviz control points.
+#
+# SVGs are written directly. PNGs are converted from the SVGs using
+# cairosvg, which is an optional dependency -- so we only import it if PNGs
+# are requested.
+
+import os
+import multiprocessing
+from xml.sax.saxutils import escape
+from . import config
+
+# Default colors in the viewer (see index.html / drawer.js)
+BG_COLOR = "#ffffff"
+NODE_COLOR = "#888888"
+EDGE_COLOR = "#555555"
+HIGH_OUTLIER_EDGE_COLOR = "#ff0000"
+LOW_OUTLIER_EDGE_COLOR = "#0000ff"
+PATTERN_BORDER_COLOR = "#000000"
+
+# Maps pattern types to keys in config.PATTERN2COLOR. Any other types (e.g.
+# user-specified patterns) are colored as misc. patterns.
+PATTERN_TYPE2PLURAL = {
+    "bubble": "bubbles",
+    "frayedrope": "frayed_ropes",
+    "chain": "chains",
+    "cyclicchain": "cyclic_chains",
+}
+
+# Node shapes, matching the "leftdir" / "rightdir" polygons in drawer.js.
+# Points are in [-1, 1] relative to the node's center and half-dimensions,
+# with y increasing upwards (as in Graphviz).
+ORIENTATION2POLYGON = {
+    "+": [(-1, 1), (0.23587, 1), (1, 0), (0.23587, -1), (-1, -1)],
+    "-": [(1, 1), (-0.23587, 1), (-1, 0), (-0.23587, -1), (1, -1)],
+}
+
+# Edge thickness, matching MIN_EDGE_THICKNESS / MAX_EDGE_THICKNESS in
+# drawer.js
+MIN_EDGE_THICKNESS = 3
+MAX_EDGE_THICKNESS = 10
+
+ARROW_SIZE = 10
+
+
+def import_cairosvg():
+    """Imports cairosvg, raising a ValueError if it isn't installed."""
+    try:
+        import cairosvg
+    except ImportError:
+        raise ValueError(
+            "Rendering PNG images requires cairosvg, which doesn't seem to be "
+            'installed. You can install it using "pip install cairosvg" '
+            "(or just render SVG images instead)."
+        )
+    return cairosvg
+
+
+def fmt(val):
+    """Formats a coordinate for use in an SVG file."""
+    return "{:.2f}".format(val)
+
+
+class SVGCanvas(object):
+    """Converts layout coordinates for a component to SVG coordinates.
+
+    After we rotate the layout from top -> bottom to left -> right, x
+    coordinates within a component's bounding box go from -(width) to 0, and
+    y coordinates go from 0 to height (increasing upwards, as in Graphviz).
+    SVG wants both to be positive, with y increasing downwards.
+    """
+
+    def __init__(self, width, height, margin):
+        self.bb_width = width
+        self.width = width + 2 * margin
+        self.height = height + 2 * margin
+        self.margin = margin
+        self.elements = []
+
+    def x(self, x):
+        return x + self.bb_width + self.margin
+
+    def y(self, y):
+        return self.height - self.margin - y
+
+    def pt(self, x, y):
+        """Returns an "x,y" string of SVG coordinates."""
+        return "{},{}".format(fmt(self.x(x)), fmt(self.y(y)))
+
+    def add(self, element):
+        self.elements.append(element)
+
+    def to_str(self):
+        header = (
+            '<svg xmlns="http://www.w3.org/2000/svg" width="{w}" '
+            'height="{h}" viewBox="0 0 {w} {h}">'
+        ).format(w=fmt(self.width), h=fmt(self.height))
+        markers = get_arrow_markers()
+        background = '<rect width="100%" height="100%" fill="{}"/>'.format(
+            BG_COLOR
+        )
+        return "\n".join(
+            [header] + markers + [background] + self.elements + ["</svg>"]
+        )
+
+
+def get_arrow_markers():
+    """Returns a list of SVG lines defining the arrowheads used for edges."""
+    markers = ["<defs>"]
+    for name, color in (
+        ("arrow", EDGE_COLOR),
+        ("arrow_high", HIGH_OUTLIER_EDGE_COLOR),
+        ("arrow_low", LOW_OUTLIER_EDGE_COLOR),
+    ):
+        markers.append(
+            '<marker id="{}" viewBox="0 0 10 10" refX="10" refY="5" '
+            'markerWidth="{s}" markerHeight="{s}" '
+            'markerUnits="userSpaceOnUse" orient="auto">'
+            '<path d="M0,0 L10,5 L0,10 z" fill="{}"/></marker>'.format(
+                name, color, s=ARROW_SIZE
+            )
+        )
+    markers.append("</defs>")
+    return markers
+
+
+def get_edge_points(ctrl_pts, src_pos, tgt_pos):
+    """Returns the points defining an edge, and whether they're a spline.
+
+    Graphviz gives us splines as a list of control points [x1, y1, ..., xn,
+    yn], where n = 1 (mod 3): the first point, and then three points per
+    cubic Bezier segment. If the control points aren't in this format (or
+    are missing), we just use a straight line between the nodes' centers.
+
+    Returns a 2-tuple of (list of (x, y) points in layout coordinates, True
+    if these points are a spline or False if they're a straight line).
+    """
+    if ctrl_pts is not None and len(ctrl_pts) >= 8:
+        pts = [
+            (ctrl_pts[i], ctrl_pts[i + 1])
+            for i in range(0, len(ctrl_pts) - 1, 2)
+        ]
+        if (len(pts) - 1) % 3 == 0:
+            return pts, True
+    return [src_pos, tgt_pos], False
+
+
+def points_to_path(canvas, pts, is_spline):
+    """Returns the "d" attribute of an SVG path through some layout points.
+
+    If is_spline is True, pts should be a start point followed by the
+    control points of one or more cubic Bezier segments; otherwise, pts
+    should be the two endpoints of a straight line.
+    """
+    svg_pts = [canvas.pt(x, y) for x, y in pts]
+    if is_spline:
+        return "M{} C{}".format(svg_pts[0], " ".join(svg_pts[1:]))
+    return "M{} L{}".format(svg_pts[0], svg_pts[1])
+
+
+def get_edge_path(canvas, ctrl_pts, src_pos, tgt_pos):
+    """Returns the "d" attribute of an SVG path for an edge."""
+    return points_to_path(canvas, *get_edge_points(ctrl_pts, src_pos, tgt_pos))
+
+
+def get_loop_points(pos, width, height):
+    """Returns control points for a self-loop edge, drawn above the node.
+
+    (The viewer doesn't use Graphviz' control points for self-loops either.)
+    """
+    x, y = pos
+    top = y + height / 2
+    return [
+        (x - width / 4, top),
+        (x - width / 2, top + height),
+        (x + width / 2, top + height),
+        (x + width / 4, top),
+    ]
+
+
+def get_bbox(canvas, pts, padding=0):
+    """Returns the (x1, y1, x2, y2) SVG bounding box of some layout points.
+
+    (The convex hull of a Bezier curve's control points contains the curve,
+    so this works for edges too.)
+    """
+    xs = [canvas.x(p[0]) for p in pts]
+    ys = [canvas.y(p[1]) for p in pts]
+    return (
+        min(xs) - padding,
+        min(ys) - padding,
+        max(xs) + padding,
+        max(ys) + padding,
+    )
+
+
+def get_component_elements(comp, node_attrs, edge_attrs, patt_attrs, canvas):
+    """Returns a list of the SVG elements needed to draw a component.
+
+    Each entry in the list is a 2-tuple of (bounding box, SVG string); the
+    bounding box is an (x1, y1, x2, y2) tuple in SVG coordinates. Elements
+    are listed in the order they should be drawn.
+
+    comp should be one of the (non-skipped) component dicts in the output of
+    AssemblyGraph.to_dict(), and the attrs should be the "node_attrs",
+    "edge_attrs", and "patt_attrs" of that output.
+    """
+    na = node_attrs
+    ea = edge_attrs
+    pta = patt_attrs
+    elements = []
+
+    # Draw patterns first, so that nodes and edges are drawn on top of them.
+    # Parent patterns are always listed before their children in "patts", so
+    # children will be drawn on top of their parents.
+    for patt in comp["patts"]:
+        ptype = patt[pta["pattern_type"]]
+        color = config.PATTERN2COLOR[
+            PATTERN_TYPE2PLURAL.get(ptype, "misc_patterns")
+        ]
+        bbox = get_bbox(
+            canvas,
+            [
+                (patt[pta["left"]], patt[pta["top"]]),
+                (patt[pta["right"]], patt[pta["bottom"]]),
+            ],
+        )
+        elements.append(
+            (
+                bbox,
+                '<rect x="{}" y="{}" width="{}" height="{}" fill="{}" '
+                'stroke="{}" stroke-width="2"><title>{}</title></rect>'.format(
+                    fmt(bbox[0]),
+                    fmt(bbox[1]),
+                    fmt(bbox[2] - bbox[0]),
+                    fmt(bbox[3] - bbox[1]),
+                    color,
+                    PATTERN_BORDER_COLOR,
+                    escape("{} {}".format(ptype, patt[pta["pattern_id"]])),
+                ),
+            )
+        )
+
+    node_pos = {}
+    for node_id, data in comp["nodes"].items():
+        node_pos[node_id] = (data[na["x"]], data[na["y"]])
+
+    for src_id, tgts in comp["edges"].items():
+        for tgt_id, data in tgts.items():
+            is_outlier = data[ea["is_outlier"]]
+            if is_outlier == 1:
+                color, marker = HIGH_OUTLIER_EDGE_COLOR, "arrow_high"
+            elif is_outlier == -1:
+                color, marker = LOW_OUTLIER_EDGE_COLOR, "arrow_low"
+            else:
+                color, marker = EDGE_COLOR, "arrow"
+            rel_weight = data[ea["relative_weight"]]
+            if rel_weight is None:
+                rel_weight = 0
+            thickness = MIN_EDGE_THICKNESS + rel_weight * (
+                MAX_EDGE_THICKNESS - MIN_EDGE_THICKNESS
+            )
+            if src_id == tgt_id:
+                src_data = comp["nodes"][src_id]
+                pts = get_loop_points(
+                    node_pos[src_id],
+                    src_data[na["width"]],
+                    src_data[na["height"]],
+                )
+                is_spline = True
+            else:
+                pts, is_spline = get_edge_points(
+                    data[ea["ctrl_pt_coords"]],
+                    node_pos[src_id],
+                    node_pos[tgt_id],
+                )
+            d = points_to_path(canvas, pts, is_spline)
+            elements.append(
+                (
+                    get_bbox(canvas, pts, max(thickness / 2, ARROW_SIZE)),
+                    '<path d="{}" fill="none" stroke="{}" stroke-width="{}" '
+                    'marker-end="url(#{})"/>'.format(
+                        d, color, fmt(thickness), marker
+                    ),
+                )
+            )
+
+    for node_id, data in comp["nodes"].items():
+        x, y = node_pos[node_id]
+        hw = data[na["width"]] / 2
+        hh = data[na["height"]] / 2
+        pts = [
+            (x + px * hw, y + py * hh)
+            for px, py in ORIENTATION2POLYGON[data[na["orientation"]]]
+        ]
+        elements.append(
+            (
+                get_bbox(canvas, pts),
+                '<polygon points="{}" fill="{}"><title>{}</title>'
+                "</polygon>".format(
+                    " ".join(canvas.pt(px, py) for px, py in pts),
+                    NODE_COLOR,
+                    escape(str(data[na["name"]])),
+                ),
+            )
+        )
+    return elements
+
+
+def component_to_svg(comp, node_attrs, edge_attrs, patt_attrs):
+    """Returns a string containing an SVG image of a component.
+
+    See get_component_elements() for details about the parameters.
+    """
+    canvas = SVGCanvas(comp["bb"][0], comp["bb"][1], config.RENDER_MARGIN)
+    for bbox, element in get_component_elements(
+        comp, node_attrs, edge_attrs, patt_attrs, canvas
+    ):
+        canvas.add(element)
+    return canvas.to_str()
+
+
+def get_image_path(images_dir, cc_num, image_format):
+    return os.path.join(
+        images_dir, "component_{}.{}".format(cc_num, image_format)
+    )
+
+
+def render_component(cc_num, comp, attrs, images_dir, formats):
+    """Renders a component to images_dir in each of the given formats.
+
+    This is a top-level function (rather than a method), so that we can run
+    it in a multiprocessing.Pool.
+    """
+    svg = component_to_svg(comp, *attrs)
+    if config.RENDER_FORMAT_SVG in formats:
+        with open(
+            get_image_path(images_dir, cc_num, config.RENDER_FORMAT_SVG), "w"
+        ) as f:
+            f.write(svg)
+    if config.RENDER_FORMAT_PNG in formats:
+        cairosvg = import_cairosvg()
+        width = comp["bb"][0] + 2 * config.RENDER_MARGIN
+        height = comp["bb"][1] + 2 * config.RENDER_MARGIN
+        scale = min(1, config.RENDER_PNG_MAX_DIM / max(width, height))
+        cairosvg.svg2png(
+            bytestring=svg.encode("utf-8"),
+            write_to=get_image_path(
+                images_dir, cc_num, config.RENDER_FORMAT_PNG
+            ),
+            output_width=max(1, round(width * scale)),
+            output_height=max(1, round(height * scale)),
+        )
+    return cc_num
+
+
+def _render_component_star(args):
+    return render_component(*args)
+
+
+def render_components(
+    graph_data,
+    output_dir,
+    formats,
+    num_components=config.RENDER_COMPONENTS_DEFAULT,
+    workers=1,
+):
+    """Renders the largest laid-out components in a graph to images.
+
+    graph_data should be the output of AssemblyGraph.to_dict() (or
+    PagedAssemblyGraph.to_dict()). Images are written to the
+    config.IMAGES_DIR_NAME subdirectory of output_dir, and named
+    component_N.svg / component_N.png (where N is the component number shown
+    in the visualization).
+
+    Components in graph_data are already sorted from largest to smallest,
+    so we just render the first num_components (or all of them, if
+    num_components is None) components that weren't skipped. If workers > 1,
+    components are rendered in parallel.
+
+    Returns a list of the numbers of the components we rendered.
+    """
+    for f in formats:
+        if f not in config.RENDER_FORMATS:
+            raise ValueError("Unrecognized image format: {}".format(f))
+    if config.RENDER_FORMAT_PNG in formats:
+        import_cairosvg()
+    if num_components is not None and num_components < 1:
+        raise ValueError("Number of components to render must be at least 1")
+
+    images_dir = os.path.join(output_dir, config.IMAGES_DIR_NAME)
+    os.makedirs(images_dir, exist_ok=True)
+    attrs = (
+        graph_data["node_attrs"],
+        graph_data["edge_attrs"],
+        graph_data["patt_attrs"],
+    )
+    jobs = []
+    for cc_num, comp in enumerate(graph_data["components"], 1):
+        if comp["skipped"]:
+            continue
+        if num_components is not None and len(jobs) >= num_components:
+            break
+        jobs.append((cc_num, comp, attrs, images_dir, formats))
+
+    if workers > 1 and len(jobs) > 1:
+        with multiprocessing.Pool(min(workers, len(jobs))) as pool:
+            # (Big components come first, so chunksize=1 helps to keep one
+            # worker from getting stuck with all of them)
+            return sorted(pool.imap_unordered(_render_component_star, jobs))
+    return [render_component(*job) for job in jobs]
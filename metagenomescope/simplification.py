@@ -0,0 +1,269 @@
+# Copyright (C) 2016-- Marcus Fedarko, Jay Ghurye, Todd Treangen, Mihai Pop
+# Authored by Marcus Fedarko
+#
+# This file is part of MetagenomeScope.
+#
+# MetagenomeScope is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# MetagenomeScope is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with MetagenomeScope.  If not, see <http://www.gnu.org/licenses/>.
+####
+# Optional simplification of the graph before we do any pattern decomposition
+# or layout. This is all opt-in (see --clip-tips, --min-coverage, and
+# --transitive-reduction): by default, MetagenomeScope shows you the graph
+# exactly as the assembler gave it to you. But messy graphs often have a lot
+# of short dead-end "tips" (usually caused by sequencing errors), low-coverage
+# junk, and redundant edges that make the layout much larger and slower
+# without telling you anything interesting.
+#
+# All of these passes work on the digraph produced by assembly_graph_parser
+# (i.e. keyed by node name), and all of them run in time linear in the size of
+# the graph. We record everything we remove (and why) so that the viewer can
+# tell the user what's missing.
+
+from . import config
+from .assembly_graph_parser import has_rc_nodes
+from .input_node_utils import negate_node_id
+
+# Reasons we'll record for removing nodes / edges.
+TIP = "tip"
+LOW_COVERAGE = "low_coverage"
+TRANSITIVE = "transitive"
+
+
+def get_rc_node_name_func(filetype, assume_oriented=False):
+    """Returns a function mapping a node name to its reverse complement's name.
+
+    Returns None if nodes in this type of graph don't have reverse-complement
+    counterparts (see assembly_graph_parser.has_rc_nodes()).
+    """
+    if not has_rc_nodes(filetype, assume_oriented):
+        return None
+    if filetype == "fastg":
+        # pyfastg names nodes like "1+" and "1-"
+        return lambda n: n[:-1] + ("-" if n[-1] == "+" else "+")
+    return negate_node_id
+
+
+def get_coverage_attr(digraph):
+    """Returns the name of the node attribute we'll treat as coverage.
+
+    This is the first attribute in config.COVERAGE_ATTRS that at least one
+    node in the graph has. Raises a ValueError if no nodes have any of these
+    attributes (e.g. GFA files, which we don't parse coverage from).
+    """
+    for attr in config.COVERAGE_ATTRS:
+        for n in digraph.nodes:
+            if attr in digraph.nodes[n]:
+                return attr
+    raise ValueError(
+        "--min-coverage was given, but none of the nodes in the graph have "
+        "coverage information (we looked for the attributes {}).".format(
+            ", ".join(config.COVERAGE_ATTRS)
+        )
+    )
+
+
+def find_low_coverage_nodes(digraph, min_coverage):
+    """Returns a list of nodes with coverage < min_coverage.
+
+    Nodes without any coverage information are kept.
+    """
+    attr = get_coverage_attr(digraph)
+    low = []
+    for n in digraph.nodes:
+        cov = digraph.nodes[n].get(attr)
+        if cov is not None and cov < min_coverage:
+            low.append(n)
+    return low
+
+
+def find_tips(digraph, max_tip_length, get_rc_node_name=None):
+    """Returns a list of "tip" nodes with length <= max_tip_length.
+
+    A tip is a node that is only connected to one other node, and is a dead
+    end: either it has no incoming edges and a single outgoing edge (to its
+    "neighbor"), or it has no outgoing edges and a single incoming edge. This
+    is the usual signature of a sequencing error near the end of a read.
+
+    We don't want to clip the actual ends of a linear sequence, though -- so
+    we only count a node as a tip if its neighbor has some *other* way in
+    (for tips with an outgoing edge) or out (for tips with an incoming edge)
+    that isn't itself a tip we're clipping. For example, in the graph
+
+        A -> B -> C
+             ^
+             |
+             D
+
+    ...if A and D are both short, one of them will be kept, so B doesn't
+    become a dead end. (We keep whichever one comes first in the graph's
+    node order, which just depends on the order of the input file.)
+
+    If get_rc_node_name is given (see get_rc_node_name_func()), then
+    whenever we clip a tip we'll also clip its reverse complement, so that
+    the graph stays symmetric.
+
+    We check each node once, and then keep a count of the not-yet-clipped
+    incoming / outgoing neighbors of each node a candidate tip is attached to
+    (decrementing these counts as we clip tips) -- so deciding whether or not
+    to clip a candidate takes constant time, and this is linear in the size of
+    the graph even if lots of candidate tips hang off of the same node.
+    """
+    # Maps each candidate tip to (its neighbor, True if the tip points into
+    # its neighbor / False if the neighbor points into it)
+    candidates = {}
+    for n in digraph.nodes:
+        length = digraph.nodes[n].get("length")
+        if length is None or length > max_tip_length:
+            continue
+        indeg = digraph.in_degree(n)
+        outdeg = digraph.out_degree(n)
+        if indeg == 0 and outdeg == 1:
+            nbr = next(iter(digraph.successors(n)))
+            if nbr != n:
+                candidates[n] = (nbr, True)
+        elif outdeg == 0 and indeg == 1:
+            nbr = next(iter(digraph.predecessors(n)))
+            if nbr != n:
+                candidates[n] = (nbr, False)
+
+    # Maps (neighbor, True) to the number of the neighbor's predecessors we
+    # haven't clipped, and (neighbor, False) to the number of the neighbor's
+    # successors we haven't clipped. A candidate tip only has one edge, so
+    # clipping it only changes one of these counts.
+    unclipped = {}
+
+    def num_unclipped(key):
+        if key not in unclipped:
+            nbr, points_in = key
+            if points_in:
+                unclipped[key] = digraph.in_degree(nbr)
+            else:
+                unclipped[key] = digraph.out_degree(nbr)
+        return unclipped[key]
+
+    tips = []
+    clipped = set()
+
+    def clip(n):
+        tips.append(n)
+        clipped.add(n)
+        key = candidates[n]
+        unclipped[key] = num_unclipped(key) - 1
+
+    for n, key in candidates.items():
+        if n in clipped:
+            continue
+        # n is one of the unclipped ways into/out of its neighbor. If there's
+        # any other (including candidate tips we decided to keep, or that we
+        # haven't looked at yet -- we'll keep those if they end up being the
+        # last way in/out), then we can clip n.
+        if num_unclipped(key) > 1:
+            clip(n)
+            if get_rc_node_name is not None:
+                rc = get_rc_node_name(n)
+                if rc in candidates and rc not in clipped:
+                    clip(rc)
+    return tips
+
+
+def remove_transitive_edges(digraph, get_rc_node_name=None):
+    """Removes (and returns a list of) "transitive" edges from the graph.
+
+    An edge u -> w is transitive if there's some other node v such that
+    u -> v and v -> w are also both edges in the graph: the path through v
+    already shows that you can get from u to w, so the direct edge doesn't
+    add much. (This is common in overlap graphs.)
+
+    Computing the full transitive reduction of a graph is too slow for
+    huge graphs, so we only look at these "triangles" -- and we skip nodes
+    with more than config.TRANSITIVE_REDUCTION_MAX_DEGREE outgoing edges,
+    which keeps this linear-time (each edge looks at a bounded number of
+    other edges). We check the graph as it currently is when deciding to
+    remove each edge, so removing edges never disconnects anything that was
+    connected before.
+
+    If get_rc_node_name is given (see get_rc_node_name_func()), then when we
+    remove an edge we'll also remove its reverse-complement edge, so that
+    the graph stays symmetric.
+    """
+    removed = []
+    max_degree = config.TRANSITIVE_REDUCTION_MAX_DEGREE
+    for u, w in list(digraph.edges):
+        if u == w or not digraph.has_edge(u, w):
+            continue
+        if digraph.out_degree(u) > max_degree:
+            continue
+        for v in digraph.successors(u):
+            if v == u or v == w or not digraph.has_edge(v, w):
+                continue
+            digraph.remove_edge(u, w)
+            removed.append((u, w))
+            if get_rc_node_name is not None:
+                ru = get_rc_node_name(u)
+                rv = get_rc_node_name(v)
+                rw = get_rc_node_name(w)
+                # The RC of u -> w is -w -> -u, which is transitive due to
+                # -w -> -v -> -u. Check that this path is still there,
+                # just in case the graph isn't perfectly symmetric.
+                if (
+                    (rw, ru) != (u, w)
+                    and digraph.has_edge(rw, ru)
+                    and digraph.has_edge(rw, rv)
+                    and digraph.has_edge(rv, ru)
+                ):
+                    digraph.remove_edge(rw, ru)
+                    removed.append((rw, ru))
+            break
+    return removed
+
+
+def simplify(
+    digraph,
+    clip_tips_length=None,
+    min_coverage=None,
+    transitive_reduction=False,
+    get_rc_node_name=None,
+):
+    """Runs whichever simplification passes were requested on a digraph.
+
+    The digraph is modified in place. Passes run in the order: coverage
+    filtering, tip clipping, transitive reduction. (Removing low-coverage
+    junk first means that tips hanging off of that junk go away with it.)
+
+    Returns a 2-tuple of (removed nodes, removed edges). Removed nodes are
+    represented as [name, reason] lists, and removed edges are represented
+    as [source name, target name, reason] lists, where reason is one of TIP,
+    LOW_COVERAGE, or TRANSITIVE. (Edges that were removed along with a
+    removed node aren't listed separately.)
+
+    Raises a ValueError if this would remove every node in the graph.
+    """
+    removed_nodes = []
+    removed_edges = []
+    if min_coverage is not None:
+        low = find_low_coverage_nodes(digraph, min_coverage)
+        digraph.remove_nodes_from(low)
+        removed_nodes.extend([n, LOW_COVERAGE] for n in low)
+    if clip_tips_length is not None:
+        tips = find_tips(digraph, clip_tips_length, get_rc_node_name)
+        digraph.remove_nodes_from(tips)
+        removed_nodes.extend([n, TIP] for n in tips)
+    if transitive_reduction:
+        te = remove_transitive_edges(digraph, get_rc_node_name)
+        removed_edges.extend([u, w, TRANSITIVE] for u, w in te)
+    if len(digraph.nodes) == 0:
+        raise ValueError(
+            "Simplifying the graph removed all of its nodes. Try again with "
+            "less aggressive simplification settings."
+        )
+    return removed_nodes, removed_edges
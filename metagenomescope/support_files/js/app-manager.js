@@ -29,6 +29,24 @@ define(["jquery", "underscore", "drawer", "utils", "dom-utils"], function (
 
             this.controlsDiv = $("#controls");
 
+            // ImageExporter for the image currently being exported, if any
+            this.imageExporter = null;
+
+            // State of the component browser (the "browse" component
+            // selection method): how the list is sorted, the size ranks of
+            // the components in the list (after filtering and sorting), and
+            // the size rank of the component that was last clicked on
+            this.browserSortCol = "rank";
+            this.browserSortAscending = true;
+            this.browserRanks = [];
+            this.browserSelectedRank = null;
+
+            // Info about the node annotation that nodes are currently colored
+            // by (see annotations.py), or null if nodes are uniformly colored
+            this.nodeColorColumn = null;
+            // Max number of categories to list in the node color legend
+            this.MAX_LEGEND_CATEGORIES = 20;
+
             $(this.doThingsWhenDOMReady.bind(this));
 
             this.cmpSelectionMethod = undefined;
@@ -47,6 +65,23 @@ define(["jquery", "underscore", "drawer", "utils", "dom-utils"], function (
             this.selectedEdges = new Set();
             this.selectedPatterns = new Set();
 
+            // Selecting lots of elements at once (e.g. with box selection)
+            // fires one Cytoscape.js event per element. Rather than updating
+            // the selected element tables for each event, we save the
+            // changes here (mapping element IDs to [element, "select" or
+            // "unselect"]; later changes replace earlier ones) and apply them
+            // all at once on the next animation frame.
+            this.pendingSelectionChanges = new Map();
+            this.selectionFlushScheduled = false;
+
+            // The selected element tables only contain rows for selected
+            // elements that are (about to be) scrolled into view, since
+            // adding thousands of rows to the DOM is slow. These are the
+            // (approximate) height of a row in pixels, and the number of
+            // extra rows to draw above and below the visible ones.
+            this.SELECTED_ROW_HEIGHT_PX = 25;
+            this.SELECTED_ROW_OVERSCAN = 10;
+
             // Set of IDs of collapsed patterns.
             this.collapsedPatterns = new Set();
 
@@ -60,6 +95,8 @@ define(["jquery", "underscore", "drawer", "utils", "dom-utils"], function (
             // Text shown in selected element info tables for attributes not
             // given for a node / edge / pattern.
             this.ATTR_NA = "N/A";
+            // Shown for extra attributes whose side table is still loading
+            this.ATTR_LOADING = "...";
         }
 
         /**
@@ -116,10 +153,19 @@ define(["jquery", "underscore", "drawer", "utils", "dom-utils"], function (
 
             this.initSelectedEleInfoTables();
 
+            this.initComponentBrowser();
+
+            this.initNodeColorization();
+
             _.each(["node", "edge", "pattern"], function (eleType) {
                 $("#" + eleType + "Header").click(function () {
                     scope.toggleEleInfo(eleType);
                 });
+                $("#" + eleType + "Info").scroll(function () {
+                    window.requestAnimationFrame(function () {
+                        scope.renderSelectedEleRows(eleType);
+                    });
+                });
             });
 
             // Set up colorpickers
@@ -145,6 +191,7 @@ define(["jquery", "underscore", "drawer", "utils", "dom-utils"], function (
             var exportFunc = this.exportGraphView.bind(this);
             $("#floatingExportButton").click(exportFunc);
             $("#exportImageButton").click(exportFunc);
+            $("#cancelExportButton").click(this.cancelExport.bind(this));
         }
 
         /**
@@ -178,6 +225,8 @@ define(["jquery", "underscore", "drawer", "utils", "dom-utils"], function (
                     $(openerID).addClass("glyphicon-triangle-right");
                 }
                 $(infoDivID).toggleClass("notviewable");
+                // Rows aren't drawn while the table is hidden
+                this.renderSelectedEleRows(eleType);
             } else {
                 throw new Error("Unrecognized eleType: " + eleType);
             }
@@ -211,6 +260,187 @@ define(["jquery", "underscore", "drawer", "utils", "dom-utils"], function (
                     }
                 });
             this.cmpSelectionMethod = newMethod;
+            if (newMethod === "browse") {
+                // The list's rows can't be laid out while it's hidden
+                this.renderComponentBrowserRows();
+            }
+        }
+
+        /**
+         * Sets up the component browser.
+         *
+         * This is a list of all of the components in the graph, based on the
+         * component summary table computed in the python code. It can be
+         * sorted (by clicking on the column headers) and filtered (see
+         * utils.parseComponentFilter()); clicking on a component draws it.
+         * Like the selected element tables, only the rows that are scrolled
+         * into view are actually drawn, since graphs can have lots of
+         * components.
+         */
+        initComponentBrowser() {
+            var scope = this;
+            $("#componentBrowserTable th").click(function () {
+                var col = $(this).attr("data-col");
+                if (col === scope.browserSortCol) {
+                    scope.browserSortAscending = !scope.browserSortAscending;
+                } else {
+                    scope.browserSortCol = col;
+                    // Biggest values first is usually more interesting
+                    // (except for the size rank, which is the opposite)
+                    scope.browserSortAscending = col === "rank";
+                }
+                scope.updateComponentBrowser();
+            });
+            $("#componentFilterInput").on(
+                "input",
+                _.debounce(this.updateComponentBrowser.bind(this), 200)
+            );
+            $("#componentBrowser").scroll(function () {
+                window.requestAnimationFrame(
+                    scope.renderComponentBrowserRows.bind(scope)
+                );
+            });
+            $("#componentBrowserTable").on(
+                "click",
+                ".componentRow",
+                function () {
+                    scope.browserSelectedRank = parseInt(
+                        $(this).attr("data-rank")
+                    );
+                    scope.draw();
+                }
+            );
+            this.updateComponentBrowser();
+        }
+
+        /**
+         * Re-filters and re-sorts the component browser's list.
+         */
+        updateComponentBrowser() {
+            var summary = this.dataHolder.getComponentSummary();
+            var conditions;
+            try {
+                conditions = utils.parseComponentFilter(
+                    $("#componentFilterInput").val(),
+                    [
+                        "nodes",
+                        "edges",
+                        "patterns",
+                        "length",
+                        "n50",
+                        "gc",
+                        "depth",
+                    ],
+                    ["status"]
+                );
+            } catch (error) {
+                $("#componentFilterInput").parent().addClass("has-error");
+                $("#componentBrowserCount").text(error.message + ".");
+                return;
+            }
+            $("#componentFilterInput").parent().removeClass("has-error");
+            this.browserRanks = utils.filterAndSortComponents(
+                summary,
+                conditions,
+                this.browserSortCol,
+                this.browserSortAscending
+            );
+            var scope = this;
+            $("#componentBrowserTable th").each(function (i, th) {
+                $(th).removeClass("sortAsc sortDesc");
+                if ($(th).attr("data-col") === scope.browserSortCol) {
+                    $(th).addClass(
+                        scope.browserSortAscending ? "sortAsc" : "sortDesc"
+                    );
+                }
+            });
+            $("#componentBrowserCount").text(
+                "Showing " +
+                    this.browserRanks.length.toLocaleString() +
+                    " of " +
+                    this.numComponents.toLocaleString() +
+                    " components."
+            );
+            $("#componentBrowser").scrollTop(0);
+            this.renderComponentBrowserRows();
+        }
+
+        /**
+         * Returns the HTML for a component's row in the component browser.
+         */
+        getComponentBrowserRowHTML(sizeRank) {
+            var scope = this;
+            var summary = this.dataHolder.getComponentSummary();
+            var i = sizeRank - 1;
+            var rowClass = "browserRow componentRow";
+            if (_.contains(this.currentlyDrawnComponents, sizeRank)) {
+                rowClass += " drawnComponent";
+            }
+            var cells = _.map(
+                ["nodes", "edges", "patterns", "length", "n50", "gc", "depth"],
+                function (col) {
+                    var val = summary[col][i];
+                    if (_.isNull(val)) {
+                        return scope.ATTR_NA;
+                    } else if (col === "gc") {
+                        return Math.round(val * 10000) / 100 + "%";
+                    } else if (col === "depth") {
+                        return Math.round(val * 100) / 100 + "x";
+                    }
+                    return val.toLocaleString();
+                }
+            );
+            cells.push(summary.status[i]);
+            return (
+                '<tr class="' +
+                rowClass +
+                '" data-rank="' +
+                sizeRank +
+                '"><td>' +
+                sizeRank +
+                "</td><td>" +
+                cells.join("</td><td>") +
+                "</td></tr>"
+            );
+        }
+
+        /**
+         * Redraws the visible rows of the component browser.
+         */
+        renderComponentBrowserRows() {
+            var scroller = $("#componentBrowser");
+            var table = $("#componentBrowserTable");
+            table.find(".browserRow").remove();
+            var numRows = this.browserRanks.length;
+            if (numRows === 0) {
+                return;
+            }
+            var range = utils.getVisibleRowRange(
+                scroller.scrollTop() - table.find("tr").first().outerHeight(),
+                scroller.innerHeight(),
+                this.SELECTED_ROW_HEIGHT_PX,
+                numRows,
+                this.SELECTED_ROW_OVERSCAN
+            );
+            var spacer = function (n) {
+                return (
+                    '<tr class="browserRow spacerRow" style="height: ' +
+                    n * this.SELECTED_ROW_HEIGHT_PX +
+                    'px"><td colspan="100"></td></tr>'
+                );
+            }.bind(this);
+            var html = "";
+            if (range.start > 0) {
+                html += spacer(range.start);
+            }
+            html += _.map(
+                this.browserRanks.slice(range.start, range.end),
+                this.getComponentBrowserRowHTML.bind(this)
+            ).join("");
+            if (range.end < numRows) {
+                html += spacer(numRows - range.end);
+            }
+            table.append(html);
         }
 
         /**
@@ -225,6 +455,37 @@ define(["jquery", "underscore", "drawer", "utils", "dom-utils"], function (
             $("#nodeCtEntry").text(this.dataHolder.totalNumNodes());
             $("#edgeCtEntry").text(this.dataHolder.totalNumEdges());
             $("#ccCtEntry").text(this.dataHolder.numComponents());
+            this.populateRemovedElements();
+        }
+
+        /**
+         * Shows what (if anything) was removed during graph simplification.
+         *
+         * If nothing was removed, the table for this stays hidden.
+         */
+        populateRemovedElements() {
+            var removed = this.dataHolder.removedElements();
+            if (removed.nodes.length === 0 && removed.edges.length === 0) {
+                return;
+            }
+            var counts = { tip: 0, low_coverage: 0, transitive: 0 };
+            var list = $("#removedElementsList");
+            _.each(removed.nodes, function (n) {
+                counts[n[1]]++;
+                list.append($("<div></div>").text(n[0] + " (" + n[1] + ")"));
+            });
+            _.each(removed.edges, function (e) {
+                counts[e[2]]++;
+                list.append(
+                    $("<div></div>").text(
+                        e[0] + " \u2192 " + e[1] + " (" + e[2] + ")"
+                    )
+                );
+            });
+            $("#removedTipCtEntry").text(counts.tip);
+            $("#removedLowCovCtEntry").text(counts.low_coverage);
+            $("#removedTransitiveCtEntry").text(counts.transitive);
+            $("#removedElementsDiv").removeClass("notviewable");
         }
 
         populateGraphInfoCurrComponents() {
@@ -293,127 +554,201 @@ define(["jquery", "underscore", "drawer", "utils", "dom-utils"], function (
             });
         }
 
-        updateSelectedNodeInfo(eleID, selectOrUnselect) {
+        /**
+         * Returns the HTML for a row in the selected node info table.
+         */
+        getSelectedNodeRowHTML(eleID) {
             var scope = this;
             // TODO abstract across nodes/edges/patterns -- basically the same
-            if (selectOrUnselect === "select") {
-                var nodeInfo = this.dataHolder.getNodeInfo(eleID);
-                // TODO: cache this for this class since it doesn't change
-                var nodeAttrs = this.dataHolder.getNodeAttrs();
-                var rowHTML =
-                    '<tr class="selectedEleRow" id="selectedEleRow' +
-                    eleID +
-                    '">';
-                _.each(this.nodeInfoTableAttrs, function (attr) {
-                    // Although these extra attributes are in theory arbitrary,
-                    // for certain known attributes we take some extra effort
-                    // and format things a bit nicely. This makes the user
-                    // experience nicer.
-                    // TODO abstract this to a util function.
-                    var lowercaseattr = attr.toLowerCase();
-                    var val = nodeInfo[nodeAttrs[attr]];
+            var nodeInfo = this.dataHolder.getNodeInfo(eleID);
+            // TODO: cache this for this class since it doesn't change
+            var nodeAttrs = this.dataHolder.getNodeAttrs();
+            var extraInfo = this.dataHolder.getExtraNodeInfo(
+                eleID,
+                this.onAttrTableLoad.bind(this)
+            );
+            var rowHTML =
+                '<tr class="selectedEleRow" id="selectedEleRow' + eleID + '">';
+            _.each(this.nodeInfoTableAttrs, function (attr) {
+                // Although these extra attributes are in theory arbitrary,
+                // for certain known attributes we take some extra effort
+                // and format things a bit nicely. This makes the user
+                // experience nicer.
+                // TODO abstract this to a util function.
+                var val;
+                if (_.has(nodeAttrs, attr)) {
+                    val = nodeInfo[nodeAttrs[attr]];
+                } else if (_.isNull(extraInfo)) {
+                    val = scope.ATTR_LOADING;
+                } else {
+                    val = extraInfo[attr];
+                }
 
-                    if (_.isNull(val)) {
-                        val = scope.ATTR_NA;
-                    } else {
-                        if (attr === "length") {
-                            // Unlike the old version of MgSc, we just say every
-                            // length measure is in bp instead of trying to
-                            // distinguish nt from bp. I think this is kosher,
-                            // since it's not like we can tell if contigs are
-                            // oriented are not for general formats like GFA...?
-                            val = val.toLocaleString() + " bp";
-                        } else if (attr === "coverage" || attr === "depth") {
-                            // Show coverages with at most two decimal places worth
-                            // of precision, but less if possible. I will be
-                            // honest, this code is from the old MgSc and I have
-                            // no idea how I came up with this. wtf marcus 4 years
-                            // ago lol
-                            val = Math.round(val * 100) / 100 + "x";
-                        } else if (attr === "gc_content") {
-                            // GC content should be shown as a percentage, rounded
-                            // to two decimal places. We multiply by 10,000 because
-                            // we're really multiplying by 100 twice: first to
-                            // convert to a percentage, then to start the rounding
-                            // process.
-                            val = Math.round(val * 10000) / 100 + "%";
-                        }
+                if (_.isNull(val)) {
+                    val = scope.ATTR_NA;
+                } else if (val !== scope.ATTR_LOADING) {
+                    if (attr === "length") {
+                        // Unlike the old version of MgSc, we just say every
+                        // length measure is in bp instead of trying to
+                        // distinguish nt from bp. I think this is kosher,
+                        // since it's not like we can tell if contigs are
+                        // oriented are not for general formats like GFA...?
+                        val = val.toLocaleString() + " bp";
+                    } else if (attr === "coverage" || attr === "depth") {
+                        // Show coverages with at most two decimal places worth
+                        // of precision, but less if possible. I will be
+                        // honest, this code is from the old MgSc and I have
+                        // no idea how I came up with this. wtf marcus 4 years
+                        // ago lol
+                        val = Math.round(val * 100) / 100 + "x";
+                    } else if (attr === "gc_content") {
+                        // GC content should be shown as a percentage, rounded
+                        // to two decimal places. We multiply by 10,000 because
+                        // we're really multiplying by 100 twice: first to
+                        // convert to a percentage, then to start the rounding
+                        // process.
+                        val = Math.round(val * 10000) / 100 + "%";
                     }
-                    rowHTML += "<td>" + val + "</td>";
-                });
-                rowHTML += "</tr>";
-                $("#nodeInfoTable").append(rowHTML);
-            } else {
-                this.removeSelectedEleInfo(eleID);
-            }
+                }
+                rowHTML += "<td>" + val + "</td>";
+            });
+            rowHTML += "</tr>";
+            return rowHTML;
         }
 
         /**
-         * Adds or removes a row in the selected edge info table.
+         * Returns the HTML for a row in the selected edge info table.
          *
-         * Note that we have an extra param here -- the Cytoscape.js edge
-         * element that is being updated. This is so we can get the original
-         * source/target from this element easily.
+         * We get the edge's original source/target from its Cytoscape.js
+         * element, which we look up by ID.
          */
-        updateSelectedEdgeInfo(ele, eleID, selectOrUnselect) {
+        getSelectedEdgeRowHTML(eleID) {
             var scope = this;
-            if (selectOrUnselect === "select") {
-                var edgeData = ele.data();
-                var edgeInfo = this.dataHolder.getEdgeInfo(
-                    edgeData.origSrcID,
-                    edgeData.origTgtID
-                );
-                var edgeAttrs = this.dataHolder.getEdgeAttrs();
-                var rowHTML =
-                    '<tr class="selectedEleRow" id="selectedEleRow' +
-                    eleID +
-                    '">';
-                _.each(this.edgeInfoTableAttrs, function (attr) {
-                    var val;
-                    // NOTE: this is super inefficient since getNodeName()
-                    // iterates over worst-case all nodes in the graph. TODO,
-                    // at minimum do both searches at once, or figure out a way
-                    // to limit the components checked.
-                    if (attr === "source") {
-                        val = scope.dataHolder.getNodeName(edgeData.origSrcID);
-                    } else if (attr === "target") {
-                        val = scope.dataHolder.getNodeName(edgeData.origTgtID);
-                    } else {
-                        // It's a "normal" attribute stored in the edge's data.
+            var edgeData = this.drawer.cy.getElementById(eleID).data();
+            var edgeInfo = this.dataHolder.getEdgeInfo(
+                edgeData.origSrcID,
+                edgeData.origTgtID
+            );
+            var edgeAttrs = this.dataHolder.getEdgeAttrs();
+            var extraInfo = this.dataHolder.getExtraEdgeInfo(
+                edgeData.origSrcID,
+                edgeData.origTgtID,
+                this.onAttrTableLoad.bind(this)
+            );
+            var rowHTML =
+                '<tr class="selectedEleRow" id="selectedEleRow' + eleID + '">';
+            _.each(this.edgeInfoTableAttrs, function (attr) {
+                var val;
+                if (attr === "source") {
+                    val = scope.dataHolder.getNodeName(edgeData.origSrcID);
+                } else if (attr === "target") {
+                    val = scope.dataHolder.getNodeName(edgeData.origTgtID);
+                } else {
+                    // It's a "normal" attribute stored in the edge's data,
+                    // or an extra attribute stored in a side table.
+                    if (_.has(edgeAttrs, attr)) {
                         val = edgeInfo[edgeAttrs[attr]];
-                        if (_.isNull(val)) {
-                            val = scope.ATTR_NA;
-                        }
+                    } else if (_.isNull(extraInfo)) {
+                        val = scope.ATTR_LOADING;
+                    } else {
+                        val = extraInfo[attr];
                     }
-                    rowHTML += "<td>" + val + "</td>";
-                });
-                rowHTML += "</tr>";
-                $("#edgeInfoTable").append(rowHTML);
-            } else {
-                this.removeSelectedEleInfo(eleID);
-            }
+                    if (_.isNull(val)) {
+                        val = scope.ATTR_NA;
+                    }
+                }
+                rowHTML += "<td>" + val + "</td>";
+            });
+            rowHTML += "</tr>";
+            return rowHTML;
         }
 
-        updateSelectedPatternInfo(eleID, selectOrUnselect) {
-            if (selectOrUnselect === "select") {
-                var pattInfo = this.dataHolder.getPatternInfo(eleID);
-                var pattType = utils.getHumanReadablePatternType(
-                    pattInfo[this.dataHolder.getPattAttrs().pattern_type]
-                );
-                $("#patternInfoTable").append(
-                    '<tr class="selectedEleRow" id="selectedEleRow' +
-                        eleID +
-                        '"><td>' +
-                        pattType +
-                        "</td></tr>"
-                );
-            } else {
-                this.removeSelectedEleInfo(eleID);
-            }
+        /**
+         * Returns the HTML for a row in the selected pattern info table.
+         */
+        getSelectedPatternRowHTML(eleID) {
+            var pattInfo = this.dataHolder.getPatternInfo(eleID);
+            var pattType = utils.getHumanReadablePatternType(
+                pattInfo[this.dataHolder.getPattAttrs().pattern_type]
+            );
+            return (
+                '<tr class="selectedEleRow" id="selectedEleRow' +
+                eleID +
+                '"><td>' +
+                pattType +
+                "</td></tr>"
+            );
         }
 
-        removeSelectedEleInfo(eleID) {
-            $("#selectedEleRow" + eleID).remove();
+        /**
+         * Redraws the selected node / edge tables once a side table of extra
+         * attributes has been loaded, replacing "loading" placeholders.
+         */
+        onAttrTableLoad() {
+            this.renderSelectedEleRows("node");
+            this.renderSelectedEleRows("edge");
+        }
+
+        /**
+         * Redraws the rows of a selected element info table.
+         *
+         * Only the rows that are scrolled into view (plus a few extra) are
+         * actually drawn; the rest of the table is filled with two empty
+         * "spacer" rows, so that the scrollbar still acts like every row is
+         * there. This is called whenever the selection changes or the table
+         * is scrolled.
+         *
+         * @param {String} eleType "node", "edge", or "pattern"
+         */
+        renderSelectedEleRows(eleType) {
+            var eleIDs, getRowHTML;
+            if (eleType === "node") {
+                eleIDs = this.selectedNodes;
+                getRowHTML = this.getSelectedNodeRowHTML.bind(this);
+            } else if (eleType === "edge") {
+                eleIDs = this.selectedEdges;
+                getRowHTML = this.getSelectedEdgeRowHTML.bind(this);
+            } else if (eleType === "pattern") {
+                eleIDs = this.selectedPatterns;
+                getRowHTML = this.getSelectedPatternRowHTML.bind(this);
+            } else {
+                throw new Error("Unrecognized eleType: " + eleType);
+            }
+            var tableID = "#" + eleType + "InfoTable";
+            var scroller = $("#" + eleType + "Info");
+            $(tableID + " .selectedEleRow").remove();
+            if (scroller.hasClass("notviewable") || eleIDs.size === 0) {
+                return;
+            }
+            // The header rows scroll along with the rest of the table
+            var headerHeight = 0;
+            $(tableID + " tr").each(function (i, tr) {
+                headerHeight += $(tr).outerHeight();
+            });
+            var range = utils.getVisibleRowRange(
+                scroller.scrollTop() - headerHeight,
+                scroller.innerHeight(),
+                this.SELECTED_ROW_HEIGHT_PX,
+                eleIDs.size,
+                this.SELECTED_ROW_OVERSCAN
+            );
+            var visibleIDs = Array.from(eleIDs).slice(range.start, range.end);
+            var spacer = function (numRows) {
+                return (
+                    '<tr class="selectedEleRow spacerRow" style="height: ' +
+                    numRows * this.SELECTED_ROW_HEIGHT_PX +
+                    'px"><td colspan="100"></td></tr>'
+                );
+            }.bind(this);
+            var html = "";
+            if (range.start > 0) {
+                html += spacer(range.start);
+            }
+            html += _.map(visibleIDs, getRowHTML).join("");
+            if (range.end < eleIDs.size) {
+                html += spacer(eleIDs.size - range.end);
+            }
+            $(tableID).append(html);
         }
 
         /**
@@ -454,6 +789,9 @@ define(["jquery", "underscore", "drawer", "utils", "dom-utils"], function (
             this.selectedNodes = new Set();
             this.selectedEdges = new Set();
             this.selectedPatterns = new Set();
+            // Any selection changes that haven't been applied yet are for
+            // elements that no longer exist
+            this.pendingSelectionChanges = new Map();
         }
 
         /**
@@ -510,6 +848,22 @@ define(["jquery", "underscore", "drawer", "utils", "dom-utils"], function (
                 }
             } else if (this.cmpSelectionMethod === "all") {
                 return this.dataHolder.getAllLaidOutComponentRanks();
+            } else if (this.cmpSelectionMethod === "browse") {
+                cmpRank = this.browserSelectedRank;
+                if (_.isNull(cmpRank)) {
+                    alert("Please click on a component in the list to draw.");
+                    throw new Error("No component selected.");
+                }
+                var status = this.dataHolder.getComponentSummary().status;
+                if (status[cmpRank - 1] === "skipped") {
+                    alert(
+                        "Component " +
+                            cmpRank +
+                            " wasn't laid out, so it can't be drawn."
+                    );
+                    throw new Error("Component wasn't laid out.");
+                }
+                return [cmpRank];
             } else {
                 throw new Error(
                     "Invalid cmp selection method set: " +
@@ -519,64 +873,42 @@ define(["jquery", "underscore", "drawer", "utils", "dom-utils"], function (
         }
 
         /**
-         * Helper function for onSelect() and onUnselect(). Based on the type
-         * of the element that was selected or unselected, updates the selected
-         * nodes / edges / patterns Set and updates the corresponding badge's
-         * number.
-         *
-         * Also enables / disables the #fitSelectedButton as needed, since that
-         * should only be enabled if at least one element is selected.
+         * Helper function for flushSelectionChanges(). Based on the type of
+         * an element that was selected or unselected, updates the selected
+         * nodes / edges / patterns Set.
          *
-         * Most of the code for these functions was basically the same, so
-         * this function is here to mitigate code reuse.
-         *
-         * @param {Cytoscape.js Event} eve Event triggered by Cytoscape.js.
+         * @param {Cytoscape.js Element} x Element that was selected or
+         *                                 unselected.
          *
          * @param {String} selectOrUnselect If this is "select", then this'll
-         *                                  add the element described in
-         *                                  eve.target to the corresponding
+         *                                  add x to the corresponding
          *                                  selected element Set; if this is
          *                                  "unselect", then this'll remove
-         *                                  that element from the Set. If this
-         *                                  isn't either of those things,
-         *                                  this'll raise an error.
+         *                                  x from the Set.
+         *
+         * @returns {String} The type of x: "node", "edge", or "pattern".
          *
          * @throws {Error} If any of the following conditions is met:
-         *                 -The element described by eve.target isn't a node
-         *                  (here "node" includes both normal nodes and
-         *                  patterns) or edge.
-         *                 -The element described by eve.target is a node,
-         *                  but it doesn't seem to be a normal or pattern node.
-         *                 -selectOrUnselect isn't "select" or "unselect"
-         */
-        updateSelectedEles(eve, selectOrUnselect) {
+         *                 -x isn't a node (here "node" includes both normal
+         *                  nodes and patterns) or edge.
+         *                 -x is a node, but it doesn't seem to be a normal or
+         *                  pattern node.
+         */
+        updateSelectedEles(x, selectOrUnselect) {
             // This is the name of the Set function we want to call with the
             // element's ID. It's either .add() or .delete(), and fortunately
             // JS makes swapping out functions to be called fairly easy.
-            var setFunc;
-            if (selectOrUnselect === "select") {
-                setFunc = "add";
-            } else if (selectOrUnselect === "unselect") {
-                setFunc = "delete";
-            } else {
-                throw new Error(
-                    "Invalid selectOrUnselect value: " + selectOrUnselect
-                );
-            }
-
-            var x = eve.target;
+            var setFunc = selectOrUnselect === "select" ? "add" : "delete";
             var xID = x.id();
             if (x.isNode()) {
                 if (x.hasClass("basic")) {
                     // It's a regular node (not a pattern).
                     this.selectedNodes[setFunc](xID);
-                    $("#selectedNodeBadge").text(this.selectedNodes.size);
-                    this.updateSelectedNodeInfo(xID, selectOrUnselect);
+                    return "node";
                 } else if (x.hasClass("pattern")) {
                     // It's a pattern.
                     this.selectedPatterns[setFunc](xID);
-                    $("#selectedPatternBadge").text(this.selectedPatterns.size);
-                    this.updateSelectedPatternInfo(xID, selectOrUnselect);
+                    return "pattern";
                 } else {
                     throw new Error(
                         "Unrecognized node type of target element: " + x
@@ -588,29 +920,85 @@ define(["jquery", "underscore", "drawer", "utils", "dom-utils"], function (
                 // Cytoscape.js initializes edges with UUIDs, which makes our
                 // job here easier.
                 this.selectedEdges[setFunc](xID);
-                $("#selectedEdgeBadge").text(this.selectedEdges.size);
-                this.updateSelectedEdgeInfo(x, xID, selectOrUnselect);
+                return "edge";
             } else {
                 throw new Error("Target element not a node or edge: " + x);
             }
+        }
+
+        /**
+         * Records that an element was selected or unselected, and makes sure
+         * that the change will be applied on the next animation frame.
+         *
+         * @param {Cytoscape.js Event} eve Event triggered by Cytoscape.js.
+         *
+         * @param {String} selectOrUnselect Either "select" or "unselect".
+         *
+         * @throws {Error} If selectOrUnselect isn't "select" or "unselect".
+         */
+        queueSelectionChange(eve, selectOrUnselect) {
+            if (
+                selectOrUnselect !== "select" &&
+                selectOrUnselect !== "unselect"
+            ) {
+                throw new Error(
+                    "Invalid selectOrUnselect value: " + selectOrUnselect
+                );
+            }
+            this.pendingSelectionChanges.set(eve.target.id(), [
+                eve.target,
+                selectOrUnselect,
+            ]);
+            if (!this.selectionFlushScheduled) {
+                this.selectionFlushScheduled = true;
+                window.requestAnimationFrame(
+                    this.flushSelectionChanges.bind(this)
+                );
+            }
+        }
+
+        /**
+         * Applies all of the selection changes queued up since the last
+         * animation frame.
+         *
+         * Updates the selected element Sets, and then (once per element
+         * type that changed) the corresponding badge and table.
+         *
+         * Also enables / disables the #fitSelectedButton as needed, since that
+         * should only be enabled if at least one element is selected.
+         */
+        flushSelectionChanges() {
+            var scope = this;
+            this.selectionFlushScheduled = false;
+            var changedTypes = new Set();
+            this.pendingSelectionChanges.forEach(function (change) {
+                changedTypes.add(
+                    scope.updateSelectedEles(change[0], change[1])
+                );
+            });
+            this.pendingSelectionChanges = new Map();
+
+            if (changedTypes.has("node")) {
+                $("#selectedNodeBadge").text(this.selectedNodes.size);
+            }
+            if (changedTypes.has("edge")) {
+                $("#selectedEdgeBadge").text(this.selectedEdges.size);
+            }
+            if (changedTypes.has("pattern")) {
+                $("#selectedPatternBadge").text(this.selectedPatterns.size);
+            }
+            changedTypes.forEach(function (eleType) {
+                scope.renderSelectedEleRows(eleType);
+            });
 
             var totalSelectedEleCt =
                 this.selectedNodes.size +
                 this.selectedEdges.size +
                 this.selectedPatterns.size;
-            if (setFunc === "add" && totalSelectedEleCt === 1) {
-                // The #fitSelectedButton element should be enabled if at least
-                // one element is selected.
+            if (totalSelectedEleCt > 0) {
                 domUtils.enableButton("fitSelectedButton");
             } else {
-                // Similarly, if we just un-selected an element, then check if
-                // no elements are now selected. If so, disable the button.
-                // (...Not sure how we'd have a negative amount of selected
-                // elements, but I figure we might as well cover our bases with
-                // the <= 0 here :P)
-                if (totalSelectedEleCt <= 0) {
-                    domUtils.disableButton("fitSelectedButton");
-                }
+                domUtils.disableButton("fitSelectedButton");
             }
         }
 
@@ -621,7 +1009,7 @@ define(["jquery", "underscore", "drawer", "utils", "dom-utils"], function (
          * @param {Cytoscape.js Event} eve Event triggered by Cytoscape.js.
          */
         onSelect(eve) {
-            this.updateSelectedEles(eve, "select");
+            this.queueSelectionChange(eve, "select");
         }
 
         /**
@@ -631,7 +1019,7 @@ define(["jquery", "underscore", "drawer", "utils", "dom-utils"], function (
          * @param {Cytoscape.js Event} eve Event triggered by Cytoscape.js.
          */
         onUnselect(eve) {
-            this.updateSelectedEles(eve, "unselect");
+            this.queueSelectionChange(eve, "unselect");
         }
 
         /**
@@ -747,6 +1135,8 @@ define(["jquery", "underscore", "drawer", "utils", "dom-utils"], function (
          */
         onDestroy() {
             this.removeAllSelectedEleInfo();
+            // Don't keep exporting an image of stuff that's gone
+            this.cancelExport();
             // Clear collapsed pattern info
             // (... If we're drawing patterns as already collapsed, then
             // those patterns should be added to this when that happens)
@@ -773,25 +1163,213 @@ define(["jquery", "underscore", "drawer", "utils", "dom-utils"], function (
             // Enable controls that only have meaning when stuff is drawn (e.g.
             // the "fit graph" buttons)
             domUtils.enableDrawNeededControls();
+            // Highlight the drawn component(s) in the component browser
+            this.renderComponentBrowserRows();
+            // Color the new nodes by the current annotation, if any
+            if (!_.isNull(this.nodeColorColumn)) {
+                this.applyNodeColorization();
+            }
+        }
+
+        /**
+         * Sets up the node coloring controls: one option for each node
+         * annotation given to the python script.
+         */
+        initNodeColorization() {
+            var select = $("#nodeColorizationSelect");
+            _.each(this.dataHolder.getAnnotationColumns(), function (col, i) {
+                select.append(
+                    $("<option></option>").attr("value", i).text(col.name)
+                );
+            });
+            $("#changeNodeColorizationButton").click(
+                this.changeNodeColorization.bind(this)
+            );
+        }
+
+        /**
+         * Colors nodes by whatever is selected in the node coloring
+         * controls.
+         */
+        changeNodeColorization() {
+            var val = $("#nodeColorizationSelect").val();
+            if (val === "") {
+                this.nodeColorColumn = null;
+            } else {
+                this.nodeColorColumn = this.dataHolder.getAnnotationColumns()[
+                    parseInt(val)
+                ];
+            }
+            this.updateNodeColorizationLegend();
+            this.applyNodeColorization();
+        }
+
+        /**
+         * Colors the nodes in the currently drawn components by
+         * this.nodeColorColumn (or resets their colors, if that's null).
+         *
+         * The annotation side tables for these components are loaded first
+         * (if needed); once they are, all of the nodes are recolored at once
+         * (see Drawer.setNodeColors()).
+         */
+        applyNodeColorization() {
+            var scope = this;
+            var col = this.nodeColorColumn;
+            if (_.isNull(col)) {
+                this.drawer.setNodeColors({});
+                return;
+            }
+            var sizeRanks = this.currentlyDrawnComponents;
+            this.dataHolder.loadAnnotationTables(sizeRanks, function () {
+                // If the selected coloring changed while we were loading
+                // tables, don't overwrite it
+                if (scope.nodeColorColumn !== col) {
+                    return;
+                }
+                var nodeColors = {};
+                _.each(sizeRanks, function (sizeRank) {
+                    var nodeID2val = scope.dataHolder.getNodeAnnotations(
+                        sizeRank,
+                        col.name
+                    );
+                    _.each(nodeID2val, function (val, nodeID) {
+                        nodeColors[nodeID] = utils.getAnnotationColor(
+                            col,
+                            val
+                        );
+                    });
+                });
+                scope.drawer.setNodeColors(nodeColors);
+            });
+        }
+
+        /**
+         * Shows what the node colors mean for this.nodeColorColumn.
+         */
+        updateNodeColorizationLegend() {
+            var col = this.nodeColorColumn;
+            var legend = $("#nodeColorizationLegend");
+            legend.empty();
+            if (_.isNull(col)) {
+                return;
+            }
+            var entries;
+            if (col.type === "categorical") {
+                entries = _.map(
+                    _.first(col.values, this.MAX_LEGEND_CATEGORIES),
+                    function (val, i) {
+                        return [utils.getAnnotationColor(col, i), val];
+                    }
+                );
+            } else {
+                var mid = (col.min + col.max) / 2;
+                entries = _.map([col.min, mid, col.max], function (val) {
+                    return [utils.getAnnotationColor(col, val), String(val)];
+                });
+            }
+            _.each(entries, function (entry) {
+                legend.append(
+                    $("<div></div>")
+                        .append(
+                            $('<span class="legendSwatch"></span>').css(
+                                "background-color",
+                                entry[0]
+                            )
+                        )
+                        .append($("<span></span>").text(entry[1]))
+                );
+            });
+            if (
+                col.type === "categorical" &&
+                col.values.length > this.MAX_LEGEND_CATEGORIES
+            ) {
+                legend.append(
+                    $("<div></div>").text(
+                        "(and " +
+                            (col.values.length - this.MAX_LEGEND_CATEGORIES) +
+                            " more)"
+                    )
+                );
+            }
         }
 
         /**
          * Exports an image of the graph, calling downloadDataURI() to prompt
-         * the user.
+         * the user once the image is ready.
          *
-         * The image filetype is determined using a button group in the control
-         * panel.
+         * The image filetype and resolution are determined using controls in
+         * the control panel. Exporting happens in the background (see
+         * image-export.js); while it's going on, we show a progress bar and a
+         * button to cancel the export.
          */
         exportGraphView() {
-            // Should be either "PNG" or "JPG"
+            if (!_.isNull(this.imageExporter)) {
+                // Already exporting something
+                return;
+            }
+            // Should be "PNG", "JPG", or "SVG"
             var imgType = $("#imgTypeButtonGroup .btn.active").attr("value");
-            var encodedImage = this.drawer.exportImage(imgType);
+            var dpi = parseFloat($("#exportDPIInput").val());
+            var scope = this;
             var fn =
                 "mgsc-" +
                 utils.getFancyTimestamp(new Date()) +
                 "." +
                 imgType.toLowerCase();
-            domUtils.downloadDataURI(fn, encodedImage, false);
+            var exporter;
+            this.alertAndThrowIfFails(function () {
+                exporter = scope.drawer.makeImageExporter(imgType, dpi, {
+                    onProgress: function (fraction) {
+                        var perc = Math.round(fraction * 100);
+                        $("#exportProgressBar")
+                            .css("width", perc + "%")
+                            .attr("aria-valuenow", perc);
+                    },
+                    onDone: function (blob) {
+                        scope.stopExportUI();
+                        var url = URL.createObjectURL(blob);
+                        domUtils.downloadDataURI(fn, url, false);
+                        // Give the download a chance to start before freeing
+                        // the image
+                        setTimeout(function () {
+                            URL.revokeObjectURL(url);
+                        }, 10000);
+                    },
+                    onError: function (message) {
+                        scope.stopExportUI();
+                        alert("Exporting the image failed: " + message);
+                    },
+                    onCancel: function () {
+                        scope.stopExportUI();
+                    },
+                });
+            });
+            this.imageExporter = exporter;
+            domUtils.disableButton("exportImageButton");
+            domUtils.disableButton("floatingExportButton");
+            $("#exportProgressBar").css("width", "0%").attr("aria-valuenow", 0);
+            $("#exportProgressControls").removeClass("notviewable");
+            exporter.start();
+        }
+
+        /**
+         * Cancels the current image export, if there is one.
+         */
+        cancelExport() {
+            if (!_.isNull(this.imageExporter)) {
+                this.imageExporter.cancel();
+            }
+        }
+
+        /**
+         * Resets the export UI after an export finishes / fails / is
+         * cancelled.
+         */
+        stopExportUI() {
+            this.imageExporter = null;
+            $("#exportProgressControls").addClass("notviewable");
+            domUtils.enableButton("exportImageButton");
+            domUtils.enableButton("floatingExportButton");
         }
     }
     return { AppManager: AppManager };
@@ -0,0 +1,323 @@
+/* Copyright (C) 2016-- Marcus Fedarko, Jay Ghurye, Todd Treangen, Mihai Pop
+ * Authored by Marcus Fedarko
+ *
+ * This file is part of MetagenomeScope.
+ *
+ * MetagenomeScope is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MetagenomeScope is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MetagenomeScope.  If not, see <http://www.gnu.org/licenses/>.
+ ****
+ * Caches decoded graph data in the browser's IndexedDB, so that reopening a
+ * big visualization doesn't mean re-parsing all of its data.
+ *
+ * The python script saves the graph data to data.js and puts a hash of this
+ * data in main.js. When the visualization is opened, we check the cache for
+ * this hash first, and only load data.js if it isn't there. Each cached
+ * dataset is stored as three kinds of records (all keyed by the hash):
+ *
+ * - "datasets": a tiny record saying when the dataset was last opened and
+ *   how many components it has
+ * - "headers": everything in the data besides the components, plus
+ *   DataHolder's lookup indexes
+ * - "components": one record per component
+ *
+ * Saving happens a few components at a time, in separate transactions during
+ * idle time: put() copies its record synchronously, so saving every component
+ * in one go would freeze the page for a while right after a big
+ * visualization is loaded. The "datasets" record is written last, so a save
+ * that was interrupted partway through just looks like a cache miss.
+ *
+ * We only keep the MAX_CACHED_DATASETS most recently opened datasets around.
+ * If anything goes wrong (e.g. IndexedDB isn't available, or we're over
+ * quota), we just act like the data isn't cached.
+ */
+define(["underscore"], function (_) {
+    var DB_NAME = "MetagenomeScope";
+    var DB_VERSION = 1;
+    var DATASET_STORE = "datasets";
+    var HEADER_STORE = "headers";
+    var COMPONENT_STORE = "components";
+    var ALL_STORES = [DATASET_STORE, HEADER_STORE, COMPONENT_STORE];
+    var MAX_CACHED_DATASETS = 5;
+    // If requestIdleCallback() isn't available, this is how many ms we spend
+    // saving components before letting the page do other stuff
+    var SAVE_BUDGET_MS = 10;
+
+    /**
+     * Calls a function once the browser isn't busy.
+     *
+     * @param {Function} f Called with a function that returns how many more
+     *                     ms f can spend working before it should stop.
+     */
+    function whenIdle(f) {
+        if (_.isFunction(window.requestIdleCallback)) {
+            window.requestIdleCallback(function (deadline) {
+                f(function () {
+                    return deadline.timeRemaining();
+                });
+            });
+        } else {
+            setTimeout(function () {
+                var start = Date.now();
+                f(function () {
+                    return SAVE_BUDGET_MS - (Date.now() - start);
+                });
+            }, 0);
+        }
+    }
+
+    /**
+     * Opens the cache database.
+     *
+     * @param {Function} callback Called with the IDBDatabase, or with null
+     *                            if it couldn't be opened.
+     */
+    function openDB(callback) {
+        var request;
+        try {
+            request = window.indexedDB.open(DB_NAME, DB_VERSION);
+        } catch (e) {
+            // IndexedDB is missing or disabled
+            callback(null);
+            return;
+        }
+        request.onupgradeneeded = function () {
+            var db = request.result;
+            var datasetStore = db.createObjectStore(DATASET_STORE, {
+                keyPath: "hash",
+            });
+            datasetStore.createIndex("lastUsed", "lastUsed");
+            db.createObjectStore(HEADER_STORE, { keyPath: "hash" });
+            var cmpStore = db.createObjectStore(COMPONENT_STORE, {
+                keyPath: ["hash", "index"],
+            });
+            cmpStore.createIndex("hash", "hash");
+        };
+        request.onsuccess = function () {
+            callback(request.result);
+        };
+        request.onerror = function () {
+            callback(null);
+        };
+        request.onblocked = function () {
+            callback(null);
+        };
+    }
+
+    /**
+     * Loads a dataset from the cache.
+     *
+     * @param {String} hash Hash of the dataset.
+     * @param {Function} callback Called with null if the dataset isn't
+     *                            cached; otherwise, called with an Object
+     *                            with keys "data" (the graph data, as it'd
+     *                            be loaded from data.js) and "indexes" (see
+     *                            DataHolder.getIndexes()).
+     */
+    function load(hash, callback) {
+        // Make sure we call the callback only once, no matter what happens
+        var done = _.once(callback);
+        openDB(function (db) {
+            if (_.isNull(db)) {
+                done(null);
+                return;
+            }
+            var tx;
+            try {
+                tx = db.transaction(ALL_STORES, "readwrite");
+            } catch (e) {
+                db.close();
+                done(null);
+                return;
+            }
+            var dataset = null;
+            var header = null;
+            var components = null;
+            var datasetStore = tx.objectStore(DATASET_STORE);
+            datasetStore.get(hash).onsuccess = function (e) {
+                if (_.isUndefined(e.target.result)) {
+                    return;
+                }
+                dataset = e.target.result;
+                // Remember that we used this dataset, for eviction purposes
+                dataset.lastUsed = Date.now();
+                datasetStore.put(dataset);
+                var headerReq = tx.objectStore(HEADER_STORE).get(hash);
+                headerReq.onsuccess = function () {
+                    header = headerReq.result;
+                };
+                var cmpReq = tx
+                    .objectStore(COMPONENT_STORE)
+                    .index("hash")
+                    .getAll(hash);
+                cmpReq.onsuccess = function () {
+                    components = cmpReq.result;
+                };
+            };
+            tx.oncomplete = function () {
+                db.close();
+                if (
+                    _.isNull(dataset) ||
+                    _.isUndefined(header) ||
+                    _.isNull(header) ||
+                    _.isNull(components) ||
+                    components.length !== dataset.numComponents
+                ) {
+                    done(null);
+                    return;
+                }
+                var data = header.data;
+                data.components = _.map(
+                    _.sortBy(components, "index"),
+                    function (record) {
+                        return record.component;
+                    }
+                );
+                done({ data: data, indexes: header.indexes });
+            };
+            tx.onerror = tx.onabort = function () {
+                db.close();
+                done(null);
+            };
+        });
+    }
+
+    /**
+     * Removes the least recently used datasets from the cache, so that at
+     * most MAX_CACHED_DATASETS are left. Closes db when done.
+     */
+    function evict(db) {
+        var tx = db.transaction(ALL_STORES, "readwrite");
+        var cmpStore = tx.objectStore(COMPONENT_STORE);
+        var numSeen = 0;
+        // Go through datasets from most to least recently used. (This is a
+        // key cursor, so we don't actually load any of the records.)
+        var cursorReq = tx
+            .objectStore(DATASET_STORE)
+            .index("lastUsed")
+            .openKeyCursor(null, "prev");
+        cursorReq.onsuccess = function () {
+            var cursor = cursorReq.result;
+            if (!cursor) {
+                return;
+            }
+            numSeen++;
+            if (numSeen > MAX_CACHED_DATASETS) {
+                var hash = cursor.primaryKey;
+                tx.objectStore(DATASET_STORE).delete(hash);
+                tx.objectStore(HEADER_STORE).delete(hash);
+                cmpStore.delete(
+                    IDBKeyRange.bound([hash, -Infinity], [hash, Infinity])
+                );
+            }
+            cursor.continue();
+        };
+        tx.oncomplete = tx.onerror = tx.onabort = function () {
+            db.close();
+        };
+    }
+
+    /**
+     * Saves a dataset to the cache.
+     *
+     * This doesn't block anything: the data is copied into the cache in the
+     * background (a few components at a time, whenever the browser is idle),
+     * and errors are ignored. The data shouldn't be modified after this is
+     * called, since we won't have copied all of it yet.
+     *
+     * @param {String} hash Hash of the dataset.
+     * @param {Object} data Graph data, as loaded from data.js.
+     * @param {Object} indexes Lookup indexes (see DataHolder.getIndexes()).
+     */
+    function save(hash, data, indexes) {
+        openDB(function (db) {
+            if (_.isNull(db)) {
+                return;
+            }
+            var numComponents = data.components.length;
+            var nextIndex = 0;
+            var close = function () {
+                db.close();
+            };
+
+            // Saves the header and dataset records, once all of the
+            // components are saved
+            var saveHeader = function () {
+                var tx;
+                try {
+                    tx = db.transaction(
+                        [HEADER_STORE, DATASET_STORE],
+                        "readwrite"
+                    );
+                    tx.objectStore(HEADER_STORE).put({
+                        hash: hash,
+                        data: _.omit(data, "components"),
+                        indexes: indexes,
+                    });
+                    tx.objectStore(DATASET_STORE).put({
+                        hash: hash,
+                        numComponents: numComponents,
+                        lastUsed: Date.now(),
+                    });
+                } catch (e) {
+                    db.close();
+                    return;
+                }
+                tx.oncomplete = function () {
+                    evict(db);
+                };
+                tx.onerror = tx.onabort = close;
+            };
+
+            // Saves as many components as we have time for (but at least
+            // one, so we always make progress) in a new transaction
+            var saveComponents = function (timeRemaining) {
+                var tx;
+                try {
+                    tx = db.transaction([COMPONENT_STORE], "readwrite");
+                    var cmpStore = tx.objectStore(COMPONENT_STORE);
+                    do {
+                        cmpStore.put({
+                            hash: hash,
+                            index: nextIndex,
+                            component: data.components[nextIndex],
+                        });
+                        nextIndex++;
+                    } while (nextIndex < numComponents && timeRemaining() > 0);
+                } catch (e) {
+                    db.close();
+                    return;
+                }
+                tx.oncomplete = function () {
+                    if (nextIndex < numComponents) {
+                        whenIdle(saveComponents);
+                    } else {
+                        whenIdle(saveHeader);
+                    }
+                };
+                tx.onerror = tx.onabort = close;
+            };
+
+            if (numComponents > 0) {
+                whenIdle(saveComponents);
+            } else {
+                whenIdle(saveHeader);
+            }
+        });
+    }
+
+    return {
+        load: load,
+        save: save,
+        MAX_CACHED_DATASETS: MAX_CACHED_DATASETS,
+    };
+});
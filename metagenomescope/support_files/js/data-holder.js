@@ -1,7 +1,106 @@
-define(["underscore", "utils"], function (_, utils) {
+define(["require", "underscore", "utils"], function (require, _, utils) {
     class DataHolder {
-        constructor(dataJSON) {
+        /**
+         * Constructs a DataHolder.
+         *
+         * @param {Object} dataJSON Graph data from the python script.
+         * @param {Object} indexes Lookup indexes for this data, as returned
+         *                         by getIndexes() (e.g. if we loaded these
+         *                         from the cache), or null if they haven't
+         *                         been built yet.
+         */
+        constructor(dataJSON, indexes) {
             this.data = dataJSON;
+            // Lookup indexes; see buildIndexes()
+            this.nodeID2cmpIdx = null;
+            this.pattID2loc = null;
+            if (!_.isUndefined(indexes) && !_.isNull(indexes)) {
+                this.nodeID2cmpIdx = indexes.nodeID2cmpIdx;
+                this.pattID2loc = indexes.pattID2loc;
+            }
+            // Side tables of extra node / edge attributes, keyed by
+            // (0-indexed) component index; see loadAttrTable()
+            this.attrTables = {};
+            this.loadingAttrTables = new Set();
+            // Side tables of node annotations, keyed the same way; see
+            // loadAnnotationTables()
+            this.annotationTables = {};
+            // Instanced components that we've expanded so far, keyed by
+            // (0-indexed) component index; see getComponent()
+            this.expandedComponents = {};
+        }
+
+        /**
+         * Returns the data for a component.
+         *
+         * To save space, the python script stores small components that have
+         * the same layout as "instances" of a shared "template" (see
+         * instancing.py). This expands instances into normal components, the
+         * first time we need them.
+         *
+         * @param {Number} cmpIdx 0-indexed component index.
+         *
+         * @returns {Object}
+         */
+        getComponent(cmpIdx) {
+            var cmp = this.data.components[cmpIdx];
+            if (!_.has(cmp, "instance_of")) {
+                return cmp;
+            }
+            if (!_.has(this.expandedComponents, cmpIdx)) {
+                this.expandedComponents[cmpIdx] = this.expandInstance(cmp);
+            }
+            return this.expandedComponents[cmpIdx];
+        }
+
+        /**
+         * Converts an instance into a normal component.
+         *
+         * Templates refer to nodes and patterns by their indices in the
+         * template, so we replace these with the instance's actual IDs.
+         */
+        expandInstance(inst) {
+            var template = this.data.templates[inst.instance_of];
+            var na = this.getNodeAttrs();
+            var ea = this.getEdgeAttrs();
+            var pa = this.getPattAttrs();
+            var pattID = function (i) {
+                return _.isNull(i) ? null : inst.patt_ids[i];
+            };
+            var cmp = {
+                nodes: {},
+                edges: {},
+                patts: [],
+                bb: template.bb,
+                skipped: false,
+                degraded: false,
+                zoom_levels: [],
+                decomposition_truncated: [],
+            };
+            _.each(template.nodes, function (tdata, i) {
+                var data = tdata.slice();
+                data[na.name] = inst.names[i];
+                data[na.length] = inst.lengths[i];
+                data[na.parent_id] = pattID(tdata[na.parent_id]);
+                cmp.nodes[inst.node_ids[i]] = data;
+            });
+            _.each(template.edges, function (tedge) {
+                var src = inst.node_ids[tedge[0]];
+                var tgt = inst.node_ids[tedge[1]];
+                var data = tedge[2].slice();
+                data[ea.parent_id] = pattID(data[ea.parent_id]);
+                if (!_.has(cmp.edges, src)) {
+                    cmp.edges[src] = {};
+                }
+                cmp.edges[src][tgt] = data;
+            });
+            _.each(template.patts, function (tdata) {
+                var data = tdata.slice();
+                data[pa.pattern_id] = pattID(tdata[pa.pattern_id]);
+                data[pa.parent_id] = pattID(tdata[pa.parent_id]);
+                cmp.patts.push(data);
+            });
+            return cmp;
         }
 
         /**
@@ -68,6 +167,25 @@ define(["underscore", "utils"], function (_, utils) {
             return this.data.input_file_basename;
         }
 
+        /**
+         * Returns info about nodes / edges removed during graph simplification.
+         *
+         * This is an object with two keys: "nodes" maps to an array of
+         * [name, reason] arrays, and "edges" maps to an array of
+         * [source name, target name, reason] arrays. The reason is one of
+         * "tip", "low_coverage", or "transitive". (Data generated by older
+         * versions of MetagenomeScope won't have this, so we just act like
+         * nothing was removed in that case.)
+         *
+         * @returns {Object}
+         */
+        removedElements() {
+            if (_.has(this.data, "removed_elements")) {
+                return this.data.removed_elements;
+            }
+            return { nodes: [], edges: [] };
+        }
+
         /**
          * Returns the (1-indexed) number of the first component that we were
          * able to lay out.
@@ -128,7 +246,10 @@ define(["underscore", "utils"], function (_, utils) {
             var matchingCmpIdx = _.findIndex(this.data.components, function (
                 cmp
             ) {
-                if (!cmp.skipped) {
+                if (_.has(cmp, "instance_of")) {
+                    // No need to expand instances; they list their names
+                    return _.contains(cmp.names, queryName);
+                } else if (!cmp.skipped) {
                     // Return true if any of the values in cmp.nodes (the
                     // values in this Object are Arrays of node data) has the
                     // "name" property that matches the query name
@@ -224,7 +345,7 @@ define(["underscore", "utils"], function (_, utils) {
          */
         getPatternsInComponent(sizeRank) {
             this.validateComponentRank(sizeRank);
-            return this.data.components[sizeRank - 1].patts;
+            return this.getComponent(sizeRank - 1).patts;
         }
 
         /**
@@ -234,7 +355,7 @@ define(["underscore", "utils"], function (_, utils) {
          */
         getNodesInComponent(sizeRank) {
             this.validateComponentRank(sizeRank);
-            return this.data.components[sizeRank - 1].nodes;
+            return this.getComponent(sizeRank - 1).nodes;
         }
 
         /**
@@ -244,7 +365,7 @@ define(["underscore", "utils"], function (_, utils) {
          */
         getEdgesInComponent(sizeRank) {
             this.validateComponentRank(sizeRank);
-            return this.data.components[sizeRank - 1].edges;
+            return this.getComponent(sizeRank - 1).edges;
         }
 
         getPattAttrs() {
@@ -267,9 +388,331 @@ define(["underscore", "utils"], function (_, utils) {
             return this.data.extra_edge_attrs;
         }
 
+        /**
+         * Returns true if there are any extra node or edge attributes.
+         *
+         * @returns {Boolean}
+         */
+        hasExtraAttrs() {
+            return (
+                this.getExtraNodeAttrs().length > 0 ||
+                this.getExtraEdgeAttrs().length > 0
+            );
+        }
+
+        /**
+         * Starts loading the side table of extra attributes for a component.
+         *
+         * The python script saves these tables separately from the rest of
+         * the data (see attr_tables.py), since we only need them once
+         * elements are selected. Once a table is loaded, we build lookups
+         * mapping node IDs / "srcID,tgtID" edge IDs to rows in the table.
+         *
+         * @param {Number} cmpIdx 0-indexed component index.
+         * @param {Function} onLoad Called once the table is loaded. (If the
+         *                          table fails to load, we act like it's
+         *                          empty.)
+         */
+        loadAttrTable(cmpIdx, onLoad) {
+            var scope = this;
+            var setTable = function (table) {
+                var node2row = {};
+                _.each(table.node_ids, function (nodeID, r) {
+                    node2row[nodeID] = r;
+                });
+                var edge2row = {};
+                _.each(table.edge_ids, function (edgeID, r) {
+                    edge2row[edgeID[0] + "," + edgeID[1]] = r;
+                });
+                scope.attrTables[cmpIdx] = {
+                    nodeCols: table.node_cols,
+                    edgeCols: table.edge_cols,
+                    node2row: node2row,
+                    edge2row: edge2row,
+                };
+                scope.loadingAttrTables.delete(cmpIdx);
+                onLoad();
+            };
+            this.loadingAttrTables.add(cmpIdx);
+            require(
+                [this.data.attr_tables_dir + "/" + (cmpIdx + 1)],
+                setTable,
+                function () {
+                    setTable({
+                        node_ids: [],
+                        node_cols: {},
+                        edge_ids: [],
+                        edge_cols: {},
+                    });
+                }
+            );
+        }
+
+        /**
+         * Returns the side table for the component containing a node.
+         *
+         * If this table isn't loaded yet, this returns null and starts
+         * loading the table (calling onLoad once it's loaded). If the table is
+         * already being loaded, onLoad is ignored -- so callers can call this
+         * for lots of elements and only get called back once per component.
+         */
+        getAttrTable(nodeID, onLoad) {
+            this.buildIndexes();
+            var cmpIdx = this.nodeID2cmpIdx[nodeID];
+            if (_.has(this.attrTables, cmpIdx)) {
+                return this.attrTables[cmpIdx];
+            }
+            if (!this.loadingAttrTables.has(cmpIdx)) {
+                this.loadAttrTable(cmpIdx, onLoad);
+            }
+            return null;
+        }
+
+        /**
+         * Returns an Object mapping extra node attributes to their values for
+         * a node, or null if these aren't loaded yet (see getAttrTable()).
+         *
+         * Attributes that the node doesn't have are null.
+         */
+        getExtraNodeInfo(nodeID, onLoad) {
+            var table = this.getAttrTable(nodeID, onLoad);
+            if (_.isNull(table)) {
+                return null;
+            }
+            var r = table.node2row[nodeID];
+            var info = {};
+            _.each(this.getExtraNodeAttrs(), function (attr) {
+                info[attr] =
+                    _.isUndefined(r) || !_.has(table.nodeCols, attr)
+                        ? null
+                        : table.nodeCols[attr][r];
+            });
+            return info;
+        }
+
+        /**
+         * Analogue of getExtraNodeInfo() for edges.
+         */
+        getExtraEdgeInfo(srcID, tgtID, onLoad) {
+            var table = this.getAttrTable(srcID, onLoad);
+            if (_.isNull(table)) {
+                return null;
+            }
+            var r = table.edge2row[srcID + "," + tgtID];
+            var info = {};
+            _.each(this.getExtraEdgeAttrs(), function (attr) {
+                info[attr] =
+                    _.isUndefined(r) || !_.has(table.edgeCols, attr)
+                        ? null
+                        : table.edgeCols[attr][r];
+            });
+            return info;
+        }
+
+        /**
+         * Returns info about the node annotation columns (see
+         * annotations.py), or an empty Array if no annotations were given.
+         *
+         * @returns {Array}
+         */
+        getAnnotationColumns() {
+            var annotations = this.data.annotations;
+            if (_.isUndefined(annotations) || _.isNull(annotations)) {
+                return [];
+            }
+            return annotations.columns;
+        }
+
+        /**
+         * Loads the node annotation side tables for some components.
+         *
+         * Only components with at least one annotated node have side tables,
+         * so we don't try to load tables for other components (and treat
+         * them as empty). Tables that fail to load are also treated as empty.
+         *
+         * @param {Array} sizeRanks 1-indexed size ranks of the components.
+         * @param {Function} onLoad Called once all of these components'
+         *                          tables are loaded.
+         */
+        loadAnnotationTables(sizeRanks, onLoad) {
+            var scope = this;
+            var annotations = this.data.annotations;
+            var toLoad = _.filter(sizeRanks, function (sizeRank) {
+                return !_.has(scope.annotationTables, sizeRank - 1);
+            });
+            if (toLoad.length === 0) {
+                onLoad();
+                return;
+            }
+            var done = _.after(toLoad.length, onLoad);
+            _.each(toLoad, function (sizeRank) {
+                var cmpIdx = sizeRank - 1;
+                var setTable = function (table) {
+                    scope.annotationTables[cmpIdx] = table;
+                    done();
+                };
+                if (!_.contains(annotations.components, cmpIdx)) {
+                    setTable({ node_ids: [], cols: {} });
+                    return;
+                }
+                require(
+                    [annotations.dir + "/" + sizeRank],
+                    setTable,
+                    function () {
+                        setTable({ node_ids: [], cols: {} });
+                    }
+                );
+            });
+        }
+
+        /**
+         * Returns the value of a node annotation for every annotated node in
+         * a component, as an Object mapping node IDs to values.
+         *
+         * The component's side table should already be loaded (see
+         * loadAnnotationTables()). Nodes without this annotation aren't
+         * included.
+         *
+         * @param {Number} sizeRank 1-indexed size rank of the component.
+         * @param {String} colName Name of the annotation column.
+         *
+         * @returns {Object}
+         */
+        getNodeAnnotations(sizeRank, colName) {
+            var table = this.annotationTables[sizeRank - 1];
+            var nodeID2val = {};
+            if (!_.has(table.cols, colName)) {
+                return nodeID2val;
+            }
+            var vals = table.cols[colName];
+            _.each(table.node_ids, function (nodeID, r) {
+                if (!_.isNull(vals[r])) {
+                    nodeID2val[nodeID] = vals[r];
+                }
+            });
+            return nodeID2val;
+        }
+
+        /**
+         * Returns the component summary table.
+         *
+         * This maps column names ("nodes", "edges", "patterns", "length",
+         * "n50", "gc", "depth", "status") to Arrays with one value per
+         * component, in size rank order; see component_summary.py in the
+         * python code for details.
+         *
+         * @returns {Object}
+         */
+        getComponentSummary() {
+            return this.data.component_summary;
+        }
+
         getComponentBoundingBox(sizeRank) {
             this.validateComponentRank(sizeRank);
-            return this.data.components[sizeRank - 1].bb;
+            return this.getComponent(sizeRank - 1).bb;
+        }
+
+        /**
+         * Returns the "zoom levels" of a component.
+         *
+         * Only huge components have these (see coarsening.py in the python
+         * code for details); for other components, this is an empty Array.
+         *
+         * @returns {Array}
+         */
+        getZoomLevels(sizeRank) {
+            this.validateComponentRank(sizeRank);
+            var comp = this.getComponent(sizeRank - 1);
+            if (_.has(comp, "zoom_levels")) {
+                return comp.zoom_levels;
+            }
+            return [];
+        }
+
+        /**
+         * Returns info about a component's tile pyramid.
+         *
+         * Only big components have these, and only if -mt was used (see
+         * tiles.py in the python code for details about what's in here);
+         * for other components, this is null.
+         *
+         * @returns {Object or null}
+         */
+        getTiles(sizeRank) {
+            this.validateComponentRank(sizeRank);
+            var comp = this.getComponent(sizeRank - 1);
+            if (_.has(comp, "tiles")) {
+                return comp.tiles;
+            }
+            return null;
+        }
+
+        /**
+         * Builds indexes mapping node IDs to the (0-indexed) components
+         * containing them, and pattern IDs to [component index, index of the
+         * pattern in that component's patts].
+         *
+         * Without these, looking up a node / edge / pattern means checking
+         * every component, which gets really slow when thousands of elements
+         * are selected at once. We only build these the first time we need
+         * them, since the data never changes. (We store indices rather than
+         * references to the components so that the indexes can be cached;
+         * see data-cache.js.)
+         */
+        buildIndexes() {
+            if (!_.isNull(this.nodeID2cmpIdx)) {
+                return;
+            }
+            var nodeID2cmpIdx = {};
+            var pattID2loc = {};
+            var pattIDIdx = this.getPattAttrs().pattern_id;
+            _.each(this.data.components, function (cmp, c) {
+                if (_.has(cmp, "instance_of")) {
+                    // Instances list their IDs in the same order as their
+                    // expanded nodes / patterns (see expandInstance())
+                    _.each(cmp.node_ids, function (nodeID) {
+                        nodeID2cmpIdx[nodeID] = c;
+                    });
+                    _.each(cmp.patt_ids, function (pattID, p) {
+                        pattID2loc[pattID] = [c, p];
+                    });
+                } else if (!cmp.skipped) {
+                    _.each(_.keys(cmp.nodes), function (nodeID) {
+                        nodeID2cmpIdx[nodeID] = c;
+                    });
+                    _.each(cmp.patts, function (patt, p) {
+                        pattID2loc[patt[pattIDIdx]] = [c, p];
+                    });
+                }
+            });
+            this.nodeID2cmpIdx = nodeID2cmpIdx;
+            this.pattID2loc = pattID2loc;
+        }
+
+        /**
+         * Returns the lookup indexes (building them first if needed).
+         *
+         * @returns {Object} With keys nodeID2cmpIdx and pattID2loc.
+         */
+        getIndexes() {
+            this.buildIndexes();
+            return {
+                nodeID2cmpIdx: this.nodeID2cmpIdx,
+                pattID2loc: this.pattID2loc,
+            };
+        }
+
+        /**
+         * Returns the (laid-out) component containing a node.
+         *
+         * @throws {Error} If the node isn't in any laid-out component.
+         */
+        getComponentOfNode(nodeID) {
+            this.buildIndexes();
+            if (_.has(this.nodeID2cmpIdx, nodeID)) {
+                return this.getComponent(this.nodeID2cmpIdx[nodeID]);
+            }
+            throw new Error("Node " + nodeID + " not found in data.");
         }
 
         getNodeInfo(nodeID) {
@@ -280,61 +723,45 @@ define(["underscore", "utils"], function (_, utils) {
             // So we don't need to worry about converting btwn strings/numbers:
             // the data assumes these are strings, and Cytoscape.js assumes
             // these are strings.
-            var nodeAttrs = this.getNodeAttrs();
-            for (var i = 0; i < this.data.components.length; i++) {
-                var cmp = this.data.components[i];
-                if (!cmp.skipped) {
-                    if (_.has(cmp.nodes, nodeID)) {
-                        return cmp.nodes[nodeID];
-                    }
-                }
-            }
-            throw new Error("Node " + nodeID + " not found in data.");
+            return this.getComponentOfNode(nodeID).nodes[nodeID];
         }
 
         getNodeName(nodeID) {
-            for (var i = 0; i < this.data.components.length; i++) {
-                var cmp = this.data.components[i];
-                if (!cmp.skipped) {
-                    if (_.has(cmp.nodes, nodeID)) {
-                        return cmp.nodes[nodeID][this.getNodeAttrs().name];
-                    }
-                }
-            }
-            throw new Error("Node " + nodeID + " not found in data.");
+            return this.getNodeInfo(nodeID)[this.getNodeAttrs().name];
         }
 
         getEdgeInfo(srcID, tgtID) {
-            var edgeAttrs = this.getEdgeAttrs();
-            for (var i = 0; i < this.data.components.length; i++) {
-                var cmp = this.data.components[i];
-                if (!cmp.skipped) {
-                    if (_.has(cmp.edges, srcID)) {
-                        if (_.has(cmp.edges[srcID], tgtID)) {
-                            return cmp.edges[srcID][tgtID];
-                        } else {
-                            // Well, the source node is in this component, but
-                            // it doesn't seem to have an edge to the target
-                            // node. something is seriously wrong.
-                            throw new Error(
-                                "Found source node " +
-                                    srcID +
-                                    " but couldn't " +
-                                    "find an edge from it to the target node " +
-                                    tgtID +
-                                    "."
-                            );
-                        }
-                    }
-                }
+            this.buildIndexes();
+            var cmp = _.has(this.nodeID2cmpIdx, srcID)
+                ? this.getComponent(this.nodeID2cmpIdx[srcID])
+                : undefined;
+            if (_.isUndefined(cmp) || !_.has(cmp.edges, srcID)) {
+                throw new Error(
+                    "Edge from " +
+                        srcID +
+                        " to " +
+                        tgtID +
+                        " not found in data."
+                );
             }
-            throw new Error(
-                "Edge from " + srcID + " to " + tgtID + " not found in data."
-            );
+            var srcEdges = cmp.edges[srcID];
+            if (!_.has(srcEdges, tgtID)) {
+                // Well, the source node is in this component, but it doesn't
+                // seem to have an edge to the target node. something is
+                // seriously wrong.
+                throw new Error(
+                    "Found source node " +
+                        srcID +
+                        " but couldn't " +
+                        "find an edge from it to the target node " +
+                        tgtID +
+                        "."
+                );
+            }
+            return srcEdges[tgtID];
         }
 
         getPatternInfo(pattID) {
-            var pattAttrs = this.getPattAttrs();
             // Cytoscape.js stores IDs as Strings, even though we store
             // pattern IDs as integers. We get around this by just
             // converting the ID Cytoscape.js gives us to an integer, which
@@ -348,15 +775,10 @@ define(["underscore", "utils"], function (_, utils) {
                     "Pattern ID " + pattID + " is not a nonnegative integer."
                 );
             }
-            for (var i = 0; i < this.data.components.length; i++) {
-                var cmp = this.data.components[i];
-                if (!cmp.skipped) {
-                    for (var p = 0; p < cmp.patts.length; p++) {
-                        if (cmp.patts[p][pattAttrs.pattern_id] === intID) {
-                            return cmp.patts[p];
-                        }
-                    }
-                }
+            this.buildIndexes();
+            if (_.has(this.pattID2loc, intID)) {
+                var loc = this.pattID2loc[intID];
+                return this.getComponent(loc[0]).patts[loc[1]];
             }
             throw new Error("Pattern " + pattID + " not found in data.");
         }
@@ -4,7 +4,8 @@ define([
     "cytoscape",
     "cytoscape-expand-collapse",
     "utils",
-], function ($, _, cytoscape, cyEC, utils) {
+    "image-export",
+], function ($, _, cytoscape, cyEC, utils, imageExport) {
     class Drawer {
         /**
          * Constructs a Drawer.
@@ -92,6 +93,35 @@ define([
 
             this.COMPONENT_PADDING = 200;
 
+            // Components with "zoom levels" (huge components that were
+            // coarsened in the python code -- see coarsening.py) are drawn
+            // differently: when zoomed out we draw a coarse version of the
+            // component, and we only draw the actual component once you zoom
+            // in far enough. This maps the size ranks of these components to
+            // info about them; see initZoomComponent().
+            this.zoomComponents = {};
+            // We try not to have more than this many elements in zoom-level
+            // components visible at once. (Elements in other components
+            // don't count towards this.)
+            this.MAX_VISIBLE_ZOOM_ELEMENTS = 3000;
+            // When we show the actual elements of a component with a tile
+            // pyramid, we only draw the ones near the viewport: those within
+            // this fraction of the viewport's width / height of its edges.
+            // (That way, panning a bit doesn't show empty space while we
+            // wait for updateZoomLevels() to add more elements.)
+            this.REAL_ELEMENT_MARGIN = 0.5;
+            // Wait this many ms after the user stops zooming / panning before
+            // checking if we need to change zoom levels
+            this.ZOOM_LEVEL_DEBOUNCE_MS = 150;
+            // Zoom-level component that's shown in the minimap (only
+            // components with tile pyramids can be shown there), or null
+            this.minimapComponent = null;
+
+            // Maps node IDs to the colors they should be drawn with, when
+            // coloring nodes by an annotation (see setNodeColors()). Nodes
+            // not in here are drawn with the normal node color.
+            this.nodeColors = {};
+
             // Used for debugging
             this.VERBOSE = false;
         }
@@ -103,6 +133,8 @@ define([
          */
         destroyGraph() {
             this.cy.destroy();
+            this.zoomComponents = {};
+            this.hideMinimap();
             this.numDrawnNodes = 0;
             this.numDrawnEdges = 0;
             this.numDrawnPatterns = 0;
@@ -274,8 +306,13 @@ define([
                             // "background-color": "data(randColor)",
                         },
                     },
-                    // TODO: add a generalized "colorized" class or something
-                    // for coloring by GC content, coverage, ...
+                    {
+                        // Nodes colored by an annotation; see setNodeColors()
+                        selector: "node.basic.annotated",
+                        style: {
+                            "background-color": "data(annColor)",
+                        },
+                    },
                     {
                         selector: "node.basic.leftdir",
                         style: {
@@ -465,6 +502,53 @@ define([
                             ),
                         },
                     },
+                    {
+                        // Super-nodes and super-edges, used when drawing a
+                        // coarse zoom level of a component
+                        selector: "node.supernode",
+                        style: {
+                            shape: "round-rectangle",
+                            "background-color": "#aaaaaa",
+                            "background-opacity": 0.6,
+                            "border-width": 2,
+                            "border-color": "#555555",
+                            label: "data(superLabel)",
+                            "text-valign": "center",
+                            "min-zoomed-font-size": 12,
+                            "font-size": 48,
+                        },
+                    },
+                    {
+                        selector: "edge.superedge",
+                        style: {
+                            width: "data(thickness)",
+                            "line-color": "#777777",
+                            "curve-style": "straight",
+                        },
+                    },
+                    {
+                        // Tiles from a component's tile pyramid. These are
+                        // just images, so users can't interact with them.
+                        selector: "node.tile",
+                        style: {
+                            shape: "rectangle",
+                            width: "data(w)",
+                            height: "data(h)",
+                            "background-image": "data(url)",
+                            "background-fit": "contain",
+                            // Needed to load images from file:// URLs
+                            "background-image-crossorigin": "null",
+                            "background-opacity": 0,
+                            "border-width": 0,
+                            events: "no",
+                        },
+                    },
+                    {
+                        selector: ".zoomhidden",
+                        style: {
+                            display: "none",
+                        },
+                    },
                     {
                         selector: "edge.low_outlier:selected",
                         style: {
@@ -622,7 +706,12 @@ define([
             if (!_.isNull(parentID)) {
                 nodeData.parent = parentID;
                 if (_.has(this.nodeName2parent, name)) {
-                    this.nodeName2parent[name].push(parentID);
+                    // (Nodes in tiled components can be drawn more than
+                    // once, as the user pans around -- see
+                    // renderRealElements().)
+                    if (!_.contains(this.nodeName2parent[name], parentID)) {
+                        this.nodeName2parent[name].push(parentID);
+                    }
                 } else {
                     this.nodeName2parent[name] = [parentID];
                 }
@@ -643,6 +732,11 @@ define([
                 classes += " is_dup";
             }
 
+            if (_.has(this.nodeColors, nodeID)) {
+                nodeData.annColor = this.nodeColors[nodeID];
+                classes += " annotated";
+            }
+
             var x = dx + nodeVals[nodeAttrs.x];
             var y = dy - nodeVals[nodeAttrs.y];
             var data = {
@@ -875,6 +969,57 @@ define([
             this.cy.on("cxttap", "node.pattern", this.onTogglePatternCollapse);
         }
 
+        /**
+         * Draws all of the patterns, nodes, and edges in a component.
+         *
+         * @param {Number} sizeRank 1-indexed size rank of the component.
+         * @param {DataHolder} dataHolder Object containing graph data.
+         * @param {Number} dx Horizontal offset of the component.
+         * @param {Number} dy Vertical offset of the component.
+         */
+        renderComponent(sizeRank, dataHolder, dx, dy) {
+            var scope = this;
+            // Draw patterns
+            var pattAttrs = dataHolder.getPattAttrs();
+            _.each(dataHolder.getPatternsInComponent(sizeRank), function (
+                pattVals
+            ) {
+                scope.renderPattern(pattAttrs, pattVals, dx, dy);
+            });
+
+            // Draw nodes
+            var node2pos = {};
+            var nodeAttrs = dataHolder.getNodeAttrs();
+            _.each(dataHolder.getNodesInComponent(sizeRank), function (
+                nodeVals,
+                nodeID
+            ) {
+                var pos = scope.renderNode(nodeAttrs, nodeVals, nodeID, dx, dy);
+                node2pos[nodeID] = pos;
+            });
+
+            // Draw edges
+            var edgeAttrs = dataHolder.getEdgeAttrs();
+            // Edges are a bit different: they're structured as
+            // {srcID: {tgtID: edgeVals, tgtID2: edgeVals}, ...}
+            _.each(dataHolder.getEdgesInComponent(sizeRank), function (
+                edgesFromSrcID,
+                srcID
+            ) {
+                _.each(edgesFromSrcID, function (edgeVals, tgtID) {
+                    scope.renderEdge(
+                        edgeAttrs,
+                        edgeVals,
+                        node2pos,
+                        srcID,
+                        tgtID,
+                        dx,
+                        dy
+                    );
+                });
+            });
+        }
+
         /**
          * Draws component(s) in the graph.
          *
@@ -904,51 +1049,13 @@ define([
             var dy = 0;
             var firstCompWidth = null;
             _.each(componentsToDraw, function (sizeRank) {
-                // Draw patterns
-                var pattAttrs = dataHolder.getPattAttrs();
-                _.each(dataHolder.getPatternsInComponent(sizeRank), function (
-                    pattVals
-                ) {
-                    scope.renderPattern(pattAttrs, pattVals, dx, dy);
-                });
-
-                // Draw nodes
-                var node2pos = {};
-                var nodeAttrs = dataHolder.getNodeAttrs();
-                _.each(dataHolder.getNodesInComponent(sizeRank), function (
-                    nodeVals,
-                    nodeID
-                ) {
-                    var pos = scope.renderNode(
-                        nodeAttrs,
-                        nodeVals,
-                        nodeID,
-                        dx,
-                        dy
-                    );
-                    node2pos[nodeID] = pos;
-                });
-
-                // Draw edges
-                var edgeAttrs = dataHolder.getEdgeAttrs();
-                // Edges are a bit different: they're structured as
-                // {srcID: {tgtID: edgeVals, tgtID2: edgeVals}, ...}
-                _.each(dataHolder.getEdgesInComponent(sizeRank), function (
-                    edgesFromSrcID,
-                    srcID
-                ) {
-                    _.each(edgesFromSrcID, function (edgeVals, tgtID) {
-                        scope.renderEdge(
-                            edgeAttrs,
-                            edgeVals,
-                            node2pos,
-                            srcID,
-                            tgtID,
-                            dx,
-                            dy
-                        );
-                    });
-                });
+                if (!_.isNull(dataHolder.getTiles(sizeRank))) {
+                    scope.initTileComponent(sizeRank, dataHolder, dx, dy);
+                } else if (dataHolder.getZoomLevels(sizeRank).length > 0) {
+                    scope.initZoomComponent(sizeRank, dataHolder, dx, dy);
+                } else {
+                    scope.renderComponent(sizeRank, dataHolder, dx, dy);
+                }
 
                 // If we're drawing multiple components at once, let's update
                 // dx and dy so that we can place other components somewhere
@@ -989,6 +1096,703 @@ define([
             });
             this.initPatterns();
             this.finishDraw();
+            if (!_.isEmpty(this.zoomComponents)) {
+                this.updateZoomLevels();
+                this.cy.on(
+                    "viewport",
+                    _.debounce(
+                        this.updateZoomLevels.bind(this),
+                        this.ZOOM_LEVEL_DEBOUNCE_MS
+                    )
+                );
+            }
+            this.initMinimap();
+        }
+
+        /**
+         * Sets up a component that will be drawn using zoom levels.
+         *
+         * To start, we just draw the coarsest zoom level of this component;
+         * after drawing is finished, updateZoomLevels() will pick the right
+         * level to show.
+         *
+         * @param {Number} sizeRank 1-indexed size rank of the component.
+         * @param {DataHolder} dataHolder Object containing graph data.
+         * @param {Number} dx Horizontal offset of the component.
+         * @param {Number} dy Vertical offset of the component.
+         */
+        initZoomComponent(sizeRank, dataHolder, dx, dy) {
+            var levels = dataHolder.getZoomLevels(sizeRank);
+            // Bounding box of the component, in Cytoscape.js coordinates.
+            // (Remember that y-coordinates are flipped.)
+            var box = {
+                x1: Infinity,
+                y1: Infinity,
+                x2: -Infinity,
+                y2: -Infinity,
+            };
+            _.each(_.last(levels).bbs, function (bb) {
+                box.x1 = Math.min(box.x1, dx + bb[0]);
+                box.x2 = Math.max(box.x2, dx + bb[2]);
+                box.y1 = Math.min(box.y1, dy - bb[3]);
+                box.y2 = Math.max(box.y2, dy - bb[1]);
+            });
+            this.zoomComponents[sizeRank] = {
+                sizeRank: sizeRank,
+                levels: levels,
+                levelSizes: _.map(levels, function (level) {
+                    return level.sizes.length;
+                }),
+                fullSize:
+                    _.size(dataHolder.getNodesInComponent(sizeRank)) +
+                    dataHolder.getPatternsInComponent(sizeRank).length,
+                box: box,
+                dataHolder: dataHolder,
+                dx: dx,
+                dy: dy,
+                currLevel: null,
+                // Cytoscape.js collection of the actual elements in this
+                // component, or null if we haven't drawn them yet
+                realEles: null,
+            };
+            this.renderZoomLevel(sizeRank, levels.length - 1);
+        }
+
+        /**
+         * Sets up a component that will be drawn using its tile pyramid.
+         *
+         * These are treated as zoom-level components (and drawn the same
+         * way when we're zoomed in enough to draw the actual component), but
+         * instead of drawing coarsened versions of the component when we're
+         * zoomed out we show the tiles that are on screen. To start, we just
+         * show the level 0 tile, which contains the entire component -- so
+         * this is very fast even for huge components.
+         *
+         * @param {Number} sizeRank 1-indexed size rank of the component.
+         * @param {DataHolder} dataHolder Object containing graph data.
+         * @param {Number} dx Horizontal offset of the component.
+         * @param {Number} dy Vertical offset of the component.
+         */
+        initTileComponent(sizeRank, dataHolder, dx, dy) {
+            var tiles = dataHolder.getTiles(sizeRank);
+            this.zoomComponents[sizeRank] = {
+                sizeRank: sizeRank,
+                tiles: tiles,
+                fullSize:
+                    _.size(dataHolder.getNodesInComponent(sizeRank)) +
+                    dataHolder.getPatternsInComponent(sizeRank).length,
+                // Remember that x-coordinates within a component go from
+                // -width to 0, and that y-coordinates are flipped.
+                box: {
+                    x1: dx - tiles.width,
+                    y1: dy - tiles.height,
+                    x2: dx,
+                    y2: dy,
+                },
+                dataHolder: dataHolder,
+                dx: dx,
+                dy: dy,
+                currLevel: null,
+                realEles: null,
+                // Where the actual elements in this component are; see
+                // getRealIndex()
+                realIndex: null,
+                // Maps names of the tiles currently drawn to their nodes
+                drawnTiles: {},
+            };
+            this.renderTiles(sizeRank, 0, null);
+        }
+
+        /**
+         * Shows the tiles of a component's tile pyramid that are on screen.
+         *
+         * If we're already showing tiles at this level, we only add / remove
+         * the tiles that came onto / went off of the screen since last time.
+         *
+         * @param {Number} sizeRank 1-indexed size rank of the component.
+         * @param {Number} level Level of the pyramid to show.
+         * @param {Object} viewport Current extent of the graph view, or null
+         *                          to show all tiles at this level.
+         */
+        renderTiles(sizeRank, level, viewport) {
+            var scope = this;
+            var zc = this.zoomComponents[sizeRank];
+            var tiles = zc.tiles;
+            if (zc.currLevel !== level) {
+                this.cy.remove(".zoomc" + sizeRank);
+                zc.drawnTiles = {};
+                if (!_.isNull(zc.realEles)) {
+                    zc.realEles.addClass("zoomhidden");
+                }
+            }
+            var extent = tiles.tile_size / (tiles.scale * Math.pow(2, level));
+            var left = zc.box.x1;
+            var top = zc.box.y1;
+            var visible = utils.visibleTiles(
+                tiles.levels[level],
+                extent,
+                left,
+                top,
+                viewport
+            );
+            var visibleSet = {};
+            _.each(visible, function (name) {
+                visibleSet[name] = true;
+            });
+            _.each(_.keys(zc.drawnTiles), function (name) {
+                if (!_.has(visibleSet, name)) {
+                    scope.cy.remove(zc.drawnTiles[name]);
+                    delete zc.drawnTiles[name];
+                }
+            });
+            _.each(visible, function (name) {
+                if (_.has(zc.drawnTiles, name)) {
+                    return;
+                }
+                var ij = name.split("_");
+                zc.drawnTiles[name] = scope.cy.add({
+                    data: {
+                        id: "tile" + sizeRank + "_" + level + "_" + name,
+                        w: extent,
+                        h: extent,
+                        url: tiles.dir + "/" + level + "/" + name + ".svg",
+                    },
+                    position: {
+                        x: left + (parseInt(ij[0]) + 0.5) * extent,
+                        y: top + (parseInt(ij[1]) + 0.5) * extent,
+                    },
+                    classes: "tile zoomc" + sizeRank,
+                    selectable: false,
+                    grabbable: false,
+                });
+            });
+            zc.currLevel = level;
+        }
+
+        /**
+         * Figures out where the actual elements of a tiled component are.
+         *
+         * This is only done once per component, so that panning around
+         * afterwards just involves comparing bounding boxes.
+         *
+         * @param {Object} zc Entry in this.zoomComponents.
+         *
+         * @return {Object} Has the following keys:
+         *                  -patts: Array of {id, parent, box, vals} Objects,
+         *                   in the same order as the component's patterns
+         *                   (so parents come before their children).
+         *                  -pattParents: Maps pattern IDs to parent IDs.
+         *                  -nodes: Maps node IDs to {parent, box, vals}.
+         *                  -nodePos: Maps node IDs to [x, y] positions, as
+         *                   renderEdge() expects.
+         *                  -edges: Array of {src, tgt, parent, box, vals}
+         *                   Objects.
+         *                  Boxes are in Cytoscape.js coordinates.
+         */
+        getRealIndex(zc) {
+            if (!_.isNull(zc.realIndex)) {
+                return zc.realIndex;
+            }
+            var dh = zc.dataHolder;
+            var index = {
+                patts: [],
+                pattParents: {},
+                nodes: {},
+                nodePos: {},
+                edges: [],
+            };
+            var pattAttrs = dh.getPattAttrs();
+            _.each(dh.getPatternsInComponent(zc.sizeRank), function (vals) {
+                var id = vals[pattAttrs.pattern_id];
+                var parent = vals[pattAttrs.parent_id];
+                index.patts.push({
+                    id: id,
+                    parent: parent,
+                    box: {
+                        x1: zc.dx + vals[pattAttrs.left],
+                        y1: zc.dy - vals[pattAttrs.top],
+                        x2: zc.dx + vals[pattAttrs.right],
+                        y2: zc.dy - vals[pattAttrs.bottom],
+                    },
+                    vals: vals,
+                });
+                index.pattParents[id] = parent;
+            });
+            var nodeAttrs = dh.getNodeAttrs();
+            _.each(dh.getNodesInComponent(zc.sizeRank), function (
+                vals,
+                nodeID
+            ) {
+                var x = zc.dx + vals[nodeAttrs.x];
+                var y = zc.dy - vals[nodeAttrs.y];
+                var hw = vals[nodeAttrs.width] / 2;
+                var hh = vals[nodeAttrs.height] / 2;
+                index.nodes[nodeID] = {
+                    parent: vals[nodeAttrs.parent_id],
+                    box: { x1: x - hw, y1: y - hh, x2: x + hw, y2: y + hh },
+                    vals: vals,
+                };
+                index.nodePos[nodeID] = [x, y];
+            });
+            var edgeAttrs = dh.getEdgeAttrs();
+            _.each(dh.getEdgesInComponent(zc.sizeRank), function (
+                edgesFromSrcID,
+                srcID
+            ) {
+                _.each(edgesFromSrcID, function (vals, tgtID) {
+                    var srcPos = index.nodePos[srcID];
+                    var tgtPos = index.nodePos[tgtID];
+                    var box = {
+                        x1: Math.min(srcPos[0], tgtPos[0]),
+                        y1: Math.min(srcPos[1], tgtPos[1]),
+                        x2: Math.max(srcPos[0], tgtPos[0]),
+                        y2: Math.max(srcPos[1], tgtPos[1]),
+                    };
+                    var ctrlPts = vals[edgeAttrs.ctrl_pt_coords] || [];
+                    for (var p = 0; p < ctrlPts.length; p += 2) {
+                        var cx = zc.dx + ctrlPts[p];
+                        var cy = zc.dy - ctrlPts[p + 1];
+                        box.x1 = Math.min(box.x1, cx);
+                        box.y1 = Math.min(box.y1, cy);
+                        box.x2 = Math.max(box.x2, cx);
+                        box.y2 = Math.max(box.y2, cy);
+                    }
+                    index.edges.push({
+                        src: srcID,
+                        tgt: tgtID,
+                        parent: vals[edgeAttrs.parent_id],
+                        box: box,
+                        vals: vals,
+                    });
+                });
+            });
+            zc.realIndex = index;
+            return index;
+        }
+
+        /**
+         * Draws the actual elements of a tiled component that are near the
+         * viewport, replacing its tiles.
+         *
+         * If some of the component's elements are already drawn, we only add
+         * the ones that came near the viewport and remove the ones that went
+         * far away from it since last time. Besides the elements whose
+         * bounding boxes overlap the viewport (plus a margin of
+         * this.REAL_ELEMENT_MARGIN), we draw the endpoints of any edges we
+         * draw and the ancestor patterns of anything we draw, so that the
+         * stuff on screen looks like it would if we drew the entire
+         * component.
+         *
+         * Collapsed patterns are a special case: the expand-collapse
+         * extension is responsible for their descendants, so we keep
+         * collapsed patterns (and their ancestors) around and leave their
+         * descendants alone.
+         *
+         * @param {Number} sizeRank 1-indexed size rank of the component.
+         * @param {Object} viewport Current extent of the graph view, or null
+         *                          to draw the entire component.
+         */
+        renderRealElements(sizeRank, viewport) {
+            var scope = this;
+            var zc = this.zoomComponents[sizeRank];
+            var index = this.getRealIndex(zc);
+            if (zc.currLevel !== -1) {
+                this.cy.remove(".zoomc" + sizeRank);
+                zc.drawnTiles = {};
+            }
+            var drawn = this.cy.collection();
+            if (!_.isNull(zc.realEles)) {
+                // (Elements in collapsed patterns are removed from the graph
+                // by the expand-collapse extension.)
+                drawn = zc.realEles.filter(function (ele) {
+                    return ele.inside();
+                });
+                drawn.removeClass("zoomhidden");
+            }
+
+            var needPatts = {};
+            var needNodes = {};
+            var needEdges = {};
+            var collapsed = {};
+            var needPatt = function (pattID) {
+                while (!_.isNull(pattID) && !_.has(needPatts, pattID)) {
+                    needPatts[pattID] = true;
+                    pattID = index.pattParents[pattID];
+                }
+            };
+            drawn.filter("node.pattern[?isCollapsed]").each(function (patt) {
+                collapsed[patt.id()] = true;
+                needPatt(patt.id());
+            });
+            // Returns true if something with this parent is hidden inside a
+            // collapsed pattern
+            var isHidden = function (pattID) {
+                while (!_.isNull(pattID)) {
+                    if (_.has(collapsed, pattID)) {
+                        return true;
+                    }
+                    pattID = index.pattParents[pattID];
+                }
+                return false;
+            };
+            var area = null;
+            if (!_.isNull(viewport)) {
+                area = utils.expandBox(viewport, this.REAL_ELEMENT_MARGIN);
+            }
+            var isNear = function (item) {
+                return _.isNull(area) || utils.boxesOverlap(item.box, area);
+            };
+            _.each(index.patts, function (patt) {
+                if (isNear(patt) && !isHidden(patt.parent)) {
+                    needPatt(patt.id);
+                }
+            });
+            var needNode = function (nodeID) {
+                needNodes[nodeID] = true;
+                needPatt(index.nodes[nodeID].parent);
+            };
+            _.each(index.nodes, function (node, nodeID) {
+                if (isNear(node) && !isHidden(node.parent)) {
+                    needNode(nodeID);
+                }
+            });
+            _.each(index.edges, function (edge) {
+                if (
+                    isNear(edge) &&
+                    !isHidden(index.nodes[edge.src].parent) &&
+                    !isHidden(index.nodes[edge.tgt].parent)
+                ) {
+                    needEdges[edge.src + "," + edge.tgt] = true;
+                    needPatt(edge.parent);
+                    needNode(edge.src);
+                    needNode(edge.tgt);
+                }
+            });
+
+            // Remove stuff that's gone far away. (Removing a node also
+            // removes its edges, and removing a pattern also removes its
+            // descendants -- but we only remove patterns that don't contain
+            // anything we need.)
+            var stale = drawn.filter(function (ele) {
+                if (ele.isEdge()) {
+                    return !_.has(
+                        needEdges,
+                        ele.data("origSrcID") + "," + ele.data("origTgtID")
+                    );
+                } else if (ele.hasClass("pattern")) {
+                    return !_.has(needPatts, ele.id());
+                }
+                return !_.has(needNodes, ele.id());
+            });
+            stale = stale.union(stale.descendants()).union(
+                stale.connectedEdges().intersection(drawn)
+            );
+            this.numDrawnPatterns -= stale.filter("node.pattern").size();
+            this.numDrawnNodes -= stale.filter("node.basic").size();
+            this.numDrawnEdges -= stale.edges().size();
+            this.cy.remove(stale);
+            drawn = drawn.difference(stale);
+
+            // Add stuff that's come near the viewport
+            var drawnIDs = {};
+            drawn.each(function (ele) {
+                if (ele.isEdge()) {
+                    drawnIDs[
+                        ele.data("origSrcID") + "," + ele.data("origTgtID")
+                    ] = true;
+                } else {
+                    drawnIDs[ele.id()] = true;
+                }
+            });
+            var prevEles = this.cy.elements();
+            var pattAttrs = zc.dataHolder.getPattAttrs();
+            _.each(index.patts, function (patt) {
+                if (_.has(needPatts, patt.id) && !_.has(drawnIDs, patt.id)) {
+                    scope.renderPattern(pattAttrs, patt.vals, zc.dx, zc.dy);
+                }
+            });
+            var nodeAttrs = zc.dataHolder.getNodeAttrs();
+            _.each(needNodes, function (t, nodeID) {
+                if (!_.has(drawnIDs, nodeID)) {
+                    scope.renderNode(
+                        nodeAttrs,
+                        index.nodes[nodeID].vals,
+                        nodeID,
+                        zc.dx,
+                        zc.dy
+                    );
+                }
+            });
+            var edgeAttrs = zc.dataHolder.getEdgeAttrs();
+            _.each(index.edges, function (edge) {
+                var key = edge.src + "," + edge.tgt;
+                if (_.has(needEdges, key) && !_.has(drawnIDs, key)) {
+                    scope.renderEdge(
+                        edgeAttrs,
+                        edge.vals,
+                        index.nodePos,
+                        edge.src,
+                        edge.tgt,
+                        zc.dx,
+                        zc.dy
+                    );
+                }
+            });
+            zc.realEles = drawn.union(this.cy.elements().difference(prevEles));
+            this.initPatterns();
+            zc.currLevel = -1;
+        }
+
+        /**
+         * Draws a zoom level of a component, replacing whatever level of it
+         * was previously drawn.
+         *
+         * @param {Number} sizeRank 1-indexed size rank of the component.
+         * @param {Number} levelIndex Index of the level to draw, or -1 to
+         *                            draw the actual component.
+         */
+        renderZoomLevel(sizeRank, levelIndex) {
+            var scope = this;
+            var zc = this.zoomComponents[sizeRank];
+            if (zc.currLevel === levelIndex) {
+                return;
+            }
+            this.cy.remove(".zoomc" + sizeRank);
+            zc.drawnTiles = {};
+            if (levelIndex === -1) {
+                if (_.isNull(zc.realEles)) {
+                    // First time we're drawing the actual component. Figure
+                    // out which elements are new, so we can hide them later.
+                    var prevEles = this.cy.elements();
+                    this.renderComponent(sizeRank, zc.dataHolder, zc.dx, zc.dy);
+                    zc.realEles = this.cy.elements().difference(prevEles);
+                    this.initPatterns();
+                } else {
+                    zc.realEles.removeClass("zoomhidden");
+                }
+            } else {
+                if (!_.isNull(zc.realEles)) {
+                    zc.realEles.addClass("zoomhidden");
+                }
+                var level = zc.levels[levelIndex];
+                var prefix = "zl" + sizeRank + "_";
+                var classes = "zoomc" + sizeRank;
+                var maxWeight = _.max(
+                    _.map(level.edges, function (e) {
+                        return e[2];
+                    })
+                );
+                _.each(level.bbs, function (bb, i) {
+                    scope.cy.add({
+                        data: {
+                            id: prefix + i,
+                            w: Math.max(bb[2] - bb[0], 1),
+                            h: Math.max(bb[3] - bb[1], 1),
+                            superLabel: level.sizes[i] + " nodes",
+                        },
+                        position: {
+                            x: zc.dx + (bb[0] + bb[2]) / 2,
+                            y: zc.dy - (bb[1] + bb[3]) / 2,
+                        },
+                        classes: "supernode " + classes,
+                    });
+                });
+                _.each(level.edges, function (e) {
+                    scope.cy.add({
+                        data: {
+                            id: prefix + e[0] + "_" + e[1],
+                            source: prefix + e[0],
+                            target: prefix + e[1],
+                            thickness:
+                                scope.MIN_EDGE_THICKNESS +
+                                (e[2] / maxWeight) * scope.EDGE_THICKNESS_RANGE,
+                        },
+                        classes: "superedge " + classes,
+                    });
+                });
+            }
+            zc.currLevel = levelIndex;
+        }
+
+        /**
+         * Draws the appropriate zoom level of each zoom-level component,
+         * based on how much of it is currently visible.
+         *
+         * See utils.chooseZoomLevel() for details.
+         */
+        updateZoomLevels() {
+            var scope = this;
+            var viewport = this.cy.extent();
+            var pxPerUnit = this.cy.zoom() * (window.devicePixelRatio || 1);
+            this.cy.batch(function () {
+                _.each(scope.zoomComponents, function (zc) {
+                    var fraction = utils.visibleFraction(zc.box, viewport);
+                    if (_.has(zc, "tiles")) {
+                        if (
+                            zc.fullSize * fraction <=
+                            scope.MAX_VISIBLE_ZOOM_ELEMENTS
+                        ) {
+                            scope.renderRealElements(zc.sizeRank, viewport);
+                        } else {
+                            scope.renderTiles(
+                                zc.sizeRank,
+                                utils.chooseTileLevel(
+                                    zc.tiles.num_levels,
+                                    zc.tiles.scale,
+                                    pxPerUnit
+                                ),
+                                viewport
+                            );
+                        }
+                        return;
+                    }
+                    var levelIndex = utils.chooseZoomLevel(
+                        zc.levelSizes,
+                        zc.fullSize,
+                        fraction,
+                        scope.MAX_VISIBLE_ZOOM_ELEMENTS
+                    );
+                    scope.renderZoomLevel(zc.sizeRank, levelIndex);
+                });
+            });
+        }
+
+        /**
+         * Draws the actual elements of all zoom-level components.
+         *
+         * Used before stuff (like searching) that needs to see every node.
+         */
+        showAllZoomComponents() {
+            var scope = this;
+            this.cy.batch(function () {
+                _.each(scope.zoomComponents, function (zc) {
+                    if (_.has(zc, "tiles")) {
+                        scope.renderRealElements(zc.sizeRank, null);
+                    } else {
+                        scope.renderZoomLevel(zc.sizeRank, -1);
+                    }
+                });
+            });
+        }
+
+        /**
+         * Shows the minimap, if any of the drawn components have tiles.
+         *
+         * The minimap shows the level 0 tile of the first of these
+         * components, along with a box showing the part of the component
+         * that's currently on screen. Clicking on the minimap moves the view
+         * to that part of the component.
+         */
+        initMinimap() {
+            var scope = this;
+            this.minimapComponent = _.find(
+                _.sortBy(_.values(this.zoomComponents), "sizeRank"),
+                function (zc) {
+                    return _.has(zc, "tiles");
+                }
+            );
+            if (_.isUndefined(this.minimapComponent)) {
+                this.minimapComponent = null;
+                return;
+            }
+            var tiles = this.minimapComponent.tiles;
+            $("#minimapImg").attr("src", tiles.dir + "/0/0_0.svg");
+            $("#minimap").removeClass("notviewable");
+            $("#minimap").on("click", function (e) {
+                scope.panToMinimapPoint(e.offsetX, e.offsetY);
+            });
+            this.cy.on("viewport", this.updateMinimap.bind(this));
+            this.updateMinimap();
+        }
+
+        hideMinimap() {
+            $("#minimap").addClass("notviewable");
+            $("#minimap").off("click");
+            this.minimapComponent = null;
+        }
+
+        /**
+         * Returns the number of graph units per pixel in the minimap.
+         *
+         * (The level 0 tile is a square containing the whole component, with
+         * the component in its top left corner.)
+         */
+        getMinimapUnitsPerPx() {
+            var tiles = this.minimapComponent.tiles;
+            return tiles.tile_size / tiles.scale / $("#minimapImg").width();
+        }
+
+        /**
+         * Moves the box in the minimap to match the current viewport.
+         */
+        updateMinimap() {
+            if (_.isNull(this.minimapComponent)) {
+                return;
+            }
+            var box = this.minimapComponent.box;
+            var viewport = this.cy.extent();
+            var unitsPerPx = this.getMinimapUnitsPerPx();
+            var size = $("#minimapImg").width();
+            var clamp = function (v) {
+                return Math.min(Math.max(v, 0), size);
+            };
+            var x1 = clamp((viewport.x1 - box.x1) / unitsPerPx);
+            var y1 = clamp((viewport.y1 - box.y1) / unitsPerPx);
+            var x2 = clamp((viewport.x2 - box.x1) / unitsPerPx);
+            var y2 = clamp((viewport.y2 - box.y1) / unitsPerPx);
+            $("#minimapViewport").css({
+                left: x1 + "px",
+                top: y1 + "px",
+                width: x2 - x1 + "px",
+                height: y2 - y1 + "px",
+            });
+        }
+
+        /**
+         * Centers the graph view on a point in the minimap.
+         *
+         * @param {Number} mx x-coordinate in the minimap, in pixels.
+         * @param {Number} my y-coordinate in the minimap, in pixels.
+         */
+        panToMinimapPoint(mx, my) {
+            var box = this.minimapComponent.box;
+            var unitsPerPx = this.getMinimapUnitsPerPx();
+            var zoom = this.cy.zoom();
+            this.cy.pan({
+                x: this.cy.width() / 2 - (box.x1 + mx * unitsPerPx) * zoom,
+                y: this.cy.height() / 2 - (box.y1 + my * unitsPerPx) * zoom,
+            });
+        }
+
+        /**
+         * Colors nodes (e.g. based on an annotation).
+         *
+         * Nodes that are already drawn are recolored all at once, in a single
+         * Cytoscape.js batch; nodes drawn later (e.g. when zooming in to a
+         * component with zoom levels) are colored as they're drawn.
+         *
+         * @param {Object} nodeColors Maps node IDs to hex color strings.
+         *                            Nodes not in this Object get the normal
+         *                            node color; so passing {} resets all
+         *                            nodes to the normal color.
+         */
+        setNodeColors(nodeColors) {
+            var scope = this;
+            this.nodeColors = nodeColors;
+            if (_.isNull(this.cy)) {
+                return;
+            }
+            this.cy.batch(function () {
+                scope.cy.nodes("node.basic").forEach(function (node) {
+                    var color = nodeColors[node.id()];
+                    if (_.isUndefined(color)) {
+                        node.removeClass("annotated");
+                    } else {
+                        node.data("annColor", color);
+                        node.addClass("annotated");
+                    }
+                });
+            });
         }
 
         /**
@@ -1126,6 +1930,7 @@ define([
          */
         searchForNodes(nodeNames) {
             var scope = this;
+            this.showAllZoomComponents();
             var eles = this.cy.collection(); // empty collection (for now)
             var newEle;
             var parentID;
@@ -1164,25 +1969,29 @@ define([
         }
 
         /**
-         * Returns a base64-encoded image of the graph.
+         * Creates an ImageExporter for the current graph view.
          *
-         * This is basically just a wrapper for cy.png() or cy.jpg().
+         * Call start() on the returned object to start exporting; see
+         * image-export.js for details.
          *
-         * @param {String} imgType Should be either "PNG" or "JPG".
+         * @param {String} imgType Should be "PNG", "JPG", or "SVG".
+         * @param {Number} dpi Resolution of the exported image.
+         * @param {Object} callbacks Has onProgress, onDone, onError, and
+         *                           onCancel functions.
          *
-         * @returns {String} encodedImage
+         * @returns {ImageExporter} exporter
          *
-         * @throws {Error} if imgType is not "PNG" or "JPG".
+         * @throws {Error} if imgType is not "PNG", "JPG", or "SVG", or if dpi
+         *                 is invalid.
          */
-        exportImage(imgType) {
-            var options = { bg: this.bgColor };
-            if (imgType === "PNG") {
-                return this.cy.png(options);
-            } else if (imgType === "JPG") {
-                return this.cy.jpg(options);
-            } else {
-                throw new Error("Unrecognized imgType: " + imgType);
-            }
+        makeImageExporter(imgType, dpi, callbacks) {
+            return new imageExport.ImageExporter(
+                this.cy,
+                _.extend(
+                    { imgType: imgType, dpi: dpi, bg: this.bgColor },
+                    callbacks
+                )
+            );
         }
     }
     return { Drawer: Drawer };
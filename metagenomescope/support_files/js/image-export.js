@@ -0,0 +1,589 @@
+/* Copyright (C) 2016-- Marcus Fedarko, Jay Ghurye, Todd Treangen, Mihai Pop
+ * Authored by Marcus Fedarko
+ *
+ * This file is part of MetagenomeScope.
+ *
+ * MetagenomeScope is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MetagenomeScope is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MetagenomeScope.  If not, see <http://www.gnu.org/licenses/>.
+ ****
+ * Exporting images of the graph view without freezing the page.
+ *
+ * Cytoscape.js' cy.png() draws the whole image at once on the main thread,
+ * which (for high-DPI exports of big graphs) can hang the page for a while
+ * or just fail once the image is bigger than the browser's max canvas size.
+ * Instead, we do the following:
+ *
+ * - PNG / JPG: we draw the view in tiles the size of the Cytoscape.js
+ *   container (by temporarily zooming in and panning around), and send each
+ *   tile to a web worker that stitches them together on an OffscreenCanvas.
+ * - SVG: we send the visible elements' geometry to the worker in chunks,
+ *   and the worker builds the SVG file from these chunks.
+ *
+ * We yield to the browser between tiles / chunks, so the page stays
+ * responsive and we can show progress and let the user cancel the export.
+ *
+ * Browsers don't allow creating workers from file:// URLs, so the worker's
+ * code is the exportWorkerMain() function below, loaded through a Blob URL.
+ * If workers or OffscreenCanvas aren't available, we run the same code on
+ * the main thread instead.
+ */
+define(["underscore", "utils"], function (_, utils) {
+    // Browsers can't make canvases much bigger than this in either dimension
+    var MAX_RASTER_DIM = 16384;
+    // Number of elements sent to the worker per SVG chunk
+    var SVG_CHUNK_SIZE = 2000;
+
+    /**
+     * Code for the export worker.
+     *
+     * This is converted to a string and run in a worker, so it can't use
+     * anything from outside of this function.
+     *
+     * @param {Object} scope The worker's global scope (or, if we're running
+     *                       this on the main thread, an object with a
+     *                       postMessage() function that we'll add an
+     *                       onmessage() function to).
+     */
+    function exportWorkerMain(scope) {
+        var canvas = null;
+        var ctx = null;
+        var mimeType = null;
+        var svgParts = null;
+
+        function fmt(v) {
+            return v.toFixed(2);
+        }
+
+        function ptsToStr(pts) {
+            return pts
+                .map(function (p) {
+                    return fmt(p[0]) + "," + fmt(p[1]);
+                })
+                .join(" ");
+        }
+
+        // Edges with control points are drawn like Cytoscape.js draws
+        // "unbundled-bezier" edges: as quadratic curves through the
+        // control points, joined at the midpoints between them.
+        function edgeToSVG(e) {
+            var pts = e.pts;
+            var d = "M" + fmt(pts[0][0]) + "," + fmt(pts[0][1]);
+            var last = pts.length - 1;
+            if (pts.length === 2) {
+                d += " L" + fmt(pts[1][0]) + "," + fmt(pts[1][1]);
+            } else {
+                for (var i = 1; i < last; i++) {
+                    var end =
+                        i + 1 < last
+                            ? [
+                                  (pts[i][0] + pts[i + 1][0]) / 2,
+                                  (pts[i][1] + pts[i + 1][1]) / 2,
+                              ]
+                            : pts[last];
+                    d +=
+                        " Q" +
+                        fmt(pts[i][0]) +
+                        "," +
+                        fmt(pts[i][1]) +
+                        " " +
+                        fmt(end[0]) +
+                        "," +
+                        fmt(end[1]);
+                }
+            }
+            var svg =
+                '<path d="' +
+                d +
+                '" fill="none" stroke="' +
+                e.color +
+                '" stroke-width="' +
+                fmt(e.width) +
+                '"/>';
+            // Arrowhead, pointing from the last control point (or the
+            // source) to the target
+            var tip = pts[last];
+            var from = pts[last - 1];
+            var len = Math.hypot(tip[0] - from[0], tip[1] - from[1]);
+            if (len > 0) {
+                var ux = (tip[0] - from[0]) / len;
+                var uy = (tip[1] - from[1]) / len;
+                var size = e.width * 3;
+                var base = [tip[0] - ux * size, tip[1] - uy * size];
+                svg +=
+                    '<polygon points="' +
+                    ptsToStr([
+                        tip,
+                        [base[0] - (uy * size) / 2, base[1] + (ux * size) / 2],
+                        [base[0] + (uy * size) / 2, base[1] - (ux * size) / 2],
+                    ]) +
+                    '" fill="' +
+                    e.color +
+                    '"/>';
+            }
+            return svg;
+        }
+
+        function eleToSVG(e) {
+            if (e.kind === "edge") {
+                return edgeToSVG(e);
+            }
+            var style =
+                'fill="' +
+                e.fill +
+                '" fill-opacity="' +
+                e.fillOpacity +
+                '"' +
+                (e.borderWidth > 0
+                    ? ' stroke="' +
+                      e.borderColor +
+                      '" stroke-width="' +
+                      fmt(e.borderWidth) +
+                      '"'
+                    : "");
+            if (e.polygon !== null) {
+                var pts = [];
+                for (var i = 0; i + 1 < e.polygon.length; i += 2) {
+                    pts.push([
+                        e.x + (e.polygon[i] * e.w) / 2,
+                        e.y + (e.polygon[i + 1] * e.h) / 2,
+                    ]);
+                }
+                return (
+                    '<polygon points="' + ptsToStr(pts) + '" ' + style + "/>"
+                );
+            }
+            return (
+                '<rect x="' +
+                fmt(e.x - e.w / 2) +
+                '" y="' +
+                fmt(e.y - e.h / 2) +
+                '" width="' +
+                fmt(e.w) +
+                '" height="' +
+                fmt(e.h) +
+                '" ' +
+                style +
+                "/>"
+            );
+        }
+
+        function makeCanvas(width, height) {
+            if (typeof OffscreenCanvas !== "undefined") {
+                return new OffscreenCanvas(width, height);
+            }
+            var c = document.createElement("canvas");
+            c.width = width;
+            c.height = height;
+            return c;
+        }
+
+        function canvasToBlob(c, type) {
+            if (c.convertToBlob) {
+                return c.convertToBlob({ type: type, quality: 0.95 });
+            }
+            return new Promise(function (resolve) {
+                c.toBlob(resolve, type, 0.95);
+            });
+        }
+
+        function fail(err) {
+            scope.postMessage({ type: "error", message: String(err) });
+        }
+
+        scope.onmessage = function (e) {
+            var msg = e.data;
+            try {
+                if (msg.type === "initRaster") {
+                    canvas = makeCanvas(msg.width, msg.height);
+                    ctx = canvas.getContext("2d");
+                    mimeType = msg.mimeType;
+                    ctx.fillStyle = msg.bg;
+                    ctx.fillRect(0, 0, msg.width, msg.height);
+                } else if (msg.type === "tile") {
+                    createImageBitmap(msg.blob).then(function (bmp) {
+                        ctx.drawImage(bmp, msg.x, msg.y);
+                        scope.postMessage({ type: "tileDone" });
+                    }, fail);
+                } else if (msg.type === "finishRaster") {
+                    canvasToBlob(canvas, mimeType).then(function (blob) {
+                        canvas = ctx = null;
+                        scope.postMessage({ type: "done", blob: blob });
+                    }, fail);
+                } else if (msg.type === "initSVG") {
+                    svgParts = [
+                        '<svg xmlns="http://www.w3.org/2000/svg" width="' +
+                            fmt(msg.width) +
+                            '" height="' +
+                            fmt(msg.height) +
+                            '" viewBox="' +
+                            msg.viewBox.map(fmt).join(" ") +
+                            '">\n',
+                        '<rect x="' +
+                            fmt(msg.viewBox[0]) +
+                            '" y="' +
+                            fmt(msg.viewBox[1]) +
+                            '" width="' +
+                            fmt(msg.viewBox[2]) +
+                            '" height="' +
+                            fmt(msg.viewBox[3]) +
+                            '" fill="' +
+                            msg.bg +
+                            '"/>\n',
+                    ];
+                } else if (msg.type === "svgChunk") {
+                    svgParts.push(msg.eles.map(eleToSVG).join("\n") + "\n");
+                    scope.postMessage({ type: "chunkDone" });
+                } else if (msg.type === "finishSVG") {
+                    svgParts.push("</svg>\n");
+                    var blob = new Blob(svgParts, { type: "image/svg+xml" });
+                    svgParts = null;
+                    scope.postMessage({ type: "done", blob: blob });
+                }
+            } catch (err) {
+                fail(err);
+            }
+        };
+    }
+
+    /**
+     * Starts the export worker.
+     *
+     * @param {Function} onMessage Called with each message from the worker.
+     *
+     * @returns {Object} Has post(msg) and terminate() functions.
+     */
+    function startWorker(onMessage) {
+        if (
+            typeof Worker !== "undefined" &&
+            typeof OffscreenCanvas !== "undefined"
+        ) {
+            try {
+                var url = URL.createObjectURL(
+                    new Blob(["(" + exportWorkerMain.toString() + ")(self);"], {
+                        type: "text/javascript",
+                    })
+                );
+                var worker = new Worker(url);
+                URL.revokeObjectURL(url);
+                worker.onmessage = function (e) {
+                    onMessage(e.data);
+                };
+                return {
+                    post: function (msg) {
+                        worker.postMessage(msg);
+                    },
+                    terminate: function () {
+                        worker.terminate();
+                    },
+                };
+            } catch (e) {
+                // Fall through to running things on the main thread
+            }
+        }
+        var terminated = false;
+        var fakeScope = {
+            postMessage: function (msg) {
+                if (!terminated) {
+                    onMessage(msg);
+                }
+            },
+        };
+        exportWorkerMain(fakeScope);
+        return {
+            post: function (msg) {
+                // Make this asynchronous, like posting to a real worker
+                setTimeout(function () {
+                    if (!terminated) {
+                        fakeScope.onmessage({ data: msg });
+                    }
+                }, 0);
+            },
+            terminate: function () {
+                terminated = true;
+            },
+        };
+    }
+
+    /**
+     * Returns the info the worker needs to draw a Cytoscape.js element in
+     * an SVG, or null if the element shouldn't be drawn.
+     */
+    function getSVGElementInfo(ele) {
+        if (ele.isEdge()) {
+            var pts = [ele.sourceEndpoint()];
+            var ctrlPts = ele.controlPoints() || ele.segmentPoints() || [];
+            _.each(ctrlPts, function (p) {
+                pts.push(p);
+            });
+            pts.push(ele.targetEndpoint());
+            return {
+                kind: "edge",
+                pts: _.map(pts, function (p) {
+                    return [p.x, p.y];
+                }),
+                color: ele.style("line-color"),
+                width: parseFloat(ele.style("width")),
+            };
+        }
+        // Tiles are images, which we don't bother including
+        if (ele.hasClass("tile")) {
+            return null;
+        }
+        var x, y, w, h;
+        if (ele.isParent()) {
+            // Size / position of compound nodes (uncollapsed patterns) is
+            // determined by their children
+            var bb = ele.boundingBox({ includeLabels: false });
+            x = (bb.x1 + bb.x2) / 2;
+            y = (bb.y1 + bb.y2) / 2;
+            w = bb.w;
+            h = bb.h;
+        } else {
+            x = ele.position("x");
+            y = ele.position("y");
+            w = ele.width();
+            h = ele.height();
+        }
+        var polygon = null;
+        if (ele.style("shape") === "polygon") {
+            polygon = _.map(
+                ele.style("shape-polygon-points").split(/\s+/),
+                parseFloat
+            );
+        }
+        return {
+            kind: "node",
+            x: x,
+            y: y,
+            w: w,
+            h: h,
+            polygon: polygon,
+            fill: ele.style("background-color"),
+            fillOpacity: parseFloat(ele.style("background-opacity")),
+            borderColor: ele.style("border-color"),
+            borderWidth: parseFloat(ele.style("border-width")),
+        };
+    }
+
+    /**
+     * Exports an image of the current graph view.
+     *
+     * Call start() to start exporting, and cancel() to stop. Exactly one of
+     * the onDone / onError / onCancel callbacks will be called.
+     */
+    class ImageExporter {
+        /**
+         * @param {Cytoscape} cy Instance of Cytoscape.js to export.
+         * @param {Object} options Has the following keys:
+         *     imgType: "PNG", "JPG", or "SVG"
+         *     dpi: Resolution of the image. 96 DPI matches the size of the
+         *          graph view on the screen.
+         *     bg: Background color
+         *     onProgress: Called with a Number in [0, 1]
+         *     onDone: Called with a Blob of the finished image
+         *     onError: Called with an error message
+         *     onCancel: Called after the export is cancelled
+         *
+         * @throws {Error} If imgType is invalid.
+         */
+        constructor(cy, options) {
+            if (!_.contains(["PNG", "JPG", "SVG"], options.imgType)) {
+                throw new Error("Unrecognized imgType: " + options.imgType);
+            }
+            this.cy = cy;
+            this.options = options;
+            this.scale = utils.dpiToScale(options.dpi);
+            this.worker = null;
+            this.finished = false;
+            // Viewport to restore after drawing raster tiles
+            this.origZoom = null;
+            this.origPan = null;
+        }
+
+        start() {
+            this.worker = startWorker(this.onWorkerMessage.bind(this));
+            if (this.options.imgType === "SVG") {
+                this.startSVG();
+            } else {
+                this.startRaster();
+            }
+        }
+
+        startRaster() {
+            var grid = utils.getExportTileGrid(
+                this.cy.width(),
+                this.cy.height(),
+                this.scale
+            );
+            if (Math.max(grid.width, grid.height) > MAX_RASTER_DIM) {
+                this.finish("onError", [
+                    "A " +
+                        grid.width +
+                        " x " +
+                        grid.height +
+                        " image is too big for the browser to draw. " +
+                        "Try a lower DPI, or export an SVG instead.",
+                ]);
+                return;
+            }
+            this.tiles = grid.tiles;
+            this.nextTile = 0;
+            this.numTilesDrawn = 0;
+            this.origZoom = this.cy.zoom();
+            this.origPan = _.clone(this.cy.pan());
+            this.worker.post({
+                type: "initRaster",
+                width: grid.width,
+                height: grid.height,
+                bg: this.options.bg,
+                mimeType:
+                    this.options.imgType === "PNG" ? "image/png" : "image/jpeg",
+            });
+            this.drawNextTile();
+        }
+
+        /**
+         * Draws the next raster tile and sends it to the worker.
+         *
+         * A tile is just whatever's visible in the Cytoscape.js container
+         * after zooming in by the export scale and panning over to it.
+         */
+        drawNextTile() {
+            var scope = this;
+            if (this.finished) {
+                return;
+            }
+            if (this.nextTile >= this.tiles.length) {
+                this.restoreViewport();
+                this.worker.post({ type: "finishRaster" });
+                return;
+            }
+            var tile = this.tiles[this.nextTile];
+            this.nextTile++;
+            this.cy.viewport({
+                zoom: this.origZoom * this.scale,
+                pan: {
+                    x: this.origPan.x * this.scale - tile.x,
+                    y: this.origPan.y * this.scale - tile.y,
+                },
+            });
+            this.cy
+                .png({ output: "blob-promise", bg: this.options.bg })
+                .then(function (blob) {
+                    if (!scope.finished) {
+                        scope.worker.post({
+                            type: "tile",
+                            blob: blob,
+                            x: tile.x,
+                            y: tile.y,
+                        });
+                        // Give the browser a chance to breathe
+                        setTimeout(scope.drawNextTile.bind(scope), 0);
+                    }
+                });
+        }
+
+        startSVG() {
+            var ext = this.cy.extent();
+            // Draw patterns first (parents before children), then edges,
+            // then nodes
+            var patterns = this.cy
+                .nodes(".pattern")
+                .filter(":visible")
+                .sort(function (a, b) {
+                    return a.ancestors().length - b.ancestors().length;
+                });
+            var eles = patterns
+                .union(this.cy.edges().filter(":visible"))
+                .union(this.cy.nodes().not(".pattern").filter(":visible"));
+            this.svgEles = eles.toArray();
+            this.nextEle = 0;
+            this.numChunksDone = 0;
+            this.numChunks = Math.max(
+                Math.ceil(this.svgEles.length / SVG_CHUNK_SIZE),
+                1
+            );
+            this.worker.post({
+                type: "initSVG",
+                width: this.cy.width() * this.scale,
+                height: this.cy.height() * this.scale,
+                viewBox: [ext.x1, ext.y1, ext.w, ext.h],
+                bg: this.options.bg,
+            });
+            this.sendNextSVGChunk();
+        }
+
+        sendNextSVGChunk() {
+            if (this.finished) {
+                return;
+            }
+            if (this.nextEle >= this.svgEles.length) {
+                this.worker.post({ type: "finishSVG" });
+                return;
+            }
+            var chunk = this.svgEles.slice(
+                this.nextEle,
+                this.nextEle + SVG_CHUNK_SIZE
+            );
+            this.nextEle += SVG_CHUNK_SIZE;
+            this.worker.post({
+                type: "svgChunk",
+                eles: _.compact(_.map(chunk, getSVGElementInfo)),
+            });
+            setTimeout(this.sendNextSVGChunk.bind(this), 0);
+        }
+
+        onWorkerMessage(msg) {
+            if (this.finished) {
+                return;
+            }
+            if (msg.type === "tileDone") {
+                this.numTilesDrawn++;
+                this.options.onProgress(this.numTilesDrawn / this.tiles.length);
+            } else if (msg.type === "chunkDone") {
+                this.numChunksDone++;
+                this.options.onProgress(this.numChunksDone / this.numChunks);
+            } else if (msg.type === "done") {
+                this.finish("onDone", [msg.blob]);
+            } else if (msg.type === "error") {
+                this.finish("onError", [msg.message]);
+            }
+        }
+
+        restoreViewport() {
+            if (!_.isNull(this.origZoom)) {
+                this.cy.viewport({ zoom: this.origZoom, pan: this.origPan });
+                this.origZoom = null;
+            }
+        }
+
+        finish(callbackName, args) {
+            if (this.finished) {
+                return;
+            }
+            this.finished = true;
+            this.restoreViewport();
+            if (!_.isNull(this.worker)) {
+                this.worker.terminate();
+            }
+            this.svgEles = null;
+            this.options[callbackName].apply(null, args);
+        }
+
+        cancel() {
+            this.finish("onCancel", []);
+        }
+    }
+
+    return { ImageExporter: ImageExporter, MAX_RASTER_DIM: MAX_RASTER_DIM };
+});
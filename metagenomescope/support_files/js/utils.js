@@ -31,9 +31,9 @@ define(["underscore"], function (_) {
     function getNodeColorization(perc, minRGB, maxRGB) {
         // Linearly scale each RGB value between the extreme colors'
         // corresponding RGB values
-        var red_i = perc * (mgsc.MAX_RGB.r - mgsc.MIN_RGB.r) + mgsc.MIN_RGB.r;
-        var green_i = perc * (mgsc.MAX_RGB.g - mgsc.MIN_RGB.g) + mgsc.MIN_RGB.g;
-        var blue_i = perc * (mgsc.MAX_RGB.b - mgsc.MIN_RGB.b) + mgsc.MIN_RGB.b;
+        var red_i = perc * (maxRGB.r - minRGB.r) + minRGB.r;
+        var green_i = perc * (maxRGB.g - minRGB.g) + minRGB.g;
+        var blue_i = perc * (maxRGB.b - minRGB.b) + minRGB.b;
         // Convert resulting RGB decimal values (should be in the range [0, 255])
         // to hexadecimal and use them to construct a color string
         var red = Math.round(red_i).toString(16);
@@ -295,6 +295,394 @@ define(["underscore"], function (_) {
         return timestamp;
     }
 
+    /**
+     * Returns the fraction of a box's area that's within another box.
+     *
+     * Used to figure out how much of a component is currently visible.
+     *
+     * @param {Object} box Has x1, y1, x2, y2 attributes, where (x1, y1) is
+     *                     the top-left corner and (x2, y2) is the bottom-right
+     *                     corner (as in Cytoscape.js' extent()).
+     * @param {Object} viewport Same format as box.
+     *
+     * @returns {Number} Value in the range [0, 1]. If box has no area, this
+     *                   is 1 if box is within the viewport and 0 otherwise.
+     */
+    function visibleFraction(box, viewport) {
+        var w = Math.min(box.x2, viewport.x2) - Math.max(box.x1, viewport.x1);
+        var h = Math.min(box.y2, viewport.y2) - Math.max(box.y1, viewport.y1);
+        if (w < 0 || h < 0) {
+            return 0;
+        }
+        var area = (box.x2 - box.x1) * (box.y2 - box.y1);
+        if (area <= 0) {
+            return 1;
+        }
+        return Math.min((w * h) / area, 1);
+    }
+
+    /**
+     * Grows a box by a fraction of its width and height on every side.
+     *
+     * @param {Object} box Has x1, y1, x2, y2 attributes (as in
+     *                     Cytoscape.js' extent()).
+     * @param {Number} fraction How much to grow the box by. (0.5 means that
+     *                          the box's width and height are doubled.)
+     *
+     * @returns {Object} New box, in the same format.
+     */
+    function expandBox(box, fraction) {
+        var mx = (box.x2 - box.x1) * fraction;
+        var my = (box.y2 - box.y1) * fraction;
+        return {
+            x1: box.x1 - mx,
+            y1: box.y1 - my,
+            x2: box.x2 + mx,
+            y2: box.y2 + my,
+        };
+    }
+
+    /**
+     * Returns true if two boxes overlap (just touching counts), else false.
+     *
+     * @param {Object} a Has x1, y1, x2, y2 attributes.
+     * @param {Object} b Same format as a.
+     *
+     * @returns {Boolean}
+     */
+    function boxesOverlap(a, b) {
+        return a.x1 <= b.x2 && b.x1 <= a.x2 && a.y1 <= b.y2 && b.y1 <= a.y2;
+    }
+
+    /**
+     * Decides which "zoom level" of a component to draw.
+     *
+     * We want to draw as much detail as we can without drawing more than
+     * maxVisible elements on the screen at once. We assume elements are
+     * spread out evenly over the component, so if (say) half of the
+     * component is visible, then about half of its elements are visible.
+     *
+     * @param {Array} levelSizes Number of super-nodes in each zoom level,
+     *                           from finest to coarsest.
+     * @param {Number} fullSize Number of elements in the actual component.
+     * @param {Number} fraction Fraction of the component that's currently
+     *                          visible (see visibleFraction()).
+     * @param {Number} maxVisible Max number of elements we want visible.
+     *
+     * @returns {Number} -1 if we should draw the actual component; otherwise,
+     *                   the index of the zoom level to draw. If even the
+     *                   coarsest level is too big, returns the coarsest level.
+     */
+    function chooseZoomLevel(levelSizes, fullSize, fraction, maxVisible) {
+        if (fullSize * fraction <= maxVisible) {
+            return -1;
+        }
+        for (var i = 0; i < levelSizes.length; i++) {
+            if (levelSizes[i] * fraction <= maxVisible) {
+                return i;
+            }
+        }
+        return levelSizes.length - 1;
+    }
+
+    /**
+     * Decides which level of a component's tile pyramid to show.
+     *
+     * Level z of the pyramid is drawn at (baseScale * 2^z) pixels per unit.
+     * We pick the coarsest level that's at least as detailed as the screen,
+     * so that tiles are never stretched out (or, if we're zoomed in past
+     * the finest level, the finest level).
+     *
+     * @param {Number} numLevels Number of levels in the pyramid.
+     * @param {Number} baseScale Pixels per unit at level 0.
+     * @param {Number} pxPerUnit Current on-screen pixels per unit (i.e. the
+     *                           Cytoscape.js zoom, times the device pixel
+     *                           ratio).
+     *
+     * @returns {Number} Index of the level to show, in [0, numLevels - 1].
+     */
+    function chooseTileLevel(numLevels, baseScale, pxPerUnit) {
+        if (pxPerUnit <= baseScale) {
+            return 0;
+        }
+        var level = Math.ceil(Math.log2(pxPerUnit / baseScale) - 1e-9);
+        return Math.min(level, numLevels - 1);
+    }
+
+    /**
+     * Figures out which tiles at a level of a tile pyramid are on screen.
+     *
+     * Tile names are of the form "i_j", where i is the column and j is the
+     * row; the tile i_j covers [left + i * extent, left + (i + 1) * extent]
+     * horizontally and [top + j * extent, top + (j + 1) * extent]
+     * vertically.
+     *
+     * @param {Array} tileNames Names of the tiles that exist at this level.
+     * @param {Number} extent Width / height of each tile, in graph units.
+     * @param {Number} left Left x-coordinate of the tile grid.
+     * @param {Number} top Top y-coordinate of the tile grid.
+     * @param {Object} viewport Has x1, y1, x2, y2 properties (e.g. the
+     *                          output of cy.extent()). If this is null, all
+     *                          tiles are returned.
+     *
+     * @returns {Array} Names of the tiles that overlap with the viewport.
+     */
+    function visibleTiles(tileNames, extent, left, top, viewport) {
+        if (_.isNull(viewport)) {
+            return tileNames;
+        }
+        var iMin = Math.floor((viewport.x1 - left) / extent);
+        var iMax = Math.floor((viewport.x2 - left) / extent);
+        var jMin = Math.floor((viewport.y1 - top) / extent);
+        var jMax = Math.floor((viewport.y2 - top) / extent);
+        return _.filter(tileNames, function (name) {
+            var ij = name.split("_");
+            var i = parseInt(ij[0]);
+            var j = parseInt(ij[1]);
+            return i >= iMin && i <= iMax && j >= jMin && j <= jMax;
+        });
+    }
+
+    /**
+     * Figures out which rows of a long, scrollable list should be drawn.
+     *
+     * Assumes all rows have the same height.
+     *
+     * @param {Number} scrollTop How far the list is scrolled down, in
+     *                           pixels. (Can be negative if there's other
+     *                           stuff above the list.)
+     * @param {Number} viewHeight Height of the visible area, in pixels.
+     * @param {Number} rowHeight Height of each row, in pixels.
+     * @param {Number} numRows Total number of rows.
+     * @param {Number} overscan Number of extra rows to draw above and below
+     *                          the visible rows, so that scrolling a bit
+     *                          doesn't show empty space.
+     *
+     * @returns {Object} Has start and end properties: rows with indices in
+     *                   [start, end) should be drawn.
+     */
+    function getVisibleRowRange(
+        scrollTop,
+        viewHeight,
+        rowHeight,
+        numRows,
+        overscan
+    ) {
+        var top = Math.max(scrollTop, 0);
+        var bottom = Math.max(scrollTop + viewHeight, 0);
+        var start = Math.max(Math.floor(top / rowHeight) - overscan, 0);
+        var end = Math.min(Math.ceil(bottom / rowHeight) + overscan, numRows);
+        return { start: Math.min(start, end), end: end };
+    }
+
+    /**
+     * Converts an image export resolution (in DPI) to a scale factor.
+     *
+     * We treat the graph view as being drawn at 96 DPI (the CSS "pixel"), so
+     * exporting at 96 DPI gives an image the size of the view, 192 DPI gives
+     * an image twice as wide and tall, etc.
+     *
+     * @param {Number} dpi
+     *
+     * @returns {Number} scale
+     *
+     * @throws {Error} If dpi isn't a positive finite number.
+     */
+    function dpiToScale(dpi) {
+        if (!_.isNumber(dpi) || !_.isFinite(dpi) || dpi <= 0) {
+            throw new Error("DPI must be a positive number");
+        }
+        return dpi / 96;
+    }
+
+    /**
+     * Splits up an exported image into tiles the size of the graph view.
+     *
+     * @param {Number} viewWidth Width of the graph view, in pixels.
+     * @param {Number} viewHeight Height of the graph view, in pixels.
+     * @param {Number} scale Scale factor of the exported image (see
+     *                       dpiToScale()).
+     *
+     * @returns {Object} Has width and height properties (the size of the
+     *                   exported image, in pixels) and a tiles property: an
+     *                   Array of {x, y} Objects, giving the top-left corner
+     *                   of each tile in the exported image. Tiles are in
+     *                   row-major order.
+     */
+    function getExportTileGrid(viewWidth, viewHeight, scale) {
+        var width = Math.max(Math.ceil(viewWidth * scale), 1);
+        var height = Math.max(Math.ceil(viewHeight * scale), 1);
+        var tiles = [];
+        for (var y = 0; y < height; y += viewHeight) {
+            for (var x = 0; x < width; x += viewWidth) {
+                tiles.push({ x: x, y: y });
+            }
+        }
+        return { width: width, height: height, tiles: tiles };
+    }
+
+    /**
+     * Parses the text of a component browser filter.
+     *
+     * A filter is a whitespace-separated list of conditions like "nodes>=10"
+     * or "status=degraded", all of which must be true for a component to be
+     * shown. The operators are =, !=, <, <=, >, and >=; only = and != can be
+     * used with non-numeric columns.
+     *
+     * @param {String} text
+     * @param {Array} numericCols Names of the numeric columns.
+     * @param {Array} textCols Names of the non-numeric columns.
+     *
+     * @returns {Array} Array of Objects with col, op, and value keys.
+     *
+     * @throws {Error} If any condition is invalid.
+     */
+    function parseComponentFilter(text, numericCols, textCols) {
+        var terms = text.trim().split(/\s+/);
+        if (terms.length === 1 && terms[0] === "") {
+            return [];
+        }
+        return _.map(terms, function (term) {
+            var match = term.match(/^([a-z0-9_]+)(>=|<=|!=|=|<|>)(.+)$/i);
+            if (_.isNull(match)) {
+                throw new Error('Invalid filter condition: "' + term + '"');
+            }
+            var col = match[1].toLowerCase();
+            var op = match[2];
+            var value = match[3];
+            if (_.contains(numericCols, col)) {
+                value = parseFloat(value);
+                if (!_.isFinite(value)) {
+                    throw new Error(
+                        'Invalid number in filter condition: "' + term + '"'
+                    );
+                }
+            } else if (_.contains(textCols, col)) {
+                if (op !== "=" && op !== "!=") {
+                    throw new Error(
+                        'Column "' + col + '" can only be used with = or !='
+                    );
+                }
+            } else {
+                throw new Error('Unrecognized column in filter: "' + col + '"');
+            }
+            return { col: col, op: op, value: value };
+        });
+    }
+
+    /**
+     * Filters and sorts the components in a component summary table.
+     *
+     * @param {Object} summary Maps column names to Arrays of values, one per
+     *                         component (in size rank order).
+     * @param {Array} conditions Output of parseComponentFilter().
+     * @param {String} sortCol Column to sort by, or "rank" to sort by size
+     *                         rank.
+     * @param {Boolean} ascending
+     *
+     * @returns {Array} Size ranks (1-indexed) of the components that pass
+     *                  the filter, sorted. Components with a null value in
+     *                  sortCol are always placed last, and ties are broken by
+     *                  size rank. Null values never pass conditions (except
+     *                  for "!=").
+     */
+    function filterAndSortComponents(summary, conditions, sortCol, ascending) {
+        var numCmps = summary.status.length;
+        var passes = function (i) {
+            return _.every(conditions, function (cond) {
+                var v = summary[cond.col][i];
+                if (cond.op === "!=") {
+                    return v !== cond.value;
+                }
+                if (_.isNull(v)) {
+                    return false;
+                }
+                switch (cond.op) {
+                    case "=":
+                        return v === cond.value;
+                    case "<":
+                        return v < cond.value;
+                    case "<=":
+                        return v <= cond.value;
+                    case ">":
+                        return v > cond.value;
+                    case ">=":
+                        return v >= cond.value;
+                    default:
+                        throw new Error("Unrecognized operator: " + cond.op);
+                }
+            });
+        };
+        var idxs = _.filter(_.range(numCmps), passes);
+        if (sortCol !== "rank") {
+            var col = summary[sortCol];
+            var dir = ascending ? 1 : -1;
+            idxs.sort(function (a, b) {
+                var va = col[a];
+                var vb = col[b];
+                if (_.isNull(va) !== _.isNull(vb)) {
+                    return _.isNull(va) ? 1 : -1;
+                }
+                if (!_.isNull(va) && va !== vb) {
+                    return va < vb ? -dir : dir;
+                }
+                return a - b;
+            });
+        } else if (!ascending) {
+            idxs.reverse();
+        }
+        return _.map(idxs, function (i) {
+            return i + 1;
+        });
+    }
+
+    // Colors used for categorical node annotations. (These are the
+    // "Tableau 10" colors.) If there are more categories than colors, we
+    // cycle back through them.
+    var CATEGORY_COLORS = [
+        "#4e79a7",
+        "#f28e2b",
+        "#e15759",
+        "#76b7b2",
+        "#59a14f",
+        "#edc948",
+        "#b07aa1",
+        "#ff9da7",
+        "#9c755f",
+        "#bab0ac",
+    ];
+
+    // Ends of the color scale used for numeric node annotations
+    var NUMERIC_MIN_RGB = { r: 255, g: 255, b: 204 };
+    var NUMERIC_MAX_RGB = { r: 189, g: 0, b: 38 };
+
+    /**
+     * Returns the color of a node annotation value.
+     *
+     * @param {Object} column Info about an annotation column, as produced by
+     *                        annotations.py in the python code. Values in
+     *                        "categorical" columns are indices into
+     *                        column.values; values in "numeric" columns are
+     *                        scaled between column.min and column.max.
+     * @param {Number} value Value of this annotation for a node, or null if
+     *                       the node doesn't have this annotation.
+     *
+     * @returns {String} Hex color string of the format #RRGGBB, or null if
+     *                   value is null.
+     */
+    function getAnnotationColor(column, value) {
+        if (_.isNull(value) || _.isUndefined(value)) {
+            return null;
+        }
+        if (column.type === "categorical") {
+            return CATEGORY_COLORS[value % CATEGORY_COLORS.length];
+        }
+        var range = column.max - column.min;
+        var perc = range > 0 ? (value - column.min) / range : 0;
+        perc = Math.min(Math.max(perc, 0), 1);
+        return getNodeColorization(perc, NUMERIC_MIN_RGB, NUMERIC_MAX_RGB);
+    }
+
     return {
         getNodeColorization: getNodeColorization,
         distance: distance,
@@ -306,5 +694,18 @@ define(["underscore"], function (_) {
         getFancyTimestamp: getFancyTimestamp,
         leftPad: leftPad,
         throwErrOnEmptyOrWhitespace: throwErrOnEmptyOrWhitespace,
+        visibleFraction: visibleFraction,
+        expandBox: expandBox,
+        boxesOverlap: boxesOverlap,
+        chooseZoomLevel: chooseZoomLevel,
+        chooseTileLevel: chooseTileLevel,
+        visibleTiles: visibleTiles,
+        getVisibleRowRange: getVisibleRowRange,
+        dpiToScale: dpiToScale,
+        getExportTileGrid: getExportTileGrid,
+        parseComponentFilter: parseComponentFilter,
+        filterAndSortComponents: filterAndSortComponents,
+        getAnnotationColor: getAnnotationColor,
+        CATEGORY_COLORS: CATEGORY_COLORS,
     };
 });
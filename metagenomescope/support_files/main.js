@@ -11,6 +11,9 @@ requirejs.config({
         cytoscape: "../vendor/js/cytoscape.min",
         "cytoscape-expand-collapse": "../vendor/js/cytoscape-expand-collapse",
         "bootstrap-colorpicker": "../vendor/js/bootstrap-colorpicker.min",
+        data: "../data",
+        attrs: "../attrs",
+        annotations: "../annotations",
     },
     shim: {
         bootstrap: { deps: ["jquery"] },
@@ -21,6 +24,7 @@ requirejs(
     [
         "app-manager",
         "data-holder",
+        "data-cache",
         "drawer",
         "utils",
         "dom-utils",
@@ -31,10 +35,22 @@ requirejs(
         "cytoscape",
         "cytoscape-expand-collapse",
     ],
-    function (AppManager, DataHolder, Drawer, Utils, DomUtils, $, _, bootstrap, bootstrapColorpicker, cy, cyEC) {
-        // Get the graph data JSON from the preprocessing script.
-        var dataJSON = {{ dataJSON }};
-        var dh = new DataHolder.DataHolder(dataJSON);
-        new AppManager.AppManager(dh);
+    function (AppManager, DataHolder, DataCache, Drawer, Utils, DomUtils, $, _, bootstrap, bootstrapColorpicker, cy, cyEC) {
+        // Hash of the graph data from the preprocessing script. If we've
+        // opened this data before, we can load it from the cache instead of
+        // loading (and parsing) data.js again.
+        var dataHash = "{{ dataHash }}";
+        DataCache.load(dataHash, function (cached) {
+            if (!_.isNull(cached)) {
+                var dh = new DataHolder.DataHolder(cached.data, cached.indexes);
+                new AppManager.AppManager(dh);
+            } else {
+                requirejs(["data"], function (dataJSON) {
+                    var dh = new DataHolder.DataHolder(dataJSON, null);
+                    new AppManager.AppManager(dh);
+                    DataCache.save(dataHash, dataJSON, dh.getIndexes());
+                });
+            }
+        });
     }
 );
@@ -0,0 +1,152 @@
+# Tests parsing graphs with assume_oriented=True (-ao / --assume-oriented), in
+# which we don't create reverse-complement nodes and edges.
+import pytest
+from metagenomescope.assembly_graph_parser import (
+    parse,
+    parse_gfa,
+    parse_lastgraph,
+    orient_edge,
+)
+from metagenomescope.graph_objects import AssemblyGraph, PagedAssemblyGraph
+from metagenomescope.graph_info import GraphInfo
+from metagenomescope.tests.assembly_graph_parser.test_validate_lastgraph import (
+    reset_glines,
+)
+
+
+def write_graph(tmp_path, suffix, lines):
+    fn = str(tmp_path / ("graph." + suffix))
+    with open(fn, "w") as f:
+        f.write("\n".join(lines))
+    return fn
+
+
+def test_orient_edge():
+    n2o = {}
+    assert orient_edge("A", "+", "B", "+", n2o) == ("A", "B")
+    assert orient_edge("B", "+", "C", "-", n2o) == ("B", "C")
+    # Reverse complement of D+ -> A+
+    assert orient_edge("A", "-", "D", "-", n2o) == ("D", "A")
+    assert n2o == {"A": "+", "B": "+", "C": "-", "D": "+"}
+    with pytest.raises(ValueError) as ei:
+        orient_edge("C", "+", "E", "+", n2o)
+    assert "Node C is used in both orientations" in str(ei.value)
+    # With check=False, we just keep the first orientation we saw
+    assert orient_edge("C", "+", "E", "+", n2o, check=False) == ("C", "E")
+    assert n2o["C"] == "-"
+
+
+def test_parse_gfa_oriented():
+    digraph = parse_gfa(
+        "metagenomescope/tests/input/sample1.gfa", assume_oriented=True
+    )
+    # Normally there are 12 nodes and 8 edges in this graph
+    assert sorted(digraph.nodes) == ["1", "2", "3", "4", "5", "6"]
+    assert sorted(digraph.edges) == [
+        ("1", "2"),
+        ("3", "2"),
+        ("3", "4"),
+        ("4", "5"),
+    ]
+    # Node 4 is only ever used as 4-
+    for n in digraph.nodes:
+        exp_orientation = "-" if n == "4" else "+"
+        assert digraph.nodes[n]["orientation"] == exp_orientation
+    assert digraph.nodes["1"]["length"] == 8
+    assert digraph.nodes["1"]["gc_content"] == pytest.approx(0.5)
+
+
+def test_parse_gfa_oriented_conflict(tmp_path):
+    fn = write_graph(
+        tmp_path,
+        "gfa",
+        [
+            "H\tVN:Z:1.0",
+            "S\t1\tACGT",
+            "S\t2\tACGT",
+            "L\t1\t+\t2\t+\t0M",
+            "L\t2\t+\t1\t-\t0M",
+        ],
+    )
+    with pytest.raises(ValueError) as ei:
+        parse_gfa(fn, assume_oriented=True)
+    assert "Node 1 is used in both orientations" in str(ei.value)
+    # Should be fine if we're not assuming the graph is oriented
+    assert len(parse_gfa(fn).nodes) == 4
+
+
+def test_parse_lastgraph_oriented(tmp_path):
+    glines = reset_glines()
+    glines[0] = "3\t10\t1\t1"
+    glines[7:] = [
+        "NODE\t3\t1\t5\t5\t0\t0",
+        "A",
+        "T",
+        "ARC\t1\t2\t5",
+        # Reverse complement of 2 -> 1, which is fine
+        "ARC\t-1\t-2\t9",
+        "ARC\t2\t-3\t4",
+    ]
+    fn = write_graph(tmp_path, "LastGraph", glines)
+    digraph = parse_lastgraph(fn, assume_oriented=True)
+    assert sorted(digraph.nodes) == ["1", "2", "3"]
+    assert sorted(digraph.edges) == [("1", "2"), ("2", "1"), ("2", "3")]
+    assert digraph.edges["2", "1"]["multiplicity"] == 9
+    assert digraph.nodes["1"]["orientation"] == "+"
+    assert digraph.nodes["3"]["orientation"] == "-"
+    # Attributes from the NODE declaration should still be there
+    assert digraph.nodes["3"]["length"] == 1
+    assert digraph.nodes["2"]["depth"] == 20 / 6
+
+
+def test_parse_lastgraph_oriented_conflict(tmp_path):
+    # 1 -> 1- uses node 1 in both orientations
+    glines = reset_glines()
+    glines[8] = "ARC\t1\t-1\t9"
+    fn = write_graph(tmp_path, "LastGraph", glines)
+    with pytest.raises(ValueError) as ei:
+        parse(fn, assume_oriented=True)
+    assert "Node 1 is used in both orientations" in str(ei.value)
+
+    # A loop on a node's forward strand is fine, though
+    digraph = parse(
+        "metagenomescope/tests/input/1_node_1_edge.LastGraph",
+        assume_oriented=True,
+    )
+    assert list(digraph.edges) == [("1", "1")]
+
+
+def test_gml_ignores_assume_oriented():
+    fn = "metagenomescope/tests/input/marygold_fig2a.gml"
+    g1 = parse(fn)
+    g2 = parse(fn, assume_oriented=True)
+    assert set(g1.nodes) == set(g2.nodes)
+    assert set(g1.edges) == set(g2.edges)
+
+
+def test_assembly_graph_oriented():
+    ag = AssemblyGraph(
+        "metagenomescope/tests/input/sample1.gfa", assume_oriented=True
+    )
+    ag.process()
+    out = ag.to_dict()
+    assert out["total_num_nodes"] == 6
+    # {1, 2, 3, 4, 5}, {6}
+    assert len(out["components"]) == 2
+
+    # Out-of-core mode should work the same way
+    pag = PagedAssemblyGraph(
+        "metagenomescope/tests/input/sample1.gfa", assume_oriented=True
+    )
+    pag.process()
+    assert pag.to_dict()["total_num_nodes"] == 6
+
+
+def test_graph_info_oriented():
+    gi = GraphInfo(
+        "metagenomescope/tests/input/sample1.gfa", assume_oriented=True
+    )
+    assert gi.num_nodes == 6
+    assert gi.num_edges == 4
+    # Every node is its own sequence now, so we count all of them
+    assert len(gi.get_sequence_lengths()) == 6
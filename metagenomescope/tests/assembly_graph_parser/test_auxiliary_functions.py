@@ -1,7 +1,11 @@
 import pytest
+import networkx as nx
 from metagenomescope.assembly_graph_parser import (
     sniff_filetype,
     is_not_pos_int,
+    parse,
+    get_attr_types,
+    AttrTrackingDiGraph,
 )
 
 
@@ -51,6 +55,34 @@ def test_is_not_pos_int():
     assert not is_not_pos_int(12345)
 
 
+@pytest.mark.parametrize(
+    "filename",
+    [
+        "metagenomescope/tests/input/sample1.gfa",
+        "metagenomescope/tests/input/E_coli_LastGraph",
+        "metagenomescope/tests/input/marygold_fig2a.gml",
+    ],
+)
+def test_parsers_track_attrs(filename):
+    g = parse(filename)
+    assert isinstance(g, AttrTrackingDiGraph)
+    tracked = (g.node_attr_types, g.edge_attr_types)
+    # Should match what we'd get by going through every node and edge
+    plain = get_attr_types(nx.DiGraph(g))
+    assert tracked == plain
+
+
+def test_attr_tracking_digraph():
+    g = AttrTrackingDiGraph()
+    g.add_node("a", length=5, cov=None)
+    g.add_node("b", length=6, cov=1.5)
+    g.add_edge("a", "b", multiplicity=3)
+    g.add_edge("b", "a", multiplicity=2.5, note=None)
+    assert g.node_attr_types == {"length": {int}, "cov": {float}}
+    assert g.edge_attr_types == {"multiplicity": {int, float}, "note": set()}
+    assert get_attr_types(g) == (g.node_attr_types, g.edge_attr_types)
+
+
 def test_sniff_filetype():
     assert sniff_filetype("asdf.lastgraph") == "lastgraph"
     assert sniff_filetype("asdf.LASTGRAPH") == "lastgraph"
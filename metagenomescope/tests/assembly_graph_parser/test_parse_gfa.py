@@ -1,4 +1,6 @@
 # from .utils import run_tempfile_test
+import pytest
+import networkx as nx
 from metagenomescope.input_node_utils import negate_node_id
 from metagenomescope.assembly_graph_parser import parse_gfa
 from .utils import run_tempfile_test
@@ -69,6 +71,28 @@ def test_parse_gfa1_good():
     )
 
 
+def test_parse_gfa1_streamed():
+    # Giving parse_gfa() a graph target makes it go through the file line by
+    # line (this is what out-of-core mode does). The result should be the same
+    check_sample_gfa_digraph(
+        parse_gfa(
+            "metagenomescope/tests/input/sample1.gfa", digraph=nx.DiGraph()
+        )
+    )
+
+
+def test_parse_gfa1_streamed_undeclared_segment(tmp_path):
+    fn = str(tmp_path / "graph.gfa")
+    with open(fn, "w") as f:
+        f.write("\n".join(get_sample1_gfa() + ["L\t6\t+\t7\t+\t0M"]))
+    with pytest.raises(ValueError) as ei:
+        parse_gfa(fn, digraph=nx.DiGraph())
+    assert "refer to segment 7, which isn't declared" in str(ei.value)
+    # (With fast validation, we don't bother checking this)
+    digraph = parse_gfa(fn, digraph=nx.DiGraph(), validation="fast")
+    assert ("6", "7") in digraph.edges
+
+
 def test_parse_gfa2_good():
     check_sample_gfa_digraph(
         parse_gfa("metagenomescope/tests/input/sample2.gfa")
@@ -0,0 +1,132 @@
+# Tests reading graphs from stdin (or other non-seekable streams). We fake
+# stdin using pytest's monkeypatch fixture.
+import sys
+import pytest
+from io import StringIO, BytesIO
+from metagenomescope.assembly_graph_parser import (
+    parse,
+    parse_lastgraph,
+    parse_metacarvel_gml,
+    parse_gfa,
+    sniff_filetype,
+)
+from metagenomescope.graph_objects import AssemblyGraph
+from metagenomescope.tests.assembly_graph_parser.test_validate_lastgraph import (
+    reset_glines,
+)
+
+
+class UnseekableStringIO(StringIO):
+    """Mimics a pipe: you can read through it once, but you can't seek."""
+
+    def seekable(self):
+        return False
+
+    def seek(self, *args):
+        raise OSError("Can't seek in this stream!")
+
+    def tell(self):
+        raise OSError("Can't tell in this stream!")
+
+
+def fake_stdin(monkeypatch, filename):
+    """Replaces sys.stdin with a non-seekable stream of a file's contents."""
+    with open(filename, "r") as f:
+        contents = f.read()
+    stdin = UnseekableStringIO(contents)
+    # GML files are read from sys.stdin.buffer, since NetworkX wants bytes
+    stdin.buffer = BytesIO(contents.encode("utf-8"))
+    monkeypatch.setattr(sys, "stdin", stdin)
+
+
+def check_same_graph(g1, g2):
+    assert set(g1.nodes) == set(g2.nodes)
+    assert set(g1.edges) == set(g2.edges)
+    for n in g1.nodes:
+        assert g1.nodes[n] == g2.nodes[n]
+    for e in g1.edges:
+        assert g1.edges[e] == g2.edges[e]
+
+
+def test_parse_lastgraph_stdin(monkeypatch):
+    fn = "metagenomescope/tests/input/cycletest_LastGraph"
+    fake_stdin(monkeypatch, fn)
+    check_same_graph(parse_lastgraph("-"), parse_lastgraph(fn))
+
+
+def test_parse_lastgraph_stdin_invalid(monkeypatch):
+    # Validation should still happen when we're reading from stdin, even
+    # though we only go through the file once
+    glines = reset_glines()
+    glines.pop(3)
+    monkeypatch.setattr(sys, "stdin", UnseekableStringIO("\n".join(glines)))
+    with pytest.raises(ValueError) as ei:
+        parse_lastgraph("-")
+    assert "Line 4: Node block ends too early." in str(ei.value)
+
+    # Errors that can only be detected at the end of the file
+    glines = reset_glines()
+    glines[0] = "3\t10\t1\t1"
+    monkeypatch.setattr(sys, "stdin", UnseekableStringIO("\n".join(glines)))
+    with pytest.raises(ValueError) as ei:
+        parse_lastgraph("-")
+    assert (
+        "The file's header indicated that there were 3 node(s), but we "
+        "identified 2 node(s)."
+    ) in str(ei.value)
+
+
+def test_parse_gml_stdin(monkeypatch):
+    fn = "metagenomescope/tests/input/marygold_fig2a.gml"
+    fake_stdin(monkeypatch, fn)
+    check_same_graph(parse_metacarvel_gml("-"), parse_metacarvel_gml(fn))
+
+
+def test_parse_gfa_stdin(monkeypatch):
+    fn = "metagenomescope/tests/input/sample1.gfa"
+    fake_stdin(monkeypatch, fn)
+    check_same_graph(parse_gfa("-"), parse_gfa(fn))
+
+
+def test_parse_gfa_stdin_no_header(monkeypatch, tmp_path):
+    # Without an H line, gfapy can't tell what version of GFA this is, so it
+    # holds these lines back until we tell it to process them
+    contents = "S\t1\tCGATGCAA\nS\t2\tTGCAAAGTAC\nS\t3\t*\tLN:i:5\n"
+    fn = str(tmp_path / "no_header.gfa")
+    with open(fn, "w") as f:
+        f.write(contents)
+    monkeypatch.setattr(sys, "stdin", UnseekableStringIO(contents))
+    digraph = parse_gfa("-")
+    assert len(digraph.nodes) == 6
+    check_same_graph(digraph, parse_gfa(fn))
+
+
+def test_parse_stdin_requires_input_format(monkeypatch):
+    fake_stdin(monkeypatch, "metagenomescope/tests/input/sample1.gfa")
+    with pytest.raises(ValueError) as ei:
+        parse("-")
+    assert "you need to specify its filetype using --input-format" in str(
+        ei.value
+    )
+    digraph = parse("-", input_format="GFA")
+    assert len(digraph.nodes) == 12
+
+
+def test_sniff_filetype_input_format():
+    assert sniff_filetype("-", "gfa") == "gfa"
+    assert sniff_filetype("-", "LastGraph") == "lastgraph"
+    # An explicit input format should override the extension
+    assert sniff_filetype("/dev/fd/63", "fastg") == "fastg"
+    assert sniff_filetype("asdf.gml", "gfa") == "gfa"
+    with pytest.raises(NotImplementedError):
+        sniff_filetype("-", "asdf")
+    with pytest.raises(NotImplementedError):
+        sniff_filetype("asdf.gfa", "asdf")
+
+
+def test_assembly_graph_stdin(monkeypatch):
+    fake_stdin(monkeypatch, "metagenomescope/tests/input/sample1.gfa")
+    ag = AssemblyGraph("-", input_format="gfa")
+    assert ag.basename == "stdin"
+    assert ag.filetype == "gfa"
+    assert len(ag.digraph.nodes) == 12
@@ -0,0 +1,151 @@
+# Tests the "fast" and "none" validation levels. (The "strict" level is the
+# default, and is what all of the other parser tests use.)
+import pytest
+from metagenomescope.assembly_graph_parser import parse
+from metagenomescope.tests.assembly_graph_parser.test_validate_lastgraph import (
+    reset_glines,
+)
+
+
+def write_graph(tmp_path, suffix, lines):
+    fn = str(tmp_path / ("graph." + suffix))
+    with open(fn, "w") as f:
+        f.write("\n".join(lines))
+    return fn
+
+
+def test_lastgraph_fast_skips_global_checks(tmp_path):
+    # The header says there are 3 nodes, but there are only 2. This requires
+    # looking at the whole file to figure out, so only strict validation
+    # should catch this.
+    glines = reset_glines()
+    glines[0] = "3\t10\t1\t1"
+    fn = write_graph(tmp_path, "LastGraph", glines)
+    with pytest.raises(ValueError) as ei:
+        parse(fn)
+    assert "header indicated that there were 3 node(s)" in str(ei.value)
+    digraph = parse(fn, validation="fast")
+    assert len(digraph.nodes) == 4
+    assert len(digraph.edges) == 4
+    digraph = parse(fn, validation="none")
+    assert len(digraph.nodes) == 4
+
+
+def test_lastgraph_fast_skips_sequence_checks(tmp_path):
+    glines = reset_glines()
+    glines[6] = "TTTTA"
+    fn = write_graph(tmp_path, "LastGraph", glines)
+    with pytest.raises(ValueError) as ei:
+        parse(fn)
+    assert "Line 7: Node sequences have unequal lengths." in str(ei.value)
+    assert len(parse(fn, validation="fast").nodes) == 4
+
+
+def test_lastgraph_fast_still_checks_structure(tmp_path):
+    # Node block interrupted
+    glines = reset_glines()
+    glines.pop(3)
+    fn = write_graph(tmp_path, "LastGraph", glines)
+    with pytest.raises(ValueError) as ei:
+        parse(fn, validation="fast")
+    assert "Line 4: Node block ends too early." in str(ei.value)
+
+    # Arc without enough fields
+    glines = reset_glines()
+    glines[7] = "ARC\t1\t2"
+    fn = write_graph(tmp_path, "LastGraph", glines)
+    with pytest.raises(ValueError) as ei:
+        parse(fn, validation="fast")
+    assert "Line 8: Arc declaration doesn't include enough fields." in str(
+        ei.value
+    )
+
+    # Zero-length node (which would otherwise cause a division by zero)
+    glines = reset_glines()
+    glines[1] = "NODE\t1\t0\t5\t5\t0\t0"
+    fn = write_graph(tmp_path, "LastGraph", glines)
+    with pytest.raises(ValueError) as ei:
+        parse(fn, validation="fast")
+    assert "must be positive integers" in str(ei.value)
+
+    # Duplicate node ID
+    glines = reset_glines()
+    glines[4] = "NODE\t1\t5\t1\t1\t0\t0"
+    fn = write_graph(tmp_path, "LastGraph", glines)
+    with pytest.raises(ValueError) as ei:
+        parse(fn, validation="fast")
+    assert "Line 5: Node ID 1 declared multiple times." in str(ei.value)
+
+    # Arc referring to an unseen node
+    glines = reset_glines()
+    glines[7] = "ARC\t1\t3\t5"
+    fn = write_graph(tmp_path, "LastGraph", glines)
+    with pytest.raises(ValueError) as ei:
+        parse(fn, validation="fast")
+    assert "Line 8: Unseen node 3 referred to in an arc." in str(ei.value)
+
+
+def get_gml_lines(node_orientation="FOW", edge_bsize="30"):
+    return [
+        "graph [",
+        "  directed 1",
+        '  node [ id 1 label "A" orientation "FOW" length "100" ]',
+        '  node [ id 2 label "B" orientation "{}" length "50" ]'.format(
+            node_orientation
+        ),
+        "  edge [ source 1 target 2",
+        '    orientation "EB" mean "-200.0" stdev 25.1234',
+        '    bsize "{}" ]'.format(edge_bsize),
+        "]",
+    ]
+
+
+def test_gml_fast_still_checks_edges(tmp_path):
+    fn = write_graph(tmp_path, "gml", get_gml_lines(edge_bsize="-3"))
+    with pytest.raises(ValueError) as ei:
+        parse(fn, validation="fast")
+    assert "non-positive-integer bsize" in str(ei.value)
+    # ... but not with no validation.
+    digraph = parse(fn, validation="none")
+    assert len(digraph.nodes) == 2
+    # Conversions should still happen
+    assert digraph.nodes["A"]["orientation"] == "+"
+    assert digraph.nodes["A"]["length"] == 100
+
+
+def test_gml_fast_skips_attribute_scans(tmp_path):
+    # Edges are missing "mean" -- the strict up-front scan and the per-edge
+    # checks done with fast validation should both catch this, just with
+    # different messages
+    glines = get_gml_lines()
+    glines[5] = '    orientation "EB" stdev 25.1234'
+    fn = write_graph(tmp_path, "gml", glines)
+    with pytest.raises(ValueError) as ei:
+        parse(fn)
+    assert 'Only 0 / 1 edges have "mean" given.' in str(ei.value)
+    with pytest.raises(ValueError) as ei:
+        parse(fn, validation="fast")
+    assert 'non-numeric mean "None"' in str(ei.value)
+
+
+def test_gml_fast_still_checks_node_orientation(tmp_path):
+    fn = write_graph(tmp_path, "gml", get_gml_lines(node_orientation="ASDF"))
+    with pytest.raises(ValueError) as ei:
+        parse(fn, validation="fast")
+    assert 'Node B has unsupported orientation "ASDF".' in str(ei.value)
+    # ... but not with no validation.
+    digraph = parse(fn, validation="none")
+    assert digraph.nodes["B"]["orientation"] == "-"
+
+
+def test_gfa_fast_still_checks_node_names(tmp_path):
+    fn = write_graph(tmp_path, "gfa", ["H\tVN:Z:1.0", "S\t-1\tACGT"])
+    with pytest.raises(ValueError) as ei:
+        parse(fn, validation="fast")
+    assert 'cannot start with the "-" character' in str(ei.value)
+
+
+def test_bad_validation_level():
+    with pytest.raises(ValueError) as ei:
+        parse("metagenomescope/tests/input/sample1.gfa", validation="asdf")
+    assert "Unrecognized validation level asdf." in str(ei.value)
@@ -0,0 +1,141 @@
+import networkx as nx
+from metagenomescope.graph_objects import AssemblyGraph
+from metagenomescope.graph_objects.decomposition_budget import (
+    DecompositionBudget,
+    TIME,
+    CALLS,
+    DEPTH,
+)
+
+ECOLI = "metagenomescope/tests/input/E_coli_LastGraph"
+
+
+def test_budget_calls_and_depth():
+    g = nx.DiGraph()
+    g.add_edges_from([(0, 1), (1, 2), (5, 6)])
+    b = DecompositionBudget(g, max_calls=2, max_depth=2)
+    for i in range(2):
+        assert b.can_check(0)
+        b.finish_check(0, b.start_check())
+    # 0, 1, and 2 are in the same component, so they share a budget
+    assert not b.can_check(1)
+    assert b.can_check(5)
+    assert b.truncated == {0: [CALLS]}
+
+    b.add_pattern(0, 10, b.get_depth([0, 1]))
+    assert b.pattern_depth[10] == 1
+    assert b.get_depth([10, 2]) == 2
+    assert b.depth_ok(10, 2)
+    b.add_pattern(10, 11, 2)
+    assert not b.depth_ok(11, b.get_depth([11]))
+    # Patterns that won't be nested don't count
+    assert b.get_depth([11, 2], excluded_ids=(11,)) == 1
+    assert b.truncated == {0: [CALLS, DEPTH]}
+
+    # The component is identified by its smallest top-level node ID
+    g.remove_nodes_from([0, 1, 2])
+    g.add_node(11)
+    assert b.get_truncated_components(g) == {11: [CALLS, DEPTH]}
+
+
+def test_no_limits():
+    ag = AssemblyGraph(ECOLI)
+    ag.hierarchically_identify_patterns()
+    assert ag.truncated_components == {}
+
+
+def test_max_pattern_depth():
+    ag = AssemblyGraph(ECOLI)
+    ag.hierarchically_identify_patterns()
+    nested = [
+        p
+        for p in ag.id2pattern.values()
+        if any(ag.is_pattern(m) for m in p.node_ids)
+    ]
+    assert len(nested) > 0
+
+    ag1 = AssemblyGraph(ECOLI, max_pattern_depth=1)
+    ag1.hierarchically_identify_patterns()
+    for p in ag1.id2pattern.values():
+        assert not any(ag1.is_pattern(m) for m in p.node_ids)
+    assert 0 < len(ag1.id2pattern) < len(ag.id2pattern)
+    assert len(ag1.truncated_components) > 0
+    assert all(r == [DEPTH] for r in ag1.truncated_components.values())
+
+
+def test_max_calls_and_time_limit():
+    for kwargs, reason in (
+        ({"decomposition_max_calls": 1}, CALLS),
+        ({"decomposition_time_limit": 1e-9}, TIME),
+    ):
+        ag = AssemblyGraph(ECOLI, **kwargs)
+        ag.hierarchically_identify_patterns()
+        # We only get to check one node in each component (with one
+        # validator), which isn't enough to find anything in this graph
+        assert len(ag.id2pattern) == 0
+        assert len(
+            ag.truncated_components
+        ) == nx.number_weakly_connected_components(ag.digraph)
+        assert all(r == [reason] for r in ag.truncated_components.values())
+
+
+def test_truncation_in_to_dict():
+    ag = AssemblyGraph(ECOLI, max_pattern_depth=1)
+    ag.process()
+    out = ag.to_dict()
+    truncated = [
+        c for c in out["components"] if c["decomposition_truncated"] != []
+    ]
+    assert len(truncated) == len(ag.truncated_components)
+    assert all(c["decomposition_truncated"] == [DEPTH] for c in truncated)
+
+
+def test_frayed_rope_scan_charges_budget():
+    # Two frayed ropes in one component, joined by a chain in the middle:
+    # 0,1 -> 2 -> 3,4 -> 5 -> 6 -> 7,8 -> 9 -> 10,11
+    g = nx.DiGraph()
+    g.add_edges_from(
+        [(0, 2), (1, 2), (2, 3), (2, 4), (3, 5), (4, 5), (5, 6)]
+        + [(6, 7), (6, 8), (7, 9), (8, 9), (9, 10), (9, 11)]
+    )
+    b = DecompositionBudget(g, max_calls=3)
+    ropes = AssemblyGraph.find_frayed_ropes(g, sorted(g.nodes), b)
+    # Each node we look at is one check, so we only get through nodes 0, 1,
+    # and 2 -- enough to find the first rope but not the second
+    assert ropes == [[0, 1, 2, 3, 4]]
+    assert b.cc_calls[0] == 3
+    assert b.truncated == {0: [CALLS]}
+
+    # add_time() only charges time, not a check
+    b = DecompositionBudget(g)
+    b.add_time(0, b.start_check() - 100)
+    assert b.cc_time[0] >= 100
+    assert b.cc_calls[0] == 0
+
+
+def test_collapse_frayed_ropes_charges_budget(tmp_path):
+    # Same graph as above, going through AssemblyGraph
+    gfa = tmp_path / "frs.gfa"
+    lines = ["H\tVN:Z:1.0"]
+    for n in range(12):
+        lines.append("S\t{}\tACGT".format(n))
+    for src, tgt in [
+        (0, 2),
+        (1, 2),
+        (2, 3),
+        (2, 4),
+        (3, 5),
+        (4, 5),
+        (5, 6),
+    ] + [(6, 7), (6, 8), (7, 9), (8, 9), (9, 10), (9, 11)]:
+        lines.append("L\t{}\t+\t{}\t+\t0M".format(src, tgt))
+    gfa.write_text("\n".join(lines) + "\n")
+    ag = AssemblyGraph(str(gfa), assume_oriented=True)
+    ag.decomposed_digraph = ag.digraph.copy()
+    b = DecompositionBudget(ag.decomposed_digraph)
+    assert ag.collapse_frayed_ropes(b) == 2
+    # Every node was scanned once, and the time spent scanning nodes and
+    # collapsing the ropes was recorded
+    assert b.cc_calls[0] == 12
+    assert b.cc_time[0] > 0
+    assert all(b.node2cc[p.pattern_id] == 0 for p in ag.frayed_ropes)
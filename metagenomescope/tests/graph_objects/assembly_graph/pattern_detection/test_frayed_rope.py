@@ -146,3 +146,91 @@ def test_diverges_to_start():
     g.add_edge(2, 0)
     assert not AssemblyGraph.is_valid_frayed_rope(g, 0)[0]
     assert not AssemblyGraph.is_valid_frayed_rope(g, 1)[0]
+
+
+def test_scan_simple_fr():
+    g = get_simple_fr_graph()
+    assert AssemblyGraph.find_frayed_ropes(g, sorted(g.nodes)) == [
+        [0, 1, 2, 3, 4]
+    ]
+    # Only the convergence node (2) matters
+    assert AssemblyGraph.find_frayed_ropes(g, [0, 1, 3, 4]) == []
+    assert AssemblyGraph.find_frayed_ropes(g, [2]) == [[0, 1, 2, 3, 4]]
+
+
+def test_scan_failures():
+    # All of the invalid graphs from the tests above should be invalid for
+    # the scan as well
+    for modify in (
+        lambda g: g.remove_edge(1, 2),
+        lambda g: g.add_edge(0, 5),
+        lambda g: g.remove_edge(2, 4),
+        lambda g: g.remove_edges_from([(2, 3), (2, 4)]),
+        lambda g: g.add_edge(5, 3),
+        lambda g: g.add_edge(3, 0),
+        lambda g: g.add_edges_from([(2, 0)]) or g.remove_edge(2, 3),
+    ):
+        g = get_simple_fr_graph()
+        modify(g)
+        assert AssemblyGraph.find_frayed_ropes(g, sorted(g.nodes)) == []
+
+
+def test_scan_path_middle():
+    r"""Tests that a graph that looks like:
+
+    0 -\               /-> 5
+        2 -> 3 -> 4 --
+    1 -/               \-> 6
+
+    ... is a valid frayed rope, with a middle path of 2 -> 3 -> 4.
+    """
+    g = nx.DiGraph()
+    g.add_edges_from([(0, 2), (1, 2), (2, 3), (3, 4), (4, 5), (4, 6)])
+    assert AssemblyGraph.find_frayed_ropes(g, sorted(g.nodes)) == [
+        [0, 1, 2, 3, 4, 5, 6]
+    ]
+    # If the middle path converges again, then there isn't a frayed rope
+    # converging at 2 any more -- but there's one converging at 3 instead!
+    g.add_edge(7, 3)
+    assert AssemblyGraph.find_frayed_ropes(g, sorted(g.nodes)) == [
+        [2, 7, 3, 4, 5, 6]
+    ]
+
+
+def test_scan_overlapping_frs():
+    r"""Tests that a graph that looks like:
+
+    0 -\ /-> 3 -\ /-> 6
+        2        5
+    1 -/ \-> 4 -/ \-> 7
+
+    ... only produces one frayed rope, since the two possible frayed ropes
+    share nodes (3 and 4).
+    """
+    g = get_simple_fr_graph()
+    g.add_edges_from([(3, 5), (4, 5), (5, 6), (5, 7)])
+    assert AssemblyGraph.find_frayed_ropes(g, sorted(g.nodes)) == [
+        [0, 1, 2, 3, 4]
+    ]
+
+
+def test_hierarchical_fr_with_chain_middle(tmp_path):
+    # Same graph as in test_scan_path_middle(), but going through the
+    # hierarchical decomposition: the middle path gets collapsed into a
+    # chain first, and then the frayed rope is found around it
+    gfa = tmp_path / "fr.gfa"
+    lines = ["H\tVN:Z:1.0"]
+    for n in range(7):
+        lines.append("S\t{}\tACGT".format(n))
+    for src, tgt in ((0, 2), (1, 2), (2, 3), (3, 4), (4, 5), (4, 6)):
+        lines.append("L\t{}\t+\t{}\t+\t0M".format(src, tgt))
+    gfa.write_text("\n".join(lines) + "\n")
+    ag = AssemblyGraph(str(gfa), assume_oriented=True)
+    ag.hierarchically_identify_patterns()
+    assert len(ag.chains) == 1
+    assert len(ag.frayed_ropes) == 1
+    assert len(ag.decomposed_digraph.nodes) == 1
+    rope = ag.frayed_ropes[0]
+    assert rope.pattern_id in ag.decomposed_digraph
+    assert ag.chains[0].pattern_id in rope.node_ids
+    assert ag.chains[0].parent_id == rope.pattern_id
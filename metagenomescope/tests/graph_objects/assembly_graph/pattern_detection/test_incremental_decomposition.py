@@ -0,0 +1,245 @@
+import math
+import random
+import pytest
+from metagenomescope.graph_objects import AssemblyGraph
+from metagenomescope.simplification import TIP
+from metagenomescope.graph_objects.decomposition_budget import DEPTH
+
+
+def check_decomposition(ag):
+    """Checks that the decomposition of a graph makes sense.
+
+    Every node should be in exactly one place (either in the top level of
+    the decomposed digraph, or in a pattern), parent IDs should match up with
+    pattern membership, and every edge should be accounted for.
+    """
+    for n in ag.digraph.nodes:
+        assert ag.get_top_level_id(n) in ag.decomposed_digraph
+    for p in ag.id2pattern.values():
+        for child_id in p.node_ids:
+            assert ag.get_parent_id(child_id) == p.pattern_id
+    for n in ag.decomposed_digraph.nodes:
+        assert ag.is_pattern(n) or n in ag.digraph.nodes
+        assert ag.get_parent_id(n) is None
+    ccs = ag.get_connected_components()
+    assert sum(cc[1] for cc in ccs) == len(ag.digraph.nodes)
+    assert sum(cc[2] for cc in ccs) == len(ag.digraph.edges)
+    patt_ids = set()
+    for patt_list in (
+        ag.chains,
+        ag.cyclic_chains,
+        ag.bubbles,
+        ag.frayed_ropes,
+        ag.misc_patterns,
+    ):
+        patt_ids |= set(p.pattern_id for p in patt_list)
+    assert patt_ids == set(ag.id2pattern.keys())
+
+
+def flatten(obj, out):
+    if isinstance(obj, dict):
+        for k in sorted(obj, key=str):
+            flatten(obj[k], out)
+    elif isinstance(obj, (list, tuple)):
+        for v in obj:
+            flatten(v, out)
+    else:
+        out.append(obj)
+    return out
+
+
+def test_remove_node_only_dissolves_ancestors():
+    ag = AssemblyGraph("metagenomescope/tests/input/marygold_fig2a.gml")
+    ag.hierarchically_identify_patterns()
+    # Bubbles 12 and 13 are both within bubble 14
+    assert ag.id2pattern[12].node_ids == [1, 3, 4, 5, 6]
+    assert ag.id2pattern[14].parent_id is None
+    bubble13 = ag.id2pattern[13]
+
+    # Remove NODE_3, which is in bubble 12
+    ag.remove_nodes_and_edges([4])
+    check_decomposition(ag)
+    assert 4 not in ag.digraph.nodes
+    # Bubble 13 wasn't affected, so it should still be around. Bubbles 12
+    # and 14 were dissolved, and then found again (sans NODE_3)
+    assert ag.id2pattern[13] is bubble13
+    assert 12 not in ag.id2pattern
+    assert 14 not in ag.id2pattern
+    assert sorted(ag.id2pattern[15].node_ids) == [1, 3, 5, 6]
+    assert sorted(ag.id2pattern[16].node_ids) == [0, 7, 13, 15]
+    assert bubble13.parent_id == 16
+    assert list(ag.decomposed_digraph.nodes) == [16]
+
+
+def test_remove_edge():
+    ag = AssemblyGraph("metagenomescope/tests/input/marygold_fig2a.gml")
+    ag.hierarchically_identify_patterns()
+    bubble13 = ag.id2pattern[13]
+    ag.remove_nodes_and_edges(edges=[(1, 3)])
+    check_decomposition(ag)
+    assert not ag.digraph.has_edge(1, 3)
+    assert ag.id2pattern[13] is bubble13
+    # Without this edge, NODE_2 -> NODE_5 is just a path hanging off of
+    # NODE_5, so we can't find the outer bubble any more
+    assert 12 not in ag.id2pattern
+    assert 14 not in ag.id2pattern
+    assert bubble13.parent_id is None
+
+
+def test_remove_before_decomposition():
+    ag = AssemblyGraph("metagenomescope/tests/input/marygold_fig2a.gml")
+    ag.remove_nodes_and_edges([4], [(0, 1)])
+    assert 4 not in ag.digraph.nodes
+    assert not ag.digraph.has_edge(0, 1)
+    ag.hierarchically_identify_patterns()
+    check_decomposition(ag)
+
+
+def test_remove_records_reason():
+    ag = AssemblyGraph("metagenomescope/tests/input/marygold_fig2a.gml")
+    ag.hierarchically_identify_patterns()
+    ag.remove_nodes_and_edges([4], [(2, 8)], reason=TIP)
+    assert ag.removed_nodes == [["NODE_3", TIP]]
+    assert ag.removed_edges == [["NODE_6", "NODE_7", TIP]]
+    # No reason given, so nothing should be recorded
+    ag.remove_nodes_and_edges([5])
+    assert ag.removed_nodes == [["NODE_3", TIP]]
+
+
+def test_remove_errors():
+    ag = AssemblyGraph("metagenomescope/tests/input/marygold_fig2a.gml")
+    ag.hierarchically_identify_patterns()
+    with pytest.raises(ValueError) as ei:
+        ag.remove_nodes_and_edges([100])
+    assert str(ei.value) == "Node 100 isn't in the graph."
+    with pytest.raises(ValueError) as ei:
+        ag.remove_nodes_and_edges(edges=[(3, 1)])
+    assert str(ei.value) == "Edge 3 -> 1 isn't in the graph."
+
+
+def test_remove_node_removes_duplicates():
+    ag = AssemblyGraph("metagenomescope/tests/input/E_coli_LastGraph")
+    ag.hierarchically_identify_patterns()
+    dup_ids = [
+        n for n in ag.digraph.nodes if ag.digraph.nodes[n].get("is_dup")
+    ]
+    assert len(dup_ids) > 0
+    dup_id = dup_ids[0]
+    group = ag.get_dup_group(dup_id)
+    orig_id = min(group)
+    name = ag.digraph.nodes[orig_id]["name"]
+    assert all(ag.digraph.nodes[n]["name"] == name for n in group)
+
+    # Removing the dup link itself isn't allowed
+    link = [e for e in ag.digraph.in_edges(dup_id)] + [
+        e for e in ag.digraph.out_edges(dup_id)
+    ]
+    link = [e for e in link if ag.digraph.edges[e].get("is_dup")][0]
+    with pytest.raises(ValueError) as ei:
+        ag.remove_nodes_and_edges(edges=[link])
+    assert "just links a duplicate node to its original node" in str(ei.value)
+
+    ag.remove_nodes_and_edges([orig_id])
+    check_decomposition(ag)
+    for n in group:
+        assert n not in ag.digraph.nodes
+    assert all(ag.digraph.nodes[n]["name"] != name for n in ag.digraph.nodes)
+
+
+def test_relayout_matches_full_layout():
+    # If we lay out every component again (without changing anything), we
+    # should get exactly what we had before -- both when reusing the
+    # existing pattern layouts and when laying them out from scratch
+    for reset_patterns in (False, True):
+        ag = AssemblyGraph("metagenomescope/tests/input/E_coli_LastGraph")
+        ag.process()
+        before = flatten(ag.to_dict(), [])
+        region = set(ag.decomposed_digraph.nodes)
+        ag.unrotate_dimensions(region)
+        if reset_patterns:
+            for p in ag.id2pattern.values():
+                p.width = None
+        ag.relayout_components(region)
+        after = flatten(ag.to_dict(), [])
+        assert len(before) == len(after)
+        for b, a in zip(before, after):
+            if isinstance(b, float):
+                assert math.isclose(b, a, rel_tol=1e-9, abs_tol=1e-9)
+            else:
+                assert b == a
+
+
+def test_remove_after_layout():
+    ag = AssemblyGraph("metagenomescope/tests/input/E_coli_LastGraph")
+    ag.process()
+    random.seed(333)
+    for i in range(10):
+        pos = {
+            n: (ag.digraph.nodes[n]["x"], ag.digraph.nodes[n]["y"])
+            for n in ag.digraph.nodes
+        }
+        node_id = random.choice(sorted(ag.digraph.nodes))
+        top_id = ag.get_top_level_id(node_id)
+        for cc in ag.get_connected_components():
+            if top_id in cc[0]:
+                changed = set(ag.get_component_contents(cc[0])[0])
+        if i % 2 == 0:
+            ag.remove_nodes_and_edges([node_id])
+        else:
+            edge = [
+                e
+                for e in ag.digraph.in_edges(node_id)
+                if not ag.digraph.edges[e].get("is_dup")
+            ][:1]
+            ag.remove_nodes_and_edges(edges=edge)
+        check_decomposition(ag)
+        # Nodes in other components shouldn't have moved
+        for n in ag.digraph.nodes:
+            if n not in changed:
+                data = ag.digraph.nodes[n]
+                assert (data["x"], data["y"]) == pos[n]
+        out = ag.to_dict()
+        assert len(out["components"]) == len(ag.get_connected_components())
+        for comp in out["components"]:
+            assert len(comp["bb"]) == 2
+
+
+def test_remove_uses_decomposition_limits():
+    ag = AssemblyGraph(
+        "metagenomescope/tests/input/marygold_fig2a.gml", max_pattern_depth=1
+    )
+    ag.hierarchically_identify_patterns()
+    assert len(ag.truncated_components) > 0
+    ag.remove_nodes_and_edges([4])
+    check_decomposition(ag)
+    # Without the depth limit, we'd find bubbles containing other bubbles
+    # (see test_remove_node_only_dissolves_ancestors())
+    assert len(ag.id2pattern) > 0
+    for p in ag.id2pattern.values():
+        assert p.get_depth(ag) == 1
+    # The component was truncated again
+    assert list(ag.truncated_components.values()) == [[DEPTH]]
+
+
+def test_remove_only_revalidates_nearby_nodes(monkeypatch):
+    ag = AssemblyGraph("metagenomescope/tests/input/E_coli_LastGraph")
+    ag.hierarchically_identify_patterns()
+    biggest = max(ag.get_connected_components(), key=lambda cc: len(cc[0]))
+    top_ids = sorted(biggest[0])
+    assert len(top_ids) > 100
+    node_id = [n for n in top_ids if not ag.is_pattern(n)][0]
+
+    checked = set()
+    orig = AssemblyGraph.is_valid_chain
+
+    def tracking_validator(g, n):
+        checked.add(n)
+        return orig(g, n)
+
+    monkeypatch.setattr(
+        AssemblyGraph, "is_valid_chain", staticmethod(tracking_validator)
+    )
+    ag.remove_nodes_and_edges([node_id])
+    check_decomposition(ag)
+    # (Before, we'd check every top-level node in the component)
+    assert 0 < len(checked) < len(top_ids) / 2
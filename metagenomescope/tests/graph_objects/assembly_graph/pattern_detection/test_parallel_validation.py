@@ -0,0 +1,142 @@
+import pytest
+import networkx as nx
+from metagenomescope import config
+from metagenomescope.graph_objects import AssemblyGraph
+from metagenomescope.graph_objects.parallel_validation import (
+    ReadTrackingGraph,
+    ChangeTrackingDiGraph,
+    NotInRegionError,
+    ValidatorPool,
+    get_regions,
+)
+
+
+def test_read_tracking_graph():
+    g = nx.DiGraph()
+    g.add_edges_from([(0, 1), (1, 2), (2, 3)])
+    rtg = ReadTrackingGraph(g)
+    outputs = AssemblyGraph.is_valid_chain(rtg, 0)
+    assert outputs == AssemblyGraph.is_valid_chain(g, 0)
+    # The chain validator should've looked at the whole path, but nothing
+    # else
+    assert rtg.reads == {0, 1, 2, 3}
+
+
+def test_change_tracking_digraph():
+    g = ChangeTrackingDiGraph()
+    g.add_edges_from([(0, 1), (1, 2), (2, 3), (3, 4)])
+    # add_edges_from() isn't tracked, but we don't use it in decomposition
+    assert g.touched == set()
+    g.add_node(5)
+    g.add_edge(5, 0)
+    assert g.touched == {0, 5}
+    g.touched = set()
+    g.remove_nodes_from([2])
+    assert g.touched == {1, 2, 3}
+    g.touched = set()
+    g.remove_edge(3, 4)
+    assert g.touched == {3, 4}
+
+
+def test_read_tracking_graph_region():
+    g = nx.DiGraph()
+    g.add_edges_from([(0, 1), (1, 2), (2, 3)])
+    rtg = ReadTrackingGraph(g, region={0, 1, 2})
+    with pytest.raises(NotInRegionError):
+        AssemblyGraph.is_valid_chain(rtg, 0)
+
+
+def test_get_regions():
+    g = nx.DiGraph()
+    g.add_edges_from([(0, 1), (2, 1), (2, 3), (10, 11), (11, 12), (20, 21)])
+    # Regions are grown by BFS, so 0's neighbors come right after it
+    assert get_regions(g, 2) == [[0, 1, 2, 3, 10], [11, 12, 20, 21]]
+    assert get_regions(g, 1) == [sorted(g.nodes)]
+    assert get_regions(g, 3, [10, 11, 12, 20]) == [[10, 11], [12, 20]]
+    # More regions than nodes
+    assert get_regions(g, 100, [0, 1]) == [[0], [1]]
+
+
+def check_precomputed(pc, g, nodes):
+    assert sorted(pc.keys()) == nodes
+    for n in nodes:
+        assert pc[n][0] == AssemblyGraph.is_valid_chain(g, n)
+
+
+def test_validator_pool(monkeypatch):
+    g = ChangeTrackingDiGraph()
+    g.add_edges_from([(0, 1), (1, 2), (2, 3), (10, 11), (11, 12)])
+    nodes = sorted(g.nodes)
+    pool = ValidatorPool(g, 2)
+    # Not enough nodes to bother
+    assert pool.precompute(AssemblyGraph.is_valid_chain, nodes) == {}
+    assert pool.workers is None
+
+    monkeypatch.setattr(config, "PARALLEL_VALIDATION_MIN_CANDIDATES", 1)
+    # Only one worker, so still don't bother
+    one = ValidatorPool(g, 1)
+    assert one.precompute(AssemblyGraph.is_valid_chain, nodes) == {}
+    assert one.workers is None
+
+    try:
+        pc = pool.precompute(AssemblyGraph.is_valid_chain, nodes)
+        # Each component got its own region, so nothing had to look outside
+        # of its region
+        check_precomputed(pc, g, nodes)
+        assert pc[10][1] == {10, 11, 12}
+        g.touched = set()
+
+        # Change the graph; the workers should be updated with just the
+        # changed nodes, and give the same results as if we started over.
+        # (New nodes go in the same region as their neighbors.)
+        g.add_edge(12, 30)
+        g.remove_nodes_from([0])
+        nodes = sorted(g.nodes)
+        pc = pool.precompute(AssemblyGraph.is_valid_chain, nodes)
+        g.touched = set()
+        check_precomputed(pc, g, nodes)
+        assert pc[10][1] == {10, 11, 12, 30}
+
+        # Now, the chain from 1 goes into the other worker's region, so the
+        # workers give up on the calls that look across this edge
+        g.add_edge(3, 10)
+        pc = pool.precompute(AssemblyGraph.is_valid_chain, nodes)
+        g.touched = set()
+        assert set(pc.keys()) < set(nodes)
+        for n in pc:
+            assert pc[n][0] == AssemblyGraph.is_valid_chain(g, n)
+    finally:
+        pool.close()
+    assert pool.workers is None
+
+
+def get_patterns(ag):
+    # (We don't sort node_ids: the order of a pattern's nodes depends on the
+    # order in which the validator saw them, and this should match, too)
+    return sorted(
+        (p.pattern_id, p.pattern_type, p.node_ids)
+        for p in ag.id2pattern.values()
+    )
+
+
+def test_parallel_decomposition_matches_sequential(monkeypatch):
+    monkeypatch.setattr(config, "PARALLEL_VALIDATION_MIN_CANDIDATES", 10)
+    fn = "metagenomescope/tests/input/E_coli_LastGraph"
+    seq = AssemblyGraph(fn)
+    seq.process()
+    par = AssemblyGraph(fn, decomposition_workers=3)
+    par.process()
+    assert len(seq.id2pattern) > 0
+    assert get_patterns(par) == get_patterns(seq)
+    assert list(par.decomposed_digraph.nodes) == list(
+        seq.decomposed_digraph.nodes
+    )
+    assert list(par.decomposed_digraph.edges) == list(
+        seq.decomposed_digraph.edges
+    )
+    for coll in ("chains", "cyclic_chains", "bubbles", "frayed_ropes"):
+        assert [p.pattern_id for p in getattr(par, coll)] == [
+            p.pattern_id for p in getattr(seq, coll)
+        ]
+    # Since the patterns are the same, the layouts should be, too
+    assert par.to_dict() == seq.to_dict()
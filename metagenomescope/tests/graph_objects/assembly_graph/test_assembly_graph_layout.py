@@ -1,5 +1,6 @@
 import pytest
 from metagenomescope.graph_objects import AssemblyGraph
+from metagenomescope.layout_cost import LayoutCostModel
 
 
 def test_ccs_avoided_due_to_max_node_ct(capsys):
@@ -26,3 +27,79 @@ def test_error_if_all_ccs_avoided():
             "metagenomescope/tests/input/sample1.gfa", max_node_count=0
         )
     assert "All components were too large to lay out." in str(ei.value)
+
+
+def test_parallel_layout_matches_sequential():
+    ag = AssemblyGraph("metagenomescope/tests/input/sample1.gfa")
+    ag.process()
+    ag2 = AssemblyGraph(
+        "metagenomescope/tests/input/sample1.gfa", layout_workers=2
+    )
+    ag2.process()
+    assert ag.to_dict() == ag2.to_dict()
+    # We should've recorded timings for both of the two non-trivial
+    # components in the graph
+    assert len(ag2.cost_model.observations) == 2
+
+
+def get_fixed_cost_model():
+    # Each of the two non-trivial components in sample1.gfa contains one
+    # pattern, so these are predicted to take 10 seconds each to lay out
+    # normally (or 5 seconds degraded). The 1-node components are free.
+    m = LayoutCostModel()
+    m.coeffs = [0, 0, 10, 0]
+    m.degraded_factor = 0.5
+    return m
+
+
+def run_with_budget(time_budget):
+    ag = AssemblyGraph(
+        "metagenomescope/tests/input/sample1.gfa",
+        time_budget=time_budget,
+        cost_model=get_fixed_cost_model(),
+    )
+    ag.process()
+    return ag.to_dict()["components"]
+
+
+def test_time_budget_everything_fits():
+    ccs = run_with_budget(1000)
+    assert [cc["skipped"] for cc in ccs] == [False] * 4
+    assert [cc["degraded"] for cc in ccs] == [False] * 4
+
+
+def test_time_budget_degrade():
+    # Full layout of both = 20 seconds, degrading one = 15 seconds
+    ccs = run_with_budget(17)
+    assert sorted(cc["degraded"] for cc in ccs[:2]) == [False, True]
+    # Degrading both = 10 seconds
+    ccs = run_with_budget(12)
+    assert [cc["degraded"] for cc in ccs] == [True, True, False, False]
+
+
+def test_time_budget_skip(capsys):
+    ccs = run_with_budget(8)
+    assert ccs[0] == {
+        "skipped": True,
+        "num_nodes": 5,
+        "num_edges": 4,
+        "length": 54,
+    }
+    assert not ccs[1]["skipped"]
+    assert ccs[1]["degraded"]
+    assert len(ccs) == 4
+    assert (
+        "Ignoring a component (5 nodes, 4 edges): predicted layout time "
+        "exceeds --time-budget."
+    ) in capsys.readouterr().out
+
+    ccs = run_with_budget(1)
+    assert [cc["skipped"] for cc in ccs[:2]] == [True, True]
+    assert [cc["num_nodes"] for cc in ccs[:2]] == [5, 5]
+    assert [cc["skipped"] for cc in ccs[2:]] == [False, False]
+
+
+def test_time_budget_nothing_fits():
+    with pytest.raises(ValueError) as ei:
+        run_with_budget(1e-9)
+    assert "enough time to lay out any components" in str(ei.value)
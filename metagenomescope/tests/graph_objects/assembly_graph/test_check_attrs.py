@@ -9,6 +9,7 @@
 # refactor this codebase one more time I think my brain is going to leap out of
 # my head and punch me in the face.
 from metagenomescope.graph_objects import AssemblyGraph
+from metagenomescope.assembly_graph_parser import AttrTrackingDiGraph
 import pytest
 
 
@@ -22,3 +23,47 @@ def test_check_attrs_edge():
     with pytest.raises(ValueError) as einfo:
         AssemblyGraph("metagenomescope/tests/input/check_attrs_test_edge.gml")
     assert "has reserved attribute(s) {'ctrl_pt_coords'}." in str(einfo.value)
+
+
+def test_check_attrs_fast_validation():
+    # The error message should be the same as with strict validation
+    with pytest.raises(ValueError) as einfo:
+        AssemblyGraph(
+            "metagenomescope/tests/input/check_attrs_test_node.gml",
+            validation="fast",
+        )
+    assert "has reserved attribute(s) {'height'}." in str(einfo.value)
+
+    with pytest.raises(ValueError) as einfo:
+        AssemblyGraph(
+            "metagenomescope/tests/input/check_attrs_test_edge.gml",
+            validation="fast",
+        )
+    assert "has reserved attribute(s) {'ctrl_pt_coords'}." in str(einfo.value)
+
+
+def test_check_attrs_extra_attrs_same_at_all_validation_levels():
+    fn = "metagenomescope/tests/input/marygold_fig2a.gml"
+    strict = AssemblyGraph(fn)
+    for level in ("fast", "none"):
+        ag = AssemblyGraph(fn, validation=level)
+        assert ag.extra_node_attrs == strict.extra_node_attrs
+        assert ag.extra_edge_attrs == strict.extra_edge_attrs
+
+
+def test_check_attrs_uses_tracked_attr_names():
+    g = AttrTrackingDiGraph()
+    g.add_node("a", length=5, orientation="+", gc=0.5)
+    g.add_node("b", length=6, orientation="+")
+    g.add_edge("a", "b", bsize=3)
+    # Sneak in a reserved attribute behind the graph's back. Strict
+    # validation goes through every node and catches this; fast validation
+    # only looks at the attributes passed to add_node() / add_edge().
+    g.nodes["b"]["height"] = 3
+    ag = AssemblyGraph("sneaky.gml", digraph=g, validation="fast")
+    assert ag.extra_node_attrs == {"length", "orientation", "gc"}
+    assert ag.extra_edge_attrs == {"bsize"}
+    assert ag.node_attr_types["gc"] == {float}
+    with pytest.raises(ValueError) as einfo:
+        AssemblyGraph("sneaky.gml", digraph=g, validation="strict")
+    assert "has reserved attribute(s) {'height'}." in str(einfo.value)
@@ -0,0 +1,180 @@
+import os
+import pytest
+from metagenomescope.graph_objects import AssemblyGraph, PagedAssemblyGraph
+
+
+def get_summary(data):
+    """Summarizes the exported components in a way that doesn't depend on IDs.
+
+    We can't compare exported data directly, since node/pattern IDs (and
+    dot's layouts, which depend on the order in which nodes are declared) can
+    differ between AssemblyGraph and PagedAssemblyGraph. But the set of nodes
+    (and their dimensions), and the types of the identified patterns, should
+    be identical. (Pattern dimensions depend on the layout, so we skip those.)
+    """
+    ni = data["node_attrs"]
+    pi = data["patt_attrs"]
+    summary = []
+    for cc in data["components"]:
+        if cc.get("skipped", False):
+            summary.append("skipped")
+            continue
+        nodes = sorted(
+            (n[ni["name"]], n[ni["width"]], n[ni["height"]], n[ni["is_dup"]])
+            for n in cc["nodes"].values()
+        )
+        patts = sorted(p[pi["pattern_type"]] for p in cc["patts"])
+        summary.append((nodes, patts))
+    return sorted(summary, key=str)
+
+
+def check_matches_assembly_graph(
+    filename, page_node_count, tmp_path, **kwargs
+):
+    ag = AssemblyGraph(filename, **kwargs)
+    ag.process()
+    pag = PagedAssemblyGraph(
+        filename,
+        page_node_count=page_node_count,
+        temp_dir=str(tmp_path),
+        **kwargs
+    )
+    pag.process()
+    ag_data = ag.to_dict()
+    pag_data = pag.to_dict()
+    for f in (
+        "node_attrs",
+        "edge_attrs",
+        "patt_attrs",
+        "extra_node_attrs",
+        "extra_edge_attrs",
+        "extra_node_attr_types",
+        "extra_edge_attr_types",
+        "input_file_basename",
+        "input_file_type",
+        "total_num_nodes",
+        "total_num_edges",
+    ):
+        assert ag_data[f] == pag_data[f]
+    assert len(ag_data["components"]) == len(pag_data["components"])
+    assert get_summary(ag_data) == get_summary(pag_data)
+    # Skipped components' placeholders don't have any IDs in them, so we can
+    # compare these directly
+    assert [c for c in ag_data["components"] if c["skipped"]] == [
+        c for c in pag_data["components"] if c["skipped"]
+    ]
+    # All of our temporary files should be gone after process()
+    assert os.listdir(str(tmp_path)) == []
+
+
+def test_matches_assembly_graph_gfa(tmp_path):
+    check_matches_assembly_graph(
+        "metagenomescope/tests/input/sample1.gfa", 3, tmp_path
+    )
+
+
+def test_matches_assembly_graph_lastgraph(tmp_path):
+    check_matches_assembly_graph(
+        "metagenomescope/tests/input/E_coli_LastGraph", 10, tmp_path
+    )
+
+
+def test_matches_assembly_graph_skipped(tmp_path):
+    check_matches_assembly_graph(
+        "metagenomescope/tests/input/E_coli_LastGraph",
+        10,
+        tmp_path,
+        max_node_count=20,
+        max_edge_count=20,
+    )
+
+
+def test_matches_assembly_graph_gml(tmp_path):
+    check_matches_assembly_graph(
+        "metagenomescope/tests/input/marygold_fig2a.gml", 1, tmp_path
+    )
+
+
+def test_pages():
+    pag = PagedAssemblyGraph(
+        "metagenomescope/tests/input/sample1.gfa", page_node_count=3
+    )
+    pages = pag.get_pages()
+    # Every component should be in exactly one page
+    assert sorted(c for p in pages for c in p) == sorted(
+        pag.cc_nums_to_process
+    )
+    for p in pages:
+        ct = sum(pag.store.cc_node_counts[c] for c in p)
+        assert len(p) == 1 or ct <= 3
+    pag.store.close()
+
+
+def test_all_components_too_large(tmp_path):
+    with pytest.raises(ValueError) as einfo:
+        PagedAssemblyGraph(
+            "metagenomescope/tests/input/sample1.gfa",
+            max_node_count=0,
+            max_edge_count=0,
+            temp_dir=str(tmp_path),
+        )
+    assert "All components were too large to lay out." in str(einfo.value)
+    assert os.listdir(str(tmp_path)) == []
+
+
+def test_check_attrs(tmp_path):
+    with pytest.raises(ValueError) as einfo:
+        PagedAssemblyGraph(
+            "metagenomescope/tests/input/check_attrs_test_node.gml",
+            temp_dir=str(tmp_path),
+        )
+    assert "has reserved attribute(s) {'height'}." in str(einfo.value)
+    # Should match AssemblyGraph's error
+    with pytest.raises(ValueError) as einfo2:
+        AssemblyGraph("metagenomescope/tests/input/check_attrs_test_node.gml")
+    assert str(einfo.value) == str(einfo2.value)
+    assert os.listdir(str(tmp_path)) == []
+
+
+def test_one_layout_progress_over_all_pages(capsys, tmp_path):
+    pag = PagedAssemblyGraph(
+        "metagenomescope/tests/input/sample1.gfa",
+        page_node_count=3,
+        temp_dir=str(tmp_path),
+    )
+    num_pages = len(pag.get_pages())
+    assert num_pages > 1
+    pag.process()
+    lines = capsys.readouterr().out.splitlines()
+    progress_lines = [
+        line for line in lines if line.startswith("Layout progress: ")
+    ]
+    # One line when we start, and one when we're done with the last page
+    assert len(progress_lines) == 2
+    assert progress_lines[0].startswith("Layout progress: components=0/4 ")
+    assert progress_lines[1].startswith(
+        "Layout progress: components=4/4 patterns=2/2 elements=20/20 "
+    )
+
+
+def test_components_saved_as_each_page_finishes(tmp_path):
+    pag = PagedAssemblyGraph(
+        "metagenomescope/tests/input/sample1.gfa",
+        page_node_count=3,
+        temp_dir=str(tmp_path),
+    )
+    pages = pag.get_pages()
+    saved = []
+    save = pag.save_components
+
+    def record_save(components):
+        saved.append(len(components))
+        save(components)
+
+    pag.save_components = record_save
+    pag.process()
+    # One save per page, right after that page is processed
+    assert saved == [len(p) for p in pages]
+    assert len(pag.component_info) == sum(saved)
+    # Reading the components back in gives the same output every time
+    assert list(pag.iter_components()) == pag.to_dict()["components"]
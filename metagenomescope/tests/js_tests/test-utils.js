@@ -127,4 +127,376 @@ define(["utils", "mocha", "chai", "underscore"], function (
             chai.assert.equal(utils.leftPad(99), "99");
         });
     });
+
+    describe("utils.visibleFraction()", function () {
+        var box = { x1: 0, y1: 0, x2: 10, y2: 10 };
+        it("Returns 1 when the box is entirely visible", function () {
+            chai.assert.equal(
+                utils.visibleFraction(box, { x1: -5, y1: -5, x2: 20, y2: 20 }),
+                1
+            );
+        });
+        it("Returns 0 when the box is entirely offscreen", function () {
+            chai.assert.equal(
+                utils.visibleFraction(box, { x1: 11, y1: 0, x2: 20, y2: 10 }),
+                0
+            );
+        });
+        it("Computes partial overlaps", function () {
+            chai.assert.equal(
+                utils.visibleFraction(box, { x1: 5, y1: 5, x2: 20, y2: 20 }),
+                0.25
+            );
+        });
+    });
+
+    describe("utils.expandBox()", function () {
+        it("Grows the box on every side", function () {
+            chai.assert.deepEqual(
+                utils.expandBox({ x1: 0, y1: 10, x2: 10, y2: 30 }, 0.5),
+                { x1: -5, y1: 0, x2: 15, y2: 40 }
+            );
+        });
+        it("Leaves the box alone if the fraction is 0", function () {
+            chai.assert.deepEqual(
+                utils.expandBox({ x1: 0, y1: 10, x2: 10, y2: 30 }, 0),
+                { x1: 0, y1: 10, x2: 10, y2: 30 }
+            );
+        });
+    });
+
+    describe("utils.boxesOverlap()", function () {
+        var box = { x1: 0, y1: 0, x2: 10, y2: 10 };
+        it("Detects overlapping and touching boxes", function () {
+            chai.assert.isTrue(
+                utils.boxesOverlap(box, { x1: 5, y1: 5, x2: 20, y2: 20 })
+            );
+            chai.assert.isTrue(
+                utils.boxesOverlap(box, { x1: 10, y1: 0, x2: 20, y2: 10 })
+            );
+            // Points count as boxes, too
+            chai.assert.isTrue(
+                utils.boxesOverlap({ x1: 3, y1: 3, x2: 3, y2: 3 }, box)
+            );
+        });
+        it("Detects boxes that don't overlap", function () {
+            chai.assert.isFalse(
+                utils.boxesOverlap(box, { x1: 11, y1: 0, x2: 20, y2: 10 })
+            );
+            chai.assert.isFalse(
+                utils.boxesOverlap(box, { x1: 0, y1: -5, x2: 10, y2: -1 })
+            );
+        });
+    });
+
+    describe("utils.chooseZoomLevel()", function () {
+        var levelSizes = [500, 250, 100];
+        it("Draws the actual component when it's small enough", function () {
+            chai.assert.equal(
+                utils.chooseZoomLevel(levelSizes, 1000, 1, 1000),
+                -1
+            );
+            chai.assert.equal(
+                utils.chooseZoomLevel(levelSizes, 1000, 0.1, 100),
+                -1
+            );
+        });
+        it("Picks the finest level that fits", function () {
+            chai.assert.equal(
+                utils.chooseZoomLevel(levelSizes, 1000, 1, 500),
+                0
+            );
+            chai.assert.equal(
+                utils.chooseZoomLevel(levelSizes, 1000, 1, 300),
+                1
+            );
+            chai.assert.equal(
+                utils.chooseZoomLevel(levelSizes, 1000, 0.5, 60),
+                2
+            );
+        });
+        it("Falls back to the coarsest level", function () {
+            chai.assert.equal(
+                utils.chooseZoomLevel(levelSizes, 1000, 1, 10),
+                2
+            );
+        });
+    });
+
+    describe("utils.chooseTileLevel()", function () {
+        it("Shows level 0 when zoomed out", function () {
+            chai.assert.equal(utils.chooseTileLevel(5, 0.1, 0.05), 0);
+            chai.assert.equal(utils.chooseTileLevel(5, 0.1, 0.1), 0);
+        });
+        it("Picks the coarsest level that's detailed enough", function () {
+            chai.assert.equal(utils.chooseTileLevel(5, 0.1, 0.2), 1);
+            chai.assert.equal(utils.chooseTileLevel(5, 0.1, 0.21), 2);
+            chai.assert.equal(utils.chooseTileLevel(5, 0.1, 0.4), 2);
+        });
+        it("Doesn't go past the finest level", function () {
+            chai.assert.equal(utils.chooseTileLevel(5, 0.1, 100), 4);
+        });
+    });
+
+    describe("utils.visibleTiles()", function () {
+        var names = ["0_0", "1_0", "0_1", "1_1", "2_1"];
+        it("Returns tiles overlapping the viewport", function () {
+            chai.assert.sameMembers(
+                utils.visibleTiles(names, 10, -20, 5, {
+                    x1: -15,
+                    y1: 0,
+                    x2: -5,
+                    y2: 10,
+                }),
+                ["0_0", "1_0"]
+            );
+            chai.assert.sameMembers(
+                utils.visibleTiles(names, 10, -20, 5, {
+                    x1: -1,
+                    y1: 16,
+                    x2: 100,
+                    y2: 100,
+                }),
+                ["1_1", "2_1"]
+            );
+        });
+        it("Returns nothing when the viewport is elsewhere", function () {
+            chai.assert.isEmpty(
+                utils.visibleTiles(names, 10, -20, 5, {
+                    x1: 100,
+                    y1: 100,
+                    x2: 200,
+                    y2: 200,
+                })
+            );
+        });
+        it("Returns everything when the viewport is null", function () {
+            chai.assert.deepEqual(
+                utils.visibleTiles(names, 10, -20, 5, null),
+                names
+            );
+        });
+    });
+
+    describe("utils.getVisibleRowRange()", function () {
+        it("Draws the visible rows plus some overscan", function () {
+            chai.assert.deepEqual(
+                utils.getVisibleRowRange(250, 100, 25, 10000, 2),
+                { start: 8, end: 16 }
+            );
+        });
+        it("Clamps the range to the list", function () {
+            chai.assert.deepEqual(
+                utils.getVisibleRowRange(0, 100, 25, 3, 10),
+                { start: 0, end: 3 }
+            );
+            chai.assert.deepEqual(
+                utils.getVisibleRowRange(1000, 100, 25, 10, 2),
+                { start: 10, end: 10 }
+            );
+        });
+        it("Handles stuff above the list", function () {
+            // List starts 50px below the top of the scrolled area
+            chai.assert.deepEqual(
+                utils.getVisibleRowRange(-50, 100, 25, 100, 0),
+                { start: 0, end: 2 }
+            );
+            // List is entirely below the visible area
+            chai.assert.deepEqual(
+                utils.getVisibleRowRange(-500, 100, 25, 100, 0),
+                { start: 0, end: 0 }
+            );
+        });
+    });
+    describe("dpiToScale()", function () {
+        it("Treats 96 DPI as the size of the view", function () {
+            chai.assert.equal(utils.dpiToScale(96), 1);
+            chai.assert.equal(utils.dpiToScale(300), 3.125);
+            chai.assert.equal(utils.dpiToScale(48), 0.5);
+        });
+        it("Throws an error on invalid DPIs", function () {
+            _.each([0, -96, NaN, Infinity, "96"], function (dpi) {
+                chai.assert.throws(function () {
+                    utils.dpiToScale(dpi);
+                }, /DPI must be a positive number/);
+            });
+        });
+    });
+    describe("getExportTileGrid()", function () {
+        it("Uses one tile when the scale is at most 1", function () {
+            chai.assert.deepEqual(utils.getExportTileGrid(800, 600, 1), {
+                width: 800,
+                height: 600,
+                tiles: [{ x: 0, y: 0 }],
+            });
+            chai.assert.deepEqual(utils.getExportTileGrid(800, 600, 0.5), {
+                width: 400,
+                height: 300,
+                tiles: [{ x: 0, y: 0 }],
+            });
+        });
+        it("Covers bigger images with view-sized tiles", function () {
+            var grid = utils.getExportTileGrid(800, 600, 2.5);
+            chai.assert.equal(grid.width, 2000);
+            chai.assert.equal(grid.height, 1500);
+            // 3 columns x 3 rows
+            chai.assert.deepEqual(grid.tiles, [
+                { x: 0, y: 0 },
+                { x: 800, y: 0 },
+                { x: 1600, y: 0 },
+                { x: 0, y: 600 },
+                { x: 800, y: 600 },
+                { x: 1600, y: 600 },
+                { x: 0, y: 1200 },
+                { x: 800, y: 1200 },
+                { x: 1600, y: 1200 },
+            ]);
+        });
+    });
+    describe("parseComponentFilter()", function () {
+        var numCols = ["nodes", "gc"];
+        var textCols = ["status"];
+        it("Parses conditions", function () {
+            chai.assert.deepEqual(
+                utils.parseComponentFilter(
+                    "  nodes>=10 GC<0.5\tstatus!=skipped ",
+                    numCols,
+                    textCols
+                ),
+                [
+                    { col: "nodes", op: ">=", value: 10 },
+                    { col: "gc", op: "<", value: 0.5 },
+                    { col: "status", op: "!=", value: "skipped" },
+                ]
+            );
+        });
+        it("Returns an empty Array for empty filters", function () {
+            chai.assert.isEmpty(utils.parseComponentFilter("", [], []));
+            chai.assert.isEmpty(utils.parseComponentFilter("  ", [], []));
+        });
+        it("Throws an error on invalid conditions", function () {
+            chai.assert.throws(function () {
+                utils.parseComponentFilter("nodes", numCols, textCols);
+            }, /Invalid filter condition: "nodes"/);
+            chai.assert.throws(function () {
+                utils.parseComponentFilter("nodes>abc", numCols, textCols);
+            }, /Invalid number/);
+            chai.assert.throws(function () {
+                utils.parseComponentFilter("status<a", numCols, textCols);
+            }, /can only be used with = or !=/);
+            chai.assert.throws(function () {
+                utils.parseComponentFilter("color=red", numCols, textCols);
+            }, /Unrecognized column in filter: "color"/);
+        });
+    });
+    describe("filterAndSortComponents()", function () {
+        var summary = {
+            nodes: [null, 5, 2, 5, 1],
+            gc: [null, 0.4, null, 0.6, 0.5],
+            status: ["skipped", "full", "degraded", "full", "full"],
+        };
+        it("Sorts by size rank", function () {
+            chai.assert.deepEqual(
+                utils.filterAndSortComponents(summary, [], "rank", true),
+                [1, 2, 3, 4, 5]
+            );
+            chai.assert.deepEqual(
+                utils.filterAndSortComponents(summary, [], "rank", false),
+                [5, 4, 3, 2, 1]
+            );
+        });
+        it("Sorts by a column, with nulls last and ties by rank", function () {
+            chai.assert.deepEqual(
+                utils.filterAndSortComponents(summary, [], "nodes", true),
+                [5, 3, 2, 4, 1]
+            );
+            chai.assert.deepEqual(
+                utils.filterAndSortComponents(summary, [], "nodes", false),
+                [2, 4, 3, 5, 1]
+            );
+            chai.assert.deepEqual(
+                utils.filterAndSortComponents(summary, [], "gc", false),
+                [4, 5, 2, 1, 3]
+            );
+        });
+        it("Filters components", function () {
+            var conds = [
+                { col: "nodes", op: ">", value: 1 },
+                { col: "status", op: "!=", value: "degraded" },
+            ];
+            chai.assert.deepEqual(
+                utils.filterAndSortComponents(summary, conds, "rank", true),
+                [2, 4]
+            );
+            // Nulls never pass numeric conditions
+            conds = [{ col: "gc", op: "<=", value: 1 }];
+            chai.assert.deepEqual(
+                utils.filterAndSortComponents(summary, conds, "rank", true),
+                [2, 4, 5]
+            );
+            conds = [{ col: "status", op: "=", value: "full" }];
+            chai.assert.deepEqual(
+                utils.filterAndSortComponents(summary, conds, "gc", true),
+                [2, 5, 4]
+            );
+        });
+    });
+    describe("getNodeColorization()", function () {
+        var minRGB = { r: 0, g: 16, b: 255 };
+        var maxRGB = { r: 255, g: 16, b: 0 };
+        it("Scales between the two colors", function () {
+            chai.assert.equal(
+                utils.getNodeColorization(0, minRGB, maxRGB),
+                "#0010ff"
+            );
+            chai.assert.equal(
+                utils.getNodeColorization(1, minRGB, maxRGB),
+                "#ff1000"
+            );
+            chai.assert.equal(
+                utils.getNodeColorization(0.5, minRGB, maxRGB),
+                "#801080"
+            );
+        });
+    });
+    describe("getAnnotationColor()", function () {
+        it("Colors categorical annotations", function () {
+            var col = { type: "categorical", values: ["a", "b"] };
+            var numColors = utils.CATEGORY_COLORS.length;
+            chai.assert.equal(
+                utils.getAnnotationColor(col, 0),
+                utils.CATEGORY_COLORS[0]
+            );
+            chai.assert.equal(
+                utils.getAnnotationColor(col, 1),
+                utils.CATEGORY_COLORS[1]
+            );
+            // Colors are reused when there are lots of categories
+            chai.assert.equal(
+                utils.getAnnotationColor(col, numColors + 1),
+                utils.CATEGORY_COLORS[1]
+            );
+        });
+        it("Colors numeric annotations", function () {
+            var col = { type: "numeric", min: 10, max: 20 };
+            var lo = utils.getAnnotationColor(col, 10);
+            var hi = utils.getAnnotationColor(col, 20);
+            chai.assert.notEqual(lo, hi);
+            chai.assert.match(
+                utils.getAnnotationColor(col, 15),
+                /^#[0-9a-f]{6}$/
+            );
+            // Out-of-range values are clamped
+            chai.assert.equal(utils.getAnnotationColor(col, 5), lo);
+            chai.assert.equal(utils.getAnnotationColor(col, 25), hi);
+            // All values are the same: don't divide by zero
+            col = { type: "numeric", min: 3, max: 3 };
+            chai.assert.equal(utils.getAnnotationColor(col, 3), lo);
+        });
+        it("Returns null for missing values", function () {
+            var col = { type: "numeric", min: 10, max: 20 };
+            chai.assert.isNull(utils.getAnnotationColor(col, null));
+            chai.assert.isNull(utils.getAnnotationColor(col, undefined));
+        });
+    });
 });
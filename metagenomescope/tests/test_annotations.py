@@ -0,0 +1,328 @@
+import os
+import pytest
+from metagenomescope import config
+from metagenomescope.graph_objects import AssemblyGraph
+from metagenomescope.tests.utils import (
+    get_graph_dict,
+    read_define_js,
+    run_make_viz,
+    SAMPLE1,
+)
+from metagenomescope.annotations import (
+    get_name_index,
+    round_value,
+    new_column,
+    set_value,
+    get_value,
+    finish_column,
+    write_annotation_tables,
+)
+
+SAMPLE1_ANNOTATIONS = "metagenomescope/tests/input/sample1_annotations.tsv"
+
+
+def read_table(output_dir, cc_num):
+    return read_define_js(
+        os.path.join(
+            output_dir, config.ANNOTATIONS_DIR_NAME, "{}.js".format(cc_num)
+        )
+    )
+
+
+def write_tsv(path, lines):
+    with open(str(path), "w") as f:
+        f.write("\n".join("\t".join(fields) for fields in lines) + "\n")
+    return str(path)
+
+
+def get_names(graph_dict, cmp_idx, node_ids):
+    nodes = graph_dict["components"][cmp_idx]["nodes"]
+    name_pos = graph_dict["node_attrs"]["name"]
+    return [nodes[n][name_pos] for n in node_ids]
+
+
+def test_get_name_index():
+    graph_dict = get_graph_dict(SAMPLE1)
+    name2nodes = get_name_index(graph_dict)
+    # sample1.gfa has 6 nodes, plus their reverse complements
+    assert len(name2nodes) == 12
+    for name, nodes in name2nodes.items():
+        assert len(nodes) == 1
+        cmp_idx, node_id = nodes[0]
+        assert get_names(graph_dict, cmp_idx, [node_id]) == [name]
+
+
+def test_get_name_index_ignores_skipped_components():
+    ag = AssemblyGraph(
+        "metagenomescope/tests/input/E_coli_LastGraph",
+        max_node_count=20,
+        max_edge_count=20,
+    )
+    ag.process()
+    graph_dict = ag.to_dict()
+    skipped = set(
+        i for i, c in enumerate(graph_dict["components"]) if c["skipped"]
+    )
+    assert len(skipped) > 0
+    for nodes in get_name_index(graph_dict).values():
+        for cmp_idx, node_id in nodes:
+            assert cmp_idx not in skipped
+
+
+def test_round_value(monkeypatch):
+    monkeypatch.setattr(config, "ANNOTATION_SIG_DIGITS", 4)
+    assert round_value(3.14159) == 3.142
+    assert round_value(0.000123456) == 0.0001235
+    assert round_value(10.0) == 10
+    assert type(round_value(10.0)) == int
+    assert round_value(123456.7) == 123500
+
+
+def make_column(name, texts):
+    col = new_column(name)
+    for slot, text in enumerate(texts):
+        if text is not None:
+            assert set_value(col, slot, text)
+    return col
+
+
+def test_finish_column():
+    col = make_column("cov", ["1.5", "2", None, "-3e2"])
+    assert finish_column(col) == {
+        "name": "cov",
+        "type": "numeric",
+        "min": -300,
+        "max": 2,
+    }
+    assert [get_value(col, s) for s in range(5)] == [1.5, 2, None, -300, None]
+
+    col = make_column("bin", ["bin.1", "7", None, "bin.2", "7"])
+    assert finish_column(col) == {
+        "name": "bin",
+        "type": "categorical",
+        "values": ["bin.1", "7", "bin.2"],
+    }
+    assert [get_value(col, s) for s in range(6)] == [0, 1, None, 2, 1, None]
+
+    # Infinite values aren't "numbers," so this isn't numeric
+    col = new_column("x")
+    assert set_value(col, 0, "inf")
+    assert set_value(col, 1, "1")
+    assert finish_column(col)["type"] == "categorical"
+
+    # Columns without any values are categorical
+    assert finish_column(new_column("empty")) == {
+        "name": "empty",
+        "type": "categorical",
+        "values": [],
+    }
+
+
+def test_set_value_after_numbers():
+    # Once a column has numbers in it, we can't turn it into a categorical
+    # column on the spot (we don't know how these numbers were written)
+    col = make_column("x", ["1.50"])
+    assert not set_value(col, 1, "abc")
+    assert col["type"] == "numeric"
+    assert get_value(col, 1) is None
+
+
+def test_write_annotation_tables(tmp_path):
+    graph_dict = get_graph_dict(SAMPLE1)
+    info, file_stats = write_annotation_tables(
+        graph_dict, [SAMPLE1_ANNOTATIONS], str(tmp_path)
+    )
+    # not_in_graph isn't a node, so it isn't matched
+    assert file_stats == [(6, 5)]
+    assert info["dir"] == config.ANNOTATIONS_DIR_NAME
+    assert info["columns"] == [
+        {
+            "name": "bin",
+            "type": "categorical",
+            "values": ["bin.1", "bin.2", "bin.3"],
+        },
+        {"name": "cov_s1", "type": "numeric", "min": 3.142, "max": 1000000},
+        {"name": "cov_s2", "type": "numeric", "min": 0, "max": 2},
+    ]
+    # The component containing -6 doesn't have any annotated nodes
+    name2nodes = get_name_index(graph_dict)
+    unannotated_cmp = name2nodes["-6"][0][0]
+    assert unannotated_cmp not in info["components"]
+    assert len(info["components"]) == 3
+    assert sorted(os.listdir(tmp_path / config.ANNOTATIONS_DIR_NAME)) == [
+        "{}.js".format(i + 1) for i in info["components"]
+    ]
+
+    # Collect all of the annotations from the side tables
+    name2annotations = {}
+    for cmp_idx in info["components"]:
+        table = read_table(str(tmp_path), cmp_idx + 1)
+        names = get_names(graph_dict, cmp_idx, table["node_ids"])
+        for r, name in enumerate(names):
+            name2annotations[name] = {
+                col: vals[r] for col, vals in table["cols"].items()
+            }
+    assert name2annotations == {
+        "1": {"bin": 0, "cov_s1": 10.5, "cov_s2": 0},
+        "-1": {"bin": 0, "cov_s1": 10.5, "cov_s2": 0},
+        "2": {"bin": 1, "cov_s1": 3.142, "cov_s2": None},
+        "3": {"bin": 0, "cov_s1": 1000000, "cov_s2": 2},
+        # Columns without any values in a component are left out
+        "6": {"bin": 2, "cov_s1": 7},
+    }
+
+
+def test_write_annotation_tables_multiple_files(tmp_path):
+    graph_dict = get_graph_dict(SAMPLE1)
+    taxa = write_tsv(
+        tmp_path / "taxa.tsv",
+        [
+            ["node", "taxonomy"],
+            ["2", "E. coli"],
+            # Later rows win
+            ["4", "B. subtilis"],
+            ["4", "S. aureus"],
+        ],
+    )
+    out_dir = tmp_path / "out"
+    info, file_stats = write_annotation_tables(
+        graph_dict, [SAMPLE1_ANNOTATIONS, taxa], str(out_dir)
+    )
+    assert file_stats == [(6, 5), (3, 3)]
+    assert [c["name"] for c in info["columns"]] == [
+        "bin",
+        "cov_s1",
+        "cov_s2",
+        "taxonomy",
+    ]
+    assert info["columns"][3]["values"] == [
+        "E. coli",
+        "B. subtilis",
+        "S. aureus",
+    ]
+    name2nodes = get_name_index(graph_dict)
+    cmp_idx, node_id = name2nodes["4"][0]
+    table = read_table(str(out_dir), cmp_idx + 1)
+    r = table["node_ids"].index(node_id)
+    assert table["cols"]["taxonomy"][r] == 2
+    # 4 isn't in the first file
+    assert table["cols"]["bin"][r] is None
+
+
+def test_write_annotation_tables_late_categorical_column(tmp_path):
+    graph_dict = get_graph_dict(SAMPLE1)
+    tsv = write_tsv(
+        tmp_path / "a.tsv",
+        [
+            ["name", "bin", "cov"],
+            ["1", "1.50", "5"],
+            ["not_in_graph", "abc", "6"],
+            ["2", "", "7"],
+            ["3", "bin.3", "NA"],
+            ["1", "2", ""],
+        ],
+    )
+    out_dir = tmp_path / "out"
+    info, file_stats = write_annotation_tables(graph_dict, [tsv], str(out_dir))
+    assert file_stats == [(5, 4)]
+    # bin is read in again, so its numbers keep their original text (and
+    # "abc" isn't included, since it isn't for a node in the graph)
+    assert info["columns"] == [
+        {
+            "name": "bin",
+            "type": "categorical",
+            "values": ["1.50", "bin.3", "2"],
+        },
+        {"name": "cov", "type": "numeric", "min": 5, "max": 7},
+    ]
+    name2nodes = get_name_index(graph_dict)
+    name2annotations = {}
+    for name in ("1", "2", "3"):
+        cmp_idx, node_id = name2nodes[name][0]
+        table = read_table(str(out_dir), cmp_idx + 1)
+        r = table["node_ids"].index(node_id)
+        name2annotations[name] = (
+            table["cols"]["bin"][r],
+            table["cols"]["cov"][r],
+        )
+    # Later values win, unless they're missing
+    assert name2annotations == {
+        "1": (2, 5),
+        "2": (None, 7),
+        "3": (1, None),
+    }
+
+
+def test_write_annotation_tables_no_matches(tmp_path):
+    graph_dict = get_graph_dict(SAMPLE1)
+    tsv = write_tsv(tmp_path / "a.tsv", [["name", "bin"], ["abc", "bin.1"]])
+    out_dir = tmp_path / "out"
+    info, file_stats = write_annotation_tables(graph_dict, [tsv], str(out_dir))
+    assert file_stats == [(1, 0)]
+    assert info["components"] == []
+    assert info["columns"] == [
+        {"name": "bin", "type": "categorical", "values": []}
+    ]
+    assert not os.path.exists(str(out_dir))
+
+
+def test_write_annotation_tables_errors(tmp_path):
+    graph_dict = get_graph_dict(SAMPLE1)
+    out_dir = str(tmp_path / "out")
+
+    empty = tmp_path / "empty.tsv"
+    empty.write_text("")
+    with pytest.raises(ValueError) as ei:
+        write_annotation_tables(graph_dict, [str(empty)], out_dir)
+    assert str(ei.value) == "Annotation file {} is empty.".format(empty)
+
+    no_cols = write_tsv(tmp_path / "no_cols.tsv", [["name"], ["1"]])
+    with pytest.raises(ValueError) as ei:
+        write_annotation_tables(graph_dict, [no_cols], out_dir)
+    assert "doesn't have any annotation columns" in str(ei.value)
+
+    dup_cols = write_tsv(
+        tmp_path / "dup_cols.tsv", [["name", "bin", "bin"], ["1", "a", "b"]]
+    )
+    with pytest.raises(ValueError) as ei:
+        write_annotation_tables(graph_dict, [dup_cols], out_dir)
+    assert str(ei.value) == "Annotation column bin is given more than once."
+
+    # Same thing, but across files
+    with pytest.raises(ValueError) as ei:
+        write_annotation_tables(
+            graph_dict, [SAMPLE1_ANNOTATIONS, SAMPLE1_ANNOTATIONS], out_dir
+        )
+    assert str(ei.value) == "Annotation column bin is given more than once."
+
+    ragged = write_tsv(
+        tmp_path / "ragged.tsv",
+        [["name", "bin", "cov"], ["1", "a", "3"], ["2", "b"]],
+    )
+    with pytest.raises(ValueError) as ei:
+        write_annotation_tables(graph_dict, [ragged], out_dir)
+    assert str(ei.value) == (
+        "Line 3 of annotation file {} has 2 field(s), but the header has "
+        "3.".format(ragged)
+    )
+
+
+def test_make_viz_annotations(tmp_path):
+    out_dir = run_make_viz(tmp_path, annotation_files=(SAMPLE1_ANNOTATIONS,))
+    assert os.path.isdir(str(out_dir / config.ANNOTATIONS_DIR_NAME))
+    with open(str(out_dir / "data.js"), "r") as f:
+        assert '"annotations": {"dir": "annotations"' in f.read()
+
+
+def test_make_viz_missing_annotation_file(tmp_path):
+    from metagenomescope.main import make_viz
+
+    with pytest.raises(ValueError) as ei:
+        make_viz(
+            SAMPLE1,
+            str(tmp_path / "out"),
+            100,
+            100,
+            annotation_files=("nonexistent.tsv",),
+        )
+    assert str(ei.value) == "Annotation file nonexistent.tsv doesn't exist."
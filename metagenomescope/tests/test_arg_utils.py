@@ -21,7 +21,8 @@
 import os
 import tempfile
 import pytest
-from metagenomescope import arg_utils
+from metagenomescope import arg_utils, config
+from metagenomescope.layout_cost import LayoutCostModel
 
 
 def test_validate_max_counts():
@@ -77,3 +78,52 @@ def test_create_output_dir():
         # the actual error message includes some extra text (e.g. "[Errno 17]")
         # so we get around this by just checking part of the message looks ok
         assert "File exists: '{}'".format(tmpdir) in str(e.value)
+
+
+def test_validate_time_budget_and_layout_workers():
+    with pytest.raises(ValueError) as e:
+        arg_utils.validate_time_budget(0)
+    assert "Time budget must be positive" == str(e.value)
+    arg_utils.validate_time_budget(0.5)
+
+    with pytest.raises(ValueError) as e:
+        arg_utils.validate_layout_workers(0)
+    assert "Number of layout workers must be at least 1" == str(e.value)
+    arg_utils.validate_layout_workers(1)
+
+
+def test_validate_decomposition_workers():
+    with pytest.raises(ValueError) as e:
+        arg_utils.validate_decomposition_workers(0)
+    assert "Number of decomposition workers must be at least 1" == str(e.value)
+    arg_utils.validate_decomposition_workers(3)
+
+
+def test_validate_decomposition_limits():
+    arg_utils.validate_decomposition_limits(None, None, None)
+    arg_utils.validate_decomposition_limits(0.5, 1, 1)
+    for args, msg in (
+        ((0, None, None), "Decomposition time limit must be positive"),
+        ((None, 0, None), "Maximum decomposition calls must be at least 1"),
+        ((None, None, 0), "Maximum pattern depth must be at least 1"),
+    ):
+        with pytest.raises(ValueError) as e:
+            arg_utils.validate_decomposition_limits(*args)
+        assert msg == str(e.value)
+
+
+def test_get_max_counts():
+    m = LayoutCostModel()
+    # Explicitly-given values should always be kept
+    assert arg_utils.get_max_counts(5, 6, None, m) == (5, 6)
+    assert arg_utils.get_max_counts(5, 6, 10, m) == (5, 6)
+    # No time budget: use the defaults
+    assert arg_utils.get_max_counts(None, None, None, m) == (
+        config.MAXN_DEFAULT,
+        config.MAXE_DEFAULT,
+    )
+    # Time budget: use the cost model
+    auto_ct = m.get_max_component_size(10)
+    assert arg_utils.get_max_counts(None, 6, 10, m) == (auto_ct, 6)
+    # ... but never go below 1
+    assert arg_utils.get_max_counts(None, None, 1e-9, m) == (1, 1)
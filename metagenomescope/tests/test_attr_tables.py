@@ -0,0 +1,118 @@
+import os
+import json
+from metagenomescope import config
+from metagenomescope.graph_objects import AssemblyGraph
+from metagenomescope.tests.utils import (
+    get_graph_dict,
+    read_define_js,
+    run_make_viz,
+    read_data_js,
+)
+from metagenomescope.attr_tables import get_core_attrs, write_attr_tables
+
+
+def test_get_core_attrs():
+    attrs = {"name": 0, "depth": 1, "x": 2, "gc_content": 3, "y": 4}
+    assert get_core_attrs(attrs, ["depth", "gc_content"]) == (
+        {"name": 0, "x": 1, "y": 2},
+        [0, 2, 4],
+    )
+    assert get_core_attrs(attrs, []) == (attrs, [0, 1, 2, 3, 4])
+
+
+def test_write_attr_tables(tmp_path):
+    graph_dict = get_graph_dict()
+    orig = json.loads(json.dumps(graph_dict))
+    viewer_dict = write_attr_tables(graph_dict, str(tmp_path))
+
+    # The original data isn't modified
+    assert json.loads(json.dumps(graph_dict)) == orig
+
+    na = graph_dict["node_attrs"]
+    ea = graph_dict["edge_attrs"]
+    vna = viewer_dict["node_attrs"]
+    vea = viewer_dict["edge_attrs"]
+    assert graph_dict["extra_node_attrs"] == ["depth", "gc_content"]
+    assert graph_dict["extra_edge_attrs"] == ["multiplicity"]
+    assert set(vna) == set(na) - {"depth", "gc_content"}
+    assert set(vea) == set(ea) - {"multiplicity"}
+    assert viewer_dict["attr_tables_dir"] == config.ATTR_TABLES_DIR_NAME
+    # The viewer still needs to know what the extra attrs are
+    assert viewer_dict["extra_node_attrs"] == ["depth", "gc_content"]
+
+    tables_dir = tmp_path / config.ATTR_TABLES_DIR_NAME
+    assert sorted(os.listdir(tables_dir)) == sorted(
+        "{}.js".format(i + 1) for i in range(len(graph_dict["components"]))
+    )
+    for cc_num, comp in enumerate(graph_dict["components"], 1):
+        vcomp = viewer_dict["components"][cc_num - 1]
+        table = read_define_js(str(tables_dir / "{}.js".format(cc_num)))
+
+        # Core attrs are still in the viewer data, and extra attrs are in
+        # the side table
+        assert len(table["node_ids"]) == len(comp["nodes"])
+        for r, node_id in enumerate(table["node_ids"]):
+            data = comp["nodes"][node_id]
+            vdata = vcomp["nodes"][node_id]
+            assert len(vdata) == len(vna)
+            for attr, i in vna.items():
+                assert vdata[i] == data[na[attr]]
+            for attr in ("depth", "gc_content"):
+                assert table["node_cols"][attr][r] == data[na[attr]]
+
+        num_edges = sum(len(tgts) for tgts in comp["edges"].values())
+        assert len(table["edge_ids"]) == num_edges
+        for r, (src, tgt) in enumerate(table["edge_ids"]):
+            data = comp["edges"][src][tgt]
+            vdata = vcomp["edges"][src][tgt]
+            assert len(vdata) == len(vea)
+            for attr, i in vea.items():
+                assert vdata[i] == data[ea[attr]]
+            assert table["edge_cols"]["multiplicity"][r] == (
+                data[ea["multiplicity"]]
+            )
+
+
+def test_write_attr_tables_skipped_components(tmp_path):
+    ag = AssemblyGraph(
+        "metagenomescope/tests/input/E_coli_LastGraph",
+        max_node_count=20,
+        max_edge_count=20,
+    )
+    ag.process()
+    graph_dict = ag.to_dict()
+    num_skipped = sum(c["skipped"] for c in graph_dict["components"])
+    assert num_skipped > 0
+    viewer_dict = write_attr_tables(graph_dict, str(tmp_path))
+    # Skipped components' placeholders get passed through as is
+    assert (
+        viewer_dict["components"][:num_skipped]
+        == graph_dict["components"][:num_skipped]
+    )
+    assert sorted(
+        os.listdir(tmp_path / config.ATTR_TABLES_DIR_NAME),
+        key=lambda fn: int(fn[:-3]),
+    ) == [
+        "{}.js".format(i)
+        for i in range(num_skipped + 1, len(graph_dict["components"]) + 1)
+    ]
+
+
+def test_write_attr_tables_no_extra_attrs(tmp_path):
+    graph_dict = get_graph_dict("metagenomescope/tests/input/loop.gfa")
+    # GFA files always have GC content; just act like this is a core attr
+    assert graph_dict["extra_node_attrs"] == ["gc_content"]
+    assert graph_dict["extra_edge_attrs"] == []
+    graph_dict["extra_node_attrs"] = []
+    viewer_dict = write_attr_tables(graph_dict, str(tmp_path))
+    assert not os.path.exists(str(tmp_path / config.ATTR_TABLES_DIR_NAME))
+    assert viewer_dict["components"] is graph_dict["components"]
+
+
+def test_make_viz_attr_tables(tmp_path):
+    out_dir = run_make_viz(tmp_path)
+    data = read_data_js(out_dir)
+    assert "gc_content" not in data["node_attrs"]
+    assert data["extra_node_attrs"] == ["gc_content"]
+    table = read_define_js(str(out_dir / config.ATTR_TABLES_DIR_NAME / "1.js"))
+    assert len(table["node_cols"]["gc_content"]) == len(table["node_ids"])
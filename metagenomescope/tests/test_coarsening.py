@@ -0,0 +1,130 @@
+from metagenomescope import config
+from metagenomescope.coarsening import (
+    coarsen_once,
+    merge_boxes,
+    build_zoom_levels,
+)
+from metagenomescope.graph_objects import AssemblyGraph
+
+
+def path_edges(n):
+    return {(i, i + 1): 1 for i in range(n - 1)}
+
+
+def test_coarsen_once_path():
+    # 0 - 1 - 2 - 3: the endpoints have the lowest degree, so they get
+    # matched first
+    groups, weights, edges = coarsen_once([1, 1, 1, 1], path_edges(4))
+    assert groups == [[0, 1], [2, 3]]
+    assert weights == [2, 2]
+    assert edges == {(0, 1): 1}
+
+
+def test_coarsen_once_prefers_heavy_edges():
+    # 0 is matched first, and its edge to 2 is heavier than its edge to 1.
+    # Then 3 is matched with 1, and 4 (whose neighbors are both taken) is
+    # absorbed into 2's group.
+    groups, weights, edges = coarsen_once(
+        [1] * 5,
+        {(0, 1): 1, (0, 2): 5, (1, 2): 1, (1, 3): 1, (2, 4): 1, (3, 4): 1},
+    )
+    assert groups == [[0, 2, 4], [1, 3]]
+    assert weights == [3, 2]
+    # (0, 1) + (1, 2) + (3, 4)
+    assert edges == {(0, 1): 3}
+
+
+def test_coarsen_once_ties_prefer_light_nodes():
+    # 1 has degree 2, so it's matched before 0; 0 and 2 both connect to 1
+    # with the same weight, but 2 is lighter
+    groups, weights, edges = coarsen_once(
+        [1, 1, 1, 1, 1], {(0, 1): 1, (1, 2): 1, (0, 3): 1, (0, 4): 1}
+    )
+    assert [1, 2] in groups
+
+
+def test_coarsen_once_star():
+    # A star with 6 leaves: only one leaf can be matched with the center, but
+    # the other leaves get absorbed into the center's group
+    edges = {(0, i): 1 for i in range(1, 7)}
+    groups, weights, new_edges = coarsen_once([1] * 7, edges)
+    assert groups == [list(range(7))]
+    assert weights == [7]
+    assert new_edges == {}
+
+
+def test_coarsen_once_keeps_weights():
+    groups, weights, edges = coarsen_once([3, 5], {(0, 1): 2})
+    assert groups == [[0, 1]]
+    assert weights == [8]
+
+
+def test_merge_boxes():
+    assert merge_boxes([[0, 0, 1, 1], [-1, 2, 0.5, 3]]) == [-1, 0, 1, 3]
+
+
+def test_build_zoom_levels(monkeypatch):
+    monkeypatch.setattr(config, "ZOOM_LEVEL_TARGET_SIZE", 2)
+    n = 16
+    node_ids = list(range(100, 100 + n))
+    boxes = [[i, 0, i + 1, 1] for i in range(n)]
+    levels = build_zoom_levels(node_ids, [1] * n, path_edges(n), boxes)
+    # 16 -> 8 -> 4 -> 2
+    assert [len(lvl["sizes"]) for lvl in levels] == [8, 4, 2]
+    # The ends of the path are matched first
+    assert levels[0]["children"][:2] == [[100, 101], [114, 115]]
+    # Later levels refer to super-node indices in the previous level
+    assert levels[1]["children"][:2] == [[0, 2], [1, 7]]
+    assert levels[-1]["sizes"] == [8, 8]
+    assert levels[-1]["bbs"] == [[0, 0, 8, 1], [8, 0, 16, 1]]
+    assert levels[-1]["edges"] == [[0, 1, 1]]
+
+
+def test_build_zoom_levels_small_graph():
+    # Already small enough: no levels needed
+    assert build_zoom_levels([0, 1], [1, 1], {(0, 1): 1}, [[0] * 4] * 2) == []
+
+
+def test_build_zoom_levels_max_levels(monkeypatch):
+    monkeypatch.setattr(config, "ZOOM_LEVEL_TARGET_SIZE", 1)
+    monkeypatch.setattr(config, "ZOOM_LEVEL_MAX_LEVELS", 2)
+    boxes = [[0, 0, 1, 1]] * 16
+    levels = build_zoom_levels(
+        list(range(16)), [1] * 16, path_edges(16), boxes
+    )
+    assert len(levels) == 2
+
+
+def test_assembly_graph_zoom_levels(monkeypatch):
+    # The largest component in this graph has 265 top-level nodes / patterns
+    monkeypatch.setattr(config, "ZOOM_LEVELS_MIN_COMPONENT_SIZE", 100)
+    monkeypatch.setattr(config, "ZOOM_LEVEL_TARGET_SIZE", 10)
+    ag = AssemblyGraph("metagenomescope/tests/input/E_coli_LastGraph")
+    ag.process()
+    out = ag.to_dict()
+    for comp in out["components"]:
+        levels = comp["zoom_levels"]
+        if len(levels) == 0:
+            continue
+        # Every top-level node / pattern in the component should be in
+        # exactly one super-node of the first level
+        top_level = set()
+        for n in comp["nodes"]:
+            if comp["nodes"][n][out["node_attrs"]["parent_id"]] is None:
+                top_level.add(n)
+        for p in comp["patts"]:
+            if p[out["patt_attrs"]["parent_id"]] is None:
+                top_level.add(p[out["patt_attrs"]["pattern_id"]])
+        members = [m for c in levels[0]["children"] for m in c]
+        assert sorted(members) == sorted(top_level)
+        # The coarsest level's super-nodes should contain every node
+        assert sum(levels[-1]["sizes"]) == len(comp["nodes"])
+    assert len(out["components"][0]["zoom_levels"]) > 1
+    assert all(len(c["zoom_levels"]) == 0 for c in out["components"][1:])
+
+    # With the default settings, this graph is way too small to bother
+    monkeypatch.undo()
+    ag2 = AssemblyGraph("metagenomescope/tests/input/marygold_fig2a.gml")
+    ag2.process()
+    for comp in ag2.to_dict()["components"]:
+        assert comp["zoom_levels"] == []
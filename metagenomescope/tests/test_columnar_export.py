@@ -0,0 +1,147 @@
+import os
+import pytest
+from metagenomescope import config
+from metagenomescope.graph_objects import AssemblyGraph
+from metagenomescope.tests.utils import E_COLI, run_make_viz
+from metagenomescope.columnar_export import write_tables, TableExporter
+
+pa = pytest.importorskip("pyarrow")
+import pyarrow.ipc  # noqa: E402
+import pyarrow.parquet  # noqa: E402
+
+
+def read_table(tmp_path, table_name, table_format):
+    fp = str(tmp_path / config.TABLES_DIR_NAME / "{}.{}").format(
+        table_name, table_format
+    )
+    if table_format == config.TABLE_FORMAT_PARQUET:
+        return pyarrow.parquet.read_table(fp)
+    else:
+        with pyarrow.ipc.open_file(fp) as reader:
+            return reader.read_all()
+
+
+@pytest.mark.parametrize("table_format", config.TABLE_FORMATS)
+def test_write_tables(tmp_path, table_format):
+    ag = AssemblyGraph(E_COLI)
+    ag.process()
+    graph_dict = ag.to_dict()
+    write_tables(graph_dict, str(tmp_path), table_format)
+
+    nodes = read_table(tmp_path, "nodes", table_format).to_pydict()
+    edges = read_table(tmp_path, "edges", table_format).to_pydict()
+    patts = read_table(tmp_path, "patterns", table_format).to_pydict()
+
+    assert len(nodes["node_id"]) == len(ag.digraph.nodes)
+    assert len(edges["src_id"]) == len(ag.digraph.edges)
+    assert len(patts["pattern_id"]) == len(ag.id2pattern)
+
+    # Check that rows match up with the graph
+    for i, node_id in enumerate(nodes["node_id"]):
+        data = ag.digraph.nodes[node_id]
+        assert nodes["name"][i] == data["name"]
+        assert nodes["orientation"][i] == data["orientation"]
+        assert nodes["x"][i] == data["x"]
+        assert nodes["parent_id"][i] == data["parent_id"]
+        assert nodes["depth"][i] == data["depth"]
+    for src, tgt, comp in zip(
+        edges["src_id"], edges["tgt_id"], edges["component"]
+    ):
+        assert ag.digraph.has_edge(src, tgt)
+        assert comp in set(
+            c for c, n in zip(nodes["component"], nodes["node_id"]) if n == src
+        )
+    for i, patt_id in enumerate(patts["pattern_id"]):
+        p = ag.id2pattern[patt_id]
+        assert patts["pattern_type"][i] == p.pattern_type
+        assert patts["parent_id"][i] == p.parent_id
+
+    # Component numbers should match the order of components in the
+    # visualization
+    assert set(nodes["component"]) == set(
+        range(1, len(graph_dict["components"]) + 1)
+    )
+
+
+def test_write_tables_dictionary_encoding(tmp_path):
+    ag = AssemblyGraph(E_COLI)
+    ag.process()
+    write_tables(ag.to_dict(), str(tmp_path), config.TABLE_FORMAT_ARROW)
+    nodes = read_table(tmp_path, "nodes", config.TABLE_FORMAT_ARROW)
+    patts = read_table(tmp_path, "patterns", config.TABLE_FORMAT_ARROW)
+    assert pa.types.is_dictionary(nodes.schema.field("orientation").type)
+    assert pa.types.is_dictionary(patts.schema.field("pattern_type").type)
+    assert pa.types.is_string(nodes.schema.field("name").type)
+    assert pa.types.is_float64(nodes.schema.field("depth").type)
+    edges = read_table(tmp_path, "edges", config.TABLE_FORMAT_ARROW)
+    assert pa.types.is_int64(edges.schema.field("multiplicity").type)
+
+
+def test_write_tables_batches(tmp_path, monkeypatch):
+    # Force every component to be written as its own batch, so that the
+    # dictionaries have to grow across batches
+    monkeypatch.setattr(config, "TABLE_BATCH_ROWS", 1)
+    ag = AssemblyGraph(E_COLI)
+    ag.process()
+    num_ccs = len(ag.to_dict()["components"])
+    assert num_ccs > 1
+    write_tables(ag.to_dict(), str(tmp_path), config.TABLE_FORMAT_ARROW)
+    fp = str(tmp_path / config.TABLES_DIR_NAME / "nodes.arrow")
+    with pyarrow.ipc.open_file(fp) as reader:
+        assert reader.num_record_batches == num_ccs
+        orientations = reader.read_all().column("orientation").to_pylist()
+    assert sorted(set(orientations)) == ["+", "-"]
+
+
+def test_table_exporter_writes_as_to_dict_goes(tmp_path, monkeypatch):
+    monkeypatch.setattr(config, "TABLE_BATCH_ROWS", 1)
+    ag = AssemblyGraph(E_COLI)
+    ag.process()
+    exporter = TableExporter(str(tmp_path), config.TABLE_FORMAT_ARROW)
+    fp = tmp_path / config.TABLES_DIR_NAME / "nodes.arrow"
+    sizes = []
+
+    def on_component(graph_data, cc_num, comp):
+        exporter.add_component(graph_data, cc_num, comp)
+        sizes.append(os.path.getsize(str(fp)))
+
+    graph_dict = ag.to_dict(on_component=on_component)
+    exporter.close()
+    # Each component's batch is written out before the next one is made
+    assert len(sizes) == len(graph_dict["components"])
+    assert sizes == sorted(sizes) and sizes[0] < sizes[-1]
+    with pyarrow.ipc.open_file(str(fp)) as reader:
+        assert reader.num_record_batches == len(sizes)
+
+
+def test_write_tables_types_from_parser(tmp_path):
+    ag = AssemblyGraph(E_COLI)
+    ag.process()
+    graph_dict = ag.to_dict()
+    assert graph_dict["extra_node_attr_types"] == {
+        "depth": "float",
+        "gc_content": "float",
+    }
+    assert graph_dict["extra_edge_attr_types"] == {"multiplicity": "int"}
+    # The exporter shouldn't need to look at the values to pick column
+    # types: say that depth is a string, and it'll be a string column
+    graph_dict["extra_node_attr_types"]["depth"] = "str"
+    write_tables(graph_dict, str(tmp_path), config.TABLE_FORMAT_ARROW)
+    nodes = read_table(tmp_path, "nodes", config.TABLE_FORMAT_ARROW)
+    assert pa.types.is_dictionary(nodes.schema.field("depth").type)
+    assert pa.types.is_float64(nodes.schema.field("gc_content").type)
+
+
+def test_write_tables_bad_format(tmp_path):
+    ag = AssemblyGraph("metagenomescope/tests/input/marygold_fig2a.gml")
+    ag.process()
+    with pytest.raises(ValueError) as ei:
+        write_tables(ag.to_dict(), str(tmp_path), "csv")
+    assert str(ei.value) == "Unrecognized table format: csv"
+
+
+def test_make_viz_export_tables(tmp_path):
+    out_dir = run_make_viz(tmp_path, export_tables=config.TABLE_FORMAT_PARQUET)
+    assert (out_dir / "index.html").exists()
+    nodes = read_table(out_dir, "nodes", config.TABLE_FORMAT_PARQUET)
+    assert nodes.num_rows > 0
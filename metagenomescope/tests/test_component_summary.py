@@ -0,0 +1,125 @@
+import json
+import pytest
+from metagenomescope.graph_objects import AssemblyGraph
+from metagenomescope.tests.utils import run_make_viz, read_data_js
+from metagenomescope.input_node_utils import n50
+from metagenomescope.component_summary import (
+    get_component_summary,
+    weighted_mean,
+    SUMMARY_COLUMNS,
+    STATUS_FULL,
+    STATUS_SKIPPED,
+)
+
+
+def test_weighted_mean():
+    assert weighted_mean([(1, 1), (4, 2)]) == 3
+    # None and negative values are ignored
+    assert weighted_mean([(1, 1), (None, 5), (-1, 5)]) == 1
+    assert weighted_mean([(None, 1)]) is None
+    assert weighted_mean([]) is None
+    # If all of the weights are 0, weight everything equally
+    assert weighted_mean([(1, 0), (2, 0)]) == 1.5
+
+
+def test_get_component_summary():
+    ag = AssemblyGraph("metagenomescope/tests/input/E_coli_LastGraph")
+    ag.process()
+    graph_dict = ag.to_dict()
+    summary = get_component_summary(graph_dict)
+    assert set(summary) == set(SUMMARY_COLUMNS)
+    num_ccs = len(graph_dict["components"])
+    for col in SUMMARY_COLUMNS:
+        assert len(summary[col]) == num_ccs
+
+    na = graph_dict["node_attrs"]
+    for i, comp in enumerate(graph_dict["components"]):
+        nodes = [d for d in comp["nodes"].values() if not d[na["is_dup"]]]
+        lengths = [d[na["length"]] for d in nodes]
+        assert summary["nodes"][i] == len(nodes)
+        assert summary["patterns"][i] == len(comp["patts"])
+        assert summary["length"][i] == sum(lengths)
+        assert summary["n50"][i] == n50(lengths)
+        assert summary["status"][i] == STATUS_FULL
+        assert summary["gc"][i] == pytest.approx(
+            sum(d[na["gc_content"]] * d[na["length"]] for d in nodes)
+            / sum(lengths)
+        )
+    # The first component has some duplicate nodes, which aren't counted
+    ea = graph_dict["edge_attrs"]
+    comp = graph_dict["components"][0]
+    assert summary["nodes"][0] < len(comp["nodes"])
+    assert summary["edges"][0] == sum(
+        1
+        for tgts in comp["edges"].values()
+        for d in tgts.values()
+        if not d[ea["is_dup"]]
+    )
+    # Single-node components
+    assert summary["nodes"][-1] == 1
+    assert summary["edges"][-1] == 0
+    assert summary["depth"][-1] == pytest.approx(45.5)
+    json.dumps(summary)
+
+
+def test_get_component_summary_skipped():
+    ag = AssemblyGraph(
+        "metagenomescope/tests/input/E_coli_LastGraph",
+        max_node_count=20,
+        max_edge_count=20,
+    )
+    ag.process()
+    graph_dict = ag.to_dict()
+    summary = get_component_summary(graph_dict)
+    num_skipped = sum(c["skipped"] for c in graph_dict["components"])
+    assert num_skipped > 0
+    assert summary["status"][:num_skipped] == [STATUS_SKIPPED] * num_skipped
+    # We still know how big the skipped components were
+    for i in range(num_skipped):
+        comp = graph_dict["components"][i]
+        assert summary["nodes"][i] == comp["num_nodes"]
+        assert summary["edges"][i] == comp["num_edges"]
+        assert summary["length"][i] == comp["length"]
+        assert summary["nodes"][i] > 20 or summary["edges"][i] > 20
+        assert summary["length"][i] > 0
+    # ... but everything else depends on the layout, so it's left empty
+    for col in ("patterns", "n50", "gc", "depth"):
+        assert summary[col][:num_skipped] == [None] * num_skipped
+    for col in SUMMARY_COLUMNS:
+        assert None not in summary[col][num_skipped:]
+    # Skipped components are sorted largest first, like everything else
+    assert summary["nodes"][:num_skipped] == sorted(
+        summary["nodes"][:num_skipped], reverse=True
+    )
+
+
+def test_get_skipped_component_info():
+    # Components skipped by --time-budget are skipped after pattern
+    # decomposition, so their info has to ignore the duplicate nodes / edges
+    # made during decomposition in order to match up with the summary. Check
+    # this on components we did lay out, so we can compare with the summary.
+    ag = AssemblyGraph("metagenomescope/tests/input/E_coli_LastGraph")
+    ag.process()
+    full_summary = get_component_summary(ag.to_dict())
+    ccs = ag.get_connected_components()
+    info = [ag.get_skipped_component_info(t[0]) for t in ccs]
+    assert [i[0] for i in info] == full_summary["nodes"]
+    assert [i[1] for i in info] == full_summary["edges"]
+    assert [i[2] for i in info] == full_summary["length"]
+
+
+def test_get_component_summary_missing_attrs():
+    ag = AssemblyGraph("metagenomescope/tests/input/bubble_test.gml")
+    ag.process()
+    summary = get_component_summary(ag.to_dict())
+    # GML files don't have GC content or depth
+    assert all(v is None for v in summary["gc"])
+    assert all(v is None for v in summary["depth"])
+    assert all(v > 0 for v in summary["nodes"])
+
+
+def test_make_viz_component_summary(tmp_path):
+    data = read_data_js(run_make_viz(tmp_path))
+    summary = data["component_summary"]
+    assert len(summary["nodes"]) == len(data["components"])
+    assert summary["status"] == [STATUS_FULL] * len(data["components"])
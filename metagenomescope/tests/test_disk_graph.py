@@ -0,0 +1,177 @@
+import os
+import pytest
+import numpy
+from metagenomescope.disk_graph import label_components, DiskBackedGraph
+
+
+def get_labels(edges, num_nodes, tmp_path, chunk_size=2):
+    src = numpy.array([e[0] for e in edges], dtype=numpy.int64)
+    tgt = numpy.array([e[1] for e in edges], dtype=numpy.int64)
+    return label_components(
+        src,
+        tgt,
+        numpy.arange(len(edges)),
+        num_nodes,
+        str(tmp_path / "labels.npy"),
+        chunk_size,
+    ).tolist()
+
+
+def test_label_components_basic(tmp_path):
+    labels = get_labels([(0, 1), (2, 3), (3, 1)], 6, tmp_path)
+    assert labels == [0, 0, 0, 0, 4, 5]
+
+
+def test_label_components_long_chains(tmp_path):
+    # Chains declared in "backwards" and shuffled orders, which need a few
+    # rounds of hooking / pointer jumping to converge
+    n = 1000
+    backwards = [(i, i - 1) for i in range(n - 1, 0, -1)]
+    assert get_labels(backwards, n + 1, tmp_path, 7) == [0] * n + [n]
+    shuffled = [(i, i + 1) for i in range(n - 1)]
+    numpy.random.RandomState(0).shuffle(shuffled)
+    assert get_labels(shuffled, n, tmp_path, 7) == [0] * n
+
+
+def test_label_components_no_edges(tmp_path):
+    assert get_labels([], 3, tmp_path) == [0, 1, 2]
+
+
+def test_components_and_digraph(tmp_path):
+    # Use a tiny chunk size so that we actually flush stuff to disk mid-parse
+    g = DiskBackedGraph(directory=str(tmp_path), chunk_size=2)
+    g.add_node("a", length=5, orientation="+")
+    g.add_node("b", length=10, orientation="-")
+    g.add_node("c", length=3)
+    g.add_edge("a", "b", multiplicity=4)
+    g.add_edge("d", "e", multiplicity=2)
+    g.add_node("f", length=7, orientation="+")
+    g.finalize()
+    assert len(g) == 6
+    assert g.number_of_edges() == 2
+    # {a, b}, {c}, {d, e}, {f}
+    assert g.num_components == 4
+    assert sorted(g.cc_node_counts.tolist()) == [1, 1, 2, 2]
+
+    cc_of_a = int(g.node_cc[g.name2idx["a"]])
+    dg = g.component_digraph([cc_of_a])
+    assert sorted(dg.nodes) == ["a", "b"]
+    assert list(dg.edges) == [("a", "b")]
+    assert dg.nodes["a"] == {"length": 5, "orientation": "+"}
+    assert dg.edges["a", "b"]["multiplicity"] == 4
+    # Make sure ints stay as ints
+    assert type(dg.nodes["a"]["length"]) is int
+
+    # d and e were only created implicitly by add_edge(), so they shouldn't
+    # have any attributes
+    cc_of_d = int(g.node_cc[g.name2idx["d"]])
+    dg2 = g.component_digraph([cc_of_d])
+    assert dg2.nodes["d"] == {}
+    assert dg2.nodes["e"] == {}
+    g.close()
+
+
+def test_duplicate_edges_keep_last_declaration(tmp_path):
+    g = DiskBackedGraph(directory=str(tmp_path))
+    g.add_edge("a", "b", bsize=1.5)
+    g.add_edge("b", "a", bsize=2)
+    g.add_edge("a", "b", bsize=3.5)
+    g.finalize()
+    assert g.number_of_edges() == 2
+    dg = g.component_digraph(range(g.num_components))
+    assert dg.edges["a", "b"]["bsize"] == 3.5
+    assert dg.edges["b", "a"]["bsize"] == 2
+    g.close()
+
+
+def test_many_duplicate_edges(tmp_path):
+    # Lots of chunks (and thus lots of buckets when looking for duplicates)
+    g = DiskBackedGraph(directory=str(tmp_path), chunk_size=3)
+    for i in range(50):
+        for j in range(i % 4):
+            g.add_edge(str(i), str(i + 1), mult=j)
+    g.add_node("lonely")
+    g.finalize()
+    assert g.number_of_edges() == 37
+    assert g.edge_rows.tolist() == sorted(g.edge_rows.tolist())
+    # Edges i -> i + 1 for every i that isn't a multiple of 4, so the
+    # components are {1, 2, 3, 4}, {5, 6, 7, 8}, ... and then {lonely}
+    assert g.num_components == 14
+    assert g.cc_node_counts.tolist() == [4] * 12 + [2, 1]
+    assert g.cc_node_starts.tolist()[-1] == len(g)
+    dg = g.component_digraph(range(g.num_components))
+    assert len(dg.edges) == 37
+    assert dg.edges["3", "4"]["mult"] == 2
+    # Components are numbered in order of their first node
+    assert g.component_node_indices([0]).tolist() == [0, 1, 2, 3]
+    assert g.component_node_indices([g.num_components - 1]).tolist() == [
+        g.name2idx["lonely"]
+    ]
+    g.close()
+
+
+def test_node_update_after_creation(tmp_path):
+    # Mimic NetworkX: adding an existing node updates its attributes
+    g = DiskBackedGraph(directory=str(tmp_path))
+    g.add_edge("a", "b")
+    g.add_node("a", length=100, cov=1.25)
+    g.add_node("b", length=50)
+    g.finalize()
+    dg = g.component_digraph([0])
+    assert dg.nodes["a"] == {"length": 100, "cov": 1.25}
+    assert dg.nodes["b"] == {"length": 50}
+    g.close()
+
+
+def test_node_updates_are_spilled_to_disk(tmp_path):
+    # Like a GFA file with all of its L lines before its S lines: every
+    # node's attributes arrive as an update
+    g = DiskBackedGraph(directory=str(tmp_path), chunk_size=2)
+    for i in range(9):
+        g.add_edge("n{}".format(i), "n{}".format(i + 1))
+    for i in range(10):
+        g.add_node("n{}".format(i), length=i * 10, seq="ACGT"[i % 4])
+    g.add_node("n3", length=5, depth=None)
+    g.add_node("n4", depth=2.5)
+    log = g.node_updates["length"]
+    # Only the unflushed tail of each log is still in memory
+    assert len(log.idx_buffer) < 2
+    assert os.path.getsize(log.idx_fh.name) > 0
+    g.finalize()
+    idx = [g.name2idx["n{}".format(i)] for i in range(10)]
+    lengths = [i * 10 for i in range(10)]
+    lengths[3] = 5
+    assert g.node_values("length", idx) == lengths
+    assert g.node_values("seq", idx) == list("ACGTACGTAC")
+    assert g.node_values("depth", idx) == [None] * 4 + [2.5] + [None] * 5
+    assert g.node_updates == {}
+    g.close()
+
+
+def test_missing_and_bool_attrs(tmp_path):
+    g = DiskBackedGraph(directory=str(tmp_path))
+    g.add_node("a", is_thing=True)
+    g.add_node("b")
+    g.add_node("c", is_thing=False)
+    g.finalize()
+    idx = [g.name2idx[n] for n in "abc"]
+    assert g.node_values("is_thing", idx) == [True, None, False]
+    g.close()
+
+
+def test_mixed_attr_types_error(tmp_path):
+    g = DiskBackedGraph(directory=str(tmp_path))
+    g.add_node("a", label="x")
+    with pytest.raises(ValueError):
+        g.add_node("b", label=5)
+    g.close()
+
+
+def test_close_removes_dir(tmp_path):
+    g = DiskBackedGraph(directory=str(tmp_path))
+    g.add_edge("a", "b")
+    g.finalize()
+    d = g.dir
+    assert os.path.isdir(d)
+    g.close()
+    assert not os.path.exists(d)
@@ -0,0 +1,140 @@
+import json
+import sqlite3
+import pytest
+from metagenomescope import config
+from metagenomescope.graph_objects import AssemblyGraph
+from metagenomescope.tests.utils import E_COLI, run_make_viz
+from metagenomescope.graph_db import write_database, find_nodes, get_component
+
+
+def make_db(tmp_path, filename=E_COLI):
+    ag = AssemblyGraph(filename)
+    ag.process()
+    graph_dict = ag.to_dict()
+    db_path = str(tmp_path / "graph.db")
+    write_database(graph_dict, db_path)
+    return ag, graph_dict, db_path
+
+
+def test_write_database(tmp_path):
+    ag, graph_dict, db_path = make_db(tmp_path)
+    conn = sqlite3.connect(db_path)
+    num_nodes = conn.execute("SELECT COUNT(*) FROM nodes").fetchone()[0]
+    num_edges = conn.execute("SELECT COUNT(*) FROM edges").fetchone()[0]
+    num_patts = conn.execute("SELECT COUNT(*) FROM patterns").fetchone()[0]
+    num_ccs = conn.execute("SELECT COUNT(*) FROM components").fetchone()[0]
+    assert num_nodes == len(ag.digraph.nodes)
+    assert num_edges == len(ag.digraph.edges)
+    assert num_patts == len(ag.id2pattern)
+    assert num_ccs == len(graph_dict["components"])
+
+    # Per-component counts should add up
+    assert conn.execute(
+        "SELECT SUM(num_nodes), SUM(num_edges), SUM(num_patterns) "
+        "FROM components"
+    ).fetchone() == (num_nodes, num_edges, num_patts)
+
+    # Extra attributes get their own columns
+    depths = dict(conn.execute("SELECT node_id, depth FROM nodes"))
+    for n in ag.digraph.nodes:
+        assert depths[n] == ag.digraph.nodes[n]["depth"]
+
+    info = dict(conn.execute("SELECT key, value FROM graph_info"))
+    assert info["input_file_basename"] == "E_coli_LastGraph"
+    assert info["total_num_nodes"] == str(num_nodes)
+
+    # Check that the indexes are there
+    index_names = set(
+        row[0]
+        for row in conn.execute(
+            "SELECT name FROM sqlite_master WHERE type = 'index'"
+        )
+    )
+    assert {"nodes_name", "nodes_component", "nodes_parent_id"} <= index_names
+    plan = " ".join(
+        str(row)
+        for row in conn.execute(
+            "EXPLAIN QUERY PLAN SELECT * FROM nodes WHERE name = '1'"
+        )
+    )
+    assert "nodes_name" in plan
+    conn.close()
+
+
+def test_write_database_small_batches(tmp_path, monkeypatch):
+    monkeypatch.setattr(config, "DB_BATCH_ROWS", 7)
+    ag, graph_dict, db_path = make_db(tmp_path)
+    conn = sqlite3.connect(db_path)
+    assert conn.execute("SELECT COUNT(*) FROM nodes").fetchone()[0] == len(
+        ag.digraph.nodes
+    )
+    conn.close()
+
+
+def test_write_database_already_exists(tmp_path):
+    ag, graph_dict, db_path = make_db(tmp_path)
+    with pytest.raises(FileExistsError) as ei:
+        write_database(graph_dict, db_path)
+    assert str(ei.value) == "Database {} already exists.".format(db_path)
+
+
+def test_find_nodes(tmp_path):
+    ag, graph_dict, db_path = make_db(tmp_path)
+    for n in list(ag.digraph.nodes)[:20]:
+        name = ag.digraph.nodes[n]["name"]
+        rows = find_nodes(db_path, name)
+        assert n in [r["node_id"] for r in rows]
+        for r in rows:
+            assert r["name"] == name
+            assert r["x"] == ag.digraph.nodes[r["node_id"]]["x"]
+    assert find_nodes(db_path, "not a node") == []
+
+
+def test_get_component(tmp_path):
+    ag, graph_dict, db_path = make_db(tmp_path)
+    for cc_num, comp in enumerate(graph_dict["components"], 1):
+        out = get_component(db_path, cc_num)
+        assert out["component"]["skipped"] == 0
+        assert sorted(r["node_id"] for r in out["nodes"]) == sorted(
+            comp["nodes"].keys()
+        )
+        assert len(out["patterns"]) == len(comp["patts"])
+        for r in out["edges"]:
+            data = comp["edges"][r["src_id"]][r["tgt_id"]]
+            assert (
+                json.loads(r["ctrl_pt_coords"])
+                == data[graph_dict["edge_attrs"]["ctrl_pt_coords"]]
+            )
+        assert (out["component"]["width"], out["component"]["height"]) == (
+            tuple(comp["bb"])
+        )
+    with pytest.raises(ValueError) as ei:
+        get_component(db_path, 1000)
+    assert str(ei.value) == "Component 1000 doesn't exist."
+
+
+def test_skipped_components(tmp_path):
+    ag = AssemblyGraph(
+        "metagenomescope/tests/input/E_coli_LastGraph",
+        max_node_count=20,
+        max_edge_count=20,
+    )
+    ag.process()
+    graph_dict = ag.to_dict()
+    db_path = str(tmp_path / "graph.db")
+    write_database(graph_dict, db_path)
+    num_skipped = sum(c["skipped"] for c in graph_dict["components"])
+    assert num_skipped > 0
+    for cc_num in range(1, num_skipped + 1):
+        out = get_component(db_path, cc_num)
+        assert out["component"]["skipped"] == 1
+        comp = graph_dict["components"][cc_num - 1]
+        assert out["component"]["num_nodes"] == comp["num_nodes"]
+        assert out["component"]["num_edges"] == comp["num_edges"]
+        assert out["nodes"] == []
+
+
+def test_make_viz_save_database(tmp_path):
+    out_dir = run_make_viz(tmp_path, save_database=True)
+    db_path = str(out_dir / config.DB_FILE_NAME)
+    assert len(get_component(db_path, 1)["nodes"]) > 0
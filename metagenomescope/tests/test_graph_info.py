@@ -0,0 +1,88 @@
+import networkx as nx
+from click.testing import CliRunner
+from metagenomescope.graph_info import GraphInfo
+from metagenomescope.assembly_graph_parser import parse
+from metagenomescope._cli import run_script
+
+
+def check_matches_networkx(filename):
+    gi = GraphInfo(filename)
+    g = parse(filename)
+    assert gi.num_nodes == len(g.nodes)
+    assert gi.num_edges == len(g.edges)
+    ccs = sorted(
+        (
+            (len(cc), len(g.subgraph(cc).edges))
+            for cc in nx.weakly_connected_components(g)
+        ),
+        reverse=True,
+    )
+    assert gi.num_components == len(ccs)
+    assert gi.component_node_counts == [c[0] for c in ccs]
+    assert gi.component_edge_counts == [c[1] for c in ccs]
+    return gi
+
+
+def test_matches_networkx_lastgraph():
+    check_matches_networkx("metagenomescope/tests/input/E_coli_LastGraph")
+
+
+def test_matches_networkx_gfa():
+    check_matches_networkx("metagenomescope/tests/input/sample1.gfa")
+
+
+def test_matches_networkx_gml():
+    check_matches_networkx("metagenomescope/tests/input/marygold_fig2a.gml")
+
+
+def test_sequence_lengths():
+    # For LastGraph files, each sequence should only be counted once (even
+    # though there's a node for it and its reverse complement)
+    gi = GraphInfo("metagenomescope/tests/input/cycletest_LastGraph")
+    assert sorted(gi.get_sequence_lengths()) == [1, 6]
+    # For GML files, every node is its own sequence
+    gi = GraphInfo("metagenomescope/tests/input/marygold_fig2a.gml")
+    assert len(gi.get_sequence_lengths()) == gi.num_nodes
+
+
+def test_size_distribution():
+    gi = GraphInfo("metagenomescope/tests/input/E_coli_LastGraph")
+    dist = gi.get_size_distribution()
+    # Bins should be in ascending order and cover every component
+    assert [d[0] for d in dist] == sorted(d[0] for d in dist)
+    assert sum(d[2] for d in dist) == gi.num_components
+    assert sum(d[3] for d in dist) == gi.num_nodes
+    assert sum(d[4] for d in dist) == gi.num_edges
+    for low, high, cc_ct, node_ct, edge_ct in dist:
+        assert high == 2 * low - 1
+        assert low * cc_ct <= node_ct <= high * cc_ct
+
+
+def test_too_large_components():
+    gi = GraphInfo("metagenomescope/tests/input/E_coli_LastGraph")
+    assert gi.get_too_large_components(10000, 10000) == []
+    # The largest component is always first
+    too_large = gi.get_too_large_components(100, 10000)
+    assert too_large == [0]
+    assert "1 component(s) (436 nodes, 570 edges) would be skipped" in (
+        gi.to_str(max_node_count=100)
+    )
+
+
+def test_info_command():
+    runner = CliRunner()
+    result = runner.invoke(
+        run_script,
+        ["info", "-i", "metagenomescope/tests/input/sample1.gfa", "-tc", "2"],
+    )
+    assert result.exit_code == 0, result.output
+    assert "Summary of sample1.gfa (gfa):" in result.output
+    assert "Largest 2 component(s)" in result.output
+
+
+def test_default_command_is_still_viz():
+    # "mgsc -h" (without a command name) should still show the help for the
+    # visualization command
+    result = CliRunner().invoke(run_script, ["-h"])
+    assert result.exit_code == 0
+    assert "Visualizes an assembly graph" in result.output
@@ -89,3 +89,16 @@ def test_negate_node_id():
     assert input_node_utils.negate_node_id("-contig_id_123") == "contig_id_123"
     assert input_node_utils.negate_node_id("abcdef") == "-abcdef"
     assert input_node_utils.negate_node_id("-abcdef") == "abcdef"
+
+
+def test_n50():
+    with pytest.raises(ValueError) as ei:
+        input_node_utils.n50([])
+    assert config.EMPTY_LIST_N50_ERR in str(ei.value)
+    assert input_node_utils.n50([5]) == 5
+    # Total is 30, so half is 15: 10 + 8 = 18 >= 15
+    assert input_node_utils.n50([2, 10, 4, 8, 6]) == 8
+    # Exactly half
+    assert input_node_utils.n50([1, 1, 2]) == 2
+    assert input_node_utils.n50([3, 3, 3, 3]) == 3
+    assert input_node_utils.n50([100, 1, 1, 1]) == 100
@@ -0,0 +1,143 @@
+import json
+from metagenomescope import config
+from metagenomescope.tests.utils import (
+    get_graph_dict,
+    run_make_viz,
+    read_data_js,
+)
+from metagenomescope.attr_tables import write_attr_tables
+from metagenomescope.instancing import instance_components, round_coords
+
+
+def get_viewer_dict(tmp_path, filename):
+    return write_attr_tables(get_graph_dict(filename), str(tmp_path))
+
+
+def expand(out, inst):
+    """Python version of DataHolder.expandInstance() in the JS."""
+    template = out["templates"][inst["instance_of"]]
+    na = out["node_attrs"]
+    ea = out["edge_attrs"]
+    pa = out["patt_attrs"]
+
+    def patt_id(i):
+        return None if i is None else inst["patt_ids"][i]
+
+    nodes = {}
+    for i, tdata in enumerate(template["nodes"]):
+        data = list(tdata)
+        data[na["name"]] = inst["names"][i]
+        data[na["length"]] = inst["lengths"][i]
+        data[na["parent_id"]] = patt_id(tdata[na["parent_id"]])
+        nodes[inst["node_ids"][i]] = data
+    edges = {}
+    for src, tgt, tdata in template["edges"]:
+        data = list(tdata)
+        data[ea["parent_id"]] = patt_id(tdata[ea["parent_id"]])
+        edges.setdefault(inst["node_ids"][src], {})[
+            inst["node_ids"][tgt]
+        ] = data
+    patts = []
+    for tdata in template["patts"]:
+        data = list(tdata)
+        data[pa["pattern_id"]] = patt_id(tdata[pa["pattern_id"]])
+        data[pa["parent_id"]] = patt_id(tdata[pa["parent_id"]])
+        patts.append(data)
+    return nodes, edges, patts, template["bb"]
+
+
+def check_instances(viewer_dict, out):
+    for comp, ocomp in zip(viewer_dict["components"], out["components"]):
+        if "instance_of" not in ocomp:
+            assert ocomp is comp
+            continue
+        nodes, edges, patts, bb = expand(out, ocomp)
+        assert nodes == {n: round_coords(d) for n, d in comp["nodes"].items()}
+        assert edges == {
+            src: {tgt: round_coords(d) for tgt, d in tgts.items()}
+            for src, tgts in comp["edges"].items()
+        }
+        assert bb == round_coords(comp["bb"])
+        # Patterns might be in a different order, but parents should still
+        # come before their children
+        assert sorted(patts, key=json.dumps) == sorted(
+            round_coords(comp["patts"]), key=json.dumps
+        )
+        seen = set()
+        for p in patts:
+            parent = p[out["patt_attrs"]["parent_id"]]
+            assert parent is None or parent in seen
+            seen.add(p[out["patt_attrs"]["pattern_id"]])
+
+
+def test_round_coords():
+    assert round_coords(1.23456) == 1.23
+    assert round_coords([1.23456, [2.34567, "a"], None, 5]) == [
+        1.23,
+        [2.35, "a"],
+        None,
+        5,
+    ]
+
+
+def test_instance_components_with_patterns(tmp_path):
+    viewer_dict = get_viewer_dict(
+        tmp_path, "metagenomescope/tests/input/three_bubbles.gfa"
+    )
+    orig = json.dumps(viewer_dict)
+    out = instance_components(viewer_dict)
+    # The input isn't modified
+    assert json.dumps(viewer_dict) == orig
+
+    # Three bubbles, plus their reverse complements: one template for each
+    # orientation
+    assert len(out["templates"]) == 2
+    assert all("instance_of" in c for c in out["components"])
+    for t in out["templates"]:
+        assert len(t["nodes"]) == 4
+        assert len(t["edges"]) == 4
+        assert len(t["patts"]) == 1
+    check_instances(viewer_dict, out)
+    names = set()
+    for c in out["components"]:
+        assert c["lengths"] == [8, 8, 8, 8]
+        names |= set(c["names"])
+    assert len(names) == 24
+
+
+def test_instance_components_lone_nodes(tmp_path):
+    viewer_dict = get_viewer_dict(
+        tmp_path, "metagenomescope/tests/input/E_coli_LastGraph"
+    )
+    out = instance_components(viewer_dict)
+    # The 50 single-node components share two layouts (+ and - nodes); the
+    # bigger components are left alone
+    assert len(out["templates"]) == 2
+    assert sum("instance_of" in c for c in out["components"]) == 50
+    assert "instance_of" not in out["components"][0]
+    check_instances(viewer_dict, out)
+
+
+def test_instance_components_settings(tmp_path, monkeypatch):
+    viewer_dict = get_viewer_dict(
+        tmp_path, "metagenomescope/tests/input/three_bubbles.gfa"
+    )
+    # There are only three copies of each bubble
+    monkeypatch.setattr(config, "INSTANCE_MIN_COUNT", 4)
+    out = instance_components(viewer_dict)
+    assert out["templates"] == []
+    assert out["components"] == viewer_dict["components"]
+
+    monkeypatch.setattr(config, "INSTANCE_MIN_COUNT", 2)
+    monkeypatch.setattr(config, "INSTANCE_MAX_COMPONENT_SIZE", 7)
+    out = instance_components(viewer_dict)
+    assert out["templates"] == []
+
+
+def test_make_viz_instancing(tmp_path):
+    out_dir = run_make_viz(
+        tmp_path, filename="metagenomescope/tests/input/three_bubbles.gfa"
+    )
+    data = read_data_js(out_dir)
+    assert len(data["templates"]) == 2
+    assert all("instance_of" in c for c in data["components"])
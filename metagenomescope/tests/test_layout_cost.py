@@ -0,0 +1,142 @@
+import json
+import pytest
+from click.testing import CliRunner
+from metagenomescope._cli import run_script
+from metagenomescope import config, layout_cost
+from metagenomescope.layout_cost import (
+    LayoutCostModel,
+    plan_layouts,
+    estimate_makespan,
+    get_schedule_order,
+    FULL,
+    DEGRADED,
+    SKIP,
+)
+
+
+def test_default_predictions():
+    m = LayoutCostModel()
+    c = config.LAYOUT_COST_DEFAULT_COEFFS
+    exp = c[0] + c[1] * (10 + 20) ** config.LAYOUT_COST_EXPONENT
+    assert m.predict(10, 20, 0, 0) == pytest.approx(exp)
+    assert m.predict(10, 20, 3, 2) == pytest.approx(exp + 3 * c[2] + 2 * c[3])
+    assert m.predict(10, 20, 0, 0, degraded=True) == pytest.approx(
+        exp * config.DEGRADED_LAYOUT_COST_FACTOR
+    )
+    # Bigger components should cost more
+    assert m.predict(100, 200, 0, 0) > m.predict(10, 20, 0, 0)
+
+
+def test_fit_recovers_coefficients():
+    m = LayoutCostModel()
+    true_coeffs = [0.1, 1e-3, 0.05, 0.2]
+    for n in range(1, 40):
+        feats = (n * 3, n * 5, n % 7, n % 3)
+        secs = sum(
+            c * f
+            for c, f in zip(true_coeffs, layout_cost.get_features(*feats))
+        )
+        m.record(*feats, secs, False)
+    m.fit()
+    assert m.coeffs == pytest.approx(true_coeffs, rel=1e-6)
+    # Degraded timings should set the degraded factor
+    m.record(30, 50, 0, 0, 0.25 * m.predict(30, 50, 0, 0), True)
+    m.fit()
+    assert m.degraded_factor == pytest.approx(0.25)
+
+
+def test_fit_keeps_coefficients_nonnegative():
+    m = LayoutCostModel()
+    # Timings that go *down* as the number of patterns goes up
+    for n in range(config.LAYOUT_COST_MIN_OBSERVATIONS):
+        m.record(10, 10, n, 0, 1 - 0.05 * n, False)
+    m.fit()
+    assert all(c >= 0 for c in m.coeffs)
+
+
+def test_fit_needs_enough_observations():
+    m = LayoutCostModel()
+    for n in range(config.LAYOUT_COST_MIN_OBSERVATIONS - 1):
+        m.record(10, 10, 0, 0, 1000, False)
+    m.fit()
+    assert m.coeffs == list(config.LAYOUT_COST_DEFAULT_COEFFS)
+
+
+def test_save_and_load(tmp_path):
+    fn = str(tmp_path / "timings.json")
+    m = LayoutCostModel(fn)
+    assert m.observations == []
+    for n in range(config.LAYOUT_COST_MIN_OBSERVATIONS):
+        m.record(n, n, 0, 0, 2 * n, False)
+    m.save()
+    m2 = LayoutCostModel(fn)
+    assert m2.observations == m.observations
+    # Since there were enough timings, m2 should have fit its coefficients
+    assert m2.coeffs != list(config.LAYOUT_COST_DEFAULT_COEFFS)
+
+
+def test_load_malformed(tmp_path):
+    fn = str(tmp_path / "timings.json")
+    with open(fn, "w") as f:
+        json.dump({"asdf": []}, f)
+    with pytest.raises(ValueError) as ei:
+        LayoutCostModel(fn)
+    assert "seems malformed" in str(ei.value)
+
+
+def test_get_max_component_size():
+    m = LayoutCostModel()
+    size = m.get_max_component_size(10)
+    # A component of this size should (just barely) fit, degraded
+    assert m.predict(size, 0, 0, 0, degraded=True) <= 10
+    assert m.predict(size + 2, 0, 0, 0, degraded=True) > 10
+    assert m.get_max_component_size(0) == 0
+
+
+def test_schedule_order_and_makespan():
+    assert get_schedule_order([1, 5, 3, 5]) == [1, 3, 2, 0]
+    assert estimate_makespan([], 4) == 0
+    assert estimate_makespan([3, 3, 2, 2, 2], 1) == 12
+    # Longest-first: 3 -> w1, 3 -> w2, then 2 + 2 + 2 split 4/2 -> 5 and 5
+    assert estimate_makespan([2, 3, 2, 3, 2], 2) == 7
+    assert estimate_makespan([10, 1, 1], 8) == 10
+
+
+def test_plan_layouts():
+    full = [10, 5, 1, 0]
+    degraded = [3, 2, 0.5, 0]
+    assert plan_layouts(full, degraded, 100) == [FULL] * 4
+    # Degrading the biggest component gets us to 3 + 5 + 1
+    assert plan_layouts(full, degraded, 9) == [DEGRADED, FULL, FULL, FULL]
+    assert plan_layouts(full, degraded, 6) == [DEGRADED, DEGRADED, FULL, FULL]
+    # (The last component is free, so it never needs to be degraded)
+    assert plan_layouts(full, degraded, 5.5) == [DEGRADED] * 3 + [FULL]
+    # Need to skip the biggest component
+    assert plan_layouts(full, degraded, 5) == [SKIP] + [DEGRADED] * 3
+    # With 2 workers, we can fit everything fully in 10 seconds
+    assert plan_layouts(full, degraded, 10, num_workers=2) == [FULL] * 4
+    # Negative budget: skip everything
+    assert plan_layouts(full, degraded, -1) == [SKIP] * 4
+
+
+def test_cli_records_timings(tmp_path):
+    timings_fn = str(tmp_path / "timings.json")
+    result = CliRunner().invoke(
+        run_script,
+        [
+            "-i",
+            "metagenomescope/tests/input/sample1.gfa",
+            "-o",
+            str(tmp_path / "out"),
+            "-tb",
+            "1000",
+            "-lt",
+            timings_fn,
+        ],
+    )
+    assert result.exit_code == 0, result.output
+    with open(timings_fn, "r") as f:
+        obs = json.load(f)["observations"]
+    # sample1.gfa has two components that actually need to be laid out
+    assert len(obs) == 2
+    assert [o[:4] for o in obs] == [[5, 4, 1, 1], [5, 4, 1, 1]]
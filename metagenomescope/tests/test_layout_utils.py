@@ -16,7 +16,7 @@
 # You should have received a copy of the GNU General Public License
 # along with MetagenomeScope.  If not, see <http://www.gnu.org/licenses/>.
 import pytest
-from metagenomescope import layout_utils
+from metagenomescope import layout_utils, config
 
 
 def test_shift_control_points_good():
@@ -68,3 +68,10 @@ def test_getxy():
 
     with pytest.raises(ValueError):
         layout_utils.getxy("one, two")
+
+
+def test_get_gv_header_degraded():
+    assert config.DEGRADED_GRAPH_STYLE not in layout_utils.get_gv_header()
+    assert config.DEGRADED_GRAPH_STYLE in layout_utils.get_gv_header(
+        degraded=True
+    )
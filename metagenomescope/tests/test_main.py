@@ -0,0 +1,22 @@
+import hashlib
+import json
+from metagenomescope.main import make_viz
+
+
+def test_make_viz_data_js_and_hash(tmp_path):
+    out_dir = tmp_path / "out"
+    make_viz("metagenomescope/tests/input/sample1.gfa", str(out_dir), 100, 100)
+    with open(str(out_dir / "data.js"), "r") as f:
+        datajs = f.read()
+    assert datajs.startswith("define(")
+    assert datajs.endswith(");\n")
+    graph_data = datajs[len("define(") : -len(");\n")]
+    assert json.loads(graph_data)["input_file_basename"] == "sample1.gfa"
+
+    # main.js just contains a hash of the data, which the viewer uses as a
+    # cache key
+    data_hash = hashlib.sha256(graph_data.encode("utf-8")).hexdigest()
+    with open(str(out_dir / "main.js"), "r") as f:
+        mainjs = f.read()
+    assert 'var dataHash = "{}";'.format(data_hash) in mainjs
+    assert "{{" not in mainjs
@@ -0,0 +1,236 @@
+import io
+import pytest
+from metagenomescope import config, progress
+from metagenomescope.graph_objects import AssemblyGraph
+from metagenomescope.progress import (
+    LayoutProgress,
+    format_duration,
+    get_size_group,
+)
+
+
+class FakeClock(object):
+    def __init__(self):
+        self.now = 0
+
+    def __call__(self):
+        return self.now
+
+
+def make_progress(components, mode=progress.LOG, interval=10, workers=1):
+    clock = FakeClock()
+    stream = io.StringIO()
+    prog = LayoutProgress(
+        components,
+        workers=workers,
+        stream=stream,
+        mode=mode,
+        interval=interval,
+        clock=clock,
+    )
+    return prog, clock, stream
+
+
+def get_lines(stream):
+    return stream.getvalue().splitlines()
+
+
+def test_format_duration():
+    assert format_duration(None) == "?"
+    assert format_duration(0) == "0:00:00"
+    assert format_duration(59.6) == "0:01:00"
+    assert format_duration(3 * 3600 + 25 * 60 + 7) == "3:25:07"
+    assert format_duration(100 * 3600) == "100:00:00"
+
+
+def test_get_size_group():
+    assert get_size_group(0) == 0
+    assert get_size_group(1) == 0
+    assert get_size_group(2) == 1
+    assert get_size_group(3) == 1
+    assert get_size_group(1024) == 10
+
+
+def test_log_lines_are_throttled(monkeypatch):
+    monkeypatch.setattr(config, "PROGRESS_LOG_HEARTBEAT", 300)
+    prog, clock, stream = make_progress(
+        [(5, 5, 1, 10), (5, 5, 2, 10), (1, 0, 0, 0)]
+    )
+    prog.start()
+    assert get_lines(stream) == [
+        "Layout progress: components=0/3 patterns=0/3 elements=0/21 "
+        "rate=? elapsed=0:00:00 eta=?"
+    ]
+    # Too soon since the last line
+    clock.now = 5
+    prog.done(0, 5)
+    assert len(get_lines(stream)) == 1
+    # The periodic check picks up that this component has finished
+    clock.now = 20
+    prog.maybe_report(periodic=True)
+    assert get_lines(stream)[-1] == (
+        "Layout progress: components=1/3 patterns=1/3 elements=10/21 "
+        "rate=0.5/s elapsed=0:00:20 eta=0:00:05"
+    )
+    # Nothing has finished since the last line
+    clock.now = 35
+    prog.maybe_report(periodic=True)
+    assert len(get_lines(stream)) == 2
+    prog.done(2, 0)
+    assert len(get_lines(stream)) == 3
+    # Nothing new, but it's been long enough for a heartbeat
+    clock.now = 100
+    prog.maybe_report(periodic=True)
+    assert len(get_lines(stream)) == 3
+    clock.now = 400
+    prog.maybe_report(periodic=True)
+    assert len(get_lines(stream)) == 4
+    # finish() always prints a line
+    clock.now = 401
+    prog.done(1, 5)
+    prog.finish()
+    lines = get_lines(stream)
+    assert len(lines) == 5
+    assert lines[-1] == (
+        "Layout progress: components=3/3 patterns=3/3 elements=21/21 "
+        "rate=0.1/s elapsed=0:06:41 eta=0:00:00"
+    )
+    # Nothing is reported after finish()
+    prog.maybe_report(periodic=True)
+    assert len(get_lines(stream)) == 5
+
+
+def test_eta():
+    prog, clock, stream = make_progress(
+        [(10, 10, 1, 100), (10, 10, 1, 100), (1000, 1000, 5, 1000)]
+    )
+    prog.start()
+    # We haven't seen anything yet, so we can't make an estimate
+    assert prog.get_eta() is None
+    prog.done(0, 4)
+    # The other 20-element component should take as long as the first one
+    # did, and the 2,000-element component (in a size group we haven't seen
+    # yet) should take (1000 * 4 / 100) = 40 seconds, since the cost model
+    # has been overestimating times by a factor of 25
+    assert prog.get_eta() == pytest.approx(44)
+    # Finishing the same component twice doesn't count
+    prog.done(0, 4)
+    assert prog.get_eta() == pytest.approx(44)
+    assert prog.get_stats()["components"] == 1
+    prog.done(2, 60)
+    assert prog.get_eta() == pytest.approx(4)
+    prog.done(1, 4)
+    assert prog.get_eta() == 0
+    prog.finish()
+
+
+def test_eta_parallel():
+    prog, clock, stream = make_progress(
+        [(10, 10, 1, 100), (10, 10, 1, 100), (10, 10, 1, 100)], workers=2
+    )
+    prog.start()
+    prog.done(0, 4)
+    # Two components left (4 seconds each), which can be done at once
+    assert prog.get_eta() == pytest.approx(4)
+    prog.done(1, 4)
+    # Only one component left, so the second worker doesn't help
+    assert prog.get_eta() == pytest.approx(4)
+    prog.finish()
+
+
+def test_bar(monkeypatch):
+    monkeypatch.setattr(config, "PROGRESS_BAR_WIDTH", 10)
+    prog, clock, stream = make_progress(
+        [(5, 5, 1, 10), (5, 5, 1, 10)], mode=progress.BAR, interval=0.5
+    )
+    prog.start()
+    clock.now = 2
+    prog.done(0, 2)
+    assert prog.get_bar_line(1000) == (
+        "[#####-----]  50% | 1/2 components | 10/20 elements "
+        "| 5 elements/s | ETA 0:00:02"
+    )
+    prog.set_current("Laying out component 2")
+    assert prog.get_bar_line(1000).endswith(" | Laying out component 2")
+    assert prog.get_bar_line(10) == "[#####----"
+
+    # Messages get their own line, and the bar is redrawn after them
+    stream.seek(0)
+    stream.truncate()
+    prog.message("hello")
+    out = stream.getvalue()
+    assert out.startswith("\r\x1b[Khello\n\r[#####-----]")
+    assert out.endswith("\x1b[K")
+
+    clock.now = 3
+    prog.done(1, 1)
+    prog.finish()
+    out = stream.getvalue()
+    assert "\r[##########] 100% | 2/2 components" in out
+    assert out.endswith("\n")
+
+
+def test_default_mode():
+    # StringIOs aren't terminals
+    prog = LayoutProgress([], stream=io.StringIO())
+    assert prog.mode == progress.LOG
+    assert prog.interval == config.PROGRESS_LOG_INTERVAL
+
+    class FakeTerminal(io.StringIO):
+        def isatty(self):
+            return True
+
+    prog = LayoutProgress([], stream=FakeTerminal())
+    assert prog.mode == progress.BAR
+    assert prog.interval == config.PROGRESS_BAR_INTERVAL
+
+    with pytest.raises(ValueError) as ei:
+        LayoutProgress([], mode="fancy")
+    assert str(ei.value) == "Unrecognized progress mode: fancy"
+
+
+@pytest.mark.parametrize("workers", [1, 2])
+def test_layout_reports_progress(capsys, workers):
+    ag = AssemblyGraph(
+        "metagenomescope/tests/input/sample1.gfa", layout_workers=workers
+    )
+    ag.process()
+    lines = capsys.readouterr().out.splitlines()
+    progress_lines = [
+        line for line in lines if line.startswith("Layout progress: ")
+    ]
+    # One line when we start, and one when we're done. (Laying out this
+    # graph shouldn't take long enough for any lines in between.)
+    assert len(progress_lines) == 2
+    assert progress_lines[0].startswith(
+        "Layout progress: components=0/4 patterns=0/2 elements=0/20 "
+    )
+    assert progress_lines[1].startswith(
+        "Layout progress: components=4/4 patterns=2/2 elements=20/20 "
+    )
+
+
+def test_set_component_and_suspend():
+    prog, clock, stream = make_progress([(10, 10, 0, 100), (1, 0, 0, 0)])
+    prog.start()
+    prog.suspend()
+    # Once we know more about a component, its old estimate is replaced
+    prog.set_component(0, (10, 10, 3, 50))
+    prog.set_component(1, (1, 0, 0, 0))
+    stats = prog.get_stats()
+    assert stats["total_patterns"] == 3
+    assert stats["total_elements"] == 21
+    # Nothing gets reported while we're suspended
+    clock.now = 100
+    prog.done(0, 4)
+    assert len(get_lines(stream)) == 1
+    prog.resume()
+    # Finished components can't be replaced
+    prog.set_component(0, (5, 5, 1, 5))
+    assert prog.get_stats()["total_patterns"] == 3
+    prog.done(1, 1)
+    prog.finish()
+    lines = get_lines(stream)
+    assert lines[-1].startswith(
+        "Layout progress: components=2/2 patterns=3/3 elements=21/21 "
+    )
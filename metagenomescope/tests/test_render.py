@@ -0,0 +1,160 @@
+import os
+import xml.etree.ElementTree as ET
+import pytest
+from metagenomescope import config
+from metagenomescope.graph_objects import AssemblyGraph
+from metagenomescope.tests.utils import get_graph_dict, run_make_viz
+from metagenomescope.render import (
+    component_to_svg,
+    render_components,
+    get_edge_path,
+    SVGCanvas,
+)
+
+SVG_NS = "{http://www.w3.org/2000/svg}"
+
+
+def test_component_to_svg():
+    graph_dict = get_graph_dict()
+    comp = graph_dict["components"][0]
+    svg = component_to_svg(
+        comp,
+        graph_dict["node_attrs"],
+        graph_dict["edge_attrs"],
+        graph_dict["patt_attrs"],
+    )
+    root = ET.fromstring(svg)
+    assert float(root.get("width")) == pytest.approx(
+        comp["bb"][0] + 2 * config.RENDER_MARGIN, abs=0.01
+    )
+    assert float(root.get("height")) == pytest.approx(
+        comp["bb"][1] + 2 * config.RENDER_MARGIN, abs=0.01
+    )
+    # One polygon per node, one path per edge, and one rect per pattern
+    # (plus the background)
+    polygons = root.findall(SVG_NS + "polygon")
+    assert len(polygons) == len(comp["nodes"])
+    assert len(root.findall(SVG_NS + "path")) == sum(
+        len(tgts) for tgts in comp["edges"].values()
+    )
+    assert len(root.findall(SVG_NS + "rect")) == len(comp["patts"]) + 1
+
+    # Node names are included as tooltips
+    na = graph_dict["node_attrs"]
+    names = set(p.find(SVG_NS + "title").text for p in polygons)
+    assert names == set(n[na["name"]] for n in comp["nodes"].values())
+
+    # Everything should be within the image
+    for p in polygons:
+        for pt in p.get("points").split():
+            x, y = (float(c) for c in pt.split(","))
+            assert 0 <= x <= float(root.get("width"))
+            assert 0 <= y <= float(root.get("height"))
+
+
+def test_node_shapes():
+    graph_dict = get_graph_dict("metagenomescope/tests/input/sample1.gfa")
+    na = graph_dict["node_attrs"]
+    for comp in graph_dict["components"]:
+        svg = component_to_svg(
+            comp,
+            graph_dict["node_attrs"],
+            graph_dict["edge_attrs"],
+            graph_dict["patt_attrs"],
+        )
+        root = ET.fromstring(svg)
+        name2polygon = {
+            p.find(SVG_NS + "title").text: p
+            for p in root.findall(SVG_NS + "polygon")
+        }
+        for data in comp["nodes"].values():
+            pts = name2polygon[data[na["name"]]].get("points").split()
+            xs = [float(pt.split(",")[0]) for pt in pts]
+            # The "tip" of the node (the third point) points right for +
+            # nodes and left for - nodes
+            if data[na["orientation"]] == "+":
+                assert xs[2] == max(xs)
+            else:
+                assert xs[2] == min(xs)
+
+
+def test_get_edge_path():
+    canvas = SVGCanvas(100, 100, 0)
+    # Start point + one cubic Bezier segment
+    coords = [-100, 0, -99, 1, -98, 2, -97, 3]
+    assert get_edge_path(canvas, coords, None, None) == (
+        "M0.00,100.00 C1.00,99.00 2.00,98.00 3.00,97.00"
+    )
+    # Missing / weird control points: fall back to a straight line
+    for ctrl_pts in (None, [], [0, 0, 1, 1, 2, 2]):
+        assert get_edge_path(canvas, ctrl_pts, (-95, 5), (-90, 10)) == (
+            "M5.00,95.00 L10.00,90.00"
+        )
+
+
+@pytest.mark.parametrize("workers", [1, 3])
+def test_render_components(tmp_path, workers):
+    graph_dict = get_graph_dict()
+    rendered = render_components(
+        graph_dict,
+        str(tmp_path),
+        [config.RENDER_FORMAT_SVG],
+        num_components=4,
+        workers=workers,
+    )
+    assert rendered == [1, 2, 3, 4]
+    images_dir = tmp_path / config.IMAGES_DIR_NAME
+    assert sorted(os.listdir(images_dir)) == [
+        "component_{}.svg".format(i) for i in range(1, 5)
+    ]
+    for i in range(1, 5):
+        ET.parse(str(images_dir / "component_{}.svg".format(i)))
+
+
+def test_render_components_skips_skipped(tmp_path):
+    ag = AssemblyGraph(
+        "metagenomescope/tests/input/E_coli_LastGraph",
+        max_node_count=20,
+        max_edge_count=20,
+    )
+    ag.process()
+    graph_dict = ag.to_dict()
+    num_skipped = sum(c["skipped"] for c in graph_dict["components"])
+    assert num_skipped > 0
+    rendered = render_components(
+        graph_dict, str(tmp_path), [config.RENDER_FORMAT_SVG], None
+    )
+    assert rendered == list(
+        range(num_skipped + 1, len(graph_dict["components"]) + 1)
+    )
+
+
+def test_render_components_errors(tmp_path):
+    graph_dict = get_graph_dict("metagenomescope/tests/input/sample1.gfa")
+    with pytest.raises(ValueError) as ei:
+        render_components(graph_dict, str(tmp_path), ["jpg"])
+    assert str(ei.value) == "Unrecognized image format: jpg"
+    with pytest.raises(ValueError) as ei:
+        render_components(
+            graph_dict, str(tmp_path), [config.RENDER_FORMAT_SVG], 0
+        )
+    assert str(ei.value) == "Number of components to render must be at least 1"
+
+
+def test_render_png(tmp_path):
+    pytest.importorskip("cairosvg")
+    graph_dict = get_graph_dict("metagenomescope/tests/input/sample1.gfa")
+    render_components(graph_dict, str(tmp_path), [config.RENDER_FORMAT_PNG])
+    with open(
+        str(tmp_path / config.IMAGES_DIR_NAME / "component_1.png"), "rb"
+    ) as f:
+        assert f.read(8) == b"\x89PNG\r\n\x1a\n"
+
+
+def test_make_viz_render_images(tmp_path):
+    out_dir = run_make_viz(
+        tmp_path,
+        render_images=(config.RENDER_FORMAT_SVG,),
+        render_components=1,
+    )
+    assert os.listdir(out_dir / config.IMAGES_DIR_NAME) == ["component_1.svg"]
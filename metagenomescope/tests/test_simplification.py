@@ -0,0 +1,220 @@
+import pytest
+import networkx as nx
+from metagenomescope import simplification
+from metagenomescope.simplification import (
+    find_tips,
+    find_low_coverage_nodes,
+    remove_transitive_edges,
+    simplify,
+    get_rc_node_name_func,
+    TIP,
+    LOW_COVERAGE,
+    TRANSITIVE,
+)
+from metagenomescope.graph_objects import AssemblyGraph
+
+
+def make_graph(edges, lengths=None, covs=None):
+    g = nx.DiGraph()
+    g.add_edges_from(edges)
+    for n in g.nodes:
+        g.nodes[n]["length"] = 100
+        if lengths is not None and n in lengths:
+            g.nodes[n]["length"] = lengths[n]
+        if covs is not None and n in covs:
+            g.nodes[n]["depth"] = covs[n]
+    return g
+
+
+def test_find_tips():
+    # A -> B -> C -> D, with a short tip T hanging off of B and another short
+    # tip U coming out of C
+    g = make_graph(
+        [("A", "B"), ("B", "C"), ("C", "D"), ("B", "T"), ("U", "C")],
+        lengths={"T": 5, "U": 10, "A": 5},
+    )
+    # A is short and a dead end, but it's the only way into B -- so it's not
+    # a tip
+    assert find_tips(g, 10) == ["T", "U"]
+    assert find_tips(g, 5) == ["T"]
+    assert find_tips(g, 4) == []
+
+
+def test_find_tips_keeps_one_of_two():
+    # A and D are both short dead ends pointing into B. We should only clip
+    # one of them, so that B isn't left as a new dead end.
+    g = make_graph([("A", "B"), ("D", "B"), ("B", "C")], {"A": 1, "D": 1})
+    assert find_tips(g, 10) == ["A"]
+
+
+def test_find_tips_many_on_one_node():
+    # 1,000 short dead ends pointing into H, which has no other way in: all
+    # but the last of them should be clipped
+    tips = ["t{}".format(i) for i in range(1000)]
+    g = make_graph(
+        [(t, "H") for t in tips] + [("H", "X")], {t: 1 for t in tips}
+    )
+    assert find_tips(g, 10) == tips[:-1]
+
+
+def test_find_tips_rc():
+    g = make_graph(
+        [("1", "2"), ("-2", "-1"), ("2", "3"), ("-3", "-2")]
+        + [("2", "4"), ("-4", "-2")],
+        lengths={"4": 5, "-4": 5},
+    )
+    assert sorted(find_tips(g, 5, get_rc_node_name_func("gfa"))) == [
+        "-4",
+        "4",
+    ]
+
+
+def test_find_low_coverage_nodes():
+    g = make_graph([("A", "B"), ("B", "C")], covs={"A": 5, "B": 1.5})
+    # C doesn't have coverage info, so it's kept
+    assert find_low_coverage_nodes(g, 2) == ["B"]
+    assert find_low_coverage_nodes(g, 10) == ["A", "B"]
+
+    g2 = make_graph([("A", "B")])
+    with pytest.raises(ValueError) as ei:
+        find_low_coverage_nodes(g2, 2)
+    assert "none of the nodes in the graph have coverage" in str(ei.value)
+
+
+def test_remove_transitive_edges():
+    # A -> B -> C, plus A -> C; and a longer path C -> D -> E -> F plus
+    # C -> F, which isn't a triangle so we leave it alone
+    g = make_graph(
+        [
+            ("A", "B"),
+            ("B", "C"),
+            ("A", "C"),
+            ("C", "D"),
+            ("D", "E"),
+            ("E", "F"),
+            ("C", "F"),
+        ]
+    )
+    assert remove_transitive_edges(g) == [("A", "C")]
+    assert not g.has_edge("A", "C")
+    assert g.has_edge("C", "F")
+
+
+def test_remove_transitive_edges_preserves_reachability():
+    # A complete DAG on 4 nodes: removing edges one at a time (checking the
+    # current graph each time) should leave just the path A -> B -> C -> D
+    nodes = ["A", "B", "C", "D"]
+    edges = [(u, v) for i, u in enumerate(nodes) for v in nodes[i + 1 :]]
+    g = make_graph(edges)
+    remove_transitive_edges(g)
+    assert sorted(g.edges) == [("A", "B"), ("B", "C"), ("C", "D")]
+
+
+def test_remove_transitive_edges_rc():
+    g = make_graph(
+        [
+            ("1", "2"),
+            ("2", "3"),
+            ("1", "3"),
+            ("-2", "-1"),
+            ("-3", "-2"),
+            ("-3", "-1"),
+        ]
+    )
+    removed = remove_transitive_edges(g, get_rc_node_name_func("gfa"))
+    assert removed == [("1", "3"), ("-3", "-1")]
+    assert len(g.edges) == 4
+
+
+def test_remove_transitive_edges_max_degree(monkeypatch):
+    g = make_graph([("A", "B"), ("B", "C"), ("A", "C")])
+    monkeypatch.setattr(
+        simplification.config, "TRANSITIVE_REDUCTION_MAX_DEGREE", 1
+    )
+    assert remove_transitive_edges(g) == []
+
+
+def test_get_rc_node_name_func():
+    assert get_rc_node_name_func("gfa")("1") == "-1"
+    assert get_rc_node_name_func("lastgraph")("-1") == "1"
+    assert get_rc_node_name_func("fastg")("EDGE_1_length_5_cov_2+") == (
+        "EDGE_1_length_5_cov_2-"
+    )
+    assert get_rc_node_name_func("gml") is None
+    assert get_rc_node_name_func("gfa", assume_oriented=True) is None
+
+
+def test_simplify():
+    g = make_graph(
+        [("A", "B"), ("B", "C"), ("A", "C"), ("B", "T"), ("C", "L")],
+        lengths={"T": 3},
+        covs={"A": 10, "B": 10, "C": 10, "T": 10, "L": 1},
+    )
+    nodes, edges = simplify(
+        g, clip_tips_length=5, min_coverage=2, transitive_reduction=True
+    )
+    assert nodes == [["L", LOW_COVERAGE], ["T", TIP]]
+    assert edges == [["A", "C", TRANSITIVE]]
+    assert sorted(g.edges) == [("A", "B"), ("B", "C")]
+
+    # Nothing requested, nothing removed
+    assert simplify(g) == ([], [])
+
+    with pytest.raises(ValueError) as ei:
+        simplify(g, min_coverage=100)
+    assert "removed all of its nodes" in str(ei.value)
+
+
+def test_assembly_graph_simplification(tmp_path):
+    fn = str(tmp_path / "graph.gfa")
+    with open(fn, "w") as f:
+        f.write(
+            "\n".join(
+                [
+                    "H\tVN:Z:1.0",
+                    "S\t1\tACGTACGTAC",
+                    "S\t2\tACGTACGTAC",
+                    "S\t3\tACGTACGTAC",
+                    "S\t4\tA",
+                    "L\t1\t+\t2\t+\t0M",
+                    "L\t2\t+\t3\t+\t0M",
+                    "L\t1\t+\t3\t+\t0M",
+                    "L\t2\t+\t4\t+\t0M",
+                ]
+            )
+        )
+    ag = AssemblyGraph(fn, clip_tips_length=1, transitive_reduction=True)
+    # 4 and -4 are gone
+    assert len(ag.digraph.nodes) == 6
+    assert sorted(ag.removed_nodes) == [["-4", TIP], ["4", TIP]]
+    assert sorted(ag.removed_edges) == [
+        ["-3", "-1", TRANSITIVE],
+        ["1", "3", TRANSITIVE],
+    ]
+    ag.process()
+    out = ag.to_dict()
+    assert out["total_num_nodes"] == 6
+    assert out["total_num_edges"] == 4
+    assert len(out["removed_elements"]["nodes"]) == 2
+    assert len(out["removed_elements"]["edges"]) == 2
+
+    # By default, nothing is removed
+    ag2 = AssemblyGraph(fn)
+    assert ag2.removed_nodes == []
+    assert ag2.removed_edges == []
+    assert len(ag2.digraph.nodes) == 8
+
+
+def test_simplification_not_supported_out_of_core(tmp_path):
+    from metagenomescope.main import make_viz
+
+    with pytest.raises(ValueError) as ei:
+        make_viz(
+            "metagenomescope/tests/input/sample1.gfa",
+            str(tmp_path / "out"),
+            100,
+            100,
+            out_of_core=True,
+            transitive_reduction=True,
+        )
+    assert "can't be used with --out-of-core" in str(ei.value)
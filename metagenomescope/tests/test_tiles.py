@@ -0,0 +1,98 @@
+import os
+import json
+import xml.etree.ElementTree as ET
+import pytest
+from metagenomescope import config
+from metagenomescope.tests.utils import get_graph_dict, run_make_viz
+from metagenomescope.tiles import get_num_levels, make_tiles
+
+SVG_NS = "{http://www.w3.org/2000/svg}"
+
+
+def test_get_num_levels(monkeypatch):
+    monkeypatch.setattr(config, "TILE_SIZE", 256)
+    monkeypatch.setattr(config, "TILE_MAX_LEVELS", 6)
+    assert get_num_levels(100, 200) == 1
+    assert get_num_levels(256, 10) == 1
+    assert get_num_levels(257, 10) == 2
+    assert get_num_levels(10, 1024) == 3
+    assert get_num_levels(1025, 10) == 4
+    # Capped at TILE_MAX_LEVELS
+    assert get_num_levels(10**9, 10) == 6
+
+
+def test_make_tiles(tmp_path, monkeypatch):
+    monkeypatch.setattr(config, "TILES_MIN_COMPONENT_SIZE", 50)
+    graph_dict = get_graph_dict()
+    tiled = make_tiles(graph_dict, str(tmp_path))
+    assert len(tiled) > 0
+    for cc_num, comp in enumerate(graph_dict["components"], 1):
+        size = len(comp["nodes"]) + sum(
+            len(tgts) for tgts in comp["edges"].values()
+        )
+        if cc_num not in tiled:
+            assert size < 50
+            assert "tiles" not in comp
+            continue
+        assert size >= 50
+        tiles = comp["tiles"]
+        assert tiles["dir"] == "tiles/{}".format(cc_num)
+        assert tiles["num_levels"] == get_num_levels(*comp["bb"])
+        assert len(tiles["levels"]) == tiles["num_levels"]
+        # Level 0 is always a single tile showing the whole component
+        assert tiles["levels"][0] == ["0_0"]
+        for z, names in enumerate(tiles["levels"]):
+            level_dir = tmp_path / tiles["dir"] / str(z)
+            assert sorted(os.listdir(level_dir)) == sorted(
+                n + ".svg" for n in names
+            )
+            extent = max(comp["bb"]) / (2**z)
+            for name in names:
+                i, j = (int(c) for c in name.split("_"))
+                assert 0 <= i * extent < max(comp["bb"][0], 1)
+                assert 0 <= j * extent < max(comp["bb"][1], 1)
+                root = ET.parse(str(level_dir / (name + ".svg"))).getroot()
+                assert root.get("width") == str(config.TILE_SIZE)
+                vb = [float(v) for v in root.get("viewBox").split()]
+                assert vb[0] == pytest.approx(i * extent, abs=0.01)
+                assert vb[2] == pytest.approx(extent, abs=0.01)
+    # The tile info should survive being converted to JSON
+    json.dumps(graph_dict)
+
+
+def test_make_tiles_small_elements_become_dots(tmp_path, monkeypatch):
+    monkeypatch.setattr(config, "TILES_MIN_COMPONENT_SIZE", 50)
+    # Make every element "small" at level 0
+    monkeypatch.setattr(config, "TILE_MIN_ELEMENT_PX", 10**9)
+    graph_dict = get_graph_dict()
+    make_tiles(graph_dict, str(tmp_path))
+    tile = tmp_path / graph_dict["components"][0]["tiles"]["dir"] / "0"
+    root = ET.parse(str(tile / "0_0.svg")).getroot()
+    assert len(root.findall(SVG_NS + "polygon")) == 0
+    assert len(root.findall(SVG_NS + "rect")) == 0
+    # All of the dots are drawn as one path
+    assert len(root.findall(SVG_NS + "path")) == 1
+
+
+def test_make_tiles_parallel(tmp_path, monkeypatch):
+    monkeypatch.setattr(config, "TILES_MIN_COMPONENT_SIZE", 20)
+    serial = get_graph_dict()
+    parallel = get_graph_dict()
+    serial_tiled = make_tiles(serial, str(tmp_path / "serial"))
+    parallel_tiled = make_tiles(parallel, str(tmp_path / "par"), workers=3)
+    assert serial_tiled == parallel_tiled
+    for cc_num in serial_tiled:
+        assert (
+            serial["components"][cc_num - 1]["tiles"]
+            == parallel["components"][cc_num - 1]["tiles"]
+        )
+
+
+def test_make_viz_make_tiles(tmp_path, monkeypatch):
+    monkeypatch.setattr(config, "TILES_MIN_COMPONENT_SIZE", 5)
+    out_dir = run_make_viz(tmp_path, make_tiles=True)
+    assert os.path.isfile(
+        str(out_dir / config.TILES_DIR_NAME / "1" / "0" / "0_0.svg")
+    )
+    with open(str(out_dir / "data.js"), "r") as f:
+        assert '"tiles": {"dir": "tiles/1"' in f.read()
@@ -0,0 +1,222 @@
+import pytest
+import networkx as nx
+from metagenomescope import config
+from metagenomescope.user_patterns import (
+    parse_bubble_file,
+    parse_pattern_file,
+    check_node_names,
+    find_source_and_sink,
+    is_contiguous,
+)
+from metagenomescope.union_find import UnionFind
+from metagenomescope.graph_objects import AssemblyGraph
+
+MARYGOLD = "metagenomescope/tests/input/marygold_fig2a.gml"
+
+
+def write(tmp_path, fn, lines):
+    path = str(tmp_path / fn)
+    with open(path, "w") as f:
+        f.write("\n".join(lines) + "\n")
+    return path
+
+
+def write_bubble_chain_gfa(tmp_path):
+    # 1 -> {2, 3} -> 4 -> {5, 6} -> 7
+    lines = ["H\tVN:Z:1.0"]
+    for i in range(1, 8):
+        lines.append("S\t{}\tACGT".format(i))
+    for s, t in ((1, 2), (1, 3), (2, 4), (3, 4), (4, 5), (4, 6), (5, 7)):
+        lines.append("L\t{}\t+\t{}\t+\t0M".format(s, t))
+    lines.append("L\t6\t+\t7\t+\t0M")
+    return write(tmp_path, "chain.gfa", lines)
+
+
+def get_names(ag, p):
+    return sorted(
+        ag.digraph.nodes[n]["name"] for n in p.node_ids if not ag.is_pattern(n)
+    )
+
+
+def test_parse_bubble_file(tmp_path):
+    fn = write(
+        tmp_path,
+        "bubbles.txt",
+        ["a\tc\ta\tb\tc", "", "d\tf\te"],
+    )
+    bubbles = parse_bubble_file(fn)
+    assert len(bubbles) == 2
+    assert bubbles[0].member_names == ["a", "b", "c"]
+    assert (bubbles[0].source, bubbles[0].sink) == ("a", "c")
+    # The source and sink get added in if they weren't listed
+    assert bubbles[1].member_names == ["d", "e", "f"]
+    assert bubbles[1].line_num == 3
+
+    fn2 = write(tmp_path, "bad.txt", ["a\tc\ta\tb\tc", "d\tf"])
+    with pytest.raises(ValueError) as ei:
+        parse_bubble_file(fn2)
+    assert str(ei.value) == (
+        "Line 2 of user-specified bubble file defines no child nodes"
+    )
+
+
+def test_parse_pattern_file(tmp_path):
+    fn = write(
+        tmp_path,
+        "patterns.txt",
+        ["Frayed Rope\ta\tb", "Bubble\tc\td\te", "Weird Thing\tf\tf\tg"],
+    )
+    patterns = parse_pattern_file(fn)
+    assert [p.pattern_type for p in patterns] == [
+        "frayedrope",
+        "bubble",
+        "Weird Thing",
+    ]
+    assert patterns[2].member_names == ["f", "g"]
+    assert patterns[1].source is None
+
+    fn2 = write(tmp_path, "bad.txt", ["Chain"])
+    with pytest.raises(ValueError) as ei:
+        parse_pattern_file(fn2)
+    assert str(ei.value) == (
+        "Line 1 of user-specified pattern file defines no child nodes"
+    )
+
+
+def test_check_node_names_and_find_source_and_sink(tmp_path):
+    g = nx.DiGraph()
+    g.add_edges_from([("a", "b"), ("a", "c"), ("b", "d"), ("c", "d")])
+    fn = write(tmp_path, "p.txt", ["Bubble\ta\tb\tc\td", "Bubble\ta\tb\tc"])
+    patterns = parse_pattern_file(fn)
+    check_node_names(patterns, g)
+    find_source_and_sink(patterns[0], g)
+    assert (patterns[0].source, patterns[0].sink) == ("a", "d")
+    # b and c are both sinks
+    with pytest.raises(ValueError) as ei:
+        find_source_and_sink(patterns[1], g)
+    assert str(ei.value) == (
+        'User-specified pattern "2" doesn\'t have exactly one start node and '
+        "one end node"
+    )
+
+    bad = parse_bubble_file(write(tmp_path, "b.txt", ["a\tz\ta\tz"]))
+    with pytest.raises(ValueError) as ei:
+        check_node_names(bad, g)
+    assert str(ei.value) == config.UBUBBLE_NODE_ERR + "z"
+
+
+def test_union_find_and_is_contiguous():
+    uf = UnionFind()
+    uf.union(1, 2)
+    uf.union(3, 4)
+    assert uf.find(2) == uf.find(1)
+    assert uf.find(3) != uf.find(1)
+    uf.union(2, 4)
+    assert len(set(uf.find(i) for i in range(1, 5))) == 1
+    # union(x, y) always makes x's root the root of the merged set
+    uf.union(5, 1)
+    assert uf.find(4) == 5
+
+    g = nx.DiGraph()
+    g.add_edges_from([(0, 1), (2, 1), (3, 4)])
+    assert is_contiguous([0, 1, 2], g)
+    assert not is_contiguous([0, 2], g)
+    assert not is_contiguous([0, 1, 3], g)
+
+
+def test_user_bubbles_and_nested_pattern(tmp_path):
+    bf = write(
+        tmp_path,
+        "bubbles.txt",
+        [
+            "NODE_1\tNODE_5\tNODE_1\tNODE_2\tNODE_3\tNODE_4\tNODE_5",
+            "NODE_6\tNODE_9\tNODE_6\tNODE_7\tNODE_8\tNODE_12\tNODE_9",
+        ],
+    )
+    pf = write(
+        tmp_path,
+        "patterns.txt",
+        [
+            "My Pattern\tNODE_10\tNODE_11\tNODE_1\tNODE_2\tNODE_3\tNODE_4\t"
+            "NODE_5\tNODE_6\tNODE_7\tNODE_8\tNODE_9\tNODE_12"
+        ],
+    )
+    ag = AssemblyGraph(MARYGOLD, bubble_file=bf, user_pattern_file=pf)
+    ag.process()
+    assert len(ag.bubbles) == 2
+    assert get_names(ag, ag.bubbles[0]) == [
+        "NODE_1",
+        "NODE_2",
+        "NODE_3",
+        "NODE_4",
+        "NODE_5",
+    ]
+    assert len(ag.misc_patterns) == 1
+    mp = ag.misc_patterns[0]
+    assert mp.pattern_type == "My Pattern"
+    assert get_names(ag, mp) == ["NODE_10", "NODE_11"]
+    assert sorted(n for n in mp.node_ids if ag.is_pattern(n)) == sorted(
+        b.pattern_id for b in ag.bubbles
+    )
+    # Everything's in the user patterns, so automatic detection has nothing
+    # left to do
+    assert len(ag.id2pattern) == 3
+    assert list(ag.decomposed_digraph.nodes) == [mp.pattern_id]
+    out = ag.to_dict()
+    ptypes = [
+        p[out["patt_attrs"]["pattern_type"]]
+        for p in out["components"][0]["patts"]
+    ]
+    assert sorted(ptypes) == ["My Pattern", "bubble", "bubble"]
+
+
+def test_user_bubbles_sharing_boundaries(tmp_path):
+    gfa = write_bubble_chain_gfa(tmp_path)
+    bf = write(tmp_path, "b.txt", ["1\t4\t1\t2\t3\t4", "4\t7\t4\t5\t6\t7"])
+    ag = AssemblyGraph(gfa, bubble_file=bf, assume_oriented=True)
+    ag.hierarchically_identify_patterns()
+    b1, b2 = ag.bubbles[:2]
+    # Node 4 is duplicated, so that each bubble gets a copy of it
+    assert get_names(ag, b1) == ["1", "2", "3", "4"]
+    assert get_names(ag, b2) == ["4", "5", "6", "7"]
+    assert b1.pattern_id not in b2.node_ids
+    # ... and then automatic detection puts them together into a chain
+    assert len(ag.chains) == 1
+    assert sorted(ag.chains[0].node_ids) == [b1.pattern_id, b2.pattern_id]
+
+
+def test_user_pattern_errors(tmp_path):
+    gfa = write_bubble_chain_gfa(tmp_path)
+    pf = write(tmp_path, "p.txt", ["Chain\t1\t2\t3", "Thing\t5\t6"])
+    with pytest.raises(ValueError) as ei:
+        AssemblyGraph(
+            gfa, user_pattern_file=pf, assume_oriented=True
+        ).hierarchically_identify_patterns()
+    assert str(ei.value) == 'User-specified pattern "2" is not contiguous'
+
+    pf2 = write(tmp_path, "p2.txt", ["Chain\t1\t2\t3", "Thing\t2\t4\t5"])
+    with pytest.raises(ValueError) as ei:
+        AssemblyGraph(
+            gfa, user_pattern_file=pf2, assume_oriented=True
+        ).hierarchically_identify_patterns()
+    assert "overlaps with another user-specified pattern" in str(ei.value)
+
+    pf3 = write(tmp_path, "p3.txt", ["Chain\t1\t100"])
+    with pytest.raises(ValueError) as ei:
+        AssemblyGraph(gfa, user_pattern_file=pf3, assume_oriented=True)
+    assert str(ei.value) == config.UPATTERN_NODE_ERR + "100"
+
+
+def test_user_patterns_skipped_if_nodes_removed(tmp_path):
+    gfa = write_bubble_chain_gfa(tmp_path)
+    with open(gfa, "a") as f:
+        f.write("S\t8\tACGT\nS\t9\tACGT\nL\t8\t+\t9\t+\t0M\n")
+    pf = write(tmp_path, "p.txt", ["Thing\t1\t2", "Thing\t8\t9"])
+    # The 7-node component is too large, so it's removed (and the first
+    # pattern along with it)
+    ag = AssemblyGraph(
+        gfa, user_pattern_file=pf, assume_oriented=True, max_node_count=3
+    )
+    ag.hierarchically_identify_patterns()
+    assert len(ag.misc_patterns) == 1
+    assert get_names(ag, ag.misc_patterns[0]) == ["8", "9"]
@@ -19,7 +19,13 @@
 # This file contains some utility functions that should help simplify the
 # process of creating tests for MetagenomeScope's preprocessing script.
 
+import os
+import json
 import random
+from metagenomescope.graph_objects import AssemblyGraph
+
+E_COLI = "metagenomescope/tests/input/E_coli_LastGraph"
+SAMPLE1 = "metagenomescope/tests/input/sample1.gfa"
 
 
 def gen_random_sequence(possible_lengths):
@@ -33,3 +39,42 @@ def gen_random_sequence(possible_lengths):
         seq += random.choice(alphabet)
         i += 1
     return seq
+
+
+def get_graph_dict(filename=E_COLI):
+    """Processes an assembly graph and returns its to_dict() output."""
+    ag = AssemblyGraph(filename)
+    ag.process()
+    return ag.to_dict()
+
+
+def read_define_js(path):
+    """Reads a "define(...);" file written by the preprocessing script.
+
+    We use this format for data.js and for the per-component tables (attribute
+    tables, annotations, ...), so this just checks the wrapper and returns
+    the JSON inside it.
+    """
+    with open(str(path), "r") as f:
+        text = f.read()
+    assert text.startswith("define(")
+    assert text.endswith(");\n")
+    return json.loads(text[len("define(") : -len(");\n")])
+
+
+def run_make_viz(tmp_path, filename=SAMPLE1, **kwargs):
+    """Runs make_viz() on a small graph and returns the output directory.
+
+    Any keyword arguments get passed on to make_viz(), so the tests that
+    check a make_viz() option end-to-end can just say which option to use.
+    """
+    from metagenomescope.main import make_viz
+
+    out_dir = tmp_path / "out"
+    make_viz(filename, str(out_dir), 100, 100, **kwargs)
+    return out_dir
+
+
+def read_data_js(out_dir):
+    """Returns the parsed contents of the data.js file in an output dir."""
+    return read_define_js(os.path.join(str(out_dir), "data.js"))
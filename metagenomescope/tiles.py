@@ -0,0 +1,226 @@
+# Copyright (C) 2016-- Marcus Fedarko, Jay Ghurye, Todd Treangen, Mihai Pop
+# Authored by Marcus Fedarko
+#
+# This file is part of MetagenomeScope.
+#
+# MetagenomeScope is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# MetagenomeScope is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with MetagenomeScope.  If not, see <http://www.gnu.org/licenses/>.
+####
+# Precomputing "deep zoom" tile pyramids (-mt) for big components.
+#
+# Drawing a component with tens of thousands of elements in Cytoscape.js
+# takes a while, even though (when you're zoomed out) most of those elements
+# are smaller than a pixel. So for big components, we draw the final layout
+# ahead of time as a pyramid of small SVG tiles, like an online map: level 0
+# is one TILE_SIZE x TILE_SIZE tile showing the whole component, level 1 is
+# (up to) 2 x 2 tiles at twice the scale, and so on. The viewer shows the
+# tiles that are on screen at the current zoom (and the level 0 tile as a
+# minimap), and only draws the actual elements once you zoom in far enough
+# that there aren't many of them visible.
+#
+# Tiles are vector images (SVG), since that's what we can make without any
+# extra dependencies; see render.py for how elements are drawn. Elements
+# that'd be smaller than a pixel at a given level are drawn as single-pixel
+# dots, which keeps the zoomed-out tiles small.
+#
+# Tiles for component N at level z are saved as
+# TILES_DIR_NAME/N/z/i_j.svg, where i is the column and j is the row (both
+# starting at 0 in the top left). Tiles that'd be empty aren't written.
+
+import os
+import math
+import multiprocessing
+from . import config
+from .render import (
+    SVGCanvas,
+    get_arrow_markers,
+    get_component_elements,
+    fmt,
+    EDGE_COLOR,
+)
+
+
+def get_num_levels(width, height):
+    """Returns the number of levels in a component's tile pyramid.
+
+    We stop once a level would be drawn at a scale of more than 1 pixel per
+    point (past that, there's no new detail to show), or once we reach
+    config.TILE_MAX_LEVELS levels.
+    """
+    dim = max(width, height, 1)
+    if dim <= config.TILE_SIZE:
+        return 1
+    return min(
+        config.TILE_MAX_LEVELS,
+        1 + math.ceil(math.log2(dim / config.TILE_SIZE)),
+    )
+
+
+def get_tile_range(lo, hi, extent, num_tiles):
+    """Returns the range of tile indices that [lo, hi] overlaps."""
+    first = max(int(math.floor(lo / extent)), 0)
+    last = min(int(math.floor(hi / extent)), num_tiles - 1)
+    return range(first, last + 1)
+
+
+def tile_to_svg(left, top, extent, elements, dots, dot_size):
+    """Returns a string containing an SVG image of a single tile.
+
+    left, top, and extent describe the part of the component (in SVG
+    coordinates; see render.SVGCanvas) that this tile covers.
+    """
+    lines = [
+        '<svg xmlns="http://www.w3.org/2000/svg" width="{s}" height="{s}" '
+        'viewBox="{} {} {e} {e}">'.format(
+            fmt(left), fmt(top), s=config.TILE_SIZE, e=fmt(extent)
+        )
+    ]
+    lines.extend(get_arrow_markers())
+    lines.extend(elements)
+    if len(dots) > 0:
+        square = "h{d}v{d}h-{d}z".format(d=fmt(dot_size))
+        lines.append(
+            '<path d="{}" fill="{}"/>'.format(
+                "".join(
+                    "M{},{}{}".format(
+                        fmt(px * dot_size), fmt(py * dot_size), square
+                    )
+                    for px, py in sorted(dots)
+                ),
+                EDGE_COLOR,
+            )
+        )
+    lines.append("</svg>")
+    return "\n".join(lines)
+
+
+def make_component_tiles(cc_num, comp, attrs, tiles_dir):
+    """Writes out the tile pyramid for a single component.
+
+    Returns a 2-tuple of (cc_num, dict describing the pyramid). The dict
+    has the keys:
+
+    "dir": the directory containing this component's tiles, relative to the
+        output directory (and using forward slashes, since it's used in URLs)
+    "num_levels": the number of levels in the pyramid
+    "tile_size": config.TILE_SIZE
+    "scale": pixels per point at level 0 (level z's scale is this * 2^z)
+    "width" / "height": the component's bounding box (same as comp["bb"])
+    "levels": a list with one entry per level, listing the "i_j" names of
+        the tiles that were written for that level
+    """
+    width, height = comp["bb"]
+    canvas = SVGCanvas(width, height, 0)
+    elements = get_component_elements(comp, *attrs, canvas)
+    num_levels = get_num_levels(width, height)
+    base_scale = config.TILE_SIZE / max(width, height, 1)
+
+    cc_dir = os.path.join(tiles_dir, str(cc_num))
+    levels = []
+    for z in range(num_levels):
+        scale = base_scale * (2**z)
+        extent = config.TILE_SIZE / scale
+        num_cols = max(math.ceil(width / extent), 1)
+        num_rows = max(math.ceil(height / extent), 1)
+        # Maps (i, j) to a list of the elements / a set of the dots in that
+        # tile
+        tile2elements = {}
+        tile2dots = {}
+        for bbox, element in elements:
+            x1, y1, x2, y2 = bbox
+            if max(x2 - x1, y2 - y1) * scale < config.TILE_MIN_ELEMENT_PX:
+                px = int(math.floor(((x1 + x2) / 2) * scale))
+                py = int(math.floor(((y1 + y2) / 2) * scale))
+                i = min(max(px // config.TILE_SIZE, 0), num_cols - 1)
+                j = min(max(py // config.TILE_SIZE, 0), num_rows - 1)
+                tile2dots.setdefault((i, j), set()).add((px, py))
+            else:
+                for i in get_tile_range(x1, x2, extent, num_cols):
+                    for j in get_tile_range(y1, y2, extent, num_rows):
+                        tile2elements.setdefault((i, j), []).append(element)
+
+        level_dir = os.path.join(cc_dir, str(z))
+        os.makedirs(level_dir, exist_ok=True)
+        tile_names = []
+        for i, j in sorted(set(tile2elements) | set(tile2dots)):
+            name = "{}_{}".format(i, j)
+            with open(os.path.join(level_dir, name + ".svg"), "w") as f:
+                f.write(
+                    tile_to_svg(
+                        i * extent,
+                        j * extent,
+                        extent,
+                        tile2elements.get((i, j), []),
+                        tile2dots.get((i, j), set()),
+                        1 / scale,
+                    )
+                )
+            tile_names.append(name)
+        levels.append(tile_names)
+
+    return (
+        cc_num,
+        {
+            "dir": "{}/{}".format(config.TILES_DIR_NAME, cc_num),
+            "num_levels": num_levels,
+            "tile_size": config.TILE_SIZE,
+            "scale": base_scale,
+            "width": width,
+            "height": height,
+            "levels": levels,
+        },
+    )
+
+
+def _make_component_tiles_star(args):
+    return make_component_tiles(*args)
+
+
+def make_tiles(graph_data, output_dir, workers=1):
+    """Writes out tile pyramids for all of the big components in a graph.
+
+    graph_data should be the output of AssemblyGraph.to_dict(). Components
+    that weren't skipped and that have at least
+    config.TILES_MIN_COMPONENT_SIZE nodes + edges get tiles; we add a
+    "tiles" entry (see make_component_tiles()) to each of these components'
+    dicts in graph_data, so this should be called before graph_data is
+    converted to JSON. If workers > 1, components are tiled in parallel.
+
+    Returns a list of the numbers of the components we made tiles for.
+    """
+    tiles_dir = os.path.join(output_dir, config.TILES_DIR_NAME)
+    attrs = (
+        graph_data["node_attrs"],
+        graph_data["edge_attrs"],
+        graph_data["patt_attrs"],
+    )
+    jobs = []
+    for cc_num, comp in enumerate(graph_data["components"], 1):
+        if comp["skipped"]:
+            continue
+        num_edges = sum(len(tgts) for tgts in comp["edges"].values())
+        if len(comp["nodes"]) + num_edges >= config.TILES_MIN_COMPONENT_SIZE:
+            jobs.append((cc_num, comp, attrs, tiles_dir))
+
+    if workers > 1 and len(jobs) > 1:
+        with multiprocessing.Pool(min(workers, len(jobs))) as pool:
+            results = list(
+                pool.imap_unordered(_make_component_tiles_star, jobs)
+            )
+    else:
+        results = [make_component_tiles(*job) for job in jobs]
+
+    components = graph_data["components"]
+    for cc_num, tiles in results:
+        components[cc_num - 1]["tiles"] = tiles
+    return sorted(cc_num for cc_num, tiles in results)
@@ -0,0 +1,56 @@
+# Copyright (C) 2016-- Marcus Fedarko, Jay Ghurye, Todd Treangen, Mihai Pop
+# Authored by Marcus Fedarko
+#
+# This file is part of MetagenomeScope.
+#
+# MetagenomeScope is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# MetagenomeScope is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with MetagenomeScope.  If not, see <http://www.gnu.org/licenses/>.
+####
+# This module contains a (dict-based) union-find structure. This gets used in
+# a few places: checking that user-specified patterns are contiguous, figuring
+# out which top-level user-specified pattern contains a node, and labelling
+# connected components when we summarize a graph without building a NetworkX
+# DiGraph of it (see graph_info.py).
+
+
+class UnionFind(object):
+    """Union-find (a.k.a. disjoint-set) structure, with path compression.
+
+    Elements can be any hashable objects, and are added lazily, the first
+    time they're looked up -- so we only store anything for elements that
+    have been involved in a union().
+
+    We don't use union by size/rank, because some callers rely on union(x, y)
+    always making x's root the root of the merged set.
+    """
+
+    def __init__(self):
+        self.parent = {}
+
+    def find(self, x):
+        root = x
+        while self.parent.get(root, root) != root:
+            root = self.parent[root]
+        # Path compression
+        while x != root:
+            nxt = self.parent.get(x, x)
+            self.parent[x] = root
+            x = nxt
+        return root
+
+    def union(self, x, y):
+        """Merges the sets containing x and y; y's root becomes x's root."""
+        rx = self.find(x)
+        ry = self.find(y)
+        if rx != ry:
+            self.parent[ry] = rx
@@ -0,0 +1,218 @@
+# Copyright (C) 2016-- Marcus Fedarko, Jay Ghurye, Todd Treangen, Mihai Pop
+# Authored by Marcus Fedarko
+#
+# This file is part of MetagenomeScope.
+#
+# MetagenomeScope is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# MetagenomeScope is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with MetagenomeScope.  If not, see <http://www.gnu.org/licenses/>.
+####
+# Reading user-specified bubbles (-mbf) and patterns (-up) from files.
+#
+# These files can be huge (MetaCarvel can output hundreds of thousands of
+# bubbles for a large graph), so everything here is done in time linear in
+# the size of the file: node names are looked up in a dict, and we check
+# that each pattern is contiguous using union-find over just its members
+# (rather than, say, building a subgraph and running a connected components
+# algorithm on it).
+#
+# The actual insertion of these patterns into the graph is done in
+# AssemblyGraph.add_user_patterns(), before automatic pattern detection.
+
+from . import config
+from .union_find import UnionFind
+
+# Names users can give pattern types in -up files (after lowercasing and
+# removing whitespace), mapped to the pattern types we use internally.
+# Anything else becomes a generic "misc. user-specified pattern," with
+# whatever type the user gave it.
+KNOWN_PATTERN_TYPES = {
+    "bubble": "bubble",
+    "frayedrope": "frayedrope",
+    "chain": "chain",
+    "cyclicchain": "cyclicchain",
+}
+
+
+class UserPattern(object):
+    """A pattern read from a -mbf or -up file.
+
+    Nodes are identified by their names (at least until
+    AssemblyGraph.add_user_patterns() resolves them to node IDs). If this
+    is a bubble, source and sink are the names of its start and end nodes;
+    otherwise they're None.
+    """
+
+    def __init__(
+        self,
+        pattern_type,
+        member_names,
+        line_num,
+        from_bubble_file,
+        source=None,
+        sink=None,
+    ):
+        self.pattern_type = pattern_type
+        self.member_names = member_names
+        self.line_num = line_num
+        self.from_bubble_file = from_bubble_file
+        self.source = source
+        self.sink = sink
+
+    def get_err_prefix(self):
+        """Returns the start of an error message about this pattern.
+
+        Patterns are identified in error messages by their (1-indexed) line
+        number in the file they came from.
+        """
+        if self.from_bubble_file:
+            prefix = config.UBUBBLE_ERR_PREFIX
+        else:
+            prefix = config.UPATTERN_ERR_PREFIX
+        return prefix + str(self.line_num)
+
+    def __repr__(self):
+        return "User-specified {} (line {}) of nodes {}".format(
+            self.pattern_type, self.line_num, self.member_names
+        )
+
+
+def _split_lines(filename):
+    """Yields (line number, list of tab-separated fields) for each line.
+
+    Blank lines are skipped.
+    """
+    with open(filename, "r") as f:
+        for line_num, line in enumerate(f, 1):
+            line = line.rstrip("\r\n")
+            if line.strip() == "":
+                continue
+            yield line_num, [field.strip() for field in line.split("\t")]
+
+
+def _dedup(names):
+    """Removes duplicate names from a list, keeping the first occurrences."""
+    seen = set()
+    out = []
+    for n in names:
+        if n not in seen and n != "":
+            seen.add(n)
+            out.append(n)
+    return out
+
+
+def parse_bubble_file(filename):
+    """Parses a MetaCarvel bubbles.txt-formatted file.
+
+    Each line should be formatted as (source)(tab)(sink)(tab)(all nodes in
+    the bubble, including the source and sink, separated by tabs). (If the
+    source or sink aren't listed again, we'll add them in.)
+
+    Returns a list of UserPatterns.
+    """
+    patterns = []
+    for line_num, fields in _split_lines(filename):
+        members = _dedup(fields[2:])
+        if len(fields) < 2 or len(members) == 0:
+            raise ValueError(
+                config.LINE_NOUN + str(line_num) + config.UBUBBLE_NOTENOUGH_ERR
+            )
+        source, sink = fields[0], fields[1]
+        members = _dedup([source] + members + [sink])
+        patterns.append(
+            UserPattern("bubble", members, line_num, True, source, sink)
+        )
+    return patterns
+
+
+def parse_pattern_file(filename):
+    """Parses a file of user-specified patterns.
+
+    Each line should be formatted as (pattern type)(tab)(all nodes in the
+    pattern, separated by tabs). See KNOWN_PATTERN_TYPES.
+
+    Returns a list of UserPatterns. (For bubbles, the source and sink are
+    filled in later by find_source_and_sink(), since we need the graph to
+    figure them out.)
+    """
+    patterns = []
+    for line_num, fields in _split_lines(filename):
+        members = _dedup(fields[1:])
+        if len(members) == 0:
+            raise ValueError(
+                config.LINE_NOUN
+                + str(line_num)
+                + config.UPATTERN_NOTENOUGH_ERR
+            )
+        ptype = fields[0]
+        normalized = "".join(ptype.lower().split())
+        ptype = KNOWN_PATTERN_TYPES.get(normalized, ptype)
+        patterns.append(UserPattern(ptype, members, line_num, False))
+    return patterns
+
+
+def check_node_names(patterns, digraph):
+    """Raises a ValueError if a pattern refers to a node not in the graph.
+
+    digraph should be keyed by node name (i.e. it should be the output of
+    one of the parsers in assembly_graph_parser).
+    """
+    for p in patterns:
+        if p.from_bubble_file:
+            err = config.UBUBBLE_NODE_ERR
+        else:
+            err = config.UPATTERN_NODE_ERR
+        for name in p.member_names:
+            if name not in digraph:
+                raise ValueError(err + name)
+
+
+def find_source_and_sink(pattern, digraph):
+    """Figures out the start and end node of a bubble from the -up file.
+
+    The source is the member without any incoming edges from other members,
+    and the sink is the member without any outgoing edges to other members.
+    If there isn't exactly one of each, raises a ValueError. digraph should
+    be keyed by node name.
+    """
+    members = set(pattern.member_names)
+    sources = []
+    sinks = []
+    for name in pattern.member_names:
+        if not any(p in members for p in digraph.pred[name] if p != name):
+            sources.append(name)
+        if not any(s in members for s in digraph.adj[name] if s != name):
+            sinks.append(name)
+    if len(sources) != 1 or len(sinks) != 1:
+        raise ValueError(
+            pattern.get_err_prefix()
+            + "\" doesn't have exactly one start node and one end node"
+        )
+    pattern.source = sources[0]
+    pattern.sink = sinks[0]
+
+
+def is_contiguous(member_ids, g):
+    """Returns True if the members are weakly connected in g.
+
+    Only edges between members are considered. This only looks at the
+    members' own adjacencies, so it takes time proportional to the total
+    degree of the members (not to the size of g).
+    """
+    member_ids = set(member_ids)
+    uf = UnionFind()
+    for m in member_ids:
+        for n in g.adj[m]:
+            if n in member_ids:
+                uf.union(m, n)
+    roots = set(uf.find(m) for m in member_ids)
+    return len(roots) == 1
@@ -64,7 +64,9 @@ setup(
     package_data={"metagenomescope": ["support_files"]},
     include_package_data=True,
     install_requires=[
-        "click",
+        # 8.0 is needed for Context.get_parameter_source() (used to figure
+        # out whether or not -maxn / -maxe were explicitly given)
+        "click>=8.0",
         # version 1.3 gives me errors when accessing bounding boxes sometimes:
         # https://github.com/pygraphviz/pygraphviz/issues/113#issuecomment-298631567
         "pygraphviz>=1.6",
@@ -74,7 +76,13 @@ setup(
         "pyfastg",
         "jinja2",
     ],
-    extras_require={"dev": ["pytest", "pytest-cov", "flake8", "black"]},
+    extras_require={
+        "dev": ["pytest", "pytest-cov", "flake8", "black"],
+        # Only needed for --export-tables
+        "tables": ["pyarrow"],
+        # Only needed for --render-images png
+        "images": ["cairosvg"],
+    },
     entry_points={"console_scripts": ["mgsc=metagenomescope._cli:run_script"]},
     zip_safe=False,
 )